@@ -0,0 +1,65 @@
+﻿/**********************************************************************************
+    Aabb.h
+
+                                                                LI WENHUI
+                                                                2025/08/21
+
+**********************************************************************************/
+
+#ifndef AABB_H
+#define AABB_H
+
+//
+// ワールド座標の軸平行矩形（Y は下向き）
+struct Aabb {
+    float minX, minY, maxX, maxY;
+};
+
+inline bool AabbOverlap(const Aabb& a, const Aabb& b) {
+    return a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY && b.minY < a.maxY;
+}
+
+//
+// a を (dx, dy) だけ動かしたとき、b に最初に触れる時刻（0..1）を返す。触れなければ 1
+// normalX / normalY には当たった面の向き（a を押し返す向き）が入る
+inline float SweepAabb(const Aabb& a, float dx, float dy, const Aabb& b, float* normalX, float* normalY) {
+    *normalX = 0.0f;
+    *normalY = 0.0f;
+
+    // 各軸で「触れ始め」と「離れる」までの距離
+    float entryX, exitX, entryY, exitY;
+    if (dx > 0.0f) { entryX = b.minX - a.maxX; exitX = b.maxX - a.minX; }
+    else           { entryX = a.minX - b.maxX; exitX = a.maxX - b.minX; }
+    if (dy > 0.0f) { entryY = b.minY - a.maxY; exitY = b.maxY - a.minY; }
+    else           { entryY = a.minY - b.maxY; exitY = a.maxY - b.minY; }
+
+    // 動いていない軸は、すでに重なっていれば常に接触中
+    float tEntryX, tExitX, tEntryY, tExitY;
+    if (dx == 0.0f) {
+        if (a.maxX <= b.minX || b.maxX <= a.minX) return 1.0f;
+        tEntryX = -1e30f; tExitX = 1e30f;
+    }
+    else {
+        float inv = 1.0f / (dx > 0.0f ? dx : -dx);
+        tEntryX = entryX * inv; tExitX = exitX * inv;
+    }
+    if (dy == 0.0f) {
+        if (a.maxY <= b.minY || b.maxY <= a.minY) return 1.0f;
+        tEntryY = -1e30f; tExitY = 1e30f;
+    }
+    else {
+        float inv = 1.0f / (dy > 0.0f ? dy : -dy);
+        tEntryY = entryY * inv; tExitY = exitY * inv;
+    }
+
+    float tEntry = tEntryX > tEntryY ? tEntryX : tEntryY;
+    float tExit = tExitX < tExitY ? tExitX : tExitY;
+    if (tEntry > tExit || tEntry < 0.0f || tEntry > 1.0f) return 1.0f;
+
+    if (tEntryX > tEntryY) *normalX = dx > 0.0f ? -1.0f : 1.0f;
+    else                   *normalY = dy > 0.0f ? -1.0f : 1.0f;
+    return tEntry;
+}
+
+
+#endif
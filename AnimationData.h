@@ -17,6 +17,7 @@ struct AnimationData {
     int columns;
     int rows;
     float fps;
+    bool loop = true;
 };
 
 
@@ -0,0 +1,285 @@
+﻿/**********************************************************************************
+    AnimationGraph.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/12
+
+**********************************************************************************/
+
+#include "AnimationGraph.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+/*
+    グラフ定義の書式（1行1命令、# 以降はコメント）
+
+        param   <name>
+        clip    <name> <texturePath> <totalFrames> <columns> <rows> <fps> [loop|once]
+        state   <name> <clip>
+        default <state>
+        transition <from|*> <to> <blendSeconds> [<param> <op> <value> | finished]...
+
+    transition の条件は全て満たしたときに成立（AND）。from に * を書くと
+    自分以外の全ステートに展開される。定義順が優先順位になる。
+*/
+
+namespace {
+
+    struct PendingTransition {
+        int from;   // -1 = 任意のステート
+        int to;
+        float blend;
+        std::vector<AnimCondition> conditions;
+    };
+
+    bool ParseOp(const std::string& token, AnimCompareOp* op) {
+        if (token == ">") { *op = AnimCompareOp::Greater; return true; }
+        if (token == "<") { *op = AnimCompareOp::Less; return true; }
+        if (token == ">=") { *op = AnimCompareOp::GreaterEqual; return true; }
+        if (token == "<=") { *op = AnimCompareOp::LessEqual; return true; }
+        if (token == "==") { *op = AnimCompareOp::Equal; return true; }
+        if (token == "!=") { *op = AnimCompareOp::NotEqual; return true; }
+        return false;
+    }
+
+    int FindName(const std::vector<std::string>& names, const std::string& name) {
+        for (size_t i = 0; i < names.size(); i++) {
+            if (names[i] == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    bool Fail(std::string* error, int line, const std::string& message) {
+        if (error) *error = "line " + std::to_string(line) + ": " + message;
+        return false;
+    }
+
+    bool TestCondition(const AnimCondition& c, const AnimGraphInstance& inst) {
+        float v = inst.params[c.param];
+        switch (c.op) {
+        case AnimCompareOp::Greater:      return v > c.value;
+        case AnimCompareOp::Less:         return v < c.value;
+        case AnimCompareOp::GreaterEqual: return v >= c.value;
+        case AnimCompareOp::LessEqual:    return v <= c.value;
+        case AnimCompareOp::Equal:        return v == c.value;
+        case AnimCompareOp::NotEqual:     return v != c.value;
+        case AnimCompareOp::Finished:     return inst.finished;
+        }
+        return false;
+    }
+
+    // クリップ時間からフレーム番号を求める。ループしないクリップは最終フレームで止める
+    int FrameAt(const AnimationData& clip, float time, bool* finished) {
+        int frame = static_cast<int>(time * clip.fps);
+        if (clip.loop) {
+            *finished = false;
+            return frame % clip.totalFrames;
+        }
+        *finished = frame >= clip.totalFrames;
+        return *finished ? clip.totalFrames - 1 : frame;
+    }
+}
+
+
+int AnimGraph::FindParam(const char* name) const {
+    return FindName(paramNames, name);
+}
+
+int AnimGraph::FindState(const char* name) const {
+    return FindName(stateNames, name);
+}
+
+
+bool CompileAnimGraph(const std::string& source, AnimGraph* outGraph, std::string* error) {
+    AnimGraph graph;
+    std::vector<std::string> stateClipNames;
+    std::vector<PendingTransition> pending;
+    std::string defaultName;
+
+    std::istringstream input(source);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(input, line)) {
+        lineNo++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream tokens(line);
+        std::string cmd;
+        if (!(tokens >> cmd)) continue;
+
+        if (cmd == "param") {
+            std::string name;
+            if (!(tokens >> name)) return Fail(error, lineNo, "param needs a name");
+            if (graph.paramNames.size() >= kMaxAnimParams) return Fail(error, lineNo, "too many params");
+            graph.paramNames.push_back(name);
+        }
+        else if (cmd == "clip") {
+            std::string name, path, mode;
+            AnimationData clip{};
+            if (!(tokens >> name >> path >> clip.totalFrames >> clip.columns >> clip.rows >> clip.fps)) {
+                return Fail(error, lineNo, "clip needs name, path, frames, columns, rows, fps");
+            }
+            if (tokens >> mode) clip.loop = (mode != "once");
+            if (clip.totalFrames <= 0 || clip.columns <= 0 || clip.rows <= 0 || clip.fps <= 0.0f) {
+                return Fail(error, lineNo, "clip '" + name + "' has an invalid layout");
+            }
+            clip.texturePath = std::filesystem::u8path(path).wstring();
+            graph.clipNames.push_back(name);
+            graph.clips.push_back(clip);
+        }
+        else if (cmd == "state") {
+            std::string name, clip;
+            if (!(tokens >> name >> clip)) return Fail(error, lineNo, "state needs name and clip");
+            graph.stateNames.push_back(name);
+            stateClipNames.push_back(clip);
+        }
+        else if (cmd == "default") {
+            if (!(tokens >> defaultName)) return Fail(error, lineNo, "default needs a state");
+        }
+        else if (cmd == "transition") {
+            std::string from, to;
+            PendingTransition t{};
+            if (!(tokens >> from >> to >> t.blend)) return Fail(error, lineNo, "transition needs from, to, blend");
+            t.from = (from == "*") ? -1 : FindName(graph.stateNames, from);
+            t.to = FindName(graph.stateNames, to);
+            if ((from != "*" && t.from < 0) || t.to < 0) return Fail(error, lineNo, "unknown state");
+
+            std::string param;
+            while (tokens >> param) {
+                AnimCondition c{};
+                if (param == "finished") {
+                    c.op = AnimCompareOp::Finished;
+                }
+                else {
+                    std::string op;
+                    int index = FindName(graph.paramNames, param);
+                    if (index < 0) return Fail(error, lineNo, "unknown param '" + param + "'");
+                    if (!(tokens >> op >> c.value) || !ParseOp(op, &c.op)) {
+                        return Fail(error, lineNo, "bad condition on '" + param + "'");
+                    }
+                    c.param = static_cast<uint8_t>(index);
+                }
+                t.conditions.push_back(c);
+            }
+            pending.push_back(t);
+        }
+        else {
+            return Fail(error, lineNo, "unknown command '" + cmd + "'");
+        }
+    }
+
+    if (graph.stateNames.empty()) return Fail(error, lineNo, "graph has no states");
+
+    // ステート→クリップの解決
+    graph.states.resize(graph.stateNames.size());
+    for (size_t s = 0; s < graph.states.size(); s++) {
+        int clip = FindName(graph.clipNames, stateClipNames[s]);
+        if (clip < 0) return Fail(error, lineNo, "state '" + graph.stateNames[s] + "' uses unknown clip");
+        graph.states[s].clip = static_cast<uint16_t>(clip);
+    }
+
+    // ソースステートごとに遷移を並べ直す（* は各ステートに展開）
+    for (size_t s = 0; s < graph.states.size(); s++) {
+        graph.states[s].transitionFirst = static_cast<uint16_t>(graph.transitions.size());
+        for (const PendingTransition& p : pending) {
+            bool fromAny = p.from < 0 && p.to != static_cast<int>(s);
+            if (p.from != static_cast<int>(s) && !fromAny) continue;
+
+            AnimTransition t{};
+            t.target = static_cast<uint16_t>(p.to);
+            t.conditionFirst = static_cast<uint16_t>(graph.conditions.size());
+            t.conditionCount = static_cast<uint16_t>(p.conditions.size());
+            t.blendDuration = p.blend;
+            graph.conditions.insert(graph.conditions.end(), p.conditions.begin(), p.conditions.end());
+            graph.transitions.push_back(t);
+        }
+        graph.states[s].transitionCount =
+            static_cast<uint16_t>(graph.transitions.size() - graph.states[s].transitionFirst);
+    }
+
+    if (!defaultName.empty()) {
+        int def = FindName(graph.stateNames, defaultName);
+        if (def < 0) return Fail(error, lineNo, "unknown default state");
+        graph.defaultState = static_cast<uint16_t>(def);
+    }
+
+    *outGraph = std::move(graph);
+    return true;
+}
+
+bool LoadAnimGraph(const wchar_t* path, AnimGraph* outGraph, std::string* error) {
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return CompileAnimGraph(buffer.str(), outGraph, error);
+}
+
+void ResetAnimGraphInstance(const AnimGraph& graph, AnimGraphInstance* instance) {
+    *instance = AnimGraphInstance{};
+    instance->state = graph.defaultState;
+    instance->prevState = graph.defaultState;
+}
+
+void EvaluateAnimGraph(const AnimGraph& graph, AnimGraphInstance* instances, size_t count, float deltaTime) {
+    for (size_t i = 0; i < count; i++) {
+        AnimGraphInstance& inst = instances[i];
+
+        inst.stateTime += deltaTime;
+        inst.prevTime += deltaTime;
+        inst.blendTime += deltaTime;
+
+        const AnimState& state = graph.states[inst.state];
+        inst.frameIndex = FrameAt(graph.clips[state.clip], inst.stateTime, &inst.finished);
+        if (inst.blendTime < inst.blendDuration) {
+            bool prevFinished = false;
+            const AnimationData& prevClip = graph.clips[graph.states[inst.prevState].clip];
+            inst.prevFrameIndex = FrameAt(prevClip, inst.prevTime, &prevFinished);
+        }
+
+        // 最初に成立した遷移だけを適用する
+        const AnimTransition* first = graph.transitions.data() + state.transitionFirst;
+        for (uint16_t t = 0; t < state.transitionCount; t++) {
+            const AnimTransition& tr = first[t];
+            const AnimCondition* cond = graph.conditions.data() + tr.conditionFirst;
+            bool pass = true;
+            for (uint16_t c = 0; c < tr.conditionCount && pass; c++) {
+                pass = TestCondition(cond[c], inst);
+            }
+            if (!pass) continue;
+
+            inst.prevState = inst.state;
+            inst.prevTime = inst.stateTime;
+            inst.prevFrameIndex = inst.frameIndex;
+            inst.state = tr.target;
+            inst.stateTime = 0.0f;
+            inst.blendTime = 0.0f;
+            inst.blendDuration = tr.blendDuration;
+            inst.frameIndex = 0;
+            inst.finished = false;
+            break;
+        }
+    }
+}
+
+float GetAnimBlendWeight(const AnimGraphInstance& instance) {
+    if (instance.blendDuration <= 0.0f || instance.blendTime >= instance.blendDuration) return 1.0f;
+    return instance.blendTime / instance.blendDuration;
+}
+
+void GetAnimFrameUV(const AnimationData& clip, int frameIndex, float texOffset[2], float texScale[2]) {
+    float frameW = 1.0f / static_cast<float>(clip.columns);
+    float frameH = 1.0f / static_cast<float>(clip.rows);
+    int col = frameIndex % clip.columns;
+    int row = frameIndex / clip.columns;
+
+    texOffset[0] = static_cast<float>(col) * frameW;
+    texOffset[1] = static_cast<float>(row) * frameH;
+    texScale[0] = frameW;
+    texScale[1] = frameH;
+}
@@ -0,0 +1,104 @@
+﻿/**********************************************************************************
+    AnimationGraph.h
+
+                                                                LI WENHUI
+                                                                2025/08/12
+
+**********************************************************************************/
+
+#ifndef ANIMATIONGRAPH_H
+#define ANIMATIONGRAPH_H
+
+#include "AnimationData.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 1インスタンスが持てるパラメータ数（speed, grounded など）
+constexpr int kMaxAnimParams = 8;
+
+// 遷移条件の比較演算
+enum class AnimCompareOp : uint8_t {
+    Greater,
+    Less,
+    GreaterEqual,
+    LessEqual,
+    Equal,
+    NotEqual,
+    Finished    // 現在のクリップが最後まで再生された（ループしないクリップ用）
+};
+
+struct AnimCondition {
+    uint8_t param;
+    AnimCompareOp op;
+    float value;
+};
+
+// 遷移はソースステートごとにまとめて transitions に並べる
+struct AnimTransition {
+    uint16_t target;
+    uint16_t conditionFirst;
+    uint16_t conditionCount;
+    float blendDuration;    // クロスフェード秒数（0 なら即切り替え）
+};
+
+struct AnimState {
+    uint16_t clip;
+    uint16_t transitionFirst;
+    uint16_t transitionCount;
+};
+
+//
+// ロード時にコンパイル済みのフラットなテーブル。複数のインスタンスで共有する
+struct AnimGraph {
+    std::vector<std::string> paramNames;
+    std::vector<std::string> stateNames;
+    std::vector<std::string> clipNames;
+    std::vector<AnimationData> clips;
+    std::vector<AnimState> states;
+    std::vector<AnimTransition> transitions;
+    std::vector<AnimCondition> conditions;
+    uint16_t defaultState = 0;
+
+    int FindParam(const char* name) const;
+    int FindState(const char* name) const;
+};
+
+//
+// エンティティごとの再生状態。グラフ本体は持たない
+struct AnimGraphInstance {
+    float params[kMaxAnimParams] = {};
+    uint16_t state = 0;
+    uint16_t prevState = 0;
+    float stateTime = 0.0f;     // 現在ステートに入ってからの秒数
+    float prevTime = 0.0f;      // フェードアウト中のステートの秒数
+    float blendTime = 0.0f;
+    float blendDuration = 0.0f;
+    int frameIndex = 0;
+    int prevFrameIndex = 0;
+    bool finished = false;
+};
+
+//
+// テキスト形式のグラフ定義をパースしてテーブルにコンパイルする
+// 失敗した場合は false を返し、error に行番号付きの理由を入れる
+bool CompileAnimGraph(const std::string& source, AnimGraph* outGraph, std::string* error = nullptr);
+
+bool LoadAnimGraph(const wchar_t* path, AnimGraph* outGraph, std::string* error = nullptr);
+
+void ResetAnimGraphInstance(const AnimGraph& graph, AnimGraphInstance* instance);
+
+//
+// count 個のインスタンスをまとめて進め、条件を満たした遷移を 1 フレームに 1 つまで適用する
+void EvaluateAnimGraph(const AnimGraph& graph, AnimGraphInstance* instances, size_t count, float deltaTime);
+
+//
+// 現在ステートのブレンド重み（0..1）。1 ならフェード完了
+float GetAnimBlendWeight(const AnimGraphInstance& instance);
+
+//
+// クリップとフレーム番号からシート上の UV オフセット/スケールを求める
+void GetAnimFrameUV(const AnimationData& clip, int frameIndex, float texOffset[2], float texScale[2]);
+
+
+#endif
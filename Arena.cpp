@@ -0,0 +1,35 @@
+﻿/**********************************************************************************
+    Arena.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/31
+
+**********************************************************************************/
+
+#include "Arena.h"
+
+Arena::Arena(size_t capacity, MemoryTag tag)
+    : memory(new uint8_t[capacity])
+    , capacity(capacity)
+    , tracked(tag)
+{
+    tracked.Set(capacity);
+}
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(memory.get());
+    uintptr_t p = (base + used + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    size_t end = static_cast<size_t>(p - base) + size;
+    if (end > capacity) return nullptr;
+    used = end;
+    if (used > peak) peak = used;
+    return reinterpret_cast<void*>(p);
+}
+
+void Arena::Reset() {
+    used = 0;
+}
+
+size_t Arena::GetUsed() const { return used; }
+size_t Arena::GetCapacity() const { return capacity; }
+size_t Arena::GetPeak() const { return peak; }
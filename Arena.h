@@ -0,0 +1,60 @@
+﻿/**********************************************************************************
+    Arena.h
+
+                                                                LI WENHUI
+                                                                2025/08/31
+
+**********************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "ResourceRegistry.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+//
+// 先頭から順に切り出すだけのメモリ領域。個別の解放はなく、Reset でまとめて戻す
+// 1 つのアリーナは 1 スレッドからだけ使う
+class Arena {
+public:
+    // 確保した領域はまるごと tag に計上する
+    explicit Arena(size_t capacity, MemoryTag tag = MemoryTag::General);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // 足りなければ nullptr
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* AllocateArray(size_t count) {
+        return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // デストラクタは呼ばれないので、必要なら呼び出し側で明示的に
+    template <typename T, typename... Args>
+    T* New(Args&&... args) {
+        void* p = Allocate(sizeof(T), alignof(T));
+        return p ? new (p) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    void Reset();
+
+    size_t GetUsed() const;
+    size_t GetCapacity() const;
+    size_t GetPeak() const;
+
+private:
+    std::unique_ptr<uint8_t[]> memory;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t peak = 0;
+    TrackedMemory tracked;
+};
+
+
+#endif
@@ -0,0 +1,621 @@
+﻿/**********************************************************************************
+    AssetCooker.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "AssetCooker.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // 出力の形を変えたときに上げる（全部作り直しになる）
+    const uint32_t kCookerVersion = 1;
+    const uint32_t kCacheMagic = 0x4B4F4F43;       // "COOK"
+    // HashContent はこの大きさごとに区切ってつなぐ（HashFile が同じ値を少しずつ読んで出せるように）
+    const size_t kHashBlock = 4 << 20;
+
+    const uint64_t kPrime1 = 11400714785074694791ull;
+    const uint64_t kPrime2 = 14029467366897019727ull;
+    const uint64_t kPrime3 = 1609587929392839161ull;
+    const uint64_t kPrime4 = 9650029242287828579ull;
+    const uint64_t kPrime5 = 2870177450012600261ull;
+
+    inline uint64_t Rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t Read64(const uint8_t* p) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return v;
+    }
+
+    inline uint32_t Read32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return v;
+    }
+
+    inline uint64_t Round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        return Rotl(acc, 31) * kPrime1;
+    }
+
+    inline uint64_t MergeRound(uint64_t acc, uint64_t value) {
+        acc ^= Round(0, value);
+        return acc * kPrime1 + kPrime4;
+    }
+
+    // xxHash64 と同じ式（リトルエンディアン）
+    uint64_t HashBlock(const uint8_t* p, size_t size, uint64_t seed) {
+        const uint8_t* end = p + size;
+        uint64_t h;
+        if (size >= 32) {
+            uint64_t v1 = seed + kPrime1 + kPrime2;
+            uint64_t v2 = seed + kPrime2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - kPrime1;
+            const uint8_t* limit = end - 32;
+            do {
+                v1 = Round(v1, Read64(p));
+                v2 = Round(v2, Read64(p + 8));
+                v3 = Round(v3, Read64(p + 16));
+                v4 = Round(v4, Read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+            h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+            h = MergeRound(h, v1);
+            h = MergeRound(h, v2);
+            h = MergeRound(h, v3);
+            h = MergeRound(h, v4);
+        }
+        else {
+            h = seed + kPrime5;
+        }
+        h += static_cast<uint64_t>(size);
+
+        for (; p + 8 <= end; p += 8) {
+            h ^= Round(0, Read64(p));
+            h = Rotl(h, 27) * kPrime1 + kPrime4;
+        }
+        if (p + 4 <= end) {
+            h ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+            h = Rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        for (; p < end; p++) {
+            h ^= static_cast<uint64_t>(*p) * kPrime5;
+            h = Rotl(h, 11) * kPrime1;
+        }
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    bool ReadFileBytes(const fs::path& path, std::vector<uint8_t>* out) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+        std::streamoff size = file.tellg();
+        if (size < 0) return false;
+        out->resize(static_cast<size_t>(size));
+        file.seekg(0);
+        return size == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(out->data()), size));
+    }
+
+    std::string ToHex(uint64_t value) {
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+        return text;
+    }
+
+    bool WriteFileBytes(const fs::path& path, const uint8_t* data, size_t size) {
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        // 途中で止まっても壊れたファイルが残らないように、別の名前で書いてから置き換える
+        // 一時ファイルは書くたびに別の名前にする（同じ鍵を 2 か所から同時に書いても混ざらず、後に置き換えた方が残る）
+        uint64_t unique = std::hash<std::thread::id>()(std::this_thread::get_id());
+        unique = HashContent(&unique, sizeof(unique), static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()));
+        fs::path temp = path;
+        temp += "." + ToHex(unique) + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            if (size > 0 && !file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size))) return false;
+        }
+        fs::rename(temp, path, ec);
+        return !ec;
+    }
+
+    template <typename T>
+    void Put(std::vector<uint8_t>* out, T value) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        out->insert(out->end(), p, p + sizeof(T));
+    }
+
+    template <typename T>
+    bool Get(const std::vector<uint8_t>& in, size_t* pos, T* value) {
+        if (*pos + sizeof(T) > in.size()) return false;
+        std::memcpy(value, in.data() + *pos, sizeof(T));
+        *pos += sizeof(T);
+        return true;
+    }
+
+    // キャッシュの 1 件：依存の一覧（パスとハッシュ）と出力の中身
+    std::vector<uint8_t> EncodeCacheEntry(const std::vector<CookDependency>& dependencies, const std::vector<uint8_t>& output) {
+        std::vector<uint8_t> out;
+        out.reserve(output.size() + 64);
+        Put(&out, kCacheMagic);
+        Put(&out, static_cast<uint32_t>(dependencies.size()));
+        for (const CookDependency& dep : dependencies) {
+            Put(&out, static_cast<uint32_t>(dep.path.size()));
+            out.insert(out.end(), dep.path.begin(), dep.path.end());
+            Put(&out, dep.hash);
+        }
+        Put(&out, static_cast<uint64_t>(output.size()));
+        out.insert(out.end(), output.begin(), output.end());
+        return out;
+    }
+
+    bool DecodeCacheEntry(const std::vector<uint8_t>& in, std::vector<CookDependency>* dependencies, std::vector<uint8_t>* output) {
+        size_t pos = 0;
+        uint32_t magic = 0, count = 0;
+        if (!Get(in, &pos, &magic) || magic != kCacheMagic || !Get(in, &pos, &count)) return false;
+        dependencies->resize(count);
+        for (CookDependency& dep : *dependencies) {
+            uint32_t length = 0;
+            if (!Get(in, &pos, &length) || pos + length > in.size()) return false;
+            dep.path.assign(reinterpret_cast<const char*>(in.data() + pos), length);
+            pos += length;
+            if (!Get(in, &pos, &dep.hash)) return false;
+        }
+        uint64_t size = 0;
+        if (!Get(in, &pos, &size) || pos + size != in.size()) return false;
+        output->assign(in.begin() + static_cast<std::ptrdiff_t>(pos), in.end());
+        return true;
+    }
+
+    bool StatFile(const fs::path& path, uint64_t* size, int64_t* time) {
+        std::error_code ec;
+        *size = fs::file_size(path, ec);
+        if (ec) return false;
+        *time = static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+        return !ec;
+    }
+
+    std::string ToLower(std::string s) {
+        for (char& c : s) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return s;
+    }
+
+    // 作り直すソース 1 件分の作業と結果
+    struct CookTask {
+        size_t source;
+        uint64_t key;
+        std::vector<CookDependency> dependencies;
+        bool fromCache = false;
+        bool ok = false;
+        std::string error;
+    };
+}
+
+
+bool CookInput::ReadDependency(const std::string& relativePath, std::vector<uint8_t>* out) const {
+    bool found = ReadFileBytes(root / fs::u8path(relativePath), out);
+    if (!found) out->clear();
+    if (dependencies) {
+        dependencies->push_back({ relativePath, found ? HashContent(out->data(), out->size()) : 0 });
+    }
+    return found;
+}
+
+
+AssetCooker::AssetCooker(const AssetCookerDesc& desc)
+    : desc(desc)
+{
+
+}
+
+void AssetCooker::AddRule(const CookRule& rule) {
+    rules.push_back(rule);
+    rules.back().extension = ToLower(rule.extension);
+}
+
+uint64_t AssetCooker::GetKey(const CookRule& rule, const std::string& path, uint64_t sourceHash) const {
+    uint64_t key = HashContent(&kCookerVersion, sizeof(kCookerVersion));
+    key = HashContent(rule.name.data(), rule.name.size(), key);
+    key = HashContent(&rule.version, sizeof(rule.version), key);
+    key = HashContent(rule.settings.data(), rule.settings.size(), key);
+    key = HashContent(path.data(), path.size(), key);
+    return HashContent(&sourceHash, sizeof(sourceHash), key);
+}
+
+fs::path AssetCooker::GetOutputPath(const CookRule& rule, const std::string& path) const {
+    fs::path out = desc.outputDir / fs::u8path(path);
+    if (!rule.outputExtension.empty()) out.replace_extension(rule.outputExtension);
+    return out;
+}
+
+fs::path AssetCooker::GetCachePath(uint64_t key) const {
+    // 1 つのディレクトリにファイルが増えすぎないように、先頭 2 文字で分ける
+    std::string name = ToHex(key);
+    return desc.cacheDir / name.substr(0, 2) / (name + ".bin");
+}
+
+bool AssetCooker::LoadDatabase() {
+    files.clear();
+    outputs.clear();
+    std::ifstream file(desc.cacheDir / "cook.db", std::ios::binary);
+    if (!file) return false;
+
+    // F <size> <time> <hash> <path>       ファイルの状態
+    // O <key> <rule> <count> <path>       出力。続く count 行が D <hash> <path>
+    std::string line;
+    if (!std::getline(file, line) || line != "cookdb " + std::to_string(kCookerVersion)) return false;
+    OutputRecord* record = nullptr;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string type;
+        in >> type;
+        if (type == "F") {
+            FileState state;
+            std::string hash;
+            in >> state.size >> state.time >> hash;
+            in.get();
+            std::string path;
+            std::getline(in, path);
+            state.hash = std::strtoull(hash.c_str(), nullptr, 16);
+            files[path] = state;
+        }
+        else if (type == "O") {
+            std::string key, rule;
+            size_t count = 0;
+            in >> key >> rule >> count;
+            in.get();
+            std::string path;
+            std::getline(in, path);
+            record = &outputs[path];
+            record->rule = rule;
+            record->key = std::strtoull(key.c_str(), nullptr, 16);
+            record->dependencies.clear();
+            record->dependencies.reserve(count);
+        }
+        else if (type == "D" && record) {
+            std::string hash;
+            in >> hash;
+            in.get();
+            CookDependency dep;
+            std::getline(in, dep.path);
+            dep.hash = std::strtoull(hash.c_str(), nullptr, 16);
+            record->dependencies.push_back(dep);
+        }
+    }
+    return true;
+}
+
+bool AssetCooker::SaveDatabase() const {
+    std::string text = "cookdb " + std::to_string(kCookerVersion) + "\n";
+    for (const auto& file : files) {
+        text += "F " + std::to_string(file.second.size) + " " + std::to_string(file.second.time) + " " +
+            ToHex(file.second.hash) + " " + file.first + "\n";
+    }
+    for (const auto& output : outputs) {
+        text += "O " + ToHex(output.second.key) + " " + output.second.rule + " " +
+            std::to_string(output.second.dependencies.size()) + " " + output.first + "\n";
+        for (const CookDependency& dep : output.second.dependencies) {
+            text += "D " + ToHex(dep.hash) + " " + dep.path + "\n";
+        }
+    }
+    return WriteFileBytes(desc.cacheDir / "cook.db", reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+bool AssetCooker::Run(CookStats* stats, std::string* log) {
+    PROFILE_ZONE("AssetCooker::Run");
+    auto start = std::chrono::steady_clock::now();
+    *stats = CookStats();
+    LoadDatabase();
+
+    // 1. ソースを集める（規則のある拡張子だけ）
+    struct Source {
+        std::string path;
+        size_t rule;
+        uint64_t size;
+        int64_t time;
+    };
+    std::vector<Source> sources;
+    {
+        PROFILE_ZONE("AssetCooker::Scan");
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(desc.sourceDir, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec)) continue;
+            std::string extension = ToLower(it->path().extension().u8string());
+            for (size_t r = 0; r < rules.size(); r++) {
+                if (rules[r].extension != extension) continue;
+                // 大きさと更新時刻はディレクトリを読んだときのもの（Windows ではもう一度ファイルを開かずに済む）
+                Source source;
+                source.path = fs::relative(it->path(), desc.sourceDir, ec).generic_u8string();
+                source.rule = r;
+                source.size = it->file_size(ec);
+                source.time = static_cast<int64_t>(it->last_write_time(ec).time_since_epoch().count());
+                sources.push_back(source);
+                break;
+            }
+        }
+        if (ec) {
+            *log += "cook: cannot scan " + desc.sourceDir.u8string() + "\n";
+            return false;
+        }
+        std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.path < b.path; });
+    }
+    stats->sources = sources.size();
+
+    // 2. ソースと前回の依存の中身のハッシュ。大きさと更新時刻が同じなら読まない
+    std::unordered_map<std::string, FileState> current;
+    {
+        PROFILE_ZONE("AssetCooker::Hash");
+        std::vector<std::string> dirty;
+        auto check = [&](const std::string& path, FileState state) {
+            auto previous = files.find(path);
+            bool same = previous != files.end() && previous->second.size == state.size && previous->second.time == state.time;
+            state.hash = same ? previous->second.hash : 0;
+            current.emplace(path, state);
+            if (!same) dirty.push_back(path);
+        };
+        for (const Source& source : sources) {
+            FileState state;
+            state.size = source.size;
+            state.time = source.time;
+            check(source.path, state);
+        }
+        for (const Source& source : sources) {
+            auto record = outputs.find(source.path);
+            if (record == outputs.end()) continue;
+            for (const CookDependency& dep : record->second.dependencies) {
+                if (current.count(dep.path)) continue;
+                FileState state;
+                if (StatFile(desc.sourceDir / fs::u8path(dep.path), &state.size, &state.time)) check(dep.path, state);  // ない依存は 0 のまま
+            }
+        }
+
+        // 中身を読むのは変わったものだけ。ファイルごとに並列
+        std::vector<uint64_t> hashes(dirty.size());
+        auto job = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) hashes[i] = HashFile(desc.sourceDir / fs::u8path(dirty[i]));
+        };
+        if (desc.jobs) desc.jobs->ParallelFor(dirty.size(), 1, job);
+        else job(0, dirty.size());
+        for (size_t i = 0; i < dirty.size(); i++) {
+            FileState& state = current[dirty[i]];
+            state.hash = hashes[i];
+            stats->hashedBytes += state.size;
+        }
+        stats->hashed = dirty.size();
+    }
+    auto currentHash = [&current](const std::string& path) -> uint64_t {
+        auto it = current.find(path);
+        return it != current.end() ? it->second.hash : 0;
+    };
+
+    // 3. 前回と同じ鍵で、依存も変わらず、出力が残っていれば何もしない
+    std::vector<CookTask> tasks;
+    for (size_t i = 0; i < sources.size(); i++) {
+        const Source& source = sources[i];
+        const CookRule& rule = rules[source.rule];
+        uint64_t key = GetKey(rule, source.path, currentHash(source.path));
+        auto record = outputs.find(source.path);
+        bool upToDate = record != outputs.end() && record->second.key == key && record->second.rule == rule.name;
+        if (upToDate) {
+            for (const CookDependency& dep : record->second.dependencies) {
+                if (currentHash(dep.path) != dep.hash) { upToDate = false; break; }
+            }
+        }
+        std::error_code ec;
+        if (upToDate && fs::exists(GetOutputPath(rule, source.path), ec)) {
+            stats->upToDate++;
+            continue;
+        }
+        CookTask task;
+        task.source = i;
+        task.key = key;
+        tasks.push_back(std::move(task));
+    }
+
+    // 4. 作り直す。キャッシュに同じ鍵があって依存も同じなら取り出し、なければ変換してキャッシュにも残す
+    // current は読むだけなので、ここでは触らない（前回の一覧にない依存はその場でハッシュする）
+    auto cookJob = [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            PROFILE_ZONE("AssetCooker::Cook");
+            CookTask& task = tasks[t];
+            const Source& source = sources[task.source];
+            const CookRule& rule = rules[source.rule];
+            fs::path outputPath = GetOutputPath(rule, source.path);
+            fs::path cachePath = GetCachePath(task.key);
+
+            std::vector<uint8_t> cached;
+            std::vector<uint8_t> output;
+            if (ReadFileBytes(cachePath, &cached) && DecodeCacheEntry(cached, &task.dependencies, &output)) {
+                bool valid = true;
+                for (const CookDependency& dep : task.dependencies) {
+                    auto it = current.find(dep.path);
+                    uint64_t hash = it != current.end() ? it->second.hash : HashFile(desc.sourceDir / fs::u8path(dep.path));
+                    if (hash != dep.hash) { valid = false; break; }
+                }
+                if (valid) {
+                    task.fromCache = true;
+                    task.ok = WriteFileBytes(outputPath, output.data(), output.size());
+                    if (!task.ok) task.error = "cannot write output";
+                    continue;
+                }
+            }
+
+            CookInput input;
+            input.path = source.path;
+            input.root = desc.sourceDir;
+            input.dependencies = &task.dependencies;
+            task.dependencies.clear();
+            output.clear();
+            if (!ReadFileBytes(desc.sourceDir / fs::u8path(source.path), &input.bytes)) {
+                task.error = "cannot read source";
+                continue;
+            }
+            if (!rule.cook(input, &output, &task.error)) continue;
+            if (!WriteFileBytes(outputPath, output.data(), output.size())) {
+                task.error = "cannot write output";
+                continue;
+            }
+            // キャッシュに書けなくても出力はできているので失敗にはしない
+            std::vector<uint8_t> entry = EncodeCacheEntry(task.dependencies, output);
+            WriteFileBytes(cachePath, entry.data(), entry.size());
+            task.ok = true;
+        }
+    };
+    if (desc.jobs) desc.jobs->ParallelFor(tasks.size(), 1, cookJob);
+    else cookJob(0, tasks.size());
+
+    bool ok = true;
+    for (CookTask& task : tasks) {
+        const Source& source = sources[task.source];
+        if (!task.ok) {
+            stats->failed++;
+            ok = false;
+            *log += "cook: " + source.path + ": " + task.error + "\n";
+            // 次も作り直すように記録を消す
+            outputs.erase(source.path);
+            continue;
+        }
+        if (task.fromCache) stats->cacheHits++;
+        else stats->cooked++;
+        OutputRecord& record = outputs[source.path];
+        record.rule = rules[source.rule].name;
+        record.key = task.key;
+        record.dependencies = std::move(task.dependencies);
+        // 前回の一覧になかった依存も次からは大きさと更新時刻で見る
+        for (const CookDependency& dep : record.dependencies) {
+            if (current.count(dep.path)) continue;
+            FileState state;
+            if (!StatFile(desc.sourceDir / fs::u8path(dep.path), &state.size, &state.time)) continue;
+            state.hash = dep.hash;
+            current.emplace(dep.path, state);
+        }
+    }
+
+    // 5. ソースがなくなった出力を消す
+    std::unordered_map<std::string, size_t> sourceIndex;
+    for (size_t i = 0; i < sources.size(); i++) sourceIndex[sources[i].path] = i;
+    for (auto it = outputs.begin(); it != outputs.end();) {
+        if (sourceIndex.count(it->first)) {
+            ++it;
+            continue;
+        }
+        for (const CookRule& rule : rules) {
+            if (rule.name != it->second.rule) continue;
+            std::error_code ec;
+            if (fs::remove(GetOutputPath(rule, it->first), ec)) stats->removed++;
+            break;
+        }
+        it = outputs.erase(it);
+    }
+
+    files = std::move(current);
+    if (!SaveDatabase()) {
+        *log += "cook: cannot write " + (desc.cacheDir / "cook.db").u8string() + "\n";
+        ok = false;
+    }
+
+    stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    char summary[256];
+    std::snprintf(summary, sizeof(summary),
+        "cook: %zu sources, %zu up to date, %zu from cache, %zu cooked, %zu failed, %zu removed, hashed %zu files (%.1f MB) in %.3f s\n",
+        stats->sources, stats->upToDate, stats->cacheHits, stats->cooked, stats->failed, stats->removed, stats->hashed,
+        static_cast<double>(stats->hashedBytes) / (1024.0 * 1024.0), stats->seconds);
+    *log += summary;
+    return ok;
+}
+
+
+uint64_t HashContent(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    size_t pos = 0;
+    do {
+        size_t block = std::min(size - pos, kHashBlock);
+        hash = HashBlock(bytes + pos, block, hash);
+        pos += block;
+    } while (pos < size);
+    return hash;
+}
+
+uint64_t HashFile(const fs::path& path, uint64_t* outSize) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return 0;
+    // 4MB をファイルごとに確保し直さないように、スレッドごとに使い回す
+    thread_local std::vector<uint8_t> block(kHashBlock);
+    uint64_t hash = 0;
+    uint64_t total = 0;
+    do {
+        file.read(reinterpret_cast<char*>(block.data()), static_cast<std::streamsize>(block.size()));
+        size_t read = static_cast<size_t>(file.gcount());
+        // 空のファイルも 1 ブロックとして数える（HashContent と同じ）
+        if (read == 0 && total > 0) break;
+        hash = HashBlock(block.data(), read, hash);
+        total += read;
+    } while (file && static_cast<size_t>(file.gcount()) == block.size());
+    if (outSize) *outSize = total;
+    return hash;
+}
+
+CookRule MakeCopyRule(const std::string& extension) {
+    CookRule rule;
+    rule.name = "copy";
+    rule.extension = extension;
+    rule.cook = [](const CookInput& input, std::vector<uint8_t>* output, std::string* error) {
+        (void)error;
+        *output = input.bytes;
+        return true;
+    };
+    return rule;
+}
+
+int RunAssetCooker(const std::vector<std::wstring>& args, const std::vector<CookRule>& rules, std::string* log) {
+    AssetCookerDesc desc;
+    bool cook = false;
+    unsigned threads = 0;
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        const std::wstring& key = args[i];
+        const std::wstring& value = args[i + 1];
+        if (key == L"-cook") { desc.sourceDir = value; cook = true; }
+        else if (key == L"-cook-out") desc.outputDir = value;
+        else if (key == L"-cook-cache") desc.cacheDir = value;
+        else if (key == L"-threads") threads = static_cast<unsigned>(std::wcstoul(value.c_str(), nullptr, 10));
+        else continue;
+        i++;
+    }
+    if (!cook) return -1;
+
+    // 呼び出しスレッドも手伝うので、ワーカーは 1 つ少なく
+    JobSystem jobs(threads > 1 ? threads - 1 : 0);
+    desc.jobs = threads == 1 ? nullptr : &jobs;
+    AssetCooker cooker(desc);
+    for (const CookRule& rule : rules) cooker.AddRule(rule);
+    CookStats stats;
+    return cooker.Run(&stats, log) ? 0 : 1;
+}
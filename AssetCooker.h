@@ -0,0 +1,125 @@
+﻿/**********************************************************************************
+    AssetCooker.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef ASSETCOOKER_H
+#define ASSETCOOKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+// 変換中に読んだファイル。hash は HashContent（ないファイルは 0）
+struct CookDependency {
+    std::string path;       // ソースのルートからの相対パス（'/' 区切り）
+    uint64_t hash = 0;
+};
+
+// 変換 1 回分の入力。ReadDependency で読んだファイルは依存として記録され、中身が変わると作り直しになる
+struct CookInput {
+    std::string path;
+    std::vector<uint8_t> bytes;
+    std::filesystem::path root;
+    std::vector<CookDependency>* dependencies = nullptr;
+
+    // ないファイルも「ない」という依存として記録する（後から作れば作り直しになる）
+    bool ReadDependency(const std::string& relativePath, std::vector<uint8_t>* out) const;
+};
+
+using CookFunction = std::function<bool(const CookInput& input, std::vector<uint8_t>* output, std::string* error)>;
+
+// 拡張子ごとの変換。version か settings を変えると、その規則の出力は全部作り直しになる
+// cook は複数のスレッドから同時に呼ばれる
+struct CookRule {
+    std::string name;
+    std::string extension;          // 小文字、"." つき
+    std::string outputExtension;    // 空なら同じ拡張子
+    uint32_t version = 1;
+    std::string settings;
+    CookFunction cook;
+};
+
+struct AssetCookerDesc {
+    std::filesystem::path sourceDir = "assets";
+    std::filesystem::path outputDir = "cooked";
+    // 変換結果のキャッシュと、前回の状態（cook.db）を置く。消しても全部作り直しになるだけ
+    std::filesystem::path cacheDir = ".cookcache";
+    JobSystem* jobs = nullptr;      // なければ 1 スレッド
+};
+
+struct CookStats {
+    size_t sources = 0;
+    size_t hashed = 0;              // 大きさか更新時刻が変わって中身を読み直したファイル
+    uint64_t hashedBytes = 0;
+    size_t upToDate = 0;
+    size_t cacheHits = 0;           // 出力はなかったが、キャッシュに同じ入力の結果があった
+    size_t cooked = 0;
+    size_t failed = 0;
+    size_t removed = 0;             // ソースがなくなった出力
+    double seconds = 0.0;
+};
+
+//
+// assets/ のような元のファイルを変換して出力のディレクトリに置く。変わったものだけを作り直す
+// 出力は（規則の名前・version・settings・ソースのパスと中身のハッシュ）と、変換中に読んだファイルの中身のハッシュで決まる
+// パスも鍵に入れるのは、依存（foo.png.prep など）がソースのパスから決まるから（中身が同じでも設定が違うことがある）
+// 中身のハッシュは大きさと更新時刻が前回と同じなら前回の値を使うので、何も変わっていなければファイルは読まない
+// 作り直すものはジョブで並列に変換し、結果はキャッシュにも残す（ブランチを戻したときなどは変換せずに取り出す）
+class AssetCooker {
+public:
+    explicit AssetCooker(const AssetCookerDesc& desc);
+
+    void AddRule(const CookRule& rule);
+
+    // 1 回分。失敗したソースがあれば false（ほかは最後まで続ける）。log には失敗したものと要約が入る
+    bool Run(CookStats* stats, std::string* log);
+
+private:
+    struct FileState {
+        uint64_t size = 0;
+        int64_t time = 0;
+        uint64_t hash = 0;
+    };
+
+    struct OutputRecord {
+        std::string rule;
+        uint64_t key = 0;
+        std::vector<CookDependency> dependencies;
+    };
+
+    bool LoadDatabase();
+    bool SaveDatabase() const;
+    uint64_t GetKey(const CookRule& rule, const std::string& path, uint64_t sourceHash) const;
+    std::filesystem::path GetOutputPath(const CookRule& rule, const std::string& path) const;
+    std::filesystem::path GetCachePath(uint64_t key) const;
+
+    AssetCookerDesc desc;
+    std::vector<CookRule> rules;
+    std::unordered_map<std::string, FileState> files;          // 前回の大きさ・更新時刻と中身のハッシュ
+    std::unordered_map<std::string, OutputRecord> outputs;     // ソースごとの前回の出力
+};
+
+// 大きなファイル向けの 64bit ハッシュ（8 バイトずつ 4 本並行に混ぜる。FNV の HashBytes より速い）
+uint64_t HashContent(const void* data, size_t size, uint64_t seed = 0);
+// ファイルを少しずつ読んで HashContent と同じ値を出す。なければ 0
+uint64_t HashFile(const std::filesystem::path& path, uint64_t* outSize = nullptr);
+
+// そのまま書き出すだけの規則（マップやアニメーショングラフ）
+CookRule MakeCopyRule(const std::string& extension);
+
+// -cook <dir> があれば変換だけして終わる。なければ -1
+//   -cook-out <dir> -cook-cache <dir> -threads <n>
+int RunAssetCooker(const std::vector<std::wstring>& args, const std::vector<CookRule>& rules, std::string* log);
+
+
+#endif
@@ -0,0 +1,174 @@
+﻿/**********************************************************************************
+    BatchSimulation.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/31
+
+**********************************************************************************/
+
+#include "BatchSimulation.h"
+#include "GameWorld.h"
+#include "Arena.h"
+#include "InputSystem.h"
+#include "JobSystem.h"
+#include "TileMap.h"
+#include "FlowField.h"
+#include "CharacterController.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+    uint32_t NextRandom(uint32_t* state) {
+        uint32_t x = *state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        *state = x;
+        return x;
+    }
+
+    // 左右どちらか（または止まる）を 0.25 〜 1.5 秒押し続け、ときどき跳ぶだけのボット
+    // frames には tick ごとに期待する入力、events には同じ変化をその tick の途中の時刻で入れる
+    void GenerateBotInput(uint32_t seed, float fixedStep, InputFrame* frames, uint32_t count, std::vector<InputEvent>* events) {
+        const int64_t stepNs = std::llround(static_cast<double>(fixedStep) * 1e9);
+        events->clear();
+        uint32_t rng = seed * 2654435761u + 1;
+        uint8_t held = 0;
+        uint32_t holdTicks = 0;
+        for (uint32_t t = 0; t < count; t++) {
+            uint8_t next = held;
+            if (holdTicks == 0) {
+                uint32_t r = NextRandom(&rng);
+                next = 0;
+                if (r % 5 < 2) next |= 1u << static_cast<int>(InputAction::Right);
+                else if (r % 5 < 4) next |= 1u << static_cast<int>(InputAction::Left);
+                float seconds = 0.25f + static_cast<float>(NextRandom(&rng) % 1000) * 0.00125f;
+                holdTicks = static_cast<uint32_t>(seconds / fixedStep) + 1;
+            }
+            holdTicks--;
+
+            next &= static_cast<uint8_t>(~(1u << static_cast<int>(InputAction::Jump)));
+            if (NextRandom(&rng) % 90 == 0) next |= 1u << static_cast<int>(InputAction::Jump);
+
+            frames[t].held = next;
+            frames[t].pressed = static_cast<uint8_t>(next & ~held);
+            frames[t].firstEventTime = 0;
+            for (int a = 0; a < static_cast<int>(InputAction::Count); a++) {
+                if (((next ^ held) >> a) & 1) {
+                    events->push_back({ static_cast<int64_t>(t) * stepNs + stepNs / 2, static_cast<InputAction>(a), ((next >> a) & 1) != 0 });
+                }
+            }
+            held = next;
+        }
+    }
+
+    bool PlayerCaught(const GameWorld& world) {
+        Aabb player = world.characters->GetBounds(world.playerBody);
+        for (const ChaseAgent& chaser : world.chasers) {
+            if (AabbOverlap(player, world.characters->GetBounds(chaser.body))) return true;
+        }
+        return false;
+    }
+}
+
+
+bool RunBatch(const std::vector<std::string>& maps, const GameWorldDesc& world, const BatchDesc& desc,
+    BatchResult* out, std::string* error) {
+
+    if (maps.empty() || desc.instances == 0) {
+        if (error) *error = "nothing to run";
+        return false;
+    }
+    // 先に全部のマップを一度読んでおき、ワーカーの中では失敗しないようにする
+    for (const std::string& text : maps) {
+        TileMap check;
+        if (!check.ParseText(text, world.tileSize, error)) return false;
+    }
+
+    unsigned threads = desc.threads ? desc.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, desc.instances));
+
+    out->instances.assign(desc.instances, BatchInstanceResult());
+    out->threads = threads;
+
+    // インスタンスの中ではジョブを使わず、1 インスタンス = 1 スレッドで最後まで進める
+    // 入力はゲームのループと同じく ScriptedInputSource → InputSystem を tick ごとに Pump / Consume して作り、
+    // 期待した tick に届いたかを GenerateBotInput の frames と比べる
+    // GameWorld の中身（TileMap・FlowField・CharacterController）はゲームと同じくそれぞれの std::vector がヒープに確保する
+    // どれも同じスレッドで確保して触るので、ほかのスレッドとは混ざらない
+    // Arena に置くのは期待する入力の列だけ。大きさは ticks から決め、同じ範囲のインスタンスでは Reset して使い回す
+    const size_t inputBytes = sizeof(InputFrame) * desc.ticks;
+    auto runInstance = [&](size_t begin, size_t end) {
+        Arena arena(inputBytes + alignof(InputFrame), MemoryTag::World);
+        for (size_t i = begin; i < end; i++) {
+            BatchInstanceResult& result = out->instances[i];
+            result.seed = desc.seed + static_cast<uint32_t>(i);
+
+            arena.Reset();
+            InputFrame* frames = arena.AllocateArray<InputFrame>(desc.ticks);
+            GameWorld instance;
+            std::vector<InputEvent> events;
+            GenerateBotInput(result.seed, desc.fixedStep, frames, desc.ticks, &events);
+            ScriptedInputSource script;
+            script.SetEvents(events);
+            InputSystem input;
+            input.AddSource(&script);
+            const int64_t stepNs = std::llround(static_cast<double>(desc.fixedStep) * 1e9);
+
+            GameWorldDesc worldDesc = world;
+            worldDesc.seed = result.seed;
+            InitGameWorld(&instance, maps[i % maps.size()], worldDesc, nullptr);
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (uint32_t t = 0; t < desc.ticks; t++) {
+                int64_t tickEnd = static_cast<int64_t>(t + 1) * stepNs;
+                input.Pump(tickEnd);
+                InputFrame frame = input.Consume(tickEnd);
+                if (frame.held != frames[t].held || frame.pressed != frames[t].pressed) result.inputMismatches++;
+                StepGameWorld(&instance, frame, desc.fixedStep, nullptr);
+                if (result.caughtTick < 0 && PlayerCaught(instance)) result.caughtTick = static_cast<int>(t);
+            }
+            auto t1 = std::chrono::steady_clock::now();
+
+            result.ticks = desc.ticks;
+            result.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            result.finalHash = HashGameWorld(instance);
+            result.playerX = instance.characters->GetX(instance.playerBody);
+            result.inputBytes = inputBytes;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    if (threads > 1) {
+        JobSystem jobs(threads - 1);    // 呼び出しスレッドも 1 本として数える
+        jobs.ParallelFor(desc.instances, 1, runInstance);
+    }
+    else {
+        runInstance(0, desc.instances);
+    }
+    out->wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double totalTicks = static_cast<double>(desc.ticks) * static_cast<double>(desc.instances);
+    double seconds = out->wallMs * 0.001;
+    out->ticksPerSecond = seconds > 0.0 ? totalTicks / seconds : 0.0;
+    out->ticksPerSecondPerCore = out->ticksPerSecond / static_cast<double>(threads);
+    return true;
+}
+
+bool WriteBatchResults(const wchar_t* path, const BatchResult& result) {
+    std::ofstream file{ std::filesystem::path(path) };
+    if (!file) return false;
+    file << "instance,seed,ticks,ms,ticksPerSecond,caughtTick,playerX,inputBytes,inputMismatches,hash\n";
+    for (size_t i = 0; i < result.instances.size(); i++) {
+        const BatchInstanceResult& r = result.instances[i];
+        double tps = r.ms > 0.0 ? static_cast<double>(r.ticks) * 1000.0 / r.ms : 0.0;
+        file << i << ',' << r.seed << ',' << r.ticks << ',' << r.ms << ',' << tps << ','
+            << r.caughtTick << ',' << r.playerX << ',' << r.inputBytes << ',' << r.inputMismatches << ',' << std::hex << r.finalHash << std::dec << '\n';
+    }
+    return static_cast<bool>(file);
+}
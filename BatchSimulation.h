@@ -0,0 +1,56 @@
+﻿/**********************************************************************************
+    BatchSimulation.h
+
+                                                                LI WENHUI
+                                                                2025/08/31
+
+**********************************************************************************/
+
+#ifndef BATCHSIMULATION_H
+#define BATCHSIMULATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GameWorldDesc;
+
+struct BatchDesc {
+    uint32_t instances = 64;
+    uint32_t ticks = 120 * 60;          // 1 インスタンスあたり（120Hz で 1 分）
+    float fixedStep = 1.0f / 120.0f;
+    uint32_t seed = 1;                  // インスタンス i は seed + i（ボットの入力とワールドの seed）
+    unsigned threads = 0;               // 0 ならハードウェアスレッド数
+};
+
+struct BatchInstanceResult {
+    uint32_t seed = 0;
+    uint32_t ticks = 0;
+    uint64_t finalHash = 0;
+    int caughtTick = -1;                // 追跡者に初めて触れた tick（なければ -1）
+    float playerX = 0.0f;
+    double ms = 0.0;
+    size_t inputBytes = 0;              // ボットの入力の列（ticks 分）
+    uint32_t inputMismatches = 0;       // ScriptedInputSource からの入力が期待した tick に届かなかった数（0 のはず）
+};
+
+struct BatchResult {
+    std::vector<BatchInstanceResult> instances;
+    unsigned threads = 0;
+    double wallMs = 0.0;
+    double ticksPerSecond = 0.0;        // 全体
+    double ticksPerSecondPerCore = 0.0;
+};
+
+//
+// ウィンドウもデバイスもなしで GameWorld を instances 個、スレッドに分けて最大速度で進める
+// 入力は seed から作るボットのイベントで、ScriptedInputSource と InputSystem を通して tick に割り振る
+// インスタンス i は maps[i % maps.size()] を使う（生成したレベルの検証など）
+bool RunBatch(const std::vector<std::string>& maps, const GameWorldDesc& world, const BatchDesc& desc,
+    BatchResult* out, std::string* error = nullptr);
+
+bool WriteBatchResults(const wchar_t* path, const BatchResult& result);
+
+
+#endif
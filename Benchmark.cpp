@@ -0,0 +1,165 @@
+﻿/**********************************************************************************
+    Benchmark.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/03
+
+**********************************************************************************/
+
+#include "Benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+namespace {
+
+    std::atomic<uint64_t> keepSink{ 0 };
+
+    // 両側 95% の t 値（自由度 1..30）。それより大きければ正規分布で近似
+    const double kStudentT95[30] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+
+    double StudentT95(size_t degrees) {
+        if (degrees == 0) return 0.0;
+        return degrees <= 30 ? kStudentT95[degrees - 1] : 1.96;
+    }
+
+    double TimeIterations(const BenchmarkCase& c, uint64_t iterations) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++) c.run();
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(t1 - t0).count();
+    }
+
+    void WriteEscaped(std::ofstream& file, const std::string& text) {
+        for (char ch : text) {
+            if (ch == '"' || ch == '\\') file << '\\';
+            file << ch;
+        }
+    }
+}
+
+
+void BenchmarkKeep(uint64_t value) {
+    keepSink.fetch_xor(value, std::memory_order_relaxed);
+}
+
+void BenchmarkKeep(const void* pointer) {
+    keepSink.fetch_xor(reinterpret_cast<uintptr_t>(pointer), std::memory_order_relaxed);
+}
+
+void ComputeBenchmarkStats(std::vector<double>* samples, BenchmarkResult* result) {
+    size_t n = samples->size();
+    result->repetitions = static_cast<int>(n);
+    if (n == 0) return;
+
+    std::sort(samples->begin(), samples->end());
+    double sum = 0.0;
+    for (double s : *samples) sum += s;
+    double mean = sum / static_cast<double>(n);
+    double squares = 0.0;
+    for (double s : *samples) squares += (s - mean) * (s - mean);
+
+    result->mean = mean;
+    result->median = n % 2 ? (*samples)[n / 2] : ((*samples)[n / 2 - 1] + (*samples)[n / 2]) * 0.5;
+    result->min = samples->front();
+    result->max = samples->back();
+    result->stddev = n > 1 ? std::sqrt(squares / static_cast<double>(n - 1)) : 0.0;
+    double half = StudentT95(n - 1) * result->stddev / std::sqrt(static_cast<double>(n));
+    result->ciLow = mean - half;
+    result->ciHigh = mean + half;
+    result->itemsPerSecond = result->items && mean > 0.0 ? static_cast<double>(result->items) * 1e9 / mean : 0.0;
+}
+
+void RunBenchmarks(const std::vector<BenchmarkCase>& cases, const BenchmarkOptions& options,
+    std::vector<BenchmarkResult>* out, const std::function<void(const BenchmarkResult&)>& progress) {
+
+    const double minNs = options.minRepetitionMs * 1e6;
+    for (const BenchmarkCase& c : cases) {
+        if (!options.filter.empty() && c.name.find(options.filter) == std::string::npos) continue;
+        if (c.setup) c.setup();
+
+        // 1 回の繰り返しが短すぎると時計の分解能に埋もれるので、回数を増やしていく
+        uint64_t iterations = 1;
+        for (;;) {
+            double ns = TimeIterations(c, iterations);
+            if (ns >= minNs || iterations >= (uint64_t(1) << 30)) break;
+            // 目標までの比で一気に増やす（ただし 1 回で 10 倍まで）
+            double scale = ns > 0.0 ? minNs * 1.2 / ns : 10.0;
+            scale = std::min(std::max(scale, 2.0), 10.0);
+            iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+        }
+
+        for (int i = 0; i < options.warmup; i++) TimeIterations(c, iterations);
+
+        std::vector<double> samples;
+        samples.reserve(static_cast<size_t>(std::max(options.repetitions, 1)));
+        for (int i = 0; i < std::max(options.repetitions, 1); i++) {
+            samples.push_back(TimeIterations(c, iterations) / static_cast<double>(iterations));
+        }
+
+        BenchmarkResult result;
+        result.name = c.name;
+        result.items = c.items;
+        result.iterations = iterations;
+        ComputeBenchmarkStats(&samples, &result);
+        if (c.teardown) c.teardown();
+        out->push_back(result);
+        if (progress) progress(result);
+    }
+}
+
+bool WriteBenchmarkJson(const wchar_t* path, const std::vector<BenchmarkResult>& results, std::string* error) {
+    std::ofstream file{ std::filesystem::path(path) };
+    if (!file) {
+        if (error) *error = "cannot open output";
+        return false;
+    }
+
+    file << std::setprecision(6);
+    file << "{\n";
+#if defined(_MSC_VER)
+    file << "\"compiler\":\"msvc " << _MSC_VER << "\",\n";
+#elif defined(__clang__)
+    file << "\"compiler\":\"clang " << __clang_major__ << "." << __clang_minor__ << "\",\n";
+#elif defined(__GNUC__)
+    file << "\"compiler\":\"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",\n";
+#endif
+#if defined(NDEBUG)
+    file << "\"build\":\"release\",\n";
+#else
+    file << "\"build\":\"debug\",\n";
+#endif
+    file << "\"benchmarks\":[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        file << "{\"name\":\"";
+        WriteEscaped(file, r.name);
+        file << "\",\"items\":" << r.items
+            << ",\"iterations\":" << r.iterations
+            << ",\"repetitions\":" << r.repetitions
+            << ",\"mean_ns\":" << r.mean
+            << ",\"median_ns\":" << r.median
+            << ",\"stddev_ns\":" << r.stddev
+            << ",\"min_ns\":" << r.min
+            << ",\"max_ns\":" << r.max
+            << ",\"ci95_low_ns\":" << r.ciLow
+            << ",\"ci95_high_ns\":" << r.ciHigh
+            << ",\"items_per_second\":" << r.itemsPerSecond
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "]}\n";
+
+    if (!file) {
+        if (error) *error = "write failed";
+        return false;
+    }
+    return true;
+}
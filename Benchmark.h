@@ -0,0 +1,68 @@
+﻿/**********************************************************************************
+    Benchmark.h
+
+                                                                LI WENHUI
+                                                                2025/09/03
+
+**********************************************************************************/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+//
+// 1 件のベンチマーク。run は 1 回分の処理で、準備はラムダに捕まえた状態で済ませておく
+// items は 1 回で処理する件数（スループット表示用。0 なら出さない）
+// ファイルを書くなど重い準備は setup に、後片付けは teardown に置く（そのケースを測るときだけ前後に呼ぶ）
+struct BenchmarkCase {
+    std::string name;               // "グループ/名前"
+    uint64_t items = 0;
+    std::function<void()> run;
+    std::function<void()> setup = nullptr;
+    std::function<void()> teardown = nullptr;
+};
+
+struct BenchmarkOptions {
+    int warmup = 3;                 // 捨てる繰り返しの回数
+    int repetitions = 15;           // 統計に使う繰り返しの回数
+    double minRepetitionMs = 20.0;  // 1 回の繰り返しがこれ以上になるまで run の回数を倍にする
+    std::string filter;             // 名前にこの文字列を含むものだけ（空なら全部）
+};
+
+// 時間はすべて run 1 回あたりのナノ秒
+struct BenchmarkResult {
+    std::string name;
+    uint64_t items = 0;
+    uint64_t iterations = 0;        // 1 回の繰り返しで run を呼んだ回数
+    int repetitions = 0;
+    double mean = 0.0;
+    double median = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double ciLow = 0.0;             // 平均の 95% 信頼区間（t 分布）
+    double ciHigh = 0.0;
+    double itemsPerSecond = 0.0;
+};
+
+// 最適化で処理ごと消されないように値を外へ逃がす
+void BenchmarkKeep(uint64_t value);
+void BenchmarkKeep(const void* pointer);
+
+// 各ケースをウォームアップ、回数の調整、繰り返しの順に測る。1 件終わるたびに progress を呼ぶ（nullptr 可）
+void RunBenchmarks(const std::vector<BenchmarkCase>& cases, const BenchmarkOptions& options,
+    std::vector<BenchmarkResult>* out, const std::function<void(const BenchmarkResult&)>& progress);
+
+// 標本から統計を出す（samples は並べ替える）
+void ComputeBenchmarkStats(std::vector<double>* samples, BenchmarkResult* result);
+
+// コミット間で diff しやすいよう、1 ケース 1 行の JSON
+bool WriteBenchmarkJson(const wchar_t* path, const std::vector<BenchmarkResult>& results, std::string* error);
+
+
+#endif
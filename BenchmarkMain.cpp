@@ -0,0 +1,700 @@
+﻿/**********************************************************************************
+    BenchmarkMain.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/03
+
+**********************************************************************************/
+
+//
+// エンジンの重い処理を単体で測るコンソールプログラム（Benchmark.vcxproj）
+// D3D のファイルは使わないので、Linux でもゲーム本体と同じソースから作れる
+// ただし ConstantBuffer.h / Vertex.h / SpriteQuad.h が <DirectXMath.h> を使うので、ヘッダーだけの DirectXMath
+// （github.com/microsoft/DirectXMath の Inc）と、それが読む sal.h（DirectX-Headers の include/wsl/stubs）が要る:
+//   g++ -std=c++17 -O2 -DNDEBUG -pthread -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs Benchmark*.cpp AnimationGraph.cpp Arena.cpp AssetCooker.cpp CharacterController.cpp
+//       CollisionMask.cpp FieldOfView.cpp FlowField.cpp GameWorld.cpp GlyphCache.cpp InputSystem.cpp
+//       JobSystem.cpp Lightmap2D.cpp ParticleSystem.cpp Profiler.cpp ResourceRegistry.cpp SpriteMesh.cpp TexturePrep.cpp
+//       TextureResidency.cpp TileMap.cpp -o bench
+// 使い方: bench [-filter 文字列] [-repetitions n] [-warmup n] [-min-ms ms] [-out file.json] [-list]
+// アセットはカレントディレクトリの assets/ から読む
+
+#include "Benchmark.h"
+#include "AnimationGraph.h"
+#include "Arena.h"
+#include "AssetCooker.h"
+#include "CollisionMask.h"
+#include "ConstantBuffer.h"
+#include "FieldOfView.h"
+#include "FlowField.h"
+#include "GameWorld.h"
+#include "GlyphCache.h"
+#include "InputSystem.h"
+#include "JobSystem.h"
+#include "Lightmap2D.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include "SpriteMesh.h"
+#include "SpriteQuad.h"
+#include "TexturePrep.h"
+#include "TextureResidency.h"
+#include "TileMap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <objbase.h>
+#include <DirectXTex.h>
+#endif
+
+using namespace DirectX;
+
+namespace {
+
+    // 床と、seed で決まる足場と壁を置いた width x height のマップ
+    std::shared_ptr<TileMap> MakeTestMap(int width, int height, uint32_t seed) {
+        auto map = std::make_shared<TileMap>();
+        map->Resize(width, height, 32.0f);
+        std::mt19937 rng(seed);
+        for (int x = 0; x < width; x++) map->SetTile(x, height - 1, TileType::Solid);
+        for (int i = 0; i < width * height / 40; i++) {
+            int x = static_cast<int>(rng() % static_cast<uint32_t>(width));
+            int y = static_cast<int>(rng() % static_cast<uint32_t>(height - 2));
+            int length = 2 + static_cast<int>(rng() % 6u);
+            bool wall = rng() % 4u == 0;
+            for (int k = 0; k < length; k++) {
+                int tx = wall ? x : x + k;
+                int ty = wall ? y + k : y;
+                if (tx < width && ty < height - 1) map->SetTile(tx, ty, wall ? TileType::Solid : TileType::OneWay);
+            }
+        }
+        return map;
+    }
+
+    // 中央を塗った円のスプライトシート（アルファだけ意味がある）
+    std::vector<uint8_t> MakeTestSheet(int width, int height, int columns, int rows) {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * static_cast<size_t>(height) * 4, 0);
+        int frameW = width / columns;
+        int frameH = height / rows;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                float dx = static_cast<float>(x % frameW) - static_cast<float>(frameW) * 0.5f;
+                float dy = static_cast<float>(y % frameH) - static_cast<float>(frameH) * 0.5f;
+                float r = static_cast<float>(frameW) * (0.3f + 0.02f * static_cast<float>((x / frameW + y / frameH) % 8));
+                uint8_t alpha = dx * dx + dy * dy < r * r ? 255 : 0;
+                pixels[(static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)) * 4 + 3] = alpha;
+            }
+        }
+        return pixels;
+    }
+
+    std::vector<SpriteQuad> MakeTestQuads(size_t count, uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(0.0f, 1888.0f);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<SpriteQuad> quads(count);
+        for (SpriteQuad& q : quads) {
+            float x = pos(rng), y = pos(rng) * 0.5f;
+            q.pos[0] = { x, y };
+            q.pos[1] = { x + 32.0f, y };
+            q.pos[2] = { x + 32.0f, y + 32.0f };
+            q.pos[3] = { x, y + 32.0f };
+            q.uv[0] = { 0.0f, 0.0f };
+            q.uv[1] = { 1.0f, 0.0f };
+            q.uv[2] = { 1.0f, 1.0f };
+            q.uv[3] = { 0.0f, 1.0f };
+            q.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+            q.depth = unit(rng);
+        }
+        return quads;
+    }
+
+    void AddAnimationCases(std::vector<BenchmarkCase>* cases) {
+        auto graph = std::make_shared<AnimGraph>();
+        std::string error;
+        if (!LoadAnimGraph(L"assets/player.animgraph", graph.get(), &error)) {
+            std::fprintf(stderr, "skip anim: %s\n", error.c_str());
+            return;
+        }
+
+        // PlayerObject::Update と同じ処理を 1024 体分。半分は走らせて遷移も起こす
+        const size_t count = 1024;
+        auto instances = std::make_shared<std::vector<AnimGraphInstance>>(count);
+        int speed = graph->FindParam("speed");
+        for (size_t i = 0; i < count; i++) ResetAnimGraphInstance(*graph, &(*instances)[i]);
+        auto uv = std::make_shared<std::vector<float>>(count * 4);
+        auto frame = std::make_shared<uint32_t>(0);
+        cases->push_back({ "anim/evaluate_1024", count, [graph, instances, speed, uv, frame] {
+            (*frame)++;
+            for (size_t i = 0; i < instances->size(); i++) {
+                if (speed >= 0) (*instances)[i].params[speed] = ((*frame + i) / 90) % 2 ? 200.0f : 0.0f;
+            }
+            EvaluateAnimGraph(*graph, instances->data(), instances->size(), 1.0f / 120.0f);
+            for (size_t i = 0; i < instances->size(); i++) {
+                const AnimGraphInstance& inst = (*instances)[i];
+                const AnimationData& clip = graph->clips[graph->states[inst.state].clip];
+                GetAnimFrameUV(clip, inst.frameIndex, &(*uv)[i * 4], &(*uv)[i * 4 + 2]);
+            }
+            BenchmarkKeep(uv->data());
+        } });
+    }
+
+    void AddConstantBufferCases(std::vector<BenchmarkCase>* cases) {
+        // PlayerObject::WriteConstantBuffer と同じ詰め方で、マップしたメモリの代わりに配列へ書く
+        const size_t count = 1024;
+        auto buffers = std::make_shared<std::vector<ConstantBuffer>>(count);
+        cases->push_back({ "cb/pack_1024", count, [buffers] {
+            XMMATRIX view = XMMatrixIdentity();
+            XMMATRIX projection = XMMatrixOrthographicOffCenterLH(0.0f, 1888.0f, 1062.0f, 0.0f, 0.0f, 1.0f);
+            for (size_t i = 0; i < buffers->size(); i++) {
+                ConstantBuffer* cb = &(*buffers)[i];
+                cb->model = XMMatrixTranspose(XMMatrixTranslation(static_cast<float>(i), 0.0f, 0.0f));
+                cb->view = XMMatrixTranspose(view);
+                cb->projection = XMMatrixTranspose(projection);
+                cb->texOffset[0] = 0.1f * static_cast<float>(i & 7);
+                cb->texOffset[1] = 0.5f;
+                cb->texScale[0] = 0.1f;
+                cb->texScale[1] = 0.5f;
+                cb->uFlipX = static_cast<uint32_t>(i & 1);
+                cb->alpha = 1.0f;
+            }
+            BenchmarkKeep(buffers->data());
+        } });
+    }
+
+    void AddTextureCases(std::vector<BenchmarkCase>* cases) {
+        // 読み込み時の CPU 側の処理（当たりマスク作り）。1024x512 を 8x4 フレームに割る
+        const int width = 1024, height = 512;
+        auto pixels = std::make_shared<std::vector<uint8_t>>(MakeTestSheet(width, height, 8, 4));
+        auto masks = std::make_shared<std::vector<CollisionMask>>();
+        cases->push_back({ "texture/build_masks_1024x512", static_cast<uint64_t>(width) * height, [pixels, masks, width, height] {
+            BuildCollisionMasks(pixels->data(), width, height, static_cast<size_t>(width) * 4, 8, 4, 32, 128, masks.get());
+            BenchmarkKeep(masks->data());
+        } });
+
+        auto meshes = std::make_shared<std::vector<SpriteMesh>>();
+        cases->push_back({ "texture/build_meshes_1024x512", static_cast<uint64_t>(width) * height, [pixels, meshes, width, height] {
+            BuildSpriteMeshes(pixels->data(), width, height, static_cast<size_t>(width) * 4, 8, 4, 32, SpriteMeshOptions(), meshes.get());
+            BenchmarkKeep(meshes->data());
+        } });
+
+        // GPU に送る前の前処理。ここからは items がバイト数なので、items/s がそのまま B/s
+        const uint64_t sheetBytes = static_cast<uint64_t>(width) * height * 4;
+        auto work = std::make_shared<std::vector<uint8_t>>(*pixels);
+        for (size_t i = 0; i < work->size(); i += 4) {
+            (*work)[i] = static_cast<uint8_t>(i * 7);
+            (*work)[i + 1] = static_cast<uint8_t>(i * 13);
+            (*work)[i + 2] = static_cast<uint8_t>(i * 29);
+            if ((*work)[i + 3] == 255 && (i / 4) % 5 == 0) (*work)[i + 3] = static_cast<uint8_t>(i * 3);   // 縁の半透明の代わり
+        }
+        // 同じバッファに何度も掛けるが、SSE2 版は値で分岐しないので時間は変わらない
+        cases->push_back({ "texture/premultiply_1024x512", sheetBytes, [work] {
+            PremultiplyAlpha(work->data(), work->size() / 4);
+            BenchmarkKeep(work->data());
+        } });
+        cases->push_back({ "texture/premultiply_linear_1024x512", sheetBytes, [work] {
+            PremultiplyAlphaLinear(work->data(), work->size() / 4);
+            BenchmarkKeep(work->data());
+        } });
+        cases->push_back({ "texture/bleed_4_passes_1024x512", sheetBytes, [pixels, width, height] {
+            std::vector<uint8_t> copy(*pixels);
+            for (int row = 0; row < 4; row++) {
+                for (int col = 0; col < 8; col++) {
+                    BleedTransparentEdges(copy.data() + (static_cast<size_t>(row) * (height / 4) * width + static_cast<size_t>(col) * (width / 8)) * 4,
+                        width / 8, height / 4, static_cast<size_t>(width) * 4, 4);
+                }
+            }
+            BenchmarkKeep(copy.data());
+        } });
+        auto gutterOut = std::make_shared<std::vector<uint8_t>>();
+        cases->push_back({ "texture/gutters_2px_1024x512", sheetBytes, [pixels, gutterOut, width, height] {
+            int outW = 0, outH = 0;
+            CopyWithFrameGutters(pixels->data(), width, height, static_cast<size_t>(width) * 4, 8, 4, 2, gutterOut.get(), &outW, &outH);
+            BenchmarkKeep(gutterOut->data());
+        } });
+        auto halfOut = std::make_shared<std::vector<uint8_t>>(sheetBytes / 4);
+        cases->push_back({ "texture/downsample_half_1024x512", sheetBytes, [work, halfOut, width, height] {
+            DownsampleHalf(work->data(), width, height, halfOut->data());
+            BenchmarkKeep(halfOut->data());
+        } });
+
+        // 読み込みと同じ組み合わせ（余白 2 と premultiply）を 8 枚。ジョブありは画像ごとに並列
+        const size_t sheetCount = 8;
+        auto inputs = std::make_shared<std::vector<TexturePrepInput>>(sheetCount);
+        for (TexturePrepInput& input : *inputs) {
+            input.pixels = work->data();
+            input.width = width;
+            input.height = height;
+            input.rowPitch = static_cast<size_t>(width) * 4;
+            input.columns = 8;
+            input.rows = 4;
+        }
+        auto outputs = std::make_shared<std::vector<TexturePrepOutput>>(sheetCount);
+        auto jobs = std::make_shared<JobSystem>();
+        TexturePrepOptions prep;
+        prep.gutter = 2;
+        cases->push_back({ "texture/prepare_8_sheets_serial", sheetBytes * sheetCount, [inputs, outputs, prep] {
+            PrepareTextures(inputs->data(), inputs->size(), prep, outputs->data(), nullptr);
+            BenchmarkKeep(outputs->data());
+        } });
+        cases->push_back({ "texture/prepare_8_sheets_jobs", sheetBytes * sheetCount, [inputs, outputs, jobs, prep] {
+            PrepareTextures(inputs->data(), inputs->size(), prep, outputs->data(), jobs.get());
+            BenchmarkKeep(outputs->data());
+        } });
+
+        // 256 チャンクを 1 チャンク 30 フレームで走り抜ける。バイオームは 16 チャンクごとで、それぞれ 1..4MB のシートが 12 枚
+        // チャンクには今のバイオームから 4 枚。予算 64MB で、載っている量は予算の中で平らのままになる（items はフレーム数）
+        const int residencyChunks = 256;
+        const int framesPerChunk = 30;
+        cases->push_back({ "texture/residency_long_run_256_chunks", static_cast<uint64_t>(residencyChunks) * framesPerChunk, [] {
+            TextureResidencyDesc desc;
+            desc.budgetBytes = 64ull << 20;
+            TextureResidency residency(desc);
+            std::vector<std::vector<int>> chunkTextures(residencyChunks);
+            std::vector<int> biome;
+            for (int chunk = 0; chunk < residencyChunks; chunk++) {
+                if (chunk % 16 == 0) {
+                    biome.clear();
+                    for (int i = 0; i < 12; i++) {
+                        uint64_t bytes = (1ull + static_cast<uint64_t>(i % 4)) << 20;
+                        biome.push_back(residency.AddTexture(bytes, bytes / 4));
+                    }
+                }
+                for (int i = 0; i < 4; i++) {
+                    int texture = biome[static_cast<size_t>((chunk * 5 + i * 3) % 12)];
+                    chunkTextures[static_cast<size_t>(chunk)].push_back(texture);
+                    residency.AddChunkTexture(chunk, texture);
+                }
+            }
+            std::vector<TextureResidencyRequest> requests;
+            for (int frame = 0; frame < residencyChunks * framesPerChunk; frame++) {
+                int chunk = frame / framesPerChunk;
+                residency.SetFocus(chunk, 1);
+                residency.Update(&requests);
+                residency.BeginFrame();
+                for (int texture : chunkTextures[static_cast<size_t>(chunk)]) residency.MarkUsed(texture);
+            }
+            BenchmarkKeep(&residency.GetStats());
+        } });
+
+#ifdef _WIN32
+        // PNG のデコード（WIC）。Windows でだけ測れる
+        if (SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {
+            DirectX::TexMetadata meta;
+            DirectX::ScratchImage probe;
+            if (SUCCEEDED(DirectX::LoadFromWICFile(L"assets\\player_run.png", DirectX::WIC_FLAGS_NONE, &meta, probe))) {
+                cases->push_back({ "texture/decode_png", static_cast<uint64_t>(meta.width * meta.height), [] {
+                    DirectX::ScratchImage image;
+                    DirectX::LoadFromWICFile(L"assets\\player_run.png", DirectX::WIC_FLAGS_NONE, nullptr, image);
+                    BenchmarkKeep(image.GetPixels());
+                } });
+            }
+        }
+#endif
+    }
+
+    void AddBatchCases(std::vector<BenchmarkCase>* cases) {
+        // SpriteBatch::Draw の CPU 側（頂点の展開）
+        const size_t count = 4096;
+        auto quads = std::make_shared<std::vector<SpriteQuad>>(MakeTestQuads(count, 1));
+        auto vertices = std::make_shared<std::vector<Vertex>>();
+        vertices->reserve(count * 4);
+        cases->push_back({ "batch/append_vertices_4096", count, [quads, vertices] {
+            vertices->clear();
+            AppendSpriteVertices(quads->data(), quads->size(), vertices.get());
+            BenchmarkKeep(vertices->data());
+        } });
+
+        // SpriteBatch::DrawMesh の CPU 側。頂点は増えるが、塗る面積は coverage の分だけになる
+        auto sheet = MakeTestSheet(1024, 512, 8, 4);
+        auto meshes = std::make_shared<std::vector<SpriteMesh>>();
+        BuildSpriteMeshes(sheet.data(), 1024, 512, 1024 * 4, 8, 4, 32, SpriteMeshOptions(), meshes.get());
+        auto meshIndices = std::make_shared<std::vector<uint32_t>>();
+        cases->push_back({ "batch/append_meshes_4096", count, [quads, meshes, vertices, meshIndices] {
+            vertices->clear();
+            meshIndices->clear();
+            for (size_t i = 0; i < quads->size(); i++) {
+                AppendSpriteMeshVertices((*meshes)[i % meshes->size()], (*quads)[i], false, vertices.get(), meshIndices.get());
+            }
+            BenchmarkKeep(vertices->data());
+        } });
+
+        auto map = MakeTestMap(128, 64, 7);
+        auto tileQuads = std::make_shared<std::vector<SpriteQuad>>();
+        cases->push_back({ "batch/tilemap_quads_128x64", static_cast<uint64_t>(128 * 64), [map, tileQuads] {
+            tileQuads->clear();
+            map->BuildQuads({ 1.0f, 1.0f, 1.0f, 1.0f }, 0.5f, tileQuads.get());
+            BenchmarkKeep(tileQuads->data());
+        } });
+    }
+
+    void AddSortCases(std::vector<BenchmarkCase>* cases) {
+        // 深度で並べ替え。四角形をそのまま動かすのと、64 ビットのキー（深度 | 番号）だけ並べるのを比べる
+        const size_t count = 4096;
+        auto source = std::make_shared<std::vector<SpriteQuad>>(MakeTestQuads(count, 2));
+        auto work = std::make_shared<std::vector<SpriteQuad>>();
+        cases->push_back({ "sort/quads_stable_4096", count, [source, work] {
+            *work = *source;
+            std::stable_sort(work->begin(), work->end(), [](const SpriteQuad& a, const SpriteQuad& b) { return a.depth < b.depth; });
+            BenchmarkKeep(work->data());
+        } });
+
+        auto keys = std::make_shared<std::vector<uint64_t>>(count);
+        cases->push_back({ "sort/keys_4096", count, [source, keys] {
+            for (size_t i = 0; i < source->size(); i++) {
+                uint32_t depthBits;
+                std::memcpy(&depthBits, &(*source)[i].depth, sizeof(depthBits));  // 0..1 の float はビットのまま比べられる
+                (*keys)[i] = (static_cast<uint64_t>(depthBits) << 32) | i;
+            }
+            std::sort(keys->begin(), keys->end());
+            BenchmarkKeep(keys->data());
+        } });
+    }
+
+    void AddCollisionCases(std::vector<BenchmarkCase>* cases) {
+        auto pixels = MakeTestSheet(512, 256, 8, 4);
+        auto masks = std::make_shared<std::vector<CollisionMask>>();
+        BuildCollisionMasks(pixels.data(), 512, 256, 512 * 4, 8, 4, 32, 128, masks.get());
+
+        auto pair = std::make_shared<std::vector<MaskInstance>>(2);
+        (*pair)[0] = { &(*masks)[0], 0, 0, false };
+        (*pair)[1] = { &(*masks)[3], 20, 24, true };
+        // MaskInstance はマスクを指すだけなので、masks もケースと一緒に持たせておく
+        cases->push_back({ "collision/mask_pair", 1, [masks, pair] {
+            BenchmarkKeep(static_cast<uint64_t>(MasksOverlap((*pair)[0], (*pair)[1])));
+        } });
+
+        // 1888x1062 の画面に 256 体
+        const size_t count = 256;
+        auto instances = std::make_shared<std::vector<MaskInstance>>(count);
+        std::mt19937 rng(3);
+        for (size_t i = 0; i < count; i++) {
+            (*instances)[i] = { &(*masks)[i % masks->size()], static_cast<int>(rng() % 1888u), static_cast<int>(rng() % 1062u), (i & 1) != 0 };
+        }
+        auto overlaps = std::make_shared<std::vector<std::pair<uint32_t, uint32_t>>>();
+        cases->push_back({ "collision/find_overlaps_256", count, [masks, instances, overlaps] {
+            overlaps->clear();
+            BenchmarkKeep(FindMaskOverlaps(instances->data(), instances->size(), overlaps.get()));
+        } });
+    }
+
+    void AddAllocatorCases(std::vector<BenchmarkCase>* cases) {
+        // 大きさのばらばらな小さい確保を 4096 回して、まとめて捨てる
+        const size_t count = 4096;
+        auto sizes = std::make_shared<std::vector<uint32_t>>(count);
+        std::mt19937 rng(4);
+        for (uint32_t& s : *sizes) s = 16 + static_cast<uint32_t>(rng() % 240u);
+
+        auto arena = std::make_shared<Arena>(2 << 20);
+        cases->push_back({ "alloc/arena_4096", count, [sizes, arena] {
+            arena->Reset();
+            for (uint32_t s : *sizes) BenchmarkKeep(arena->Allocate(s));
+        } });
+
+        auto pointers = std::make_shared<std::vector<void*>>(count);
+        cases->push_back({ "alloc/malloc_free_4096", count, [sizes, pointers] {
+            for (size_t i = 0; i < sizes->size(); i++) (*pointers)[i] = std::malloc((*sizes)[i]);
+            BenchmarkKeep((*pointers)[0]);
+            for (void* p : *pointers) std::free(p);
+        } });
+    }
+
+    void AddParticleCases(std::vector<BenchmarkCase>* cases) {
+        // 雨と同じ設定で、数を増やして満杯に近い状態を作ってから測る
+        auto particles = std::make_shared<ParticleSystem>(16384, 5);
+        EmitterDesc rain;
+        rain.width = 2288.0f;
+        rain.rate = 16000.0f;
+        rain.lifeMin = 0.7f;
+        rain.lifeMax = 0.9f;
+        rain.velXMin = -260.0f;
+        rain.velXMax = -200.0f;
+        rain.velYMin = 1500.0f;
+        rain.velYMax = 1800.0f;
+        rain.aspect = 10.0f;
+        particles->AddEmitter(rain);
+        for (int i = 0; i < 120; i++) particles->Update(1.0f / 120.0f, nullptr);
+        cases->push_back({ "particles/update_16k", particles->GetCapacity(), [particles] {
+            particles->Update(1.0f / 120.0f, nullptr);
+            BenchmarkKeep(particles->GetAliveCount());
+        } });
+
+        auto quads = std::make_shared<std::vector<SpriteQuad>>();
+        cases->push_back({ "particles/build_quads_16k", particles->GetCapacity(), [particles, quads] {
+            quads->clear();
+            BenchmarkKeep(particles->BuildQuads(ParticleBlend::Normal, quads.get()));
+        } });
+    }
+
+    void AddPathingCases(std::vector<BenchmarkCase>* cases) {
+        // マップの大きさごとに、ゴールを 2 か所で往復させて毎回解き直させる
+        for (int size : { 64, 256 }) {
+            auto map = MakeTestMap(size, size, 6);
+            auto field = std::make_shared<FlowField>();
+            field->Sync(*map, nullptr);
+            auto flip = std::make_shared<bool>(false);
+            cases->push_back({ "flowfield/solve_" + std::to_string(size), static_cast<uint64_t>(size * size), [map, field, flip, size] {
+                *flip = !*flip;
+                BenchmarkKeep(static_cast<uint64_t>(field->SetGoal(*flip ? 1 : size - 2, size - 2)));
+            } });
+        }
+
+        // 視界は半径ごと
+        auto map = MakeTestMap(256, 256, 8);
+        for (int radius : { 8, 16, 32 }) {
+            auto result = std::make_shared<FovResult>();
+            cases->push_back({ "fov/radius_" + std::to_string(radius), static_cast<uint64_t>((2 * radius + 1) * (2 * radius + 1)), [map, result, radius] {
+                ComputeFov(*map, 128, 128, radius, result.get());
+                BenchmarkKeep(result->bits.data());
+            } });
+        }
+    }
+
+    void AddLightingCases(std::vector<BenchmarkCase>* cases) {
+        // ゲームと同じ 1/8 解像度、ライト 4 つ
+        auto map = MakeTestMap(59, 33, 9);
+        auto occluders = std::make_shared<std::vector<Aabb>>();
+        map->CollectOccluders({ 0.0f, 0.0f, 1888.0f, 1062.0f }, occluders.get());
+        auto lightmap = std::make_shared<Lightmap2D>();
+        lightmap->Resize(236, 133, 1888.0f, 1064.0f);
+        auto lights = std::make_shared<std::vector<Light2D>>(4);
+        for (size_t i = 0; i < lights->size(); i++) {
+            (*lights)[i].x = 200.0f + 450.0f * static_cast<float>(i);
+            (*lights)[i].y = 500.0f;
+        }
+        cases->push_back({ "lightmap/build_4_lights", static_cast<uint64_t>(236 * 133), [lightmap, lights, occluders] {
+            // 入力が同じだと作り直さないので、毎回作り直させて測る
+            lightmap->Invalidate();
+            lightmap->Build(lights->data(), lights->size(), occluders->data(), occluders->size(), nullptr);
+            BenchmarkKeep(lightmap->GetPixels());
+        } });
+    }
+
+    void AddWorldCases(std::vector<BenchmarkCase>* cases) {
+        // ヘッドレスと同じワールド 1 tick（プレイヤーは右へ走り続ける）
+        std::string mapText;
+        auto world = std::make_shared<GameWorld>();
+        std::string error;
+        if (!ReadAssetText(L"assets/level01.txt", &mapText) || !InitGameWorld(world.get(), mapText, GameWorldDesc(), nullptr, &error)) {
+            std::fprintf(stderr, "skip world: cannot load assets/level01.txt %s\n", error.c_str());
+            return;
+        }
+        cases->push_back({ "world/step", 1, [world] {
+            InputFrame input;
+            input.held = static_cast<uint8_t>(1u << static_cast<int>(InputAction::Right));
+            StepGameWorld(world.get(), input, 1.0f / 120.0f, nullptr);
+            BenchmarkKeep(static_cast<uint64_t>(world->tick));
+        } });
+    }
+
+    void AddProfilerCases(std::vector<BenchmarkCase>* cases) {
+        cases->push_back({ "profiler/zone", 1, [] {
+            ProfileScope zone("BenchmarkZone");
+        } });
+    }
+
+    // 文字ごとに幅の違う箱を出すだけのフォント（ラスタライズの回数を見るため）
+    class BoxGlyphSource : public GlyphSource {
+    public:
+        float GetAscent() const override { return 13.0f; }
+        float GetLineHeight() const override { return 18.0f; }
+        int GetMaxGlyphWidth() const override { return 12; }
+        int GetMaxGlyphHeight() const override { return 16; }
+        bool Rasterize(uint32_t codepoint, GlyphBitmap* out) override {
+            out->advance = 6.0f + static_cast<float>(codepoint % 5u);
+            if (codepoint == ' ') return true;
+            out->width = 4 + static_cast<int>(codepoint % 7u);
+            out->height = 10;
+            out->offsetX = 1;
+            out->offsetY = -10;
+            out->coverage.assign(static_cast<size_t>(out->width * out->height), 255);
+            return true;
+        }
+    };
+
+    void AddTextCases(std::vector<BenchmarkCase>* cases) {
+        // デバッグ表示 1 画面分（40 行 x 約 70 文字）。changing は毎回数字が変わり、並べ直しだけが走る
+        const int kLines = 40;
+        auto source = std::make_shared<BoxGlyphSource>();
+        auto cache = std::make_shared<GlyphCache>(1024, 1024);
+        int font = cache->AddFont(source.get());
+        auto quads = std::make_shared<std::vector<SpriteQuad>>();
+        auto lines = std::make_shared<std::vector<std::string>>();
+        char line[128];
+        for (int i = 0; i < kLines; i++) {
+            std::snprintf(line, sizeof(line), "stat %02d  frame %8.3f ms  p99 %8.3f ms  draws %5d  quads %7d", i, 16.6 + i, 33.3 + i, i * 7, i * 1000);
+            lines->push_back(line);
+        }
+        uint64_t glyphCount = 0;
+        for (const std::string& s : *lines) glyphCount += s.size();
+
+        cases->push_back({ "text/overlay_cached_40_lines", glyphCount, [source, cache, font, quads, lines] {
+            cache->BeginFrame();
+            quads->clear();
+            float y = 0.0f;
+            for (const std::string& s : *lines) {
+                cache->BuildQuads(font, s, 8.0f, y, { 1.0f, 1.0f, 1.0f, 1.0f }, 0.0f, quads.get());
+                y += 18.0f;
+            }
+            BenchmarkKeep(quads->data());
+        } });
+
+        auto counter = std::make_shared<uint32_t>(0);
+        cases->push_back({ "text/overlay_changing_40_lines", glyphCount, [source, cache, font, quads, counter] {
+            cache->BeginFrame();
+            quads->clear();
+            uint32_t n = ++*counter;
+            char text[128];
+            for (int i = 0; i < kLines; i++) {
+                std::snprintf(text, sizeof(text), "stat %02d  frame %8.3f ms  p99 %8.3f ms  draws %5u  quads %7u", i,
+                    static_cast<double>(n % 1000) * 0.01, static_cast<double>(n % 977) * 0.03, n % 9973u, n);
+                cache->BuildQuads(font, text, 8.0f, static_cast<float>(i) * 18.0f, { 1.0f, 1.0f, 1.0f, 1.0f }, 0.0f, quads.get());
+            }
+            BenchmarkKeep(quads->data());
+        } });
+    }
+
+    void AddCookCases(std::vector<BenchmarkCase>* cases) {
+        // 中身のハッシュ。items はバイト数
+        const size_t hashBytes = 64 << 20;
+        auto data = std::make_shared<std::vector<uint8_t>>();
+        BenchmarkCase hash = { "cook/hash_content_64mb", hashBytes, [data] {
+            BenchmarkKeep(HashContent(data->data(), data->size()));
+        } };
+        hash.setup = [data, hashBytes] {
+            data->resize(hashBytes);
+            for (size_t i = 0; i < hashBytes; i++) (*data)[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+        };
+        hash.teardown = [data] { std::vector<uint8_t>().swap(*data); };
+        cases->push_back(hash);
+
+        // 一時ディレクトリに 2000 ファイル（16KB ずつ）を置いて 1 回変換しておき、2 回目以降を測る（items はファイル数）
+        // ファイルはケースを測る前に作り、終わったらディレクトリごと消す
+        const int fileCount = 2000;
+        namespace fs = std::filesystem;
+        auto root = std::make_shared<fs::path>(fs::temp_directory_path() / "bench_cook");
+        auto jobs = std::make_shared<JobSystem>();
+        auto makeCooker = [root, jobs] {
+            AssetCookerDesc desc;
+            desc.sourceDir = *root / "src";
+            desc.outputDir = *root / "out";
+            desc.cacheDir = *root / "cache";
+            desc.jobs = jobs.get();
+            auto cooker = std::make_shared<AssetCooker>(desc);
+            cooker->AddRule(MakeCopyRule(".txt"));
+            return cooker;
+        };
+        auto setup = [root, makeCooker, fileCount] {
+            std::error_code ec;
+            fs::remove_all(*root, ec);
+            std::vector<char> contents(16 << 10);
+            for (int i = 0; i < fileCount; i++) {
+                fs::path path = *root / "src" / ("dir" + std::to_string(i % 20)) / ("asset" + std::to_string(i) + ".txt");
+                fs::create_directories(path.parent_path(), ec);
+                std::fill(contents.begin(), contents.end(), static_cast<char>('a' + i % 26));
+                std::ofstream(path, std::ios::binary).write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            }
+            CookStats stats;
+            std::string log;
+            makeCooker()->Run(&stats, &log);
+        };
+        auto teardown = [root] {
+            std::error_code ec;
+            fs::remove_all(*root, ec);
+        };
+
+        // 何も変わっていない：ファイルの大きさと更新時刻を見るだけ
+        BenchmarkCase noop = { "cook/noop_2000_files", static_cast<uint64_t>(fileCount), [makeCooker] {
+            CookStats stats;
+            std::string log;
+            makeCooker()->Run(&stats, &log);
+            BenchmarkKeep(&stats);
+        }, setup, teardown };
+        cases->push_back(noop);
+
+        // 毎回 1 ファイルを前のどれとも違う中身にする：そのファイルだけ読み直して変換する（キャッシュにも当たらない）
+        // 中身は回数の番号で、更新時刻も回数ぶん進めて、時計の分解能で変化を見落とさないようにする
+        auto counter = std::make_shared<uint32_t>(0);
+        BenchmarkCase changed = { "cook/one_changed_of_2000", static_cast<uint64_t>(fileCount), [makeCooker, root, counter] {
+            uint32_t n = ++*counter;
+            fs::path path = *root / "src" / "dir0" / "asset0.txt";
+            std::ofstream(path, std::ios::binary) << "changed " << n << '\n';
+            std::error_code ec;
+            fs::last_write_time(path, fs::file_time_type::clock::now() + std::chrono::seconds(n), ec);
+            CookStats stats;
+            std::string log;
+            makeCooker()->Run(&stats, &log);
+            BenchmarkKeep(&stats);
+        }, setup, teardown };
+        cases->push_back(changed);
+    }
+
+    std::wstring Widen(const char* text) {
+        std::string s(text);
+        return std::wstring(s.begin(), s.end());
+    }
+}
+
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    std::wstring outPath;
+    bool listOnly = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-filter") == 0 && hasValue) options.filter = argv[++i];
+        else if (std::strcmp(argv[i], "-repetitions") == 0 && hasValue) options.repetitions = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-warmup") == 0 && hasValue) options.warmup = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-min-ms") == 0 && hasValue) options.minRepetitionMs = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "-out") == 0 && hasValue) outPath = Widen(argv[++i]);
+        else if (std::strcmp(argv[i], "-list") == 0) listOnly = true;
+        else {
+            std::fprintf(stderr, "usage: [-filter text] [-repetitions n] [-warmup n] [-min-ms ms] [-out file.json] [-list]\n");
+            return 1;
+        }
+    }
+
+    std::vector<BenchmarkCase> cases;
+    AddAnimationCases(&cases);
+    AddConstantBufferCases(&cases);
+    AddTextureCases(&cases);
+    AddBatchCases(&cases);
+    AddSortCases(&cases);
+    AddCollisionCases(&cases);
+    AddAllocatorCases(&cases);
+    AddParticleCases(&cases);
+    AddPathingCases(&cases);
+    AddLightingCases(&cases);
+    AddWorldCases(&cases);
+    AddProfilerCases(&cases);
+    AddTextCases(&cases);
+    AddCookCases(&cases);
+
+    if (listOnly) {
+        for (const BenchmarkCase& c : cases) std::printf("%s\n", c.name.c_str());
+        return 0;
+    }
+
+    std::printf("%-32s %12s %12s %20s %14s\n", "name", "mean ns", "median ns", "95% ci ns", "items/s");
+    std::vector<BenchmarkResult> results;
+    RunBenchmarks(cases, options, &results, [](const BenchmarkResult& r) {
+        std::printf("%-32s %12.1f %12.1f %9.1f..%-9.1f %14.4g\n", r.name.c_str(), r.mean, r.median, r.ciLow, r.ciHigh, r.itemsPerSecond);
+        std::fflush(stdout);
+    });
+
+    if (!outPath.empty()) {
+        std::string error;
+        if (!WriteBenchmarkJson(outPath.c_str(), results, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -7,9 +7,107 @@
 **********************************************************************************/
 
 #include "BufferUtils.h"
+#include "ResourceRegistry.h"
 #include "Vertex.h"
+#include <DirectXTex.h>
+#include <atomic>
 
-ID3D11Buffer* CreateDynamicVertexBuffer(ID3D11Device* device, size_t vertices_count) {
+namespace {
+
+    // {5B8E1C3A-7D24-4F61-9E0B-3A6C82D4F157}
+    const GUID kResourceWatcherGuid = { 0x5b8e1c3a, 0x7d24, 0x4f61, { 0x9e, 0x0b, 0x3a, 0x6c, 0x82, 0xd4, 0xf1, 0x57 } };
+
+    // オブジェクトのプライベートデータに置いておくと、オブジェクトが破棄されるときに一緒に Release される
+    // そこで登録を消すので、Release する側のコードは ResourceRegistry を知らなくてよい
+    class ResourceReleaseWatcher : public IUnknown {
+    public:
+        explicit ResourceReleaseWatcher(const void* handle) : handle(handle) {}
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+            if (!object) return E_POINTER;
+            if (riid == __uuidof(IUnknown)) {
+                *object = static_cast<IUnknown*>(this);
+                AddRef();
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++refCount; }
+        ULONG STDMETHODCALLTYPE Release() override {
+            ULONG count = --refCount;
+            if (count == 0) {
+                ResourceUnregister(handle);
+                delete this;
+            }
+            return count;
+        }
+
+    private:
+        const void* handle;
+        std::atomic<ULONG> refCount{ 1 };
+    };
+
+    void Watch(ID3D11DeviceChild* object) {
+        ResourceReleaseWatcher* watcher = new ResourceReleaseWatcher(object);
+        object->SetPrivateDataInterface(kResourceWatcherGuid, watcher);
+        watcher->Release();
+    }
+
+    uint64_t TextureBytes(DXGI_FORMAT format, UINT width, UINT height, UINT mipLevels, UINT arraySize) {
+        uint64_t bytes = 0;
+        for (UINT mip = 0; mip < mipLevels; mip++) {
+            // windows.h の max マクロとぶつかるので std::max は使わない
+            UINT w = (width >> mip) ? (width >> mip) : 1;
+            UINT h = (height >> mip) ? (height >> mip) : 1;
+            size_t rowPitch = 0, slicePitch = 0;
+            if (FAILED(DirectX::ComputePitch(format, w, h, rowPitch, slicePitch))) break;
+            bytes += slicePitch;
+        }
+        return bytes * arraySize;
+    }
+}
+
+
+void TrackBuffer(ID3D11Buffer* buffer, const char* owner, const char* name) {
+    if (!buffer) return;
+    D3D11_BUFFER_DESC desc;
+    buffer->GetDesc(&desc);
+    ResourceKind kind = ResourceKind::VertexBuffer;
+    if (desc.BindFlags & D3D11_BIND_INDEX_BUFFER) kind = ResourceKind::IndexBuffer;
+    else if (desc.BindFlags & D3D11_BIND_CONSTANT_BUFFER) kind = ResourceKind::ConstantBuffer;
+    if (ResourceRegister(buffer, kind, desc.ByteWidth, 0, owner, name)) Watch(buffer);
+}
+
+void TrackTexture(ID3D11Texture2D* texture, const char* owner, const char* name) {
+    if (!texture) return;
+    D3D11_TEXTURE2D_DESC desc;
+    texture->GetDesc(&desc);
+    ResourceKind kind = (desc.BindFlags & D3D11_BIND_DEPTH_STENCIL) ? ResourceKind::DepthStencil : ResourceKind::Texture;
+    uint64_t bytes = TextureBytes(desc.Format, desc.Width, desc.Height, desc.MipLevels, desc.ArraySize) * desc.SampleDesc.Count;
+    if (ResourceRegister(texture, kind, bytes, static_cast<uint32_t>(desc.Format), owner, name)) Watch(texture);
+}
+
+void TrackShaderResourceView(ID3D11ShaderResourceView* srv, const char* owner, const std::string& name) {
+    if (!srv) return;
+    // 大きさは元のテクスチャから。SRV を持つ側はテクスチャを直接持たないので、SRV の破棄で登録を消す
+    ID3D11Resource* resource = nullptr;
+    srv->GetResource(&resource);
+    ID3D11Texture2D* texture = nullptr;
+    uint64_t bytes = 0;
+    uint32_t format = 0;
+    if (resource && SUCCEEDED(resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&texture)))) {
+        D3D11_TEXTURE2D_DESC desc;
+        texture->GetDesc(&desc);
+        bytes = TextureBytes(desc.Format, desc.Width, desc.Height, desc.MipLevels, desc.ArraySize);
+        format = static_cast<uint32_t>(desc.Format);
+        texture->Release();
+    }
+    if (resource) resource->Release();
+    if (ResourceRegister(srv, ResourceKind::Texture, bytes, format, owner, name)) Watch(srv);
+}
+
+ID3D11Buffer* CreateDynamicVertexBuffer(ID3D11Device* device, size_t vertices_count, const char* owner) {
 
     D3D11_BUFFER_DESC bd = {};
     bd.Usage = D3D11_USAGE_DYNAMIC;              
@@ -26,9 +124,10 @@ ID3D11Buffer* CreateDynamicVertexBuffer(ID3D11Device* device, size_t vertices_co
         // 
         return nullptr;
     }
+    TrackBuffer(vertexBuffer, owner);
     return vertexBuffer;
 }
-ID3D11Buffer* CreateDynamicIndexBuffer(ID3D11Device* device, size_t indexCount)
+ID3D11Buffer* CreateDynamicIndexBuffer(ID3D11Device* device, size_t indexCount, const char* owner)
 {
     // 
     D3D11_BUFFER_DESC bd = {};
@@ -46,6 +145,7 @@ ID3D11Buffer* CreateDynamicIndexBuffer(ID3D11Device* device, size_t indexCount)
     {
         return nullptr;
     }
+    TrackBuffer(indexBuffer, owner);
     //
     return indexBuffer;
 }
\ No newline at end of file
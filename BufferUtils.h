@@ -12,6 +12,12 @@
 struct Vertex;
 
 
-ID3D11Buffer* CreateDynamicVertexBuffer(ID3D11Device* device, size_t vertices_count);
+// owner は ResourceRegistry に記録する作成元（文字列リテラル）
+ID3D11Buffer* CreateDynamicVertexBuffer(ID3D11Device* device, size_t vertices_count, const char* owner = "Unknown");
 
-ID3D11Buffer* CreateDynamicIndexBuffer(ID3D11Device* device, size_t indexCount);
\ No newline at end of file
+ID3D11Buffer* CreateDynamicIndexBuffer(ID3D11Device* device, size_t indexCount, const char* owner = "Unknown");
+
+// 自前で作ったリソースを ResourceRegistry に登録する。D3D がオブジェクトを破棄したときに登録も消える
+void TrackBuffer(ID3D11Buffer* buffer, const char* owner, const char* name = "");
+void TrackTexture(ID3D11Texture2D* texture, const char* owner, const char* name = "");
+void TrackShaderResourceView(ID3D11ShaderResourceView* srv, const char* owner, const std::string& name = std::string());
\ No newline at end of file
@@ -0,0 +1,409 @@
+﻿/**********************************************************************************
+    CharacterController.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/27
+
+**********************************************************************************/
+
+#include "CharacterController.h"
+#include "TileMap.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace {
+    constexpr float kEpsilon = 0.01f;
+    constexpr float kMaxDeltaTime = 0.1f;       // これ以上は重力の積分が荒くなるので切る
+    constexpr size_t kBodiesPerJob = 64;        // 4 の倍数
+
+    inline XMVECTOR Load4(const std::vector<float>& v, size_t i) {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&v[i]));
+    }
+    inline void Store4(std::vector<float>& v, size_t i, FXMVECTOR x) {
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&v[i]), x);
+    }
+
+    int FloorDiv(float v, float tileSize) {
+        return static_cast<int>(std::floor(v / tileSize));
+    }
+
+    // 左右のマップ外は壁にして外へ出ないようにする（下端より下は TileMap が壁を返す）
+    TileType TileAt(const TileMap& map, int x, int y) {
+        if (x < 0 || x >= map.GetWidth()) return TileType::Solid;
+        return map.GetTile(x, y);
+    }
+
+    // タイルの上面。坂は足元の中心 px をタイルの中に丸めた位置で測る
+    // （坂の高い側にいればタイルの上端、低い側にいれば下端になる）
+    float SurfaceY(TileType t, int x, int y, float px, float tileSize) {
+        float top = static_cast<float>(y) * tileSize;
+        float lx = std::clamp(px - static_cast<float>(x) * tileSize, 0.0f, tileSize);
+        if (t == TileType::SlopeUp) return top + tileSize - lx;
+        if (t == TileType::SlopeDown) return top + lx;
+        return top;
+    }
+}
+
+struct CharacterController::Context {
+    const TileMap* map;
+    const MovingSolid* solids;
+    size_t solidCount;
+    float deltaTime;
+    float tileSize;
+};
+
+
+void CharacterController::SetParams(const ControllerParams& params) {
+    this->params = params;
+}
+
+int CharacterController::AddBody(const CharacterDesc& desc) {
+    size_t i = count++;
+    size_t padded = (count + 3) & ~size_t(3);
+    for (std::vector<float>* v : { &posX, &posY, &velX, &velY, &halfWidth, &height, &runSpeed, &moveX, &jump, &grounded }) {
+        v->resize(padded, 0.0f);
+    }
+    dropThrough.resize(padded, 0);
+    groundSolid.resize(padded, -1);
+
+    posX[i] = desc.x;
+    posY[i] = desc.y;
+    halfWidth[i] = desc.width * 0.5f;
+    height[i] = desc.height;
+    runSpeed[i] = desc.runSpeed;
+    return static_cast<int>(i);
+}
+
+size_t CharacterController::GetBodyCount() const {
+    return count;
+}
+
+void CharacterController::SetInput(int body, float moveX, bool jump, bool dropThrough) {
+    size_t i = static_cast<size_t>(body);
+    this->moveX[i] = std::clamp(moveX, -1.0f, 1.0f);
+    this->jump[i] = jump ? 1.0f : 0.0f;
+    this->dropThrough[i] = dropThrough ? 1 : 0;
+}
+
+void CharacterController::SetPosition(int body, float x, float y) {
+    size_t i = static_cast<size_t>(body);
+    posX[i] = x;
+    posY[i] = y;
+    velX[i] = 0.0f;
+    velY[i] = 0.0f;
+    grounded[i] = 0.0f;
+    groundSolid[i] = -1;
+}
+
+float CharacterController::GetX(int body) const {
+    return posX[static_cast<size_t>(body)];
+}
+
+float CharacterController::GetY(int body) const {
+    return posY[static_cast<size_t>(body)];
+}
+
+float CharacterController::GetVelocityX(int body) const {
+    return velX[static_cast<size_t>(body)];
+}
+
+float CharacterController::GetVelocityY(int body) const {
+    return velY[static_cast<size_t>(body)];
+}
+
+bool CharacterController::IsGrounded(int body) const {
+    return grounded[static_cast<size_t>(body)] > 0.5f;
+}
+
+Aabb CharacterController::GetBounds(int body) const {
+    size_t i = static_cast<size_t>(body);
+    return { posX[i] - halfWidth[i], posY[i] - height[i], posX[i] + halfWidth[i], posY[i] };
+}
+
+void CharacterController::Integrate(size_t begin, size_t end, float deltaTime) {
+    const XMVECTOR half = XMVectorReplicate(0.5f);
+    const XMVECTOR groundDelta = XMVectorReplicate(params.groundAccel * deltaTime);
+    const XMVECTOR airDelta = XMVectorReplicate(params.airAccel * deltaTime);
+    const XMVECTOR gravity = XMVectorReplicate(params.gravity * deltaTime);
+    const XMVECTOR maxFall = XMVectorReplicate(params.maxFallSpeed);
+    const XMVECTOR jumpVel = XMVectorReplicate(-params.jumpSpeed);
+
+    for (size_t i = begin; i < end; i += 4) {
+        XMVECTOR onGround = XMVectorGreater(Load4(grounded, i), half);
+
+        // 横は目標速度へ加速度の上限つきで近づける
+        XMVECTOR maxDelta = XMVectorSelect(airDelta, groundDelta, onGround);
+        XMVECTOR target = XMVectorMultiply(Load4(moveX, i), Load4(runSpeed, i));
+        XMVECTOR vx = Load4(velX, i);
+        vx = XMVectorAdd(vx, XMVectorClamp(XMVectorSubtract(target, vx), XMVectorNegate(maxDelta), maxDelta));
+
+        // 縦は重力。着地していてジャンプが押されていれば跳ぶ
+        XMVECTOR vy = XMVectorMin(XMVectorAdd(Load4(velY, i), gravity), maxFall);
+        XMVECTOR jumping = XMVectorAndInt(onGround, XMVectorGreater(Load4(jump, i), half));
+        vy = XMVectorSelect(vy, jumpVel, jumping);
+
+        Store4(velX, i, vx);
+        Store4(velY, i, vy);
+    }
+}
+
+float CharacterController::SweepX(size_t i, float dx, bool onGround, const Context& ctx) const {
+    if (dx == 0.0f) return 0.0f;
+
+    const TileMap& map = *ctx.map;
+    const float ts = ctx.tileSize;
+    const float left = posX[i] - halfWidth[i];
+    const float right = posX[i] + halfWidth[i];
+    const float top = posY[i] - height[i];
+    // 着地中は足元から stepHeight までの段差を無視し、後の ProbeGround で上に乗せる
+    const float feet = posY[i] - (onGround ? params.stepHeight * ts : 0.0f);
+
+    int r0 = FloorDiv(top + kEpsilon, ts);
+    int r1 = FloorDiv(feet - kEpsilon, ts);
+
+    if (dx > 0.0f) {
+        int c0 = static_cast<int>(std::ceil((right - kEpsilon) / ts));
+        int c1 = static_cast<int>(std::ceil((right + dx) / ts)) - 1;
+        for (int c = c0; c <= c1; c++) {
+            bool blocked = false;
+            for (int r = r0; r <= r1 && !blocked; r++) {
+                TileType t = TileAt(map, c, r);
+                blocked = t == TileType::Solid || t == TileType::SlopeDown;   // 右下がりの坂は左側が壁
+            }
+            if (blocked) {
+                dx = std::max(static_cast<float>(c) * ts - right, 0.0f);
+                break;
+            }
+        }
+    }
+    else {
+        int c0 = FloorDiv(left + kEpsilon, ts) - 1;
+        int c1 = FloorDiv(left + dx, ts);
+        for (int c = c0; c >= c1; c--) {
+            bool blocked = false;
+            for (int r = r0; r <= r1 && !blocked; r++) {
+                TileType t = TileAt(map, c, r);
+                blocked = t == TileType::Solid || t == TileType::SlopeUp;     // 右上がりの坂は右側が壁
+            }
+            if (blocked) {
+                dx = std::min(static_cast<float>(c + 1) * ts - left, 0.0f);
+                break;
+            }
+        }
+    }
+
+    Aabb box = { left, top, right, feet };
+    for (size_t k = 0; k < ctx.solidCount; k++) {
+        const MovingSolid& s = ctx.solids[k];
+        if (s.oneWay || s.box.minY >= feet - kEpsilon) continue;
+        float nx, ny;
+        float t = SweepAabb(box, dx, 0.0f, s.box, &nx, &ny);
+        if (t < 1.0f) dx *= t;
+    }
+    return dx;
+}
+
+float CharacterController::SweepY(size_t i, float dy, bool* landed, const Context& ctx) {
+    *landed = false;
+    if (dy == 0.0f) return 0.0f;
+
+    const TileMap& map = *ctx.map;
+    const float ts = ctx.tileSize;
+    const float left = posX[i] - halfWidth[i];
+    const float right = posX[i] + halfWidth[i];
+    int cL = FloorDiv(left + kEpsilon, ts);
+    int cR = FloorDiv(right - kEpsilon, ts);
+
+    if (dy > 0.0f) {
+        // 落下：足元が通過する範囲で一番高い上面に着地
+        const float b = posY[i];
+        float land = b + dy;
+        int landSolid = -1;
+        bool hit = false;
+        int r0 = FloorDiv(b - kEpsilon, ts);
+        int r1 = FloorDiv(b + dy, ts);
+        for (int c = cL; c <= cR; c++) {
+            for (int r = r0; r <= r1; r++) {
+                TileType t = TileAt(map, c, r);
+                if (t == TileType::Empty) continue;
+                if (t == TileType::OneWay && dropThrough[i]) continue;
+                float s = SurfaceY(t, c, r, posX[i], ts);
+                if (s < b - kEpsilon) continue;     // 足元より上（横の壁）
+                if (s <= land) {
+                    land = s;
+                    hit = true;
+                }
+                break;
+            }
+        }
+        // 動く足場は「前の位置で上にいた」なら着地。上昇中の足場に追い越されても抜けない
+        for (size_t k = 0; k < ctx.solidCount; k++) {
+            const MovingSolid& s = ctx.solids[k];
+            if (s.box.maxX <= left || right <= s.box.minX) continue;
+            if (s.oneWay && dropThrough[i]) continue;
+            float prevTop = s.box.minY - s.dy;
+            if (b <= prevTop + kEpsilon && b + dy >= s.box.minY && s.box.minY <= land) {
+                land = s.box.minY;
+                landSolid = static_cast<int>(k);
+                hit = true;
+            }
+        }
+        if (!hit) return dy;
+        *landed = true;
+        groundSolid[i] = landSolid;
+        return land - b;
+    }
+
+    // 上昇：頭が通過する範囲で一番低い天井（一方通行の足場は下から抜ける）
+    const float tp = posY[i] - height[i];
+    float ceiling = tp + dy;
+    bool hit = false;
+    int r0 = FloorDiv(tp + kEpsilon, ts) - 1;
+    int r1 = FloorDiv(tp + dy, ts);
+    for (int c = cL; c <= cR; c++) {
+        for (int r = r0; r >= r1; r--) {
+            TileType t = TileAt(map, c, r);
+            if (t == TileType::Empty || t == TileType::OneWay) continue;
+            float bottom = static_cast<float>(r + 1) * ts;
+            if (bottom > ceiling) {
+                ceiling = bottom;
+                hit = true;
+            }
+            break;
+        }
+    }
+    Aabb box = GetBounds(static_cast<int>(i));
+    for (size_t k = 0; k < ctx.solidCount; k++) {
+        const MovingSolid& s = ctx.solids[k];
+        if (s.oneWay) continue;
+        float nx, ny;
+        float t = SweepAabb(box, 0.0f, dy, s.box, &nx, &ny);
+        if (t < 1.0f && tp + dy * t > ceiling) {
+            ceiling = tp + dy * t;
+            hit = true;
+        }
+    }
+    return hit ? ceiling - tp : dy;
+}
+
+bool CharacterController::ProbeGround(size_t i, float snap, const Context& ctx) {
+    const TileMap& map = *ctx.map;
+    const float ts = ctx.tileSize;
+    const float b = posY[i];
+    const float step = params.stepHeight * ts;
+    const float left = posX[i] - halfWidth[i];
+    const float right = posX[i] + halfWidth[i];
+    int cL = FloorDiv(left + kEpsilon, ts);
+    int cR = FloorDiv(right - kEpsilon, ts);
+    int r0 = FloorDiv(b - step, ts);
+    int r1 = FloorDiv(b + snap, ts);
+
+    // 足元の上下 [b - step, b + snap] で一番高い上面に合わせる（段差は上り、下り坂は吸い付く）
+    float best = b + snap + 1.0f;
+    int bestSolid = -1;
+    for (int c = cL; c <= cR; c++) {
+        for (int r = r0; r <= r1; r++) {
+            TileType t = TileAt(map, c, r);
+            if (t == TileType::Empty) continue;
+            if (t == TileType::OneWay && dropThrough[i]) continue;
+            float s = SurfaceY(t, c, r, posX[i], ts);
+            float lowest = (t == TileType::OneWay ? b : b - step) - kEpsilon;
+            if (s < lowest) continue;
+            if (s < best) best = s;
+            break;
+        }
+    }
+    for (size_t k = 0; k < ctx.solidCount; k++) {
+        const MovingSolid& s = ctx.solids[k];
+        if (s.box.maxX <= left || right <= s.box.minX) continue;
+        if (s.oneWay && dropThrough[i]) continue;
+        float lowest = (s.oneWay ? b : b - step) - kEpsilon;
+        if (s.box.minY >= lowest && s.box.minY < best) {
+            best = s.box.minY;
+            bestSolid = static_cast<int>(k);
+        }
+    }
+    if (best > b + snap) return false;
+
+    posY[i] = best;
+    groundSolid[i] = bestSolid;
+    return true;
+}
+
+void CharacterController::Resolve(size_t i, const Context& ctx) {
+    const float ts = ctx.tileSize;
+    bool onGround = grounded[i] > 0.5f && velY[i] >= 0.0f;
+
+    // 動く足場に乗っていれば一緒に運ばれる
+    float carryX = 0.0f;
+    float carryY = 0.0f;
+    int solid = groundSolid[i];
+    if (onGround && solid >= 0 && static_cast<size_t>(solid) < ctx.solidCount) {
+        carryX = ctx.solids[solid].dx;
+        carryY = ctx.solids[solid].dy;
+        posY[i] += carryY;
+    }
+    groundSolid[i] = -1;
+
+    // 横：半タイルずつ進めて、着地中なら毎回足元を合わせ直す（坂・段差・崖）
+    // 下降中の空中でも、坂の裾や低い段差に横から入ったらそのまま乗せる
+    const bool falling = velY[i] >= 0.0f;
+    float remaining = velX[i] * ctx.deltaTime + carryX;
+    int steps = std::max(1, static_cast<int>(std::ceil(std::fabs(remaining) / (ts * 0.5f))));
+    float stepX = remaining / static_cast<float>(steps);
+    for (int s = 0; s < steps; s++) {
+        float moved = SweepX(i, stepX, onGround, ctx);
+        posX[i] += moved;
+        if (onGround) {
+            onGround = ProbeGround(i, std::fabs(moved) + std::fabs(carryY) + ts * 0.25f, ctx);
+        }
+        else if (falling) {
+            onGround = ProbeGround(i, 0.0f, ctx);
+        }
+        if (moved != stepX) {
+            velX[i] = 0.0f;
+            break;
+        }
+    }
+
+    // 縦
+    if (onGround) {
+        velY[i] = 0.0f;
+    }
+    else {
+        float dy = velY[i] * ctx.deltaTime;
+        float moved = SweepY(i, dy, &onGround, ctx);
+        posY[i] += moved;
+        if (moved != dy) velY[i] = 0.0f;
+    }
+    grounded[i] = onGround ? 1.0f : 0.0f;
+}
+
+void CharacterController::Step(const TileMap& map, const MovingSolid* solids, size_t solidCount,
+    float deltaTime, JobSystem* jobs) {
+    PROFILE_ZONE("CharacterController::Step");
+
+    Context ctx = { &map, solids, solidCount, std::min(deltaTime, kMaxDeltaTime), map.GetTileSize() };
+    size_t padded = (count + 3) & ~size_t(3);
+
+    // 1) 速度をまとめて積分  2) 体ごとに衝突を解く（互いに干渉しないので並列）
+    auto integrateJob = [&](size_t begin, size_t end) {
+        Integrate(begin, end, ctx.deltaTime);
+    };
+    auto resolveJob = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) Resolve(i, ctx);
+    };
+    if (jobs) {
+        jobs->ParallelFor(padded, kBodiesPerJob, integrateJob);
+        jobs->ParallelFor(count, kBodiesPerJob, resolveJob);
+    }
+    else {
+        integrateJob(0, padded);
+        resolveJob(0, count);
+    }
+}
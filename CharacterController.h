@@ -0,0 +1,91 @@
+﻿/**********************************************************************************
+    CharacterController.h
+
+                                                                LI WENHUI
+                                                                2025/08/27
+
+**********************************************************************************/
+
+#ifndef CHARACTERCONTROLLER_H
+#define CHARACTERCONTROLLER_H
+
+#include "Aabb.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TileMap;
+class JobSystem;
+
+struct ControllerParams {
+    float groundAccel = 2400.0f;    // 目標速度に近づける加速度
+    float airAccel = 1200.0f;
+    float gravity = 2200.0f;
+    float jumpSpeed = 820.0f;
+    float maxFallSpeed = 1400.0f;
+    float stepHeight = 0.5f;        // 歩いて乗り越えられる段差（タイルに対する比率）
+};
+
+// x は中心、y は足元。坂をきちんと上るには幅がタイル以下であること
+struct CharacterDesc {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 28.0f;
+    float height = 28.0f;
+    float runSpeed = 200.0f;
+};
+
+// 動く足場・箱など。box は今回のステップで動いた後の位置、dx / dy はその移動量
+struct MovingSolid {
+    Aabb box;
+    float dx = 0.0f;
+    float dy = 0.0f;
+    bool oneWay = false;
+};
+
+//
+// プラットフォーマー用のキャラクター移動
+// 速度の積分は SoA のまま 4 体ずつ DirectXMath で、衝突は体ごとに並列で解く。
+// 衝突は軸ごとのスイープで、移動で横切るタイルを全部調べるので速度が大きくても抜けない
+class CharacterController {
+public:
+    void SetParams(const ControllerParams& params);
+
+    int AddBody(const CharacterDesc& desc);
+    size_t GetBodyCount() const;
+
+    // moveX は -1..1。jump は押している間、着地していれば跳ぶ。dropThrough で一方通行の足場を降りる
+    void SetInput(int body, float moveX, bool jump, bool dropThrough);
+    void SetPosition(int body, float x, float y);
+
+    void Step(const TileMap& map, const MovingSolid* solids, size_t solidCount, float deltaTime, JobSystem* jobs);
+
+    float GetX(int body) const;
+    float GetY(int body) const;
+    float GetVelocityX(int body) const;
+    float GetVelocityY(int body) const;
+    bool IsGrounded(int body) const;
+    Aabb GetBounds(int body) const;
+
+private:
+    struct Context;
+
+    void Integrate(size_t begin, size_t end, float deltaTime);
+    void Resolve(size_t body, const Context& ctx);
+    float SweepX(size_t body, float dx, bool onGround, const Context& ctx) const;
+    float SweepY(size_t body, float dy, bool* landed, const Context& ctx);
+    bool ProbeGround(size_t body, float snap, const Context& ctx);
+
+    ControllerParams params;
+    size_t count = 0;
+
+    // 4 の倍数に切り上げた長さで持つ（末尾は使わない）
+    std::vector<float> posX, posY, velX, velY;
+    std::vector<float> halfWidth, height, runSpeed;
+    std::vector<float> moveX, jump, grounded;     // jump / grounded は 0 か 1
+    std::vector<uint8_t> dropThrough;
+    std::vector<int> groundSolid;                 // 乗っている MovingSolid（なければ -1）
+};
+
+
+#endif
@@ -0,0 +1,173 @@
+﻿/**********************************************************************************
+    CollisionMask.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/28
+
+**********************************************************************************/
+
+#include "CollisionMask.h"
+#include <DirectXMath.h>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace {
+
+    // row のビット s から 64 ビット分（範囲外は 0）。s は負でもよい
+    inline uint64_t Bits64(const uint64_t* row, int words, int s) {
+        if (s <= -64 || s >= words * 64) return 0;
+        if (s < 0) return row[0] << (-s);
+        int w = s >> 6;
+        int r = s & 63;
+        uint64_t v = row[w] >> r;
+        if (r != 0 && w + 1 < words) v |= row[w + 1] << (64 - r);
+        return v;
+    }
+
+    struct MaskView {
+        const uint64_t* bits;
+        int minX, minY, maxX, maxY;     // ワールド（グリッド）座標、両端を含む
+    };
+
+    MaskView View(const MaskInstance& m) {
+        const CollisionMask& mask = *m.mask;
+        MaskView v;
+        v.bits = m.flipX ? mask.mirrored.data() : mask.bits.data();
+        v.minX = m.x + (m.flipX ? mask.width - 1 - mask.maxX : mask.minX);
+        v.maxX = m.x + (m.flipX ? mask.width - 1 - mask.minX : mask.maxX);
+        v.minY = m.y + mask.minY;
+        v.maxY = m.y + mask.maxY;
+        return v;
+    }
+
+    void ComputeBounds(CollisionMask* mask) {
+        mask->minX = mask->width;
+        mask->minY = mask->height;
+        mask->maxX = -1;
+        mask->maxY = -1;
+        for (int y = 0; y < mask->height; y++) {
+            for (int x = 0; x < mask->width; x++) {
+                size_t word = static_cast<size_t>(y) * static_cast<size_t>(mask->wordsPerRow) + static_cast<size_t>(x >> 6);
+                if (!((mask->bits[word] >> (x & 63)) & 1)) continue;
+                mask->minX = std::min(mask->minX, x);
+                mask->maxX = std::max(mask->maxX, x);
+                mask->minY = std::min(mask->minY, y);
+                mask->maxY = std::max(mask->maxY, y);
+            }
+        }
+    }
+
+    void Allocate(CollisionMask* mask, int width, int height) {
+        mask->width = width;
+        mask->height = height;
+        mask->wordsPerRow = (width + 63) / 64;
+        size_t words = static_cast<size_t>(mask->wordsPerRow) * static_cast<size_t>(height);
+        mask->bits.assign(words, 0);
+        mask->mirrored.assign(words, 0);
+    }
+
+    void SetPixel(CollisionMask* mask, int x, int y) {
+        size_t row = static_cast<size_t>(y) * static_cast<size_t>(mask->wordsPerRow);
+        int mx = mask->width - 1 - x;
+        mask->bits[row + static_cast<size_t>(x >> 6)] |= uint64_t(1) << (x & 63);
+        mask->mirrored[row + static_cast<size_t>(mx >> 6)] |= uint64_t(1) << (mx & 63);
+    }
+}
+
+
+void BuildCollisionMasks(const uint8_t* pixels, int width, int height, size_t rowPitch,
+    int columns, int rows, int frames, uint8_t alphaThreshold, std::vector<CollisionMask>* out) {
+
+    out->clear();
+    if (columns <= 0 || rows <= 0) return;
+    int frameW = width / columns;
+    int frameH = height / rows;
+    frames = std::min(frames, columns * rows);
+    out->resize(static_cast<size_t>(std::max(frames, 0)));
+
+    for (int f = 0; f < frames; f++) {
+        CollisionMask& mask = (*out)[static_cast<size_t>(f)];
+        Allocate(&mask, frameW, frameH);
+        int x0 = (f % columns) * frameW;
+        int y0 = (f / columns) * frameH;
+        for (int y = 0; y < frameH; y++) {
+            const uint8_t* src = pixels + static_cast<size_t>(y0 + y) * rowPitch + static_cast<size_t>(x0) * 4;
+            for (int x = 0; x < frameW; x++) {
+                if (src[x * 4 + 3] >= alphaThreshold) SetPixel(&mask, x, y);
+            }
+        }
+        ComputeBounds(&mask);
+    }
+}
+
+CollisionMask MakeBoxMask(int width, int height) {
+    CollisionMask mask;
+    Allocate(&mask, width, height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) SetPixel(&mask, x, y);
+    }
+    ComputeBounds(&mask);
+    return mask;
+}
+
+bool MasksOverlap(const MaskInstance& a, const MaskInstance& b) {
+    if (a.mask->IsEmpty() || b.mask->IsEmpty()) return false;
+
+    // まず 1 が立っている範囲同士
+    MaskView va = View(a);
+    MaskView vb = View(b);
+    int x0 = std::max(va.minX, vb.minX);
+    int x1 = std::min(va.maxX, vb.maxX);
+    int y0 = std::max(va.minY, vb.minY);
+    int y1 = std::min(va.maxY, vb.maxY);
+    if (x0 > x1 || y0 > y1) return false;
+
+    // A の 64 ビット語ごとに、同じ位置の B のビットをずらして取り出し、2 語ずつ AND する
+    // B の外は 0 が返るので、重なり範囲の外のビットは気にしなくてよい
+    const int wordsA = a.mask->wordsPerRow;
+    const int wordsB = b.mask->wordsPerRow;
+    const int k0 = (x0 - a.x) >> 6;
+    const int k1 = (x1 - a.x) >> 6;
+    const int dx = b.x - a.x;
+    const XMVECTOR zero = XMVectorZero();
+
+    for (int y = y0; y <= y1; y++) {
+        const uint64_t* rowA = va.bits + static_cast<size_t>(y - a.y) * static_cast<size_t>(wordsA);
+        const uint64_t* rowB = vb.bits + static_cast<size_t>(y - b.y) * static_cast<size_t>(wordsB);
+        for (int k = k0; k <= k1; k += 2) {
+            alignas(16) uint64_t wa[2] = { rowA[k], k + 1 <= k1 ? rowA[k + 1] : 0 };
+            alignas(16) uint64_t wb[2] = { Bits64(rowB, wordsB, k * 64 - dx), Bits64(rowB, wordsB, (k + 1) * 64 - dx) };
+            XMVECTOR hit = XMVectorAndInt(XMLoadInt4(reinterpret_cast<const uint32_t*>(wa)),
+                XMLoadInt4(reinterpret_cast<const uint32_t*>(wb)));
+            if (!XMVector4EqualInt(hit, zero)) return true;
+        }
+    }
+    return false;
+}
+
+size_t FindMaskOverlaps(const MaskInstance* instances, size_t count, std::vector<std::pair<uint32_t, uint32_t>>* out) {
+    size_t before = out->size();
+
+    std::vector<MaskView> views;
+    std::vector<uint32_t> order;
+    views.reserve(count);
+    order.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        views.push_back(instances[i].mask && !instances[i].mask->IsEmpty() ? View(instances[i]) : MaskView{ nullptr, 0, 0, -1, -1 });
+        if (views.back().bits) order.push_back(static_cast<uint32_t>(i));
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t l, uint32_t r) { return views[l].minX < views[r].minX; });
+
+    for (size_t i = 0; i < order.size(); i++) {
+        const MaskView& vi = views[order[i]];
+        for (size_t j = i + 1; j < order.size(); j++) {
+            const MaskView& vj = views[order[j]];
+            if (vj.minX > vi.maxX) break;
+            if (vj.minY > vi.maxY || vi.minY > vj.maxY) continue;
+            if (!MasksOverlap(instances[order[i]], instances[order[j]])) continue;
+            out->push_back({ std::min(order[i], order[j]), std::max(order[i], order[j]) });
+        }
+    }
+    return out->size() - before;
+}
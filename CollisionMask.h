@@ -0,0 +1,57 @@
+﻿/**********************************************************************************
+    CollisionMask.h
+
+                                                                LI WENHUI
+                                                                2025/08/28
+
+**********************************************************************************/
+
+#ifndef COLLISIONMASK_H
+#define COLLISIONMASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//
+// スプライト 1 フレーム分の 1 ビットの当たりマスク（アルファがしきい値以上なら 1）
+// 行ごとに 64 ビット単位で詰め、左端のピクセルが最下位ビット。
+// uFlipX と同じ左右反転を最初から持っておくので、反転しても判定のコストは変わらない
+struct CollisionMask {
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> bits;
+    std::vector<uint64_t> mirrored;
+
+    // 1 が立っている範囲（空なら minX > maxX）。反転時は左右を入れ替えて使う
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+
+    bool IsEmpty() const { return minX > maxX; }
+};
+
+// 判定に使う 1 体分。x, y はマスク左上のピクセル座標（全員同じ縮尺のグリッドで）
+struct MaskInstance {
+    const CollisionMask* mask = nullptr;
+    int x = 0;
+    int y = 0;
+    bool flipX = false;
+};
+
+//
+// RGBA8 のシートを columns x rows に割って、先頭から frames 枚分のマスクを作る（アルファは各ピクセルの 4 バイト目）
+void BuildCollisionMasks(const uint8_t* pixels, int width, int height, size_t rowPitch,
+    int columns, int rows, int frames, uint8_t alphaThreshold, std::vector<CollisionMask>* out);
+
+// 全面が 1 の矩形マスク（絵のないものを同じ判定に混ぜるとき）
+CollisionMask MakeBoxMask(int width, int height);
+
+// 1 が立っている範囲の矩形同士で先に弾いてから、重なる行だけビット AND で調べる
+bool MasksOverlap(const MaskInstance& a, const MaskInstance& b);
+
+// x 方向のソート＆スイープで候補を絞り、重なっている組を (i, j) (i < j) で返す
+size_t FindMaskOverlaps(const MaskInstance* instances, size_t count, std::vector<std::pair<uint32_t, uint32_t>>* out);
+
+
+#endif
@@ -18,7 +18,8 @@ struct ConstantBuffer {
     float texOffset[2];
     float texScale[2];
 	uint32_t uFlipX;
-    float pad[3];
+    float alpha;    // クロスフェード用の不透明度
+    float pad[2];
 };
 
 
@@ -0,0 +1,200 @@
+﻿/**********************************************************************************
+    DynamicResolution.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "DynamicResolution.h"
+#include "BufferUtils.h"
+#include "SpriteBatch.h"
+#include "Profiler.h"
+#include <cmath>
+
+DynamicResolution::DynamicResolution()
+    : texture(nullptr),
+    rtv(nullptr),
+    srv(nullptr),
+    clampSampler(nullptr),
+    frame(0),
+    width(0),
+    height(0),
+    sceneWidth(0),
+    sceneHeight(0),
+    fixedScale(0.0f)
+{
+
+}
+
+DynamicResolution::~DynamicResolution() {
+    Release();
+}
+
+void DynamicResolution::Release() {
+    SAFE_RELEASE(srv);
+    SAFE_RELEASE(rtv);
+    SAFE_RELEASE(texture);
+    SAFE_RELEASE(clampSampler);
+    for (FrameQueries& q : queries) {
+        SAFE_RELEASE(q.disjoint);
+        SAFE_RELEASE(q.begin);
+        SAFE_RELEASE(q.end);
+        q.issued = false;
+    }
+}
+
+bool DynamicResolution::Init(ID3D11Device* device, UINT width, UINT height, const ResolutionScalerDesc& desc) {
+    Release();
+    scaler.SetDesc(desc);
+
+    // 引き伸ばし用。クランプが効くのはテクスチャの端だけで、描いた範囲（sceneWidth x sceneHeight）の端は Upscale の UV で守る
+    D3D11_SAMPLER_DESC sampDesc = {};
+    sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    if (FAILED(device->CreateSamplerState(&sampDesc, &clampSampler))) return false;
+
+    // タイムスタンプが使えなくても描画はできる（倍率が変わらないだけ）
+    for (FrameQueries& q : queries) {
+        D3D11_QUERY_DESC qd = {};
+        qd.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+        device->CreateQuery(&qd, &q.disjoint);
+        qd.Query = D3D11_QUERY_TIMESTAMP;
+        device->CreateQuery(&qd, &q.begin);
+        device->CreateQuery(&qd, &q.end);
+    }
+    return Resize(device, width, height);
+}
+
+bool DynamicResolution::Resize(ID3D11Device* device, UINT newWidth, UINT newHeight) {
+    SAFE_RELEASE(srv);
+    SAFE_RELEASE(rtv);
+    SAFE_RELEASE(texture);
+    width = newWidth;
+    height = newHeight;
+
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width = width;
+    td.Height = height;
+    td.MipLevels = 1;
+    td.ArraySize = 1;
+    td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_DEFAULT;
+    td.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+    if (FAILED(device->CreateTexture2D(&td, nullptr, &texture))) return false;
+    TrackTexture(texture, "DynamicResolution", "scene");
+    if (FAILED(device->CreateRenderTargetView(texture, nullptr, &rtv))) return false;
+    return SUCCEEDED(device->CreateShaderResourceView(texture, nullptr, &srv));
+}
+
+void DynamicResolution::SetFixedScale(float scale) {
+    fixedScale = scale;
+}
+
+void DynamicResolution::BeginScene(ID3D11DeviceContext* context, ID3D11DepthStencilView* depth, const float clearColor[4]) {
+    float scale = GetScale();
+    sceneWidth = static_cast<UINT>(std::lround(static_cast<float>(width) * scale));
+    sceneHeight = static_cast<UINT>(std::lround(static_cast<float>(height) * scale));
+    if (sceneWidth == 0) sceneWidth = 1;
+    if (sceneHeight == 0) sceneHeight = 1;
+
+    FrameQueries& q = queries[frame % kQueryFrames];
+    if (q.disjoint && q.begin && q.end) {
+        context->Begin(q.disjoint);
+        context->End(q.begin);
+    }
+
+    // 前のフレームで貼ったときの入力に残っていると描き先にできないので外す
+    ID3D11ShaderResourceView* none = nullptr;
+    context->PSSetShaderResources(0, 1, &none);
+
+    context->OMSetRenderTargets(1, &rtv, depth);
+    context->ClearRenderTargetView(rtv, clearColor);
+
+    D3D11_VIEWPORT vp = {};
+    vp.Width = static_cast<FLOAT>(sceneWidth);
+    vp.Height = static_cast<FLOAT>(sceneHeight);
+    vp.MinDepth = 0.0f;
+    vp.MaxDepth = 1.0f;
+    context->RSSetViewports(1, &vp);
+}
+
+void DynamicResolution::Upscale(ID3D11DeviceContext* context, ID3D11RenderTargetView* backBuffer, SpriteBatch* batch,
+    const DirectX::XMMATRIX& projection, ID3D11BlendState* opaqueBlend, ID3D11SamplerState* restoreSampler,
+    float logicalWidth, float logicalHeight) {
+    PROFILE_ZONE("DynamicResolution::Upscale");
+
+    context->OMSetRenderTargets(1, &backBuffer, nullptr);
+    D3D11_VIEWPORT vp = {};
+    vp.Width = static_cast<FLOAT>(width);
+    vp.Height = static_cast<FLOAT>(height);
+    vp.MinDepth = 0.0f;
+    vp.MaxDepth = 1.0f;
+    context->RSSetViewports(1, &vp);
+
+    // 描いたのはテクスチャの左上 sceneWidth x sceneHeight だけ。倍率が 1 未満だとその外はクリアした色なので、
+    // 両端を半テクセル内側にして、バイリニアが描いた範囲の外のテクセルを混ぜないようにする
+    float u0 = 0.5f / static_cast<float>(width);
+    float v0 = 0.5f / static_cast<float>(height);
+    float u1 = (static_cast<float>(sceneWidth) - 0.5f) / static_cast<float>(width);
+    float v1 = (static_cast<float>(sceneHeight) - 0.5f) / static_cast<float>(height);
+    SpriteQuad q;
+    q.pos[0] = { 0.0f, 0.0f };
+    q.pos[1] = { logicalWidth, 0.0f };
+    q.pos[2] = { logicalWidth, logicalHeight };
+    q.pos[3] = { 0.0f, logicalHeight };
+    q.uv[0] = { u0, v0 };
+    q.uv[1] = { u1, v0 };
+    q.uv[2] = { u1, v1 };
+    q.uv[3] = { u0, v1 };
+    q.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    q.depth = 0.0f;
+
+    context->OMSetBlendState(opaqueBlend, nullptr, 0xffffffff);
+    context->PSSetSamplers(0, 1, &clampSampler);
+    batch->Begin(context, DirectX::XMMatrixIdentity(), projection);
+    batch->Draw(srv, &q, 1);
+    batch->End();
+    context->PSSetSamplers(0, 1, &restoreSampler);
+
+    FrameQueries& fq = queries[frame % kQueryFrames];
+    if (fq.disjoint && fq.begin && fq.end) {
+        context->End(fq.end);
+        context->End(fq.disjoint);
+        fq.issued = true;
+    }
+}
+
+float DynamicResolution::EndFrame(ID3D11DeviceContext* context) {
+    frame++;
+
+    // 次に使う（一番古い）スロットを読む。まだ終わっていなければその分は捨てる
+    FrameQueries& q = queries[frame % kQueryFrames];
+    if (!q.issued) return -1.0f;
+    q.issued = false;
+
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint = {};
+    UINT64 begin = 0, end = 0;
+    if (context->GetData(q.disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return -1.0f;
+    if (context->GetData(q.begin, &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return -1.0f;
+    if (context->GetData(q.end, &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return -1.0f;
+    // 途中でクロックが変わったフレームは時間が当てにならない
+    if (disjoint.Disjoint || disjoint.Frequency == 0 || end < begin) return -1.0f;
+
+    float ms = static_cast<float>(static_cast<double>(end - begin) * 1000.0 / static_cast<double>(disjoint.Frequency));
+    if (fixedScale <= 0.0f) scaler.Update(ms);
+    return ms;
+}
+
+float DynamicResolution::GetScale() const {
+    return fixedScale > 0.0f ? (fixedScale < 1.0f ? fixedScale : 1.0f) : scaler.GetScale();
+}
+
+const ResolutionScaler& DynamicResolution::GetScaler() const {
+    return scaler;
+}
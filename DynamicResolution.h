@@ -0,0 +1,72 @@
+﻿/**********************************************************************************
+    DynamicResolution.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include "d3dApp.h"
+#include "ResolutionScaler.h"
+
+class SpriteBatch;
+
+//
+// シーンはバックバッファと同じ大きさのテクスチャの左上だけ（倍率分）に描き、最後に引き伸ばして貼る
+// テクスチャは最大の大きさで持っておくので、倍率が変わっても作り直さない（ウィンドウの大きさが変わったときだけ）
+// GPU の時間はタイムスタンプで測り、数フレーム遅れで ResolutionScaler に渡す
+class DynamicResolution {
+public:
+    DynamicResolution();
+    ~DynamicResolution();
+
+    bool Init(ID3D11Device* device, UINT width, UINT height, const ResolutionScalerDesc& desc);
+    bool Resize(ID3D11Device* device, UINT width, UINT height);
+    void Release();
+
+    // 0 より大きければ倍率を固定する（測った時間は使わない）
+    void SetFixedScale(float scale);
+
+    // シーンのテクスチャと depth を描き先にして、倍率分のビューポートにする
+    void BeginScene(ID3D11DeviceContext* context, ID3D11DepthStencilView* depth, const float clearColor[4]);
+
+    // backBuffer 全体に引き伸ばして貼る。projection は logicalWidth x logicalHeight を写すもの
+    void Upscale(ID3D11DeviceContext* context, ID3D11RenderTargetView* backBuffer, SpriteBatch* batch,
+        const DirectX::XMMATRIX& projection, ID3D11BlendState* opaqueBlend, ID3D11SamplerState* restoreSampler,
+        float logicalWidth, float logicalHeight);
+
+    // Present の後に呼ぶ。測り終わったフレームがあれば倍率を更新して、その GPU 時間を返す（なければ負）
+    float EndFrame(ID3D11DeviceContext* context);
+
+    float GetScale() const;
+    const ResolutionScaler& GetScaler() const;
+
+private:
+    static const int kQueryFrames = 4;     // GPU が何フレーム遅れても待たずに読めるように
+
+    struct FrameQueries {
+        ID3D11Query* disjoint = nullptr;
+        ID3D11Query* begin = nullptr;
+        ID3D11Query* end = nullptr;
+        bool issued = false;
+    };
+
+    ID3D11Texture2D* texture;
+    ID3D11RenderTargetView* rtv;
+    ID3D11ShaderResourceView* srv;
+    ID3D11SamplerState* clampSampler;
+    FrameQueries queries[kQueryFrames];
+    uint32_t frame;
+    UINT width;
+    UINT height;
+    UINT sceneWidth;        // 今フレームのビューポート
+    UINT sceneHeight;
+    float fixedScale;
+    ResolutionScaler scaler;
+};
+
+
+#endif
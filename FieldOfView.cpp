@@ -0,0 +1,195 @@
+﻿/**********************************************************************************
+    FieldOfView.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/25
+
+**********************************************************************************/
+
+#include "FieldOfView.h"
+#include "TileMap.h"
+#include "Aabb.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+/*
+    Symmetric Shadowcasting
+    4 つの象限ごとに、視点から 1 行ずつ外へ走査する。行は [startSlope, endSlope] の
+    範囲だけを見る。壁の切れ目で範囲を狭めた行をスタックに積んでいく。
+    傾きは (2col - 1) / (2depth) の形しか出てこないので、誤差の出ない分数で持つ。
+*/
+
+namespace {
+
+    struct Slope {
+        int num;
+        int den;
+    };
+
+    struct Row {
+        int depth;
+        Slope start;
+        Slope end;
+    };
+
+    // floor(depth * s + 0.5)
+    int RoundTiesUp(int depth, Slope s) {
+        int n = 2 * depth * s.num + s.den;
+        int d = 2 * s.den;
+        return n >= 0 ? n / d : -((-n + d - 1) / d);
+    }
+
+    // ceil(depth * s - 0.5)
+    int RoundTiesDown(int depth, Slope s) {
+        int n = 2 * depth * s.num - s.den;
+        int d = 2 * s.den;
+        return n >= 0 ? (n + d - 1) / d : -((-n) / d);
+    }
+
+    Slope TileSlope(int depth, int col) {
+        return { 2 * col - 1, 2 * depth };
+    }
+
+    // col が行の範囲 [depth*start, depth*end] に入っているか
+    bool IsSymmetric(const Row& row, int col) {
+        return col * row.start.den >= row.depth * row.start.num
+            && col * row.end.den <= row.depth * row.end.num;
+    }
+
+    void Transform(int quadrant, int ox, int oy, int depth, int col, int* x, int* y) {
+        switch (quadrant) {
+        case 0: *x = ox + col;   *y = oy - depth; break;   // 上
+        case 1: *x = ox + col;   *y = oy + depth; break;   // 下
+        case 2: *x = ox + depth; *y = oy + col;   break;   // 右
+        default: *x = ox - depth; *y = oy + col;  break;   // 左
+        }
+    }
+
+    void MarkVisible(FovResult* out, int x, int y) {
+        int lx = x - out->originX + out->radius;
+        int ly = y - out->originY + out->radius;
+        int size = out->radius * 2 + 1;
+        if (lx < 0 || ly < 0 || lx >= size || ly >= size) return;
+        size_t bit = static_cast<size_t>(ly) * static_cast<size_t>(size) + static_cast<size_t>(lx);
+        out->bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+}
+
+
+bool FovResult::IsVisible(int tileX, int tileY) const {
+    int lx = tileX - originX + radius;
+    int ly = tileY - originY + radius;
+    int size = radius * 2 + 1;
+    if (lx < 0 || ly < 0 || lx >= size || ly >= size) return false;
+    size_t bit = static_cast<size_t>(ly) * static_cast<size_t>(size) + static_cast<size_t>(lx);
+    return (bits[bit >> 6] >> (bit & 63)) & 1;
+}
+
+bool FovResult::IsAreaVisible(const Aabb& area, float tileSize) const {
+    // 半径の外は見えないので、調べるのは重なる所だけ
+    float invTile = 1.0f / tileSize;
+    int x0 = std::max(static_cast<int>(std::floor(area.minX * invTile)), originX - radius);
+    int y0 = std::max(static_cast<int>(std::floor(area.minY * invTile)), originY - radius);
+    int x1 = std::min(static_cast<int>(std::floor(area.maxX * invTile)), originX + radius);
+    int y1 = std::min(static_cast<int>(std::floor(area.maxY * invTile)), originY + radius);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            if (IsVisible(x, y)) return true;
+        }
+    }
+    return false;
+}
+
+void ComputeFov(const TileMap& map, int originX, int originY, int radius, FovResult* out) {
+    int size = radius * 2 + 1;
+    out->originX = originX;
+    out->originY = originY;
+    out->radius = radius;
+    out->bits.assign((static_cast<size_t>(size) * static_cast<size_t>(size) + 63) / 64, 0);
+
+    MarkVisible(out, originX, originY);
+    const int r2 = radius * radius;
+
+    std::vector<Row> stack;
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        stack.push_back({ 1, { -1, 1 }, { 1, 1 } });
+
+        while (!stack.empty()) {
+            Row row = stack.back();
+            stack.pop_back();
+            if (row.depth > radius) continue;
+
+            int minCol = RoundTiesUp(row.depth, row.start);
+            int maxCol = RoundTiesDown(row.depth, row.end);
+
+            // -1 = まだ前のタイルなし, 0 = 床, 1 = 壁
+            int prev = -1;
+            for (int col = minCol; col <= maxCol; col++) {
+                int x, y;
+                Transform(quadrant, originX, originY, row.depth, col, &x, &y);
+                int wall = map.IsOpaque(x, y) ? 1 : 0;
+
+                if ((wall || IsSymmetric(row, col)) && col * col + row.depth * row.depth <= r2) {
+                    MarkVisible(out, x, y);
+                }
+                if (prev == 1 && !wall) {
+                    row.start = TileSlope(row.depth, col);
+                }
+                if (prev == 0 && wall) {
+                    stack.push_back({ row.depth + 1, row.start, TileSlope(row.depth, col) });
+                }
+                prev = wall;
+            }
+            if (prev == 0) {
+                stack.push_back({ row.depth + 1, row.start, row.end });
+            }
+        }
+    }
+}
+
+bool FovNeedsUpdate(const TileMap& map, const FovViewer& viewer) {
+    if (!viewer.valid) return true;
+    if (viewer.result.originX != viewer.tileX || viewer.result.originY != viewer.tileY) return true;
+    if (viewer.result.radius != viewer.radius) return true;
+    if (map.GetRevision() == viewer.computedRevision) return false;
+
+    // 半径内に掛かるチャンクだけを調べる
+    int cx0 = (viewer.tileX - viewer.radius) / TileMap::kChunkSize;
+    int cy0 = (viewer.tileY - viewer.radius) / TileMap::kChunkSize;
+    int cx1 = (viewer.tileX + viewer.radius) / TileMap::kChunkSize;
+    int cy1 = (viewer.tileY + viewer.radius) / TileMap::kChunkSize;
+    for (int cy = std::max(cy0, 0); cy <= cy1; cy++) {
+        for (int cx = std::max(cx0, 0); cx <= cx1; cx++) {
+            if (map.GetChunkRevision(cx, cy) > viewer.computedRevision) return true;
+        }
+    }
+    return false;
+}
+
+size_t UpdateFovViewers(const TileMap& map, FovViewer* viewers, size_t count, JobSystem* jobs) {
+    PROFILE_ZONE("UpdateFovViewers");
+    std::vector<size_t> dirty;
+    for (size_t i = 0; i < count; i++) {
+        if (FovNeedsUpdate(map, viewers[i])) {
+            dirty.push_back(i);
+        }
+        else {
+            viewers[i].computedRevision = map.GetRevision();
+        }
+    }
+
+    auto job = [&](size_t begin, size_t end) {
+        for (size_t d = begin; d < end; d++) {
+            FovViewer& v = viewers[dirty[d]];
+            ComputeFov(map, v.tileX, v.tileY, v.radius, &v.result);
+            v.computedRevision = map.GetRevision();
+            v.valid = true;
+        }
+    };
+    if (jobs) jobs->ParallelFor(dirty.size(), 16, job);
+    else job(0, dirty.size());
+
+    return dirty.size();
+}
@@ -0,0 +1,56 @@
+﻿/**********************************************************************************
+    FieldOfView.h
+
+                                                                LI WENHUI
+                                                                2025/08/25
+
+**********************************************************************************/
+
+#ifndef FIELDOFVIEW_H
+#define FIELDOFVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TileMap;
+class JobSystem;
+struct Aabb;
+
+//
+// 視点を中心とした (2r+1) x (2r+1) タイルの可視ビットセット
+struct FovResult {
+    int originX = 0;
+    int originY = 0;
+    int radius = 0;
+    std::vector<uint64_t> bits;
+
+    bool IsVisible(int tileX, int tileY) const;
+    // ワールド座標の矩形にかかるタイルが 1 つでも見えるか
+    bool IsAreaVisible(const Aabb& area, float tileSize) const;
+};
+
+//
+// 視点ごとの状態。セルを移動したか、半径内のチャンクが変わったときだけ再計算する
+struct FovViewer {
+    int tileX = 0;
+    int tileY = 0;
+    int radius = 12;
+    FovResult result;
+    uint32_t computedRevision = 0;  // 計算時の TileMap::GetRevision()
+    bool valid = false;
+};
+
+//
+// 対称シャドウキャスティング（視点 A から B が見えるなら B から A も見える）
+void ComputeFov(const TileMap& map, int originX, int originY, int radius, FovResult* out);
+
+// 再計算が必要か（セル移動・半径変更・周辺チャンクの変更）
+bool FovNeedsUpdate(const TileMap& map, const FovViewer& viewer);
+
+//
+// 必要な視点だけをまとめて再計算する。戻り値は再計算した数
+size_t UpdateFovViewers(const TileMap& map, FovViewer* viewers, size_t count, JobSystem* jobs);
+
+
+#endif
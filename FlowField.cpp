@@ -0,0 +1,335 @@
+﻿/**********************************************************************************
+    FlowField.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/26
+
+**********************************************************************************/
+
+#include "FlowField.h"
+#include "TileMap.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace {
+    constexpr float kWalkCost = 1.0f;
+    constexpr float kSlopeCost = 1.4f;
+    constexpr float kJumpCostPerTile = 1.5f;
+    constexpr float kFallCostPerTile = 0.5f;
+
+    bool IsSlope(TileType t) {
+        return t == TileType::SlopeUp || t == TileType::SlopeDown;
+    }
+}
+
+
+void FlowField::SetJumpLimits(int height, int reach) {
+    jumpHeight = std::clamp(height, 0, TileMap::kChunkSize - 1);
+    jumpReach = std::clamp(reach, 0, TileMap::kChunkSize - 1);
+    std::fill(seenRevisions.begin(), seenRevisions.end(), 0u);
+}
+
+int FlowField::GetWidth() const {
+    return width;
+}
+
+int FlowField::GetHeight() const {
+    return height;
+}
+
+bool FlowField::IsPassable(const TileMap& map, int x, int y) const {
+    if (x < 0 || y < 0 || x >= width || y >= height) return false;
+    return map.GetTile(x, y) != TileType::Solid;
+}
+
+// 坂のセルか、真下が壁か一方通行の足場なら立てる
+bool FlowField::IsStandable(const TileMap& map, int x, int y) const {
+    if (!IsPassable(map, x, y)) return false;
+    if (IsSlope(map.GetTile(x, y))) return true;
+    TileType below = map.GetTile(x, y + 1);
+    return below == TileType::Solid || below == TileType::OneWay;
+}
+
+void FlowField::BuildLanding(const TileMap& map, int x0, int x1) {
+    for (int x = x0; x < x1; x++) {
+        // 下から上へ。マップの下端より下は壁なので、一番下の行は必ず着地できる
+        uint32_t land = kNone;
+        for (int y = height - 1; y >= 0; y--) {
+            uint32_t cell = static_cast<uint32_t>(y * width + x);
+            if (!IsPassable(map, x, y)) land = kNone;
+            else if (IsStandable(map, x, y)) land = cell;
+            landing[cell] = land;
+        }
+    }
+}
+
+void FlowField::BuildChunkEdges(const TileMap& map, int chunk) {
+    std::vector<Edge>& edges = chunkEdges[static_cast<size_t>(chunk)];
+    edges.clear();
+
+    int cx = chunk % chunksX;
+    int cy = chunk / chunksX;
+    int x0 = cx * TileMap::kChunkSize;
+    int y0 = cy * TileMap::kChunkSize;
+    int x1 = std::min(x0 + TileMap::kChunkSize, width);
+    int y1 = std::min(y0 + TileMap::kChunkSize, height);
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            if (!IsStandable(map, x, y)) continue;
+            uint32_t from = static_cast<uint32_t>(y * width + x);
+            size_t first = edges.size();
+
+            // 同じ行き先なら安いほうだけ残す
+            auto add = [&](uint32_t to, float cost, FlowMove move) {
+                if (to == kNone || to == from) return;
+                for (size_t i = first; i < edges.size(); i++) {
+                    if (edges[i].to != to) continue;
+                    if (cost < edges[i].cost) {
+                        edges[i].cost = cost;
+                        edges[i].move = move;
+                    }
+                    return;
+                }
+                edges.push_back({ from, to, cost, move });
+            };
+
+            bool onSlope = IsSlope(map.GetTile(x, y));
+            for (int s = -1; s <= 1; s += 2) {
+                int nx = x + s;
+
+                // 歩き。隣に足場がなければ落ちる（1 段下の坂なら歩いて下りる）
+                if (IsStandable(map, nx, y)) {
+                    add(static_cast<uint32_t>(y * width + nx), kWalkCost, FlowMove::Walk);
+                }
+                else if (IsPassable(map, nx, y)) {
+                    uint32_t land = landing[static_cast<size_t>(y * width + nx)];
+                    if (land != kNone) {
+                        int drop = static_cast<int>(land) / width - y;
+                        if (drop == 1 && (onSlope || IsSlope(map.GetTile(nx, y + 1)))) {
+                            add(land, kSlopeCost, FlowMove::Walk);
+                        }
+                        else {
+                            add(land, kWalkCost + drop * kFallCostPerTile, FlowMove::Fall);
+                        }
+                    }
+                }
+
+                // 坂を上る
+                if (IsStandable(map, nx, y - 1) && IsPassable(map, x, y - 1)
+                    && (onSlope || IsSlope(map.GetTile(nx, y - 1)))) {
+                    add(static_cast<uint32_t>((y - 1) * width + nx), kSlopeCost, FlowMove::Walk);
+                }
+            }
+
+            // ジャンプ：真上に h 上がり、頂点の高さで横に d 進んでから落ちる
+            for (int h = 1; h <= jumpHeight; h++) {
+                int ay = y - h;
+                if (!IsPassable(map, x, ay)) break;
+                float rise = h * kJumpCostPerTile;
+
+                uint32_t straight = landing[static_cast<size_t>(ay * width + x)];
+                if (straight != kNone && static_cast<int>(straight) / width < y) {
+                    add(straight, rise + (static_cast<int>(straight) / width - ay) * kFallCostPerTile, FlowMove::Jump);
+                }
+                for (int s = -1; s <= 1; s += 2) {
+                    for (int d = 1; d <= jumpReach; d++) {
+                        int tx = x + s * d;
+                        if (!IsPassable(map, tx, ay)) break;
+                        uint32_t land = landing[static_cast<size_t>(ay * width + tx)];
+                        if (land == kNone) continue;
+                        int drop = static_cast<int>(land) / width - ay;
+                        add(land, rise + d * kWalkCost + drop * kFallCostPerTile, FlowMove::Jump);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void FlowField::BuildReverse() {
+    size_t cells = static_cast<size_t>(width) * static_cast<size_t>(height);
+    reverseOffsets.assign(cells + 1, 0);
+    size_t total = 0;
+    for (const std::vector<Edge>& edges : chunkEdges) {
+        for (const Edge& e : edges) reverseOffsets[e.to + 1]++;
+        total += edges.size();
+    }
+    for (size_t i = 0; i < cells; i++) reverseOffsets[i + 1] += reverseOffsets[i];
+
+    reverseEdges.resize(total);
+    std::vector<uint32_t> cursor(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    for (const std::vector<Edge>& edges : chunkEdges) {
+        for (const Edge& e : edges) reverseEdges[cursor[e.to]++] = e;
+    }
+}
+
+int FlowField::Sync(const TileMap& map, JobSystem* jobs) {
+    PROFILE_ZONE("FlowField::Sync");
+    std::vector<uint8_t> dirty;
+    if (map.GetWidth() != width || map.GetHeight() != height) {
+        width = map.GetWidth();
+        height = map.GetHeight();
+        chunksX = map.GetChunkCountX();
+        chunksY = map.GetChunkCountY();
+        size_t chunks = static_cast<size_t>(chunksX) * static_cast<size_t>(chunksY);
+        seenRevisions.assign(chunks, 0);
+        chunkEdges.assign(chunks, {});
+        landing.assign(static_cast<size_t>(width) * static_cast<size_t>(height), kNone);
+        goal = kNone;
+    }
+
+    // 変わったチャンクから、そこへ落ちる・跳ぶ辺を持ちうるチャンクを広げる
+    // （横は隣まで、縦は 1 つ下から上全部）
+    // 着地点は列の中のタイルだけで決まるので、作り直すのは変わったチャンクの列だけ
+    dirty.assign(seenRevisions.size(), 0);
+    std::vector<uint8_t> dirtyColumns(static_cast<size_t>(chunksX), 0);
+    bool any = false;
+    for (int cy = 0; cy < chunksY; cy++) {
+        for (int cx = 0; cx < chunksX; cx++) {
+            size_t c = static_cast<size_t>(cy * chunksX + cx);
+            uint32_t rev = map.GetChunkRevision(cx, cy);
+            if (rev == seenRevisions[c]) continue;
+            seenRevisions[c] = rev;
+            dirtyColumns[static_cast<size_t>(cx)] = 1;
+            any = true;
+            for (int y = 0; y <= std::min(cy + 1, chunksY - 1); y++) {
+                for (int x = std::max(cx - 1, 0); x <= std::min(cx + 1, chunksX - 1); x++) {
+                    dirty[static_cast<size_t>(y * chunksX + x)] = 1;
+                }
+            }
+        }
+    }
+    if (!any) return 0;
+
+    std::vector<int> rebuild;
+    for (size_t c = 0; c < dirty.size(); c++) {
+        if (dirty[c]) rebuild.push_back(static_cast<int>(c));
+    }
+    std::vector<int> columns;
+    for (int cx = 0; cx < chunksX; cx++) {
+        if (dirtyColumns[static_cast<size_t>(cx)]) columns.push_back(cx);
+    }
+
+    // 1) 変わった列の着地点  2) チャンクごとの辺。どちらもチャンク単位で独立
+    auto landingJob = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            int x0 = columns[i] * TileMap::kChunkSize;
+            BuildLanding(map, x0, std::min(x0 + TileMap::kChunkSize, width));
+        }
+    };
+    auto edgeJob = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) BuildChunkEdges(map, rebuild[i]);
+    };
+    if (jobs) {
+        jobs->ParallelFor(columns.size(), 1, landingJob);
+        jobs->ParallelFor(rebuild.size(), 1, edgeJob);
+    }
+    else {
+        landingJob(0, columns.size());
+        edgeJob(0, rebuild.size());
+    }
+
+    BuildReverse();
+    edgesChanged = true;
+    return static_cast<int>(rebuild.size());
+}
+
+uint32_t FlowField::Resolve(int tileX, int tileY) const {
+    if (tileX < 0 || tileX >= width || height == 0) return kNone;
+    tileY = std::clamp(tileY, 0, height - 1);
+    return landing[static_cast<size_t>(tileY * width + tileX)];
+}
+
+bool FlowField::SetGoal(int tileX, int tileY) {
+    uint32_t cell = Resolve(tileX, tileY);
+    if (cell == kNone) return false;
+    if (cell == goal && !edgesChanged) return false;
+    goal = cell;
+    edgesChanged = false;
+    Solve();
+    return true;
+}
+
+void FlowField::Solve() {
+    PROFILE_ZONE("FlowField::Solve");
+    size_t cells = static_cast<size_t>(width) * static_cast<size_t>(height);
+    distance.assign(cells, kUnreachable);
+    next.assign(cells, kNone);
+    nextMove.assign(cells, FlowMove::None);
+
+    using Entry = std::pair<float, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    distance[goal] = 0.0f;
+    open.push({ 0.0f, goal });
+
+    while (!open.empty()) {
+        Entry top = open.top();
+        open.pop();
+        uint32_t v = top.second;
+        if (top.first > distance[v]) continue;
+
+        for (uint32_t i = reverseOffsets[v]; i < reverseOffsets[v + 1]; i++) {
+            const Edge& e = reverseEdges[i];
+            float d = top.first + e.cost;
+            if (d < distance[e.from]) {
+                distance[e.from] = d;
+                next[e.from] = v;
+                nextMove[e.from] = e.move;
+                open.push({ d, e.from });
+            }
+        }
+    }
+}
+
+FlowStep FlowField::Sample(int tileX, int tileY) const {
+    FlowStep step;
+    step.distance = kUnreachable;
+    uint32_t cell = Resolve(tileX, tileY);
+    if (cell == kNone || distance.empty()) return step;
+
+    step.distance = distance[cell];
+    if (next[cell] == kNone) {
+        step.targetX = static_cast<int>(cell) % width;
+        step.targetY = static_cast<int>(cell) / width;
+        return step;
+    }
+    step.move = nextMove[cell];
+    step.targetX = static_cast<int>(next[cell]) % width;
+    step.targetY = static_cast<int>(next[cell]) / width;
+    return step;
+}
+
+float FlowField::GetDistance(int tileX, int tileY) const {
+    uint32_t cell = Resolve(tileX, tileY);
+    if (cell == kNone || distance.empty()) return kUnreachable;
+    return distance[cell];
+}
+
+void SteerAgents(const FlowField& field, const TileMap& map, ChaseAgent* agents, size_t count, JobSystem* jobs) {
+    PROFILE_ZONE("SteerAgents");
+    const float tileSize = map.GetTileSize();
+
+    auto job = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            ChaseAgent& a = agents[i];
+            // 足元ちょうどは下のタイルになるので少し上を引く
+            FlowStep step = field.Sample(map.WorldToTileX(a.x), map.WorldToTileY(a.y - 1.0f));
+            if (step.move == FlowMove::None) {
+                a.moveX = 0.0f;
+                a.jump = false;
+                continue;
+            }
+            float targetX = (static_cast<float>(step.targetX) + 0.5f) * tileSize;
+            float dx = targetX - a.x;
+            a.moveX = std::clamp(dx / (tileSize * 0.25f), -1.0f, 1.0f);
+            a.jump = step.move == FlowMove::Jump;
+        }
+    };
+    if (jobs) jobs->ParallelFor(count, 256, job);
+    else job(0, count);
+}
@@ -0,0 +1,112 @@
+﻿/**********************************************************************************
+    FlowField.h
+
+                                                                LI WENHUI
+                                                                2025/08/26
+
+**********************************************************************************/
+
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TileMap;
+class JobSystem;
+
+enum class FlowMove : uint8_t {
+    None,
+    Walk,
+    Jump,
+    Fall
+};
+
+// あるセルから次に向かうべきセル
+struct FlowStep {
+    FlowMove move = FlowMove::None;
+    int targetX = 0;
+    int targetY = 0;
+    float distance = 0.0f;      // ゴールまでのコスト
+};
+
+// 追跡者 1 体分の入力。位置から向きとジャンプを決める（移動そのものは別）
+struct ChaseAgent {
+    float x = 0.0f;             // 足元のワールド座標
+    float y = 0.0f;
+    float moveX = 0.0f;         // -1 .. 1
+    bool jump = false;
+    int body = -1;              // CharacterController の体
+    bool touchingPlayer = false;
+};
+
+//
+// プレイヤーを目標にした Dijkstra マップ
+// 立てるセルをノードにして、歩き・ジャンプ・落下の辺でつなぐ。
+// 全セルの「次のセル」を持っているので、エージェント数が増えても引くだけで済む
+class FlowField {
+public:
+    static constexpr float kUnreachable = 1e30f;
+
+    // ジャンプで届く高さと横の距離（タイル数、チャンクより小さいこと）
+    void SetJumpLimits(int height, int reach);
+
+    // 変わったチャンクとその周りだけ辺を作り直す。戻り値は作り直したチャンク数
+    int Sync(const TileMap& map, JobSystem* jobs);
+
+    // ゴールのセルか辺が変わったときだけ解き直す。空中なら真下の足場をゴールにする
+    bool SetGoal(int tileX, int tileY);
+
+    FlowStep Sample(int tileX, int tileY) const;
+    float GetDistance(int tileX, int tileY) const;
+
+    int GetWidth() const;
+    int GetHeight() const;
+
+private:
+    struct Edge {
+        uint32_t from;
+        uint32_t to;
+        float cost;
+        FlowMove move;
+    };
+
+    static constexpr uint32_t kNone = 0xffffffffu;
+
+    bool IsPassable(const TileMap& map, int x, int y) const;
+    bool IsStandable(const TileMap& map, int x, int y) const;
+    void BuildLanding(const TileMap& map, int x0, int x1);
+    void BuildChunkEdges(const TileMap& map, int chunk);
+    void BuildReverse();
+    void Solve();
+    uint32_t Resolve(int tileX, int tileY) const;
+
+    int width = 0;
+    int height = 0;
+    int chunksX = 0;
+    int chunksY = 0;
+    int jumpHeight = 3;
+    int jumpReach = 3;
+
+    std::vector<uint32_t> seenRevisions;        // チャンクごとの TileMap リビジョン
+    std::vector<std::vector<Edge>> chunkEdges;  // 出発セルのチャンクごと
+    std::vector<uint32_t> landing;              // そのセルから落ちて着くセル（立てなければ kNone）
+
+    // 逆向きの辺（Dijkstra はゴールから広げる）
+    std::vector<uint32_t> reverseOffsets;
+    std::vector<Edge> reverseEdges;
+
+    std::vector<float> distance;
+    std::vector<uint32_t> next;
+    std::vector<FlowMove> nextMove;
+    uint32_t goal = kNone;
+    bool edgesChanged = true;
+};
+
+//
+// エージェントごとに O(1) でフィールドを引いて moveX / jump を決める
+void SteerAgents(const FlowField& field, const TileMap& map, ChaseAgent* agents, size_t count, JobSystem* jobs);
+
+
+#endif
@@ -0,0 +1,120 @@
+﻿/**********************************************************************************
+    FramePacer.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "FramePacer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+    float ToMs(FramePacer::Clock::duration d) {
+        return std::chrono::duration<float, std::milli>(d).count();
+    }
+
+    FramePacer::Clock::duration FromMs(float ms) {
+        return std::chrono::duration_cast<FramePacer::Clock::duration>(std::chrono::duration<float, std::milli>(ms));
+    }
+}
+
+
+FramePacer::FramePacer(const FramePacerDesc& desc) {
+    SetDesc(desc);
+}
+
+void FramePacer::SetDesc(const FramePacerDesc& newDesc) {
+    desc = newDesc;
+    desc.maxSpinMarginMs = std::max(desc.maxSpinMarginMs, desc.spinMarginMs);
+    spinMarginMs = desc.spinMarginMs;
+    hasDeadline = false;
+}
+
+const FramePacerDesc& FramePacer::GetDesc() const {
+    return desc;
+}
+
+void FramePacer::SetWindowState(PacerWindowState newState) {
+    if (newState == state) return;
+    state = newState;
+    // 間隔が変わるので、次は今から数える
+    hasDeadline = false;
+}
+
+PacerWindowState FramePacer::GetWindowState() const {
+    return state;
+}
+
+float FramePacer::GetTargetMs() const {
+    float hz = desc.targetHz;
+    if (state == PacerWindowState::Minimized) hz = desc.minimizedHz;
+    else if (state == PacerWindowState::Unfocused && desc.unfocusedHz > 0.0f) {
+        hz = hz > 0.0f ? std::min(hz, desc.unfocusedHz) : desc.unfocusedHz;
+    }
+    return hz > 0.0f ? 1000.0f / hz : 0.0f;
+}
+
+float FramePacer::Wait() {
+    float targetMs = GetTargetMs();
+    Clock::time_point start = Clock::now();
+    if (targetMs <= 0.0f) {
+        hasDeadline = false;
+        lastErrorMs = 0.0f;
+        return 0.0f;
+    }
+
+    Clock::duration period = FromMs(targetMs);
+    if (!hasDeadline) {
+        deadline = start + period;
+        hasDeadline = true;
+    }
+    else {
+        deadline += period;
+        // 1 フレーム以上遅れていたら、取り戻そうと続けて走らないように今から数え直す
+        if (start > deadline) {
+            missed++;
+            lastErrorMs = ToMs(start - deadline);
+            deadline = start;
+            return 0.0f;
+        }
+    }
+
+    PROFILE_ZONE("FramePacer::Wait");
+    float remainingMs = ToMs(deadline - start);
+    if (remainingMs > spinMarginMs) {
+        float sleepMs = remainingMs - spinMarginMs;
+        Clock::time_point sleepStart = Clock::now();
+        std::this_thread::sleep_for(FromMs(sleepMs));
+        float overshootMs = ToMs(Clock::now() - sleepStart) - sleepMs;
+
+        // 遅れたらすぐ広げ、早く起きられる間は少しずつ狭める
+        float wanted = std::max(overshootMs * 1.25f, desc.spinMarginMs);
+        spinMarginMs = wanted > spinMarginMs ? wanted : spinMarginMs + (wanted - spinMarginMs) * 0.05f;
+        spinMarginMs = std::min(spinMarginMs, desc.maxSpinMarginMs);
+    }
+
+    // 残りは回って待つ
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+
+    Clock::time_point end = Clock::now();
+    lastErrorMs = ToMs(end - deadline);
+    return ToMs(end - start);
+}
+
+float FramePacer::GetLastErrorMs() const {
+    return lastErrorMs;
+}
+
+float FramePacer::GetSpinMarginMs() const {
+    return spinMarginMs;
+}
+
+uint64_t FramePacer::GetMissedCount() const {
+    return missed;
+}
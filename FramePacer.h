@@ -0,0 +1,68 @@
+﻿/**********************************************************************************
+    FramePacer.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <chrono>
+#include <cstdint>
+
+enum class PacerWindowState : uint8_t {
+    Active,
+    Unfocused,      // 別のウィンドウが前にある
+    Minimized,      // 最小化、または Present が隠れていると返した
+};
+
+struct FramePacerDesc {
+    float targetHz = 0.0f;          // 0 なら待たない（Present の垂直同期まかせ）
+    float unfocusedHz = 30.0f;      // フォーカスがないとき。0 なら Active と同じ
+    float minimizedHz = 10.0f;      // 最小化のとき（描画もしない）
+    // 眠りから起きるのが遅れる分を見込んで、期限のこれだけ前からは眠らずに回る
+    float spinMarginMs = 1.0f;
+    float maxSpinMarginMs = 4.0f;
+};
+
+//
+// 目標のフレーム間隔まで待つ。前半は眠り、期限の直前だけ回って待つ（眠りだけだと OS の都合で遅れる）
+// 入力を取り出す直前に呼ぶと、待った分が入力から表示までの遅れに入らない
+// 期限は前の期限から間隔ずつ進めるので、1 フレーム遅れても平均の間隔はずれない（大きく遅れたら今から数え直す）
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FramePacer(const FramePacerDesc& desc = FramePacerDesc());
+
+    void SetDesc(const FramePacerDesc& desc);
+    const FramePacerDesc& GetDesc() const;
+
+    void SetWindowState(PacerWindowState state);
+    PacerWindowState GetWindowState() const;
+
+    // 今の状態での間隔。0 なら待たない
+    float GetTargetMs() const;
+
+    // 次の期限まで待つ。待ったミリ秒を返す
+    float Wait();
+
+    // 最後に起きた時刻と期限の差（正なら遅れ）、眠りの遅れの見込み
+    float GetLastErrorMs() const;
+    float GetSpinMarginMs() const;
+    uint64_t GetMissedCount() const;
+
+private:
+    FramePacerDesc desc;
+    PacerWindowState state = PacerWindowState::Active;
+    Clock::time_point deadline;
+    bool hasDeadline = false;
+    float spinMarginMs = 1.0f;
+    float lastErrorMs = 0.0f;
+    uint64_t missed = 0;
+};
+
+
+#endif
@@ -0,0 +1,131 @@
+﻿/**********************************************************************************
+    GameWorld.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/30
+
+**********************************************************************************/
+
+#include "GameWorld.h"
+#include "TileMap.h"
+#include "FlowField.h"
+#include "CharacterController.h"
+#include "InputSystem.h"
+#include "Profiler.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+    template <typename T>
+    uint64_t HashValue(const T& value, uint64_t hash) {
+        return HashBytes(&value, sizeof(T), hash);
+    }
+}
+
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+GameWorld::GameWorld() = default;
+GameWorld::~GameWorld() = default;
+
+bool ReadAssetText(const wchar_t* path, std::string* out) {
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    *out = buffer.str();
+    return true;
+}
+
+bool InitGameWorld(GameWorld* world, const std::string& mapText, const GameWorldDesc& desc, JobSystem* jobs, std::string* error) {
+    PROFILE_ZONE("InitGameWorld");
+    world->tileMap = std::make_unique<TileMap>();
+    if (!world->tileMap->ParseText(mapText, desc.tileSize, error)) return false;
+    world->mapHash = HashBytes(mapText.data(), mapText.size());
+    world->seed = desc.seed;
+    world->tick = 0;
+
+    world->flowField = std::make_unique<FlowField>();
+    world->flowField->Sync(*world->tileMap, jobs);
+
+    world->characters = std::make_unique<CharacterController>();
+    CharacterDesc playerDesc;
+    playerDesc.x = desc.playerX;
+    playerDesc.y = desc.playerY;
+    playerDesc.width = desc.playerWidth;
+    playerDesc.height = desc.playerHeight;
+    playerDesc.runSpeed = desc.playerSpeed;
+    world->playerBody = world->characters->AddBody(playerDesc);
+    world->playerFacing = 1;
+
+    world->chasers.clear();
+    for (int tx : desc.chaserColumns) {
+        CharacterDesc chaserDesc;
+        chaserDesc.x = (static_cast<float>(tx) + 0.5f) * desc.tileSize;
+        chaserDesc.y = desc.tileSize;
+        chaserDesc.width = desc.chaserWidth;
+        chaserDesc.height = desc.chaserHeight;
+        chaserDesc.runSpeed = desc.chaserSpeed;
+        ChaseAgent chaser;
+        chaser.x = chaserDesc.x;
+        chaser.y = chaserDesc.y;
+        chaser.body = world->characters->AddBody(chaserDesc);
+        world->chasers.push_back(chaser);
+    }
+    return true;
+}
+
+void StepGameWorld(GameWorld* world, const InputFrame& input, float deltaTime, JobSystem* jobs) {
+    PROFILE_ZONE("StepGameWorld");
+    CharacterController* characters = world->characters.get();
+
+    float moveX = (input.IsDown(InputAction::Right) ? 1.0f : 0.0f) - (input.IsDown(InputAction::Left) ? 1.0f : 0.0f);
+    if (moveX < 0.0f) world->playerFacing = -1;
+    if (moveX > 0.0f) world->playerFacing = 1;
+    characters->SetInput(world->playerBody, moveX, input.IsDown(InputAction::Jump), input.IsDown(InputAction::Down));
+    for (const ChaseAgent& chaser : world->chasers) {
+        characters->SetInput(chaser.body, chaser.moveX, chaser.jump, false);
+    }
+
+    characters->Step(*world->tileMap, nullptr, 0, deltaTime, jobs);
+
+    for (ChaseAgent& chaser : world->chasers) {
+        chaser.x = characters->GetX(chaser.body);
+        chaser.y = characters->GetY(chaser.body);
+    }
+
+    // 解き直すのはタイルが変わったか、プレイヤーが別のセルに入ったときだけ
+    world->flowField->Sync(*world->tileMap, jobs);
+    world->flowField->SetGoal(
+        world->tileMap->WorldToTileX(characters->GetX(world->playerBody)),
+        world->tileMap->WorldToTileY(characters->GetY(world->playerBody) - 1.0f));
+    SteerAgents(*world->flowField, *world->tileMap, world->chasers.data(), world->chasers.size(), jobs);
+
+    world->tick++;
+}
+
+uint64_t HashGameWorld(const GameWorld& world) {
+    const CharacterController& characters = *world.characters;
+    uint64_t hash = HashValue(world.tick, kHashSeed);
+    for (size_t i = 0; i < characters.GetBodyCount(); i++) {
+        int body = static_cast<int>(i);
+        float values[4] = { characters.GetX(body), characters.GetY(body),
+            characters.GetVelocityX(body), characters.GetVelocityY(body) };
+        hash = HashBytes(values, sizeof(values), hash);
+        hash = HashValue(static_cast<uint8_t>(characters.IsGrounded(body)), hash);
+    }
+    for (const ChaseAgent& chaser : world.chasers) {
+        hash = HashValue(chaser.moveX, hash);
+        hash = HashValue(static_cast<uint8_t>(chaser.jump), hash);
+    }
+    return hash;
+}
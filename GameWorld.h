@@ -0,0 +1,81 @@
+﻿/**********************************************************************************
+    GameWorld.h
+
+                                                                LI WENHUI
+                                                                2025/08/30
+
+**********************************************************************************/
+
+#ifndef GAMEWORLD_H
+#define GAMEWORLD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TileMap;
+class FlowField;
+class CharacterController;
+class JobSystem;
+struct ChaseAgent;
+struct InputFrame;
+
+// FNV-1a。アセットの版や状態のチェックサムに使う
+const uint64_t kHashSeed = 14695981039346656037ull;
+uint64_t HashBytes(const void* data, size_t size, uint64_t hash = kHashSeed);
+
+// 初期配置。座標はワールド（ピクセル）で、体の x は中心、y は足元
+struct GameWorldDesc {
+    float tileSize = 32.0f;
+    uint32_t seed = 1;
+
+    float playerX = 632.0f;
+    float playerY = 984.0f;
+    float playerWidth = 30.0f;
+    float playerHeight = 96.0f;
+    float playerSpeed = 200.0f;
+
+    // 追跡者はこの列の上から落とす
+    std::vector<int> chaserColumns = { 4, 12, 22, 34, 41, 48, 52, 57 };
+    float chaserWidth = 24.0f;
+    float chaserHeight = 28.0f;
+    float chaserSpeed = 150.0f;
+};
+
+//
+// シミュレーションだけの状態（ウィンドウもデバイスも持たない）
+// 固定ステップの tick ごとに入力だけで決まるので、リプレイやヘッドレス実行でも同じ結果になる
+struct GameWorld {
+    std::unique_ptr<TileMap> tileMap;
+
+    // 追跡者はプレイヤーへのフローフィールドを引いて進む向きを決める
+    std::unique_ptr<FlowField> flowField;
+    std::vector<ChaseAgent> chasers;
+
+    // プレイヤーと追跡者の移動・衝突
+    std::unique_ptr<CharacterController> characters;
+    int playerBody = -1;
+    int playerFacing = 1;       // -1 左, 1 右
+
+    uint32_t seed = 1;
+    uint64_t mapHash = 0;       // 読み込んだマップの内容のハッシュ（リプレイのアセットの版）
+    uint64_t tick = 0;
+
+    GameWorld();
+    ~GameWorld();
+};
+
+bool ReadAssetText(const wchar_t* path, std::string* out);
+
+bool InitGameWorld(GameWorld* world, const std::string& mapText, const GameWorldDesc& desc, JobSystem* jobs, std::string* error = nullptr);
+
+// 1 tick 進める。入力 → 移動と衝突 → 追跡者の進路
+void StepGameWorld(GameWorld* world, const InputFrame& input, float deltaTime, JobSystem* jobs);
+
+// 体の位置・速度と追跡者の入力から作るチェックサム。リプレイの再現確認用
+uint64_t HashGameWorld(const GameWorld& world);
+
+
+#endif
@@ -0,0 +1,365 @@
+﻿/**********************************************************************************
+    GlyphCache.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "GlyphCache.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+    const size_t kMaxLayouts = 1024;        // これを超えたら、しばらく使っていないものを捨てる
+    const uint32_t kLayoutKeepFrames = 60;
+    const int kCellPadding = 1;             // 線形フィルタで隣のセルを拾わないための透明な縁
+
+    uint64_t HashText(const std::string& text, uint64_t hash) {
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t LayoutKey(int font, float maxWidth, TextAlign align, const std::string& text) {
+        uint32_t widthBits;
+        std::memcpy(&widthBits, &maxWidth, sizeof(widthBits));
+        uint64_t hash = 14695981039346656037ull;
+        hash = (hash ^ static_cast<uint64_t>(font)) * 1099511628211ull;
+        hash = (hash ^ widthBits) * 1099511628211ull;
+        hash = (hash ^ static_cast<uint64_t>(align)) * 1099511628211ull;
+        return HashText(text, hash);
+    }
+}
+
+
+uint32_t DecodeUtf8(const std::string& text, size_t* pos) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(text.data());
+    size_t i = *pos;
+    size_t size = text.size();
+    unsigned char c = s[i];
+    int length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xe ? 3 : (c >> 3) == 0x1e ? 4 : 0;
+    if (length == 0 || i + static_cast<size_t>(length) > size) {
+        *pos = i + 1;
+        return 0xfffd;
+    }
+    uint32_t cp = length == 1 ? c : c & (0x7f >> length);
+    for (int k = 1; k < length; k++) {
+        unsigned char next = s[i + static_cast<size_t>(k)];
+        if ((next & 0xc0) != 0x80) {
+            *pos = i + 1;
+            return 0xfffd;
+        }
+        cp = (cp << 6) | (next & 0x3f);
+    }
+    *pos = i + static_cast<size_t>(length);
+    return cp;
+}
+
+
+GlyphCache::GlyphCache(int atlasWidth, int atlasHeight)
+    : atlasWidth(atlasWidth),
+    atlasHeight(atlasHeight),
+    dirtyX0(0), dirtyY0(0), dirtyX1(atlasWidth), dirtyY1(atlasHeight)
+{
+    // 白を premultiplied alpha で持つので、RGBA どれも被覆率（頂点カラーで色を付ける）
+    pixels.assign(static_cast<size_t>(atlasWidth) * static_cast<size_t>(atlasHeight) * 4, 0);
+}
+
+int GlyphCache::AddFont(GlyphSource* source, float unitsPerPixel) {
+    FontEntry font;
+    font.source = source;
+    font.unitsPerPixel = unitsPerPixel;
+    font.cellWidth = source->GetMaxGlyphWidth() + kCellPadding * 2;
+    font.cellHeight = source->GetMaxGlyphHeight() + kCellPadding * 2;
+    fonts.push_back(font);
+    return static_cast<int>(fonts.size() - 1);
+}
+
+float GlyphCache::GetLineHeight(int font) const {
+    const FontEntry& f = fonts[static_cast<size_t>(font)];
+    return f.source->GetLineHeight() * f.unitsPerPixel;
+}
+
+void GlyphCache::BeginFrame() {
+    frame++;
+    if (layoutCount <= kMaxLayouts) return;
+
+    for (auto it = layouts.begin(); it != layouts.end();) {
+        std::vector<CachedLayout>& bucket = it->second;
+        size_t before = bucket.size();
+        bucket.erase(std::remove_if(bucket.begin(), bucket.end(), [this](const CachedLayout& c) {
+            return c.lastUsed + kLayoutKeepFrames < frame;
+        }), bucket.end());
+        layoutCount -= before - bucket.size();
+        it = bucket.empty() ? layouts.erase(it) : std::next(it);
+    }
+}
+
+int GlyphCache::AllocateCell(const FontEntry& font) {
+    const int cw = font.cellWidth, ch = font.cellHeight;
+    if (cw > atlasWidth || ch > atlasHeight) return -1;
+
+    // 同じ大きさの棚に空きがあればそこへ
+    for (size_t s = 0; s < shelves.size(); s++) {
+        Shelf& shelf = shelves[s];
+        if (shelf.height != ch || shelf.cellWidth != cw || (shelf.used + 1) * cw > atlasWidth) continue;
+        cells.push_back({ shelf.used * cw, shelf.y, static_cast<int>(s), 0, 0 });
+        shelf.used++;
+        return static_cast<int>(cells.size() - 1);
+    }
+
+    // 新しい棚
+    if (nextShelfY + ch <= atlasHeight) {
+        shelves.push_back({ nextShelfY, ch, cw, 1 });
+        nextShelfY += ch;
+        cells.push_back({ 0, shelves.back().y, static_cast<int>(shelves.size() - 1), 0, 0 });
+        return static_cast<int>(cells.size() - 1);
+    }
+
+    // いっぱいなら、同じ大きさのセルのうち一番長く使っていないもの（このフレームで使ったものは除く）
+    int oldest = -1;
+    for (size_t c = 0; c < cells.size(); c++) {
+        const Shelf& shelf = shelves[static_cast<size_t>(cells[c].shelf)];
+        if (shelf.height != ch || shelf.cellWidth != cw || cells[c].lastUsed >= frame) continue;
+        if (oldest < 0 || cells[c].lastUsed < cells[static_cast<size_t>(oldest)].lastUsed) oldest = static_cast<int>(c);
+    }
+    if (oldest < 0) return -1;
+
+    Cell& cell = cells[static_cast<size_t>(oldest)];
+    auto previous = glyphs.find(cell.key);
+    if (previous != glyphs.end()) previous->second.cell = -2;    // 大きさは覚えたまま、絵だけ捨てる
+    cell.key = 0;
+    stats.evicted++;
+    return oldest;
+}
+
+const GlyphCache::GlyphEntry* GlyphCache::GetGlyph(int font, uint32_t codepoint, bool needPixels) {
+    uint64_t key = (static_cast<uint64_t>(font + 1) << 32) | codepoint;
+    auto found = glyphs.find(key);
+    if (found != glyphs.end()) {
+        GlyphEntry& entry = found->second;
+        if (entry.cell >= 0) cells[static_cast<size_t>(entry.cell)].lastUsed = frame;
+        if (entry.cell != -2 || !needPixels) return &entry;
+    }
+
+    PROFILE_ZONE("GlyphCache::Rasterize");
+    const FontEntry& f = fonts[static_cast<size_t>(font)];
+    GlyphBitmap bitmap;
+    GlyphEntry& entry = glyphs[key];
+    if (!f.source->Rasterize(codepoint, &bitmap)) {
+        // 書体にない文字は幅だけ空ける
+        entry = GlyphEntry();
+        entry.advance = f.source->GetLineHeight() * 0.5f;
+        return &entry;
+    }
+    stats.rasterized++;
+    entry.width = std::min(bitmap.width, f.cellWidth - kCellPadding * 2);
+    entry.height = std::min(bitmap.height, f.cellHeight - kCellPadding * 2);
+    entry.offsetX = bitmap.offsetX;
+    entry.offsetY = bitmap.offsetY;
+    entry.advance = bitmap.advance;
+    entry.cell = -1;
+    if (entry.width <= 0 || entry.height <= 0) return &entry;
+
+    int cellIndex = AllocateCell(f);
+    if (cellIndex < 0) {
+        stats.atlasFull++;
+        entry.cell = -2;
+        return &entry;
+    }
+    Cell& cell = cells[static_cast<size_t>(cellIndex)];
+    cell.key = key;
+    cell.lastUsed = frame;
+    entry.cell = cellIndex;
+
+    // 前のグリフが残らないようにセルごと透明にしてから書く
+    for (int y = 0; y < f.cellHeight; y++) {
+        uint8_t* row = &pixels[(static_cast<size_t>(cell.y + y) * static_cast<size_t>(atlasWidth) + static_cast<size_t>(cell.x)) * 4];
+        std::memset(row, 0, static_cast<size_t>(f.cellWidth) * 4);
+    }
+    for (int y = 0; y < entry.height; y++) {
+        uint8_t* row = &pixels[(static_cast<size_t>(cell.y + kCellPadding + y) * static_cast<size_t>(atlasWidth)
+            + static_cast<size_t>(cell.x + kCellPadding)) * 4];
+        const uint8_t* src = &bitmap.coverage[static_cast<size_t>(y) * static_cast<size_t>(bitmap.width)];
+        for (int x = 0; x < entry.width; x++) std::memset(row + x * 4, src[x], 4);
+    }
+    MarkDirty(cell.x, cell.y, f.cellWidth, f.cellHeight);
+    return &entry;
+}
+
+const TextLayout& GlyphCache::Layout(int font, const std::string& utf8, float maxWidth, TextAlign align) {
+    uint64_t key = LayoutKey(font, maxWidth, align, utf8);
+    std::vector<CachedLayout>& bucket = layouts[key];
+    for (CachedLayout& cached : bucket) {
+        if (cached.font == font && cached.maxWidth == maxWidth && cached.align == align && cached.text == utf8) {
+            cached.lastUsed = frame;
+            stats.layoutHits++;
+            return cached.layout;
+        }
+    }
+
+    PROFILE_ZONE("GlyphCache::Layout");
+    stats.layoutMisses++;
+    const FontEntry& f = fonts[static_cast<size_t>(font)];
+    const float scale = f.unitsPerPixel;
+    const float lineHeight = f.source->GetLineHeight() * scale;
+
+    TextLayout layout;
+    struct Line {
+        size_t first;
+        float width;
+    };
+    std::vector<Line> lines{ { 0, 0.0f } };
+    float penX = 0.0f, penY = 0.0f;
+    size_t breakGlyph = SIZE_MAX;           // 今の行で最後の空白（折り返す位置）
+    uint32_t previous = 0;
+
+    size_t pos = 0;
+    while (pos < utf8.size()) {
+        uint32_t cp = DecodeUtf8(utf8, &pos);
+        if (cp == '\r') continue;
+        if (cp == '\n') {
+            lines.back().width = penX;
+            penX = 0.0f;
+            penY += lineHeight;
+            lines.push_back({ layout.glyphs.size(), 0.0f });
+            breakGlyph = SIZE_MAX;
+            previous = 0;
+            continue;
+        }
+
+        bool tab = cp == '\t';
+        if (tab) cp = ' ';
+        const GlyphEntry* glyph = GetGlyph(font, cp, false);
+        float advance = glyph->advance * scale * (tab ? 4.0f : 1.0f);
+        if (previous) penX += f.source->GetKerning(previous, cp) * scale;
+
+        // 入りきらなければ最後の空白の次から下の行へ送る
+        if (maxWidth > 0.0f && cp != ' ' && penX + advance > maxWidth && breakGlyph != SIZE_MAX) {
+            size_t first = breakGlyph + 1;
+            lines.back().width = layout.glyphs[breakGlyph].x;
+            float shift = first < layout.glyphs.size() ? layout.glyphs[first].x : penX;
+            penY += lineHeight;
+            for (size_t g = first; g < layout.glyphs.size(); g++) {
+                layout.glyphs[g].x -= shift;
+                layout.glyphs[g].y = penY;
+            }
+            penX -= shift;
+            lines.push_back({ first, 0.0f });
+            breakGlyph = SIZE_MAX;
+        }
+
+        if (cp == ' ') breakGlyph = layout.glyphs.size();
+        layout.glyphs.push_back({ cp, penX, penY });
+        penX += advance;
+        previous = cp;
+    }
+    lines.back().width = penX;
+
+    // 揃えは行ごとに、原点からの位置をずらす
+    for (size_t l = 0; l < lines.size(); l++) {
+        layout.width = std::max(layout.width, lines[l].width);
+        if (align == TextAlign::Left) continue;
+        float offset = align == TextAlign::Center ? -lines[l].width * 0.5f : -lines[l].width;
+        size_t end = l + 1 < lines.size() ? lines[l + 1].first : layout.glyphs.size();
+        for (size_t g = lines[l].first; g < end; g++) layout.glyphs[g].x += offset;
+    }
+    layout.lines = static_cast<int>(lines.size());
+    layout.height = lineHeight * static_cast<float>(lines.size());
+
+    bucket.push_back({ font, maxWidth, align, utf8, frame, std::move(layout) });
+    layoutCount++;
+    return bucket.back().layout;
+}
+
+size_t GlyphCache::BuildQuads(int font, const std::string& utf8, float x, float y, const DirectX::XMFLOAT4& color, float depth,
+    std::vector<SpriteQuad>* out, float maxWidth, TextAlign align) {
+    const TextLayout& layout = Layout(font, utf8, maxWidth, align);
+    const FontEntry& f = fonts[static_cast<size_t>(font)];
+    const float scale = f.unitsPerPixel;
+
+    // ベースラインをピクセルの境目に合わせると、グリフのピクセルがそのまま画面のピクセルに乗る
+    float originX = std::round(x / scale) * scale;
+    float baseline = std::round((y + f.source->GetAscent() * scale) / scale) * scale;
+    const float invW = 1.0f / static_cast<float>(atlasWidth);
+    const float invH = 1.0f / static_cast<float>(atlasHeight);
+
+    size_t before = out->size();
+    for (const TextLayout::Glyph& g : layout.glyphs) {
+        const GlyphEntry* glyph = GetGlyph(font, g.codepoint, true);
+        if (glyph->cell < 0) continue;
+        const Cell& cell = cells[static_cast<size_t>(glyph->cell)];
+
+        float x0 = originX + std::round(g.x / scale) * scale + static_cast<float>(glyph->offsetX) * scale;
+        float y0 = baseline + g.y + static_cast<float>(glyph->offsetY) * scale;
+        float x1 = x0 + static_cast<float>(glyph->width) * scale;
+        float y1 = y0 + static_cast<float>(glyph->height) * scale;
+        float u0 = static_cast<float>(cell.x + kCellPadding) * invW;
+        float v0 = static_cast<float>(cell.y + kCellPadding) * invH;
+        float u1 = u0 + static_cast<float>(glyph->width) * invW;
+        float v1 = v0 + static_cast<float>(glyph->height) * invH;
+
+        SpriteQuad q;
+        q.pos[0] = { x0, y0 };
+        q.pos[1] = { x1, y0 };
+        q.pos[2] = { x1, y1 };
+        q.pos[3] = { x0, y1 };
+        q.uv[0] = { u0, v0 };
+        q.uv[1] = { u1, v0 };
+        q.uv[2] = { u1, v1 };
+        q.uv[3] = { u0, v1 };
+        q.color = color;
+        q.depth = depth;
+        out->push_back(q);
+    }
+    return out->size() - before;
+}
+
+int GlyphCache::GetAtlasWidth() const {
+    return atlasWidth;
+}
+
+int GlyphCache::GetAtlasHeight() const {
+    return atlasHeight;
+}
+
+const uint8_t* GlyphCache::GetPixels() const {
+    return pixels.data();
+}
+
+void GlyphCache::MarkDirty(int x, int y, int width, int height) {
+    if (dirtyX0 >= dirtyX1) {
+        dirtyX0 = x;
+        dirtyY0 = y;
+        dirtyX1 = x + width;
+        dirtyY1 = y + height;
+        return;
+    }
+    dirtyX0 = std::min(dirtyX0, x);
+    dirtyY0 = std::min(dirtyY0, y);
+    dirtyX1 = std::max(dirtyX1, x + width);
+    dirtyY1 = std::max(dirtyY1, y + height);
+}
+
+bool GlyphCache::TakeDirtyRect(int* x, int* y, int* width, int* height) {
+    if (dirtyX0 >= dirtyX1 || dirtyY0 >= dirtyY1) return false;
+    *x = dirtyX0;
+    *y = dirtyY0;
+    *width = dirtyX1 - dirtyX0;
+    *height = dirtyY1 - dirtyY0;
+    dirtyX0 = dirtyY0 = dirtyX1 = dirtyY1 = 0;
+    return true;
+}
+
+GlyphCacheStats GlyphCache::GetStats() const {
+    GlyphCacheStats s = stats;
+    s.cachedGlyphs = glyphs.size();
+    s.cachedLayouts = layoutCount;
+    return s;
+}
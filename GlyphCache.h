@@ -0,0 +1,169 @@
+﻿/**********************************************************************************
+    GlyphCache.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef GLYPHCACHE_H
+#define GLYPHCACHE_H
+
+#include "SpriteQuad.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// 1 グリフ分のラスタライズ結果。座標は y 下向きで、ペンの位置（ベースライン上）からの位置
+struct GlyphBitmap {
+    int width = 0;
+    int height = 0;
+    int offsetX = 0;            // ペンから左上まで
+    int offsetY = 0;            // ベースラインから上端まで（上なら負）
+    float advance = 0.0f;
+    std::vector<uint8_t> coverage;  // width x height、0..255
+};
+
+//
+// 1 書体 1 サイズのグリフの出どころ（Windows は GDI。ヘッドレスやベンチでは作り物でもよい）
+// 単位はピクセル。GlyphCache::AddFont で論理座標への倍率を渡す
+class GlyphSource {
+public:
+    virtual ~GlyphSource() = default;
+
+    virtual float GetAscent() const = 0;
+    virtual float GetLineHeight() const = 0;
+    // どのグリフもこの大きさに収まる（アトラスのセルの大きさになる）
+    virtual int GetMaxGlyphWidth() const = 0;
+    virtual int GetMaxGlyphHeight() const = 0;
+
+    virtual bool Rasterize(uint32_t codepoint, GlyphBitmap* out) = 0;
+    virtual float GetKerning(uint32_t left, uint32_t right) { (void)left; (void)right; return 0.0f; }
+};
+
+enum class TextAlign : uint8_t {
+    Left,
+    Center,
+    Right
+};
+
+// 並べ終わった文字列。座標は論理座標で、原点は 1 行目のベースラインの左端（揃えの基準）
+struct TextLayout {
+    struct Glyph {
+        uint32_t codepoint;
+        float x;
+        float y;
+    };
+    std::vector<Glyph> glyphs;
+    float width = 0.0f;
+    float height = 0.0f;
+    int lines = 0;
+};
+
+struct GlyphCacheStats {
+    uint64_t rasterized = 0;        // ラスタライズした回数（同じ文字でも追い出された後はもう一度）
+    uint64_t evicted = 0;
+    uint64_t atlasFull = 0;         // このフレームで使っているセルしかなく、置けなかったグリフ
+    uint64_t layoutHits = 0;
+    uint64_t layoutMisses = 0;
+    size_t cachedGlyphs = 0;
+    size_t cachedLayouts = 0;
+};
+
+//
+// グリフを使うときにラスタライズして 1 枚のアトラスに置き、並べた文字列も内容のハッシュで覚えておく
+// 文字が変わらない限り、毎フレームはキャッシュを引いて四角形を作るだけになる
+// アトラスはフォントのセルの大きさごとの棚に分け、いっぱいなら同じ大きさで一番長く使っていないセルを使い回す
+// D3D は使わない。ピクセルは RGBA8（白の premultiplied alpha で、4 チャンネルとも被覆率）で、変わった範囲を TakeDirtyRect で取り出して転送する
+class GlyphCache {
+public:
+    GlyphCache(int atlasWidth = 1024, int atlasHeight = 1024);
+
+    // source は呼び出し側が持ち続ける。unitsPerPixel はピクセルから論理座標への倍率
+    int AddFont(GlyphSource* source, float unitsPerPixel = 1.0f);
+    float GetLineHeight(int font) const;
+
+    // 毎フレーム最初に 1 回。このフレームで使ったグリフは追い出さない
+    void BeginFrame();
+
+    // UTF-8 を並べる。'\n' で改行、maxWidth > 0 なら空白で折り返す
+    const TextLayout& Layout(int font, const std::string& utf8, float maxWidth = 0.0f, TextAlign align = TextAlign::Left);
+
+    // (x, y) を 1 行目の上端として四角形を out の後ろに足す。足した数を返す
+    size_t BuildQuads(int font, const std::string& utf8, float x, float y, const DirectX::XMFLOAT4& color, float depth,
+        std::vector<SpriteQuad>* out, float maxWidth = 0.0f, TextAlign align = TextAlign::Left);
+
+    int GetAtlasWidth() const;
+    int GetAtlasHeight() const;
+    const uint8_t* GetPixels() const;
+
+    // 前回から書き換えた範囲。なければ false
+    bool TakeDirtyRect(int* x, int* y, int* width, int* height);
+
+    GlyphCacheStats GetStats() const;
+
+private:
+    struct FontEntry {
+        GlyphSource* source;
+        float unitsPerPixel;
+        int cellWidth;
+        int cellHeight;
+    };
+
+    struct GlyphEntry {
+        int cell = -1;              // -1 は空白など絵のないグリフ
+        int width = 0;
+        int height = 0;
+        int offsetX = 0;
+        int offsetY = 0;
+        float advance = 0.0f;
+    };
+
+    struct Cell {
+        int x, y;
+        int shelf;
+        uint64_t key;               // 入っているグリフ（0 なら空き）
+        uint32_t lastUsed;
+    };
+
+    struct Shelf {
+        int y, height, cellWidth;
+        int used;                   // 左から使ったセル数
+    };
+
+    struct CachedLayout {
+        int font;
+        float maxWidth;
+        TextAlign align;
+        std::string text;
+        uint32_t lastUsed;
+        TextLayout layout;
+    };
+
+    const GlyphEntry* GetGlyph(int font, uint32_t codepoint, bool needPixels);
+    int AllocateCell(const FontEntry& font);
+    void MarkDirty(int x, int y, int width, int height);
+
+    int atlasWidth;
+    int atlasHeight;
+    std::vector<uint8_t> pixels;
+    std::vector<FontEntry> fonts;
+    std::vector<Shelf> shelves;
+    std::vector<Cell> cells;
+    std::unordered_map<uint64_t, GlyphEntry> glyphs;        // (font << 32) | codepoint
+    std::unordered_map<uint64_t, std::vector<CachedLayout>> layouts;
+    size_t layoutCount = 0;
+    int nextShelfY = 0;
+    uint32_t frame = 1;
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1;
+    GlyphCacheStats stats;
+};
+
+// UTF-8 を 1 文字ずつ取り出す。壊れたバイト列は U+FFFD にして 1 バイト進む
+uint32_t DecodeUtf8(const std::string& text, size_t* pos);
+
+
+#endif
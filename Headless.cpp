@@ -0,0 +1,512 @@
+﻿/**********************************************************************************
+    Headless.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/31
+
+**********************************************************************************/
+
+#include "Headless.h"
+#include "GameWorld.h"
+#include "Replay.h"
+#include "BatchSimulation.h"
+#include "StressScene.h"
+#include "AnimationGraph.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "FramePacer.h"
+#include "ResolutionScaler.h"
+#include "Telemetry.h"
+#include "Skeleton2D.h"
+#include "TextureResidency.h"
+#include "FieldOfView.h"
+#include "TileMap.h"
+#include "CharacterController.h"
+#include "InputSystem.h"
+#include "Timer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+namespace {
+
+    struct HeadlessArgs {
+        std::wstring replayPath;
+        std::wstring mapPath = L"assets/level01.txt";
+        bool mapGiven = false;              // -map があった（リプレイでも記録したマップより優先する）
+        std::wstring outPath;               // 空ならモードごとの既定（batch.csv / stress.csv）
+        std::wstring profilePath;
+        std::wstring animPath = L"assets/player.animgraph";
+        std::wstring telemetryPath;         // -telemetry-report
+        std::vector<uint32_t> scalerLoads;  // -scaler。倍率 1 のときの GPU の時間（ミリ秒）
+        float streamingSeconds = 0.0f;      // -streaming。右へ歩く・左へ歩く・立ち止まる、それぞれの秒数
+        BatchDesc batch;
+        bool runBatch = false;
+        std::vector<uint32_t> stressCounts;
+        uint32_t stressFrames = 300;        // -frames。-pace でも使う
+        float paceHz = 0.0f;
+        float paceWorkMs = 0.0f;
+    };
+
+    uint32_t ToUint(const std::wstring& s) {
+        return static_cast<uint32_t>(std::wcstoul(s.c_str(), nullptr, 10));
+    }
+
+    int RunReplayMode(const HeadlessArgs& args, std::string* log) {
+        ReplayPlayer replay;
+        std::string error;
+        if (!replay.Load(args.replayPath.c_str(), &error)) {
+            *log += "replay: " + error + "\n";
+            return 1;
+        }
+
+        // マップは -map がなければ記録したときのパスから読む
+        const std::vector<ReplayAsset>& assets = replay.GetHeader().assets;
+        std::wstring mapPath = args.mapPath;
+        if (!args.mapGiven && !assets.empty()) mapPath.assign(assets[0].name.begin(), assets[0].name.end());
+        std::string mapText;
+        if (!ReadAssetText(mapPath.c_str(), &mapText)) {
+            *log += "replay: cannot open map " + std::string(mapPath.begin(), mapPath.end()) + "\n";
+            return 1;
+        }
+        // 記録したときとマップの中身が違えば再現しないので知らせる（再生は続ける）
+        if (!assets.empty() && assets[0].hash != HashBytes(mapText.data(), mapText.size())) {
+            *log += "replay: " + std::string(mapPath.begin(), mapPath.end()) + " differs from the recorded " + assets[0].name + "\n";
+        }
+
+        // 絵の位置から決めていた初期位置は GameWorldDesc の既定値と同じ
+        JobSystem jobs;
+        GameWorld world;
+        GameWorldDesc desc;
+        desc.seed = replay.GetHeader().seed;
+        if (!InitGameWorld(&world, mapText, desc, &jobs, &error)) {
+            *log += "replay: " + error + "\n";
+            return 1;
+        }
+
+        ReplayTiming timing;
+        RunReplay(&replay, &world, &jobs, &timing);
+        WriteReplayTiming((args.replayPath + L".csv").c_str(), timing);
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "replay: %u ticks in %.1f ms, hash %s\n",
+            replay.GetHeader().tickCount, timing.totalMs, timing.hashMatched ? "ok" : "MISMATCH");
+        *log += line;
+        return timing.hashMatched ? 0 : 2;
+    }
+
+    int RunBatchMode(const HeadlessArgs& args, const std::string& mapText, std::string* log) {
+        BatchResult result;
+        std::string error;
+        if (!RunBatch({ mapText }, GameWorldDesc(), args.batch, &result, &error)) {
+            *log += "batch: " + error + "\n";
+            return 1;
+        }
+        WriteBatchResults(args.outPath.empty() ? L"batch.csv" : args.outPath.c_str(), result);
+
+        int caught = 0;
+        uint32_t mismatches = 0;
+        for (const BatchInstanceResult& r : result.instances) {
+            caught += r.caughtTick >= 0 ? 1 : 0;
+            mismatches += r.inputMismatches;
+        }
+        char line[256];
+        std::snprintf(line, sizeof(line), "batch: %u instances x %u ticks on %u threads in %.1f ms\n"
+            "batch: %.0f ticks/s, %.0f ticks/s per core\n"
+            "batch: caught in %d of %u\n"
+            "batch: scripted input %s (%u ticks off)\n",
+            args.batch.instances, args.batch.ticks, result.threads, result.wallMs,
+            result.ticksPerSecond, result.ticksPerSecondPerCore,
+            caught, args.batch.instances,
+            mismatches == 0 ? "ok" : "MISMATCH", mismatches);
+        *log += line;
+        return mismatches == 0 ? 0 : 2;
+    }
+
+    int RunStressMode(const HeadlessArgs& args, std::string* log) {
+        AnimGraph graph;
+        std::string error;
+        if (!LoadAnimGraph(args.animPath.c_str(), &graph, &error)) {
+            *log += "stress: " + error + "\n";
+            return 1;
+        }
+
+        // 数ごとに同じ seed でシーンを作り直すので、どの点も単独で再現できる
+        std::vector<StressResult> results;
+        for (uint32_t sprites : args.stressCounts) {
+            StressSceneDesc desc;
+            desc.sprites = sprites;
+            desc.frames = args.stressFrames;
+            desc.seed = args.batch.seed;
+            desc.threads = args.batch.threads;
+            StressResult result;
+            if (!RunStressScene(graph, desc, &result, &error)) {
+                *log += "stress: " + error + "\n";
+                return 1;
+            }
+            results.push_back(result);
+
+            char line[256];
+            std::snprintf(line, sizeof(line), "stress: %u sprites, %.2f ms/frame (p99 %.2f), %.0f draw calls, %.0f overlaps\n",
+                result.sprites, result.frame.meanMs, result.frame.p99Ms, result.drawCalls, result.overlaps);
+            *log += line;
+            std::snprintf(line, sizeof(line), "stress:   overdraw %.2f -> %.2f with depth passes (%.0f%% rejected by early-Z)\n",
+                result.overdrawPainter, result.overdrawPasses, result.earlyZRejected * 100.0);
+            *log += line;
+            std::snprintf(line, sizeof(line), "stress:   layers %.1f%% hit, %.2f redraws/frame, %.0f quads/frame (%.0f uncached)\n",
+                result.layerHitRate * 100.0, result.layerRedraws, result.layerQuads, result.layerQuadsUncached);
+            *log += line;
+            for (int i = 0; i < static_cast<int>(StressStage::Count); i++) {
+                std::snprintf(line, sizeof(line), "stress:   %-10s %8.3f ms (p99 %.3f)\n",
+                    GetStressStageName(static_cast<StressStage>(i)), result.stages[i].meanMs, result.stages[i].p99Ms);
+                *log += line;
+            }
+        }
+        if (!WriteStressResults(args.outPath.empty() ? L"stress.csv" : args.outPath.c_str(), results)) {
+            *log += "stress: cannot write results\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    int RunPaceMode(const HeadlessArgs& args, std::string* log) {
+        FramePacerDesc desc;
+        desc.targetHz = args.paceHz;
+        FramePacer pacer(desc);
+        const float targetMs = pacer.GetTargetMs();
+
+        // 間隔はゲームのループと同じく Timer で測る。最初のフレームは基準を作るだけ
+        HdrHistogram intervals, errors;
+        double totalMs = 0.0, worstMs = 0.0;
+        uint32_t work = 1;
+        Timer timer;
+        pacer.Wait();
+        timer.Reset();
+        for (uint32_t frame = 0; frame < args.stressFrames; frame++) {
+            if (args.paceWorkMs > 0.0f) {
+                work = work * 1664525u + 1013904223u;
+                float ms = args.paceWorkMs * static_cast<float>(work >> 8) / 16777216.0f;
+                auto until = std::chrono::steady_clock::now() + std::chrono::duration<float, std::milli>(ms);
+                while (std::chrono::steady_clock::now() < until) {}
+            }
+            pacer.Wait();
+            timer.Tick();
+            double ms = static_cast<double>(timer.GetDeltaTime()) * 1000.0;
+            double error = std::fabs(ms - static_cast<double>(targetMs));
+            intervals.Record(static_cast<uint64_t>(ms * 1000.0));
+            errors.Record(static_cast<uint64_t>(error * 1000.0));
+            totalMs += ms;
+            if (error > worstMs) worstMs = error;
+        }
+
+        char line[256];
+        double frames = args.stressFrames ? static_cast<double>(args.stressFrames) : 1.0;
+        std::snprintf(line, sizeof(line), "pace: %.1f Hz (%.3f ms), %u frames, mean %.3f ms, p50 %.3f ms, p99 %.3f ms\n"
+            "pace: error p50 %.3f ms, p99 %.3f ms, max %.3f ms, %llu missed, spin margin %.2f ms\n",
+            args.paceHz, targetMs, args.stressFrames, totalMs / frames,
+            static_cast<double>(intervals.GetPercentile(50.0)) * 0.001, static_cast<double>(intervals.GetPercentile(99.0)) * 0.001,
+            static_cast<double>(errors.GetPercentile(50.0)) * 0.001, static_cast<double>(errors.GetPercentile(99.0)) * 0.001,
+            worstMs, static_cast<unsigned long long>(pacer.GetMissedCount()), pacer.GetSpinMarginMs());
+        *log += line;
+        return 0;
+    }
+
+    int RunScalerMode(const HeadlessArgs& args, std::string* log) {
+        // 後半に入ってからの変更は、負荷が揺れても 1 回まで（下げた後の 1 段の戻しなど）
+        const uint32_t frames = std::max<uint32_t>(args.stressFrames, 600);
+        const uint32_t secondHalf = frames / 2;
+        bool allOk = true;
+        for (uint32_t load : args.scalerLoads) {
+            ResolutionScalerDesc desc;
+            ResolutionScaler scaler(desc);
+            uint32_t rng = 1;
+            uint32_t lateChanges = 0;
+            float lastMs = 0.0f;
+            for (uint32_t frame = 0; frame < frames; frame++) {
+                rng = rng * 1664525u + 1013904223u;
+                float noise = 0.9f + 0.2f * static_cast<float>(rng >> 8) / 16777216.0f;
+                float scale = scaler.GetScale();
+                lastMs = static_cast<float>(load) * scale * scale;
+                if (scaler.Update(lastMs * noise) && frame >= secondHalf) lateChanges++;
+            }
+
+            // 帯（upThreshold..downThreshold）に入っているか、倍率の端で帯の外に押し出されているか
+            float scale = scaler.GetScale();
+            float ratio = lastMs / desc.targetMs;
+            bool inBand = ratio >= desc.upThreshold * 0.9f && ratio <= desc.downThreshold * 1.1f;
+            bool atLimit = (scale <= desc.minScale && ratio > desc.downThreshold) || (scale >= desc.maxScale && ratio < desc.upThreshold);
+            bool converged = inBand || atLimit;
+            bool ok = converged && lateChanges <= 1;
+            allOk = allOk && ok;
+
+            char line[256];
+            std::snprintf(line, sizeof(line), "scaler: %3u ms at 1.0 -> scale %.2f (%.2f ms), %u changes, %u in the second half: %s\n",
+                load, scale, lastMs, scaler.GetChangeCount(), lateChanges,
+                ok ? "ok" : !converged ? "NOT CONVERGED" : "OSCILLATING");
+            *log += line;
+        }
+        return allOk ? 0 : 2;
+    }
+
+    int RunStreamingMode(const HeadlessArgs& args, const std::string& mapText, std::string* log) {
+        GameWorld world;
+        std::string error;
+        if (!InitGameWorld(&world, mapText, GameWorldDesc(), nullptr, &error)) {
+            *log += "streaming: " + error + "\n";
+            return 1;
+        }
+        const TileMap& map = *world.tileMap;
+
+        // 街灯の蛾と柱の上のカラスは d3dApp.cpp の InitD3D と同じ配置
+        SkeletonData moth, crow;
+        if (!LoadSkeletonData(L"assets/moth.skel", &moth, &error) || !LoadSkeletonData(L"assets/crow.skel", &crow, &error)) {
+            *log += "streaming: " + error + "\n";
+            return 1;
+        }
+        const float lamps[2][2] = { { 760.0f, 560.0f }, { 1500.0f, 620.0f } };
+        std::vector<SkeletonInstance> skeletons;
+        for (int i = 0; i < 2; i++) {
+            for (int k = 0; k < 2; k++) {
+                SkeletonInstance instance;
+                InitSkeletonInstance(&moth, &instance);
+                instance.x = lamps[i][0] + (k == 0 ? -36.0f : 28.0f);
+                instance.y = lamps[i][1] - 40.0f + 18.0f * static_cast<float>(k);
+                instance.time = 0.37f * static_cast<float>((i + 1) * 2 + k);
+                instance.flipX = k == 1;
+                skeletons.push_back(std::move(instance));
+            }
+        }
+        SkeletonInstance crowInstance;
+        InitSkeletonInstance(&crow, &crowInstance);
+        crowInstance.x = 1744.0f;
+        crowInstance.y = 800.0f;
+        crowInstance.flipX = true;
+        skeletons.push_back(std::move(crowInstance));
+
+        // GPU に載せる代わりに TextureResidency の決めたとおりに数えるだけ（RGBA8、縮小版は 1/4）
+        TextureResidency residency;
+        for (SkeletonData* data : { &moth, &crow }) {
+            uint64_t bytes = static_cast<uint64_t>(data->atlasWidth * data->atlasHeight) * 4;
+            data->atlasTexture = residency.AddTexture(bytes, bytes / 4);
+        }
+        for (const SkeletonInstance& skeleton : skeletons) {
+            residency.AddChunkTexture(map.WorldToTileX(skeleton.x) / TileMap::kChunkSize, skeleton.data->atlasTexture);
+        }
+
+        // 右へ歩き、左へ戻り、立ち止まる。1 フレーム 1 tick の 60Hz
+        const float step = 1.0f / 60.0f;
+        const uint32_t legFrames = static_cast<uint32_t>(args.streamingSeconds / step);
+        FovViewer view;
+        view.radius = 24;
+        std::vector<SpriteQuad> quads;
+        std::vector<TextureResidencyRequest> requests;
+        int crowPrefetchFrame = -1, crowVisibleFrame = -1, crowEvictFrame = -1;
+        char line[256];
+        for (uint32_t frame = 0; frame < legFrames * 3; frame++) {
+            InputFrame input;
+            if (frame < legFrames) input.held = 1 << static_cast<int>(InputAction::Right);
+            else if (frame < legFrames * 2) input.held = 1 << static_cast<int>(InputAction::Left);
+            StepGameWorld(&world, input, step, nullptr);
+
+            // UpdateVisibility と同じ目の高さ（絵の高さ 384 の上から 0.55）
+            float bodyX = world.characters->GetX(world.playerBody);
+            view.tileX = map.WorldToTileX(bodyX);
+            view.tileY = map.WorldToTileY(world.characters->GetY(world.playerBody) - 384.0f * 0.45f);
+            UpdateFovViewers(map, &view, 1, nullptr);
+            UpdateSkeletons(skeletons.data(), skeletons.size(), step);
+
+            // UpdateTextureStreaming → TextureStreamer::Update と同じ順
+            float velocityX = world.characters->GetVelocityX(world.playerBody);
+            int direction = std::fabs(velocityX) > 1.0f ? (velocityX < 0.0f ? -1 : 1) : 0;
+            int chunk = map.WorldToTileX(bodyX) / TileMap::kChunkSize;
+            residency.SetFocus(chunk, direction);
+            residency.Update(&requests);
+            residency.BeginFrame();
+            for (const TextureResidencyRequest& request : requests) {
+                if (request.texture != crow.atlasTexture) continue;
+                const char* what = request.level == TextureLevel::None ? "evicted" : (request.prefetch ? "prefetched" : "loaded");
+                if (request.prefetch && crowPrefetchFrame < 0) crowPrefetchFrame = static_cast<int>(frame);
+                if (request.level == TextureLevel::None) crowEvictFrame = static_cast<int>(frame);
+                std::snprintf(line, sizeof(line), "streaming: frame %4u  crow atlas %s (player x %.0f, chunk %d, direction %d)\n",
+                    frame, what, bodyX, chunk, direction);
+                *log += line;
+            }
+
+            // Render の描画キューと同じ判定。見えるものだけを使ったことにし、載っていなければその場で読む
+            const Aabb cameraRect = { 0.0f, 0.0f, 1888.0f, 1062.0f };
+            for (const SkeletonInstance& skeleton : skeletons) {
+                quads.clear();
+                if (BuildSkeletonQuads(skeleton, &quads) == 0) continue;
+                Aabb bounds = GetSpriteQuadBounds(quads.data(), quads.size());
+                if (!AabbOverlap(bounds, cameraRect) || !view.result.IsAreaVisible(bounds, map.GetTileSize())) continue;
+                int texture = skeleton.data->atlasTexture;
+                residency.MarkUsed(texture);
+                if (residency.GetLevel(texture) == TextureLevel::None) residency.SetLevel(texture, residency.GetImmediateLevel(texture));
+                if (texture == crow.atlasTexture && crowVisibleFrame < 0) {
+                    crowVisibleFrame = static_cast<int>(frame);
+                    std::snprintf(line, sizeof(line), "streaming: frame %4u  crow first drawn (player x %.0f, chunk %d)\n", frame, bodyX, chunk);
+                    *log += line;
+                }
+            }
+        }
+
+        // カラスは見える前に先読みで載り、離れた後で追い出されているはず
+        const TextureResidencyStats& stats = residency.GetStats();
+        bool ok = crowPrefetchFrame >= 0 && crowVisibleFrame > crowPrefetchFrame && crowEvictFrame > crowVisibleFrame
+            && residency.GetLevel(crow.atlasTexture) == TextureLevel::None;
+        std::snprintf(line, sizeof(line), "streaming: %u frames  loads %llu  prefetch %llu  miss %llu  evict %llu  resident %.1f KB (peak %.1f KB)\n"
+            "streaming: crow atlas %s\n",
+            legFrames * 3, static_cast<unsigned long long>(stats.loads), static_cast<unsigned long long>(stats.prefetches),
+            static_cast<unsigned long long>(stats.demandMisses), static_cast<unsigned long long>(stats.evictions),
+            static_cast<double>(stats.residentBytes) / 1024.0, static_cast<double>(stats.peakBytes) / 1024.0,
+            ok ? "prefetched before it was drawn and evicted after leaving: ok" : "NOT STREAMED");
+        *log += line;
+        return ok ? 0 : 2;
+    }
+
+    int RunTelemetryReportMode(const HeadlessArgs& args, std::string* log) {
+        std::ifstream file(std::filesystem::path(args.telemetryPath), std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!file && !file.eof()) {
+            *log += "telemetry: cannot read file\n";
+            return 1;
+        }
+
+        const int metricCount = static_cast<int>(FrameMetric::Count);
+        std::unique_ptr<HdrHistogram[]> metrics(new HdrHistogram[metricCount]);
+        std::vector<uint64_t> hitches(static_cast<size_t>(metricCount) * FrameTelemetry::kMaxThresholds, 0);
+        uint32_t snapshots = 0;
+        if (!AggregateTelemetry(bytes.data(), bytes.size(), metrics.get(), hitches.data(), &snapshots)) {
+            *log += "telemetry: malformed snapshot\n";
+            return 1;
+        }
+
+        char line[256];
+        std::snprintf(line, sizeof(line), "telemetry: %u snapshots, %zu bytes\n", snapshots, bytes.size());
+        *log += line;
+        for (int m = 0; m < metricCount; m++) {
+            const HdrHistogram& h = metrics[m];
+            const uint64_t* hits = &hitches[static_cast<size_t>(m) * FrameTelemetry::kMaxThresholds];
+            std::snprintf(line, sizeof(line), "telemetry: %-8s %12llu samples, p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms, hitches %llu/%llu/%llu/%llu\n",
+                GetFrameMetricName(static_cast<FrameMetric>(m)), static_cast<unsigned long long>(h.GetCount()),
+                static_cast<double>(h.GetPercentile(50.0)) * 0.001, static_cast<double>(h.GetPercentile(99.0)) * 0.001,
+                static_cast<double>(h.GetPercentile(99.9)) * 0.001, static_cast<double>(h.GetMax()) * 0.001,
+                static_cast<unsigned long long>(hits[0]), static_cast<unsigned long long>(hits[1]),
+                static_cast<unsigned long long>(hits[2]), static_cast<unsigned long long>(hits[3]));
+            *log += line;
+        }
+        return 0;
+    }
+
+    std::vector<uint32_t> ToUintList(const std::wstring& s) {
+        std::vector<uint32_t> values;
+        size_t begin = 0;
+        while (begin < s.size()) {
+            size_t end = s.find(L',', begin);
+            if (end == std::wstring::npos) end = s.size();
+            values.push_back(ToUint(s.substr(begin, end - begin)));
+            begin = end + 1;
+        }
+        return values;
+    }
+}
+
+
+int RunHeadless(const std::vector<std::wstring>& argv, std::string* log) {
+    HeadlessArgs args;
+    for (size_t i = 0; i + 1 < argv.size(); i++) {
+        const std::wstring& key = argv[i];
+        const std::wstring& value = argv[i + 1];
+        if (key == L"-replay") args.replayPath = value;
+        else if (key == L"-batch") { args.batch.instances = ToUint(value); args.runBatch = true; }
+        else if (key == L"-ticks") args.batch.ticks = ToUint(value);
+        else if (key == L"-threads") args.batch.threads = ToUint(value);
+        else if (key == L"-seed") args.batch.seed = ToUint(value);
+        else if (key == L"-map") { args.mapPath = value; args.mapGiven = true; }
+        else if (key == L"-out") args.outPath = value;
+        else if (key == L"-profile") args.profilePath = value;
+        else if (key == L"-stress") args.stressCounts = ToUintList(value);
+        else if (key == L"-frames") args.stressFrames = ToUint(value);
+        else if (key == L"-anim") args.animPath = value;
+        else if (key == L"-telemetry-report") args.telemetryPath = value;
+        else if (key == L"-scaler") args.scalerLoads = ToUintList(value);
+        else if (key == L"-streaming") args.streamingSeconds = static_cast<float>(std::wcstod(value.c_str(), nullptr));
+        else if (key == L"-pace") args.paceHz = static_cast<float>(std::wcstod(value.c_str(), nullptr));
+        else if (key == L"-work") args.paceWorkMs = static_cast<float>(std::wcstod(value.c_str(), nullptr));
+        else continue;
+        i++;
+    }
+    if (args.replayPath.empty() && !args.runBatch && args.stressCounts.empty() && args.paceHz <= 0.0f && args.telemetryPath.empty()
+        && args.scalerLoads.empty() && args.streamingSeconds <= 0.0f) return -1;
+
+    // プロファイルを取るときは、記録の前にゾーン 1 つの重さを出しておく（測った分のゾーンは捨てる）
+    if (!args.profilePath.empty()) {
+        double timestampNs = 0.0;
+        double zoneNs = ProfilerMeasureOverhead(1000000, &timestampNs);
+        char line[128];
+        std::snprintf(line, sizeof(line), "profile: %.1f ns per zone (timestamp %.1f ns)\n", zoneNs, timestampNs);
+        *log += line;
+    }
+
+    int result = 0;
+    if (!args.telemetryPath.empty()) {
+        result = RunTelemetryReportMode(args, log);
+    }
+    else if (!args.scalerLoads.empty()) {
+        result = RunScalerMode(args, log);
+    }
+    else if (args.paceHz > 0.0f) {
+        result = RunPaceMode(args, log);
+    }
+    else if (!args.stressCounts.empty()) {
+        result = RunStressMode(args, log);
+    }
+    else if (!args.replayPath.empty()) {
+        result = RunReplayMode(args, log);
+    }
+    else {
+        std::string mapText;
+        if (!ReadAssetText(args.mapPath.c_str(), &mapText)) {
+            *log += "cannot open map\n";
+            return 1;
+        }
+        result = args.streamingSeconds > 0.0f ? RunStreamingMode(args, mapText, log) : RunBatchMode(args, mapText, log);
+    }
+    if (!args.profilePath.empty() && !ProfilerWriteChromeTrace(args.profilePath.c_str())) {
+        *log += "cannot write profile\n";
+    }
+    return result;
+}
+
+
+#ifndef _WIN32
+// Windows 以外ではこれが入口（ウィンドウ・D3D のファイルは使わない）
+int main(int argc, char** argv) {
+    std::vector<std::wstring> args;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        args.push_back(std::wstring(arg.begin(), arg.end()));
+    }
+
+    PROFILE_THREAD("Main");
+    std::string log;
+    int code = RunHeadless(args, &log);
+    if (code < 0) {
+        std::fputs("usage: -replay <file> | -batch <instances> [-ticks n] [-threads n] [-seed n] [-map file] [-out csv]\n"
+            "       -stress <n[,n...]> [-frames n] [-threads n] [-seed n] [-anim file] [-out csv]\n"
+            "       -pace <hz> [-frames n] [-work ms]\n"
+            "       -scaler <ms[,ms...]> [-frames n]\n"
+            "       -streaming <seconds> [-map file]\n"
+            "       -telemetry-report <file>\n", stderr);
+        return 1;
+    }
+    std::fputs(log.c_str(), stdout);
+    return code;
+}
+#endif
@@ -0,0 +1,43 @@
+﻿/**********************************************************************************
+    Headless.h
+
+                                                                LI WENHUI
+                                                                2025/08/31
+
+**********************************************************************************/
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <string>
+#include <vector>
+
+//
+// ウィンドウもデバイスも作らずに GameWorld だけを動かすモード
+//   -replay <file>                   リプレイを最大速度で再生し、tick ごとの時間を <file>.csv に書く
+//                                    （マップは -map がなければ記録したときのもの。中身が違えば知らせる）
+//   -batch <instances>               ボット入力のインスタンスを全コアで並列に進める
+//       -ticks <n> -threads <n> -seed <n> -out <csv>
+//   -stress <n[,n...]>               スプライト n 体のストレスシーンを数ごとに動かし、段階ごとの時間を CSV に書く
+//       -frames <n> -threads <n> -seed <n> -anim <file> -out <csv>
+//   -pace <hz>                       FramePacer で hz に合わせて待ち、Timer で測った間隔のずれを出す
+//       -frames <n> -work <ms>       （毎フレーム 0..ms のばらついた処理を入れる）
+//   -scaler <ms[,ms...]>             GPU の時間が ms x 倍率^2（±10% の揺れ）になる負荷で ResolutionScaler を回し、
+//       -frames <n>                  目標の帯に収まるか、後半で上げ下げを繰り返していないかを確かめる（だめなら 2）
+//   -streaming <seconds>             プレイヤーを右へ歩かせ、左へ戻し、立ち止まらせながら（それぞれ seconds 秒）、描画と同じ判定で
+//                                    見えるスケルトンのアトラスだけを使い、TextureResidency の先読み・追い出しを出す
+//                                    （カラスのアトラスが見える前に載り、離れた後に追い出されなければ 2）
+//   -telemetry-report <file>         -telemetry で書いたスナップショット（何台分をつないだものでもよい）を合計して出す
+//   -map <file>                      使うマップ（既定は assets/level01.txt か、リプレイに記録したもの）
+//   -profile <file>                  終わったらプロファイラーの記録を Chrome trace の JSON で書き出す
+// どれも指定がなければ -1 を返す。log には結果の要約が入る
+// Windows 以外ではこのファイルの main が入口になる。D3D のファイルは使わないので、ベンチマークと同じヘッダーだけで作れる:
+//   g++ -std=c++17 -O2 -pthread -I<DirectXMath>/Inc -I<DirectX-Headers>/include/wsl/stubs Headless.cpp AnimationGraph.cpp Arena.cpp
+//       BatchSimulation.cpp CharacterController.cpp CollisionMask.cpp FieldOfView.cpp FlowField.cpp FramePacer.cpp GameWorld.cpp
+//       InputSystem.cpp JobSystem.cpp LayerCache.cpp Lightmap2D.cpp ParticleSystem.cpp Profiler.cpp Replay.cpp ResolutionScaler.cpp
+//       ResourceRegistry.cpp Skeleton2D.cpp SpriteMesh.cpp SpritePass.cpp StressScene.cpp Telemetry.cpp TextureResidency.cpp TileMap.cpp
+//       Timer.cpp -o headless
+int RunHeadless(const std::vector<std::wstring>& args, std::string* log);
+
+
+#endif
@@ -0,0 +1,115 @@
+﻿/**********************************************************************************
+    InputSystem.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/29
+
+**********************************************************************************/
+
+#include "InputSystem.h"
+#include <algorithm>
+#include <chrono>
+
+int64_t InputNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+KeyboardSource::KeyboardSource(InputQueue* queue)
+    : queue(queue)
+{
+
+}
+
+void KeyboardSource::BindKey(int keyCode, InputAction action) {
+    bindings.push_back({ keyCode, action, false, false });
+}
+
+// 積めたときだけ queued を進める（満杯なら次の Produce でもう一度）
+void KeyboardSource::Flush(Binding* binding, int64_t time) {
+    if (binding->queued == binding->down) return;
+    if (queue->Push({ time, binding->action, binding->down })) binding->queued = binding->down;
+}
+
+void KeyboardSource::OnKey(int keyCode, bool down, int64_t time) {
+    time = std::max(time, lastTime);
+    for (Binding& b : bindings) {
+        if (b.keyCode != keyCode || b.down == down) continue;
+        b.down = down;
+        lastTime = time;
+        Flush(&b, time);
+    }
+}
+
+void KeyboardSource::ReleaseAll() {
+    int64_t now = std::max(InputNow(), lastTime);
+    lastTime = now;
+    for (Binding& b : bindings) {
+        b.down = false;
+        Flush(&b, now);
+    }
+}
+
+void KeyboardSource::Produce(int64_t now, InputQueue* queue) {
+    // メッセージを受けた時点で積んでいるので、ここでは積めなかった変化を積み直すだけ
+    // 時刻は最後に受けたメッセージのもの（変化はそれより前に起きている）
+    (void)now;
+    (void)queue;
+    for (Binding& b : bindings) Flush(&b, lastTime);
+}
+
+
+void ScriptedInputSource::SetEvents(const std::vector<InputEvent>& events) {
+    this->events = events;
+    std::stable_sort(this->events.begin(), this->events.end(),
+        [](const InputEvent& a, const InputEvent& b) { return a.time < b.time; });
+    cursor = 0;
+}
+
+void ScriptedInputSource::Produce(int64_t now, InputQueue* queue) {
+    while (cursor < events.size() && events[cursor].time <= now) {
+        if (!queue->Push(events[cursor])) break;    // 満杯なら次の Pump で
+        cursor++;
+    }
+}
+
+bool ScriptedInputSource::IsFinished() const {
+    return cursor >= events.size();
+}
+
+
+InputQueue* InputSystem::GetQueue() {
+    return &queue;
+}
+
+void InputSystem::AddSource(InputSource* source) {
+    sources.push_back(source);
+}
+
+void InputSystem::Pump(int64_t now) {
+    for (InputSource* source : sources) {
+        source->Produce(now, &queue);
+    }
+}
+
+InputFrame InputSystem::Consume(int64_t tickEnd) {
+    InputFrame frame;
+    while (hasPending || queue.Pop(&pending)) {
+        hasPending = true;
+        if (pending.time > tickEnd) break;
+        hasPending = false;
+
+        uint8_t bit = static_cast<uint8_t>(1u << static_cast<int>(pending.action));
+        if (pending.pressed) {
+            held |= bit;
+            frame.pressed |= bit;
+        }
+        else {
+            held &= static_cast<uint8_t>(~bit);
+        }
+        if (frame.firstEventTime == 0) frame.firstEventTime = pending.time;
+    }
+    frame.held = held;
+    return frame;
+}
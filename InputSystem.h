@@ -0,0 +1,160 @@
+﻿/**********************************************************************************
+    InputSystem.h
+
+                                                                LI WENHUI
+                                                                2025/08/29
+
+**********************************************************************************/
+
+#ifndef INPUTSYSTEM_H
+#define INPUTSYSTEM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class InputAction : uint8_t {
+    Left,
+    Right,
+    Jump,
+    Down,
+    Count
+};
+
+// time は InputNow() と同じ時計（ナノ秒）
+struct InputEvent {
+    int64_t time = 0;
+    InputAction action = InputAction::Left;
+    bool pressed = false;
+};
+
+//
+// 1 tick 分の入力。held は tick の終わりで押されているもの、pressed はその tick 中に押されたもの
+// （tick の間に押して離した短いタップも pressed に残る）
+struct InputFrame {
+    uint8_t held = 0;
+    uint8_t pressed = 0;
+    int64_t firstEventTime = 0;     // この tick で反映した最初のイベントの時刻（なければ 0）
+
+    bool IsDown(InputAction action) const {
+        return (((held | pressed) >> static_cast<int>(action)) & 1) != 0;
+    }
+    bool WasPressed(InputAction action) const {
+        return ((pressed >> static_cast<int>(action)) & 1) != 0;
+    }
+};
+
+int64_t InputNow();
+
+//
+// 単一プロデューサー・単一コンシューマーのリングバッファ（ロックなし）
+// N は 2 のべき乗。満杯なら Push は false を返して捨てる
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "N must be a power of two");
+public:
+    bool Push(const T& value) {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        if (head - tail.load(std::memory_order_acquire) == N) return false;
+        items[head & (N - 1)] = value;
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T* value) {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail == head.load(std::memory_order_acquire)) return false;
+        *value = items[tail & (N - 1)];
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+private:
+    // head と tail は別スレッドが書くのでキャッシュラインを分ける
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    T items[N];
+};
+
+using InputQueue = SpscRing<InputEvent, 1024>;
+
+//
+// 入力の取り出し口。プラットフォームの入力やテスト用の合成入力を同じ形で差し替えられる
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // now までに起きたイベントを queue に積む（プロデューサー側のスレッドで呼ぶ）
+    virtual void Produce(int64_t now, InputQueue* queue) = 0;
+};
+
+//
+// キーボード。ウィンドウのメッセージからキーコードと、メッセージが起きた時刻を受け取って積む
+// キーリピートは無視する。キューが満杯で積めなかった変化は Produce で積み直すので、離したキーが押されたままにはならない
+class KeyboardSource : public InputSource {
+public:
+    explicit KeyboardSource(InputQueue* queue);
+
+    void BindKey(int keyCode, InputAction action);
+    // time は InputNow() の時計。キューの中で時刻が戻らないように、前のイベントより前にはしない
+    void OnKey(int keyCode, bool down, int64_t time);
+    void ReleaseAll();      // フォーカスを失ったとき
+
+    void Produce(int64_t now, InputQueue* queue) override;
+
+private:
+    struct Binding {
+        int keyCode;
+        InputAction action;
+        bool down;          // キーの状態
+        bool queued;        // キューに積んだ最後の状態（コンシューマーから見える状態）
+    };
+
+    void Flush(Binding* binding, int64_t time);
+
+    InputQueue* queue;
+    std::vector<Binding> bindings;
+    int64_t lastTime = 0;
+};
+
+//
+// 決まった時刻にイベントを出すだけのソース（Linux のテストやボット用）
+class ScriptedInputSource : public InputSource {
+public:
+    // time の昇順でなくてもよい
+    void SetEvents(const std::vector<InputEvent>& events);
+    void Produce(int64_t now, InputQueue* queue) override;
+    bool IsFinished() const;
+
+private:
+    std::vector<InputEvent> events;
+    size_t cursor = 0;
+};
+
+//
+// ソースからイベントを集め、固定ステップのシミュレーションへ tick ごとに時刻順で渡す
+class InputSystem {
+public:
+    InputQueue* GetQueue();
+    void AddSource(InputSource* source);    // 所有はしない
+
+    void Pump(int64_t now);
+
+    // tickEnd までのイベントを反映して 1 tick 分の入力を返す。後のイベントは次の tick に残る
+    InputFrame Consume(int64_t tickEnd);
+
+private:
+    InputQueue queue;
+    std::vector<InputSource*> sources;
+    InputEvent pending;
+    bool hasPending = false;
+    uint8_t held = 0;
+};
+
+
+#endif
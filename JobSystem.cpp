@@ -0,0 +1,111 @@
+﻿/**********************************************************************************
+    JobSystem.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/18
+
+**********************************************************************************/
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace {
+    thread_local bool isWorkerThread = false;
+}
+
+JobSystem::JobSystem(unsigned workerCount) {
+    if (workerCount == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        workerCount = hw > 1 ? hw - 1 : 1;
+    }
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+unsigned JobSystem::GetWorkerCount() const {
+    return static_cast<unsigned>(workers.size());
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+
+    // チャンクが 1 つしかない、またはワーカー内からの呼び出しならその場で実行
+    if (count <= grain || isWorkerThread || workers.empty()) {
+        for (size_t begin = 0; begin < count; begin += grain) {
+            func(begin, std::min(begin + grain, count));
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        jobCount = count;
+        jobGrain = grain;
+        chunkCount = (count + grain - 1) / grain;
+        nextChunk.store(0);
+        finishedChunks.store(0);
+        generation++;
+    }
+    wake.notify_all();
+
+    RunChunks(func, count, grain, chunkCount);
+
+    // 次のジョブの引数を書き換える前に、全ワーカーが RunChunks を抜けるのを待つ
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return finishedChunks.load() == chunkCount && activeWorkers == 0; });
+    job = nullptr;
+}
+
+void JobSystem::RunChunks(const std::function<void(size_t, size_t)>& func, size_t count, size_t grain, size_t chunks) {
+    PROFILE_ZONE("Jobs");
+    size_t finished = 0;
+    for (;;) {
+        size_t chunk = nextChunk.fetch_add(1);
+        if (chunk >= chunks) break;
+        size_t begin = chunk * grain;
+        func(begin, std::min(begin + grain, count));
+        finished++;
+    }
+    finishedChunks.fetch_add(finished);
+}
+
+void JobSystem::WorkerLoop() {
+    isWorkerThread = true;
+    PROFILE_THREAD("Worker");
+    unsigned seen = 0;
+    for (;;) {
+        const std::function<void(size_t, size_t)>* func;
+        size_t count, grain, chunks;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || (generation != seen && job != nullptr); });
+            if (quit) return;
+            seen = generation;
+            func = job;
+            count = jobCount;
+            grain = jobGrain;
+            chunks = chunkCount;
+            activeWorkers++;
+        }
+        RunChunks(*func, count, grain, chunks);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        done.notify_all();
+    }
+}
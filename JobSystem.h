@@ -0,0 +1,59 @@
+﻿/**********************************************************************************
+    JobSystem.h
+
+                                                                LI WENHUI
+                                                                2025/08/18
+
+**********************************************************************************/
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// 固定数のワーカースレッドで範囲を分割して実行するだけの簡単なジョブシステム
+// ParallelFor は呼び出しスレッドも手伝い、全チャンクが終わるまで戻らない
+class JobSystem {
+public:
+    // workerCount = 0 ならハードウェアスレッド数 - 1
+    explicit JobSystem(unsigned workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // [0, count) を grain 個ずつのチャンクに分けて func(begin, end) を並列に呼ぶ
+    // ワーカーの中から呼ばれた場合は入れ子にせずその場で順番に実行する
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func);
+
+    unsigned GetWorkerCount() const;
+
+private:
+    void WorkerLoop();
+    void RunChunks(const std::function<void(size_t, size_t)>& func, size_t count, size_t grain, size_t chunks);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex submitMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    size_t jobGrain = 1;
+    size_t chunkCount = 0;
+    std::atomic<size_t> nextChunk{ 0 };
+    std::atomic<size_t> finishedChunks{ 0 };
+    unsigned activeWorkers = 0;     // RunChunks 実行中のワーカー数（mutex で保護）
+    unsigned generation = 0;
+    bool quit = false;
+};
+
+
+#endif
@@ -0,0 +1,137 @@
+﻿/**********************************************************************************
+    LayerCache.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "LayerCache.h"
+#include <cmath>
+
+
+void LayerCache::SetViewport(float width, float height) {
+    if (width == viewportWidth && height == viewportHeight) return;
+    viewportWidth = width;
+    viewportHeight = height;
+    InvalidateAll();
+}
+
+float LayerCache::GetViewportWidth() const {
+    return viewportWidth;
+}
+
+float LayerCache::GetViewportHeight() const {
+    return viewportHeight;
+}
+
+int LayerCache::AddLayer(const LayerDesc& desc) {
+    Layer layer;
+    layer.desc = desc;
+    // 余白はテクセルの境目に合わせる
+    layer.desc.margin = std::ceil(desc.margin > 0.0f ? desc.margin : 0.0f);
+    layers.push_back(layer);
+    return static_cast<int>(layers.size() - 1);
+}
+
+size_t LayerCache::GetLayerCount() const {
+    return layers.size();
+}
+
+const LayerDesc& LayerCache::GetDesc(int layer) const {
+    return layers[static_cast<size_t>(layer)].desc;
+}
+
+float LayerCache::GetTextureWidth(int layer) const {
+    return std::ceil(viewportWidth) + layers[static_cast<size_t>(layer)].desc.margin * 2.0f;
+}
+
+float LayerCache::GetTextureHeight(int layer) const {
+    return std::ceil(viewportHeight) + layers[static_cast<size_t>(layer)].desc.margin * 2.0f;
+}
+
+void LayerCache::Invalidate(int layer) {
+    layers[static_cast<size_t>(layer)].dirty = true;
+}
+
+void LayerCache::InvalidateAll() {
+    for (Layer& layer : layers) layer.dirty = true;
+}
+
+void LayerCache::SetRevision(int layer, uint32_t revision) {
+    Layer& l = layers[static_cast<size_t>(layer)];
+    if (l.hasRevision && l.revision == revision) return;
+    l.hasRevision = true;
+    l.revision = revision;
+    l.dirty = true;
+}
+
+LayerCacheResult LayerCache::Prepare(int layer, float cameraX, float cameraY) {
+    Layer& l = layers[static_cast<size_t>(layer)];
+
+    // ピクセル単位に丸めて、テクセルがちょうど画面のピクセルに乗るようにする
+    l.scrollX = std::round(cameraX * l.desc.parallaxX);
+    l.scrollY = std::round(cameraY * l.desc.parallaxY);
+
+    bool inside = l.region.width > 0.0f
+        && l.scrollX >= l.region.x && l.scrollX + viewportWidth <= l.region.x + l.region.width
+        && l.scrollY >= l.region.y && l.scrollY + viewportHeight <= l.region.y + l.region.height;
+    if (!l.dirty && inside) {
+        l.stats.hits++;
+        return LayerCacheResult::Hit;
+    }
+
+    if (l.dirty) l.stats.invalidations++;
+    else l.stats.scrollMisses++;
+    l.stats.redraws++;
+    l.dirty = false;
+
+    // 今の位置を真ん中にして、どちらへスクロールしても余白分は持つようにする
+    l.region.x = l.scrollX - l.desc.margin;
+    l.region.y = l.scrollY - l.desc.margin;
+    l.region.width = GetTextureWidth(layer);
+    l.region.height = GetTextureHeight(layer);
+    return LayerCacheResult::Redraw;
+}
+
+LayerRegion LayerCache::GetRenderRegion(int layer) const {
+    return layers[static_cast<size_t>(layer)].region;
+}
+
+void LayerCache::BuildCompositeQuad(int layer, float left, float top, float depth, SpriteQuad* out) const {
+    const Layer& l = layers[static_cast<size_t>(layer)];
+    float w = l.region.width > 0.0f ? l.region.width : 1.0f;
+    float h = l.region.height > 0.0f ? l.region.height : 1.0f;
+    float u0 = (l.scrollX - l.region.x) / w, v0 = (l.scrollY - l.region.y) / h;
+    float u1 = u0 + viewportWidth / w, v1 = v0 + viewportHeight / h;
+
+    out->pos[0] = { left, top };
+    out->pos[1] = { left + viewportWidth, top };
+    out->pos[2] = { left + viewportWidth, top + viewportHeight };
+    out->pos[3] = { left, top + viewportHeight };
+    out->uv[0] = { u0, v0 };
+    out->uv[1] = { u1, v0 };
+    out->uv[2] = { u1, v1 };
+    out->uv[3] = { u0, v1 };
+    out->color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    out->depth = depth;
+}
+
+const LayerCacheStats& LayerCache::GetStats(int layer) const {
+    return layers[static_cast<size_t>(layer)].stats;
+}
+
+LayerCacheStats LayerCache::GetTotalStats() const {
+    LayerCacheStats total;
+    for (const Layer& l : layers) {
+        total.hits += l.stats.hits;
+        total.redraws += l.stats.redraws;
+        total.invalidations += l.stats.invalidations;
+        total.scrollMisses += l.stats.scrollMisses;
+    }
+    return total;
+}
+
+void LayerCache::ResetStats() {
+    for (Layer& l : layers) l.stats = LayerCacheStats();
+}
@@ -0,0 +1,109 @@
+﻿/**********************************************************************************
+    LayerCache.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef LAYERCACHE_H
+#define LAYERCACHE_H
+
+#include "SpriteQuad.h"
+#include <cstdint>
+#include <vector>
+
+//
+// めったに変わらない層（背景、遠景、HUD、タイル）を画面外のテクスチャに描いておき、
+// 毎フレームは 1 枚の四角形として貼るだけにするための管理
+// 描き直すのは中身が変わったとき（リビジョンか Invalidate）と、スクロールが余白を越えたときだけ
+// ここは D3D を使わない。テクスチャは LayerCachePass が持つ
+enum class LayerCacheResult : uint8_t {
+    Hit,        // そのまま貼る
+    Redraw,     // GetRenderRegion の範囲を描き直してから貼る
+};
+
+struct LayerDesc {
+    const char* name = "";
+    // カメラの移動に対する倍率。1 ならワールドと一緒に動き、0 なら画面に固定（HUD）
+    float parallaxX = 1.0f;
+    float parallaxY = 1.0f;
+    // 画面の外側に余分に描いておく幅。スクロールがこの内側に収まる間は描き直さない
+    float margin = 0.0f;
+};
+
+// 層の座標での矩形。テクスチャの大きさは (width, height)
+struct LayerRegion {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+};
+
+struct LayerCacheStats {
+    uint64_t hits = 0;
+    uint64_t redraws = 0;
+    uint64_t invalidations = 0;     // 中身が変わって描き直したもの
+    uint64_t scrollMisses = 0;      // 余白を越えて描き直したもの
+
+    double GetHitRate() const {
+        uint64_t total = hits + redraws;
+        return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+    }
+};
+
+class LayerCache {
+public:
+    // 画面の大きさ（論理座標）。変わったら全部描き直す
+    void SetViewport(float width, float height);
+    float GetViewportWidth() const;
+    float GetViewportHeight() const;
+
+    int AddLayer(const LayerDesc& desc);
+    size_t GetLayerCount() const;
+    const LayerDesc& GetDesc(int layer) const;
+
+    // テクスチャの大きさ（画面 + 余白の両側）
+    float GetTextureWidth(int layer) const;
+    float GetTextureHeight(int layer) const;
+
+    // 中身が変わったら呼ぶ。次の Prepare で描き直しになる
+    void Invalidate(int layer);
+    void InvalidateAll();
+
+    // 中身のリビジョン（TileMap::GetRevision など）。前回描いたときと違えば Invalidate と同じ
+    void SetRevision(int layer, uint32_t revision);
+
+    // 毎フレーム、描く前に 1 回。カメラ位置から層のスクロールを決める
+    // Redraw なら呼び出し側はこのフレームのうちに GetRenderRegion の範囲を描くこと
+    LayerCacheResult Prepare(int layer, float cameraX, float cameraY);
+
+    // 最後に描いた（描く）範囲。ここを正射影でテクスチャ全体に写す
+    LayerRegion GetRenderRegion(int layer) const;
+
+    // 画面の (left, top) から画面 1 枚分に、キャッシュのうち今見えている部分を貼る四角形
+    void BuildCompositeQuad(int layer, float left, float top, float depth, SpriteQuad* out) const;
+
+    const LayerCacheStats& GetStats(int layer) const;
+    LayerCacheStats GetTotalStats() const;
+    void ResetStats();
+
+private:
+    struct Layer {
+        LayerDesc desc;
+        bool dirty = true;
+        bool hasRevision = false;
+        uint32_t revision = 0;
+        float scrollX = 0.0f;       // 今フレームの層の座標での画面左上
+        float scrollY = 0.0f;
+        LayerRegion region;         // テクスチャに描いてある範囲
+        LayerCacheStats stats;
+    };
+
+    float viewportWidth = 0.0f;
+    float viewportHeight = 0.0f;
+    std::vector<Layer> layers;
+};
+
+
+#endif
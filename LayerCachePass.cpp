@@ -0,0 +1,104 @@
+﻿/**********************************************************************************
+    LayerCachePass.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "LayerCachePass.h"
+#include "LayerCache.h"
+#include "BufferUtils.h"
+#include "Profiler.h"
+#include <cmath>
+
+LayerCachePass::LayerCachePass()
+    : savedRtv(nullptr),
+    savedDsv(nullptr),
+    savedViewport(),
+    savedViewportCount(0)
+{
+
+}
+
+LayerCachePass::~LayerCachePass() {
+    Release();
+}
+
+void LayerCachePass::Release() {
+    for (Target& t : targets) {
+        SAFE_RELEASE(t.srv);
+        SAFE_RELEASE(t.rtv);
+        SAFE_RELEASE(t.texture);
+    }
+    targets.clear();
+    SAFE_RELEASE(savedRtv);
+    SAFE_RELEASE(savedDsv);
+}
+
+bool LayerCachePass::Init(ID3D11Device* device, const LayerCache& cache, float pixelScale) {
+    Release();
+    targets.resize(cache.GetLayerCount());
+    for (size_t i = 0; i < targets.size(); i++) {
+        Target& t = targets[i];
+        int layer = static_cast<int>(i);
+        t.width = static_cast<UINT>(std::ceil(cache.GetTextureWidth(layer) * pixelScale));
+        t.height = static_cast<UINT>(std::ceil(cache.GetTextureHeight(layer) * pixelScale));
+
+        D3D11_TEXTURE2D_DESC td = {};
+        td.Width = t.width;
+        td.Height = t.height;
+        td.MipLevels = 1;
+        td.ArraySize = 1;
+        td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        td.SampleDesc.Count = 1;
+        td.Usage = D3D11_USAGE_DEFAULT;
+        td.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+        if (FAILED(device->CreateTexture2D(&td, nullptr, &t.texture))) return false;
+        TrackTexture(t.texture, "LayerCache", cache.GetDesc(layer).name);
+        if (FAILED(device->CreateRenderTargetView(t.texture, nullptr, &t.rtv))) return false;
+        if (FAILED(device->CreateShaderResourceView(t.texture, nullptr, &t.srv))) return false;
+    }
+    return true;
+}
+
+void LayerCachePass::BeginLayer(ID3D11DeviceContext* context, const LayerCache& cache, int layer, DirectX::XMMATRIX* projection) {
+    PROFILE_ZONE("LayerCachePass::BeginLayer");
+    Target& t = targets[static_cast<size_t>(layer)];
+
+    // 前のフレームに貼ったときのまま入力に残っていると、描き先にできないので外す
+    ID3D11ShaderResourceView* none = nullptr;
+    context->PSSetShaderResources(0, 1, &none);
+
+    context->OMGetRenderTargets(1, &savedRtv, &savedDsv);
+    savedViewportCount = 1;
+    context->RSGetViewports(&savedViewportCount, &savedViewport);
+
+    float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    context->OMSetRenderTargets(1, &t.rtv, nullptr);
+    context->ClearRenderTargetView(t.rtv, clearColor);
+
+    D3D11_VIEWPORT vp = {};
+    vp.Width = static_cast<FLOAT>(t.width);
+    vp.Height = static_cast<FLOAT>(t.height);
+    vp.MinDepth = 0.0f;
+    vp.MaxDepth = 1.0f;
+    context->RSSetViewports(1, &vp);
+
+    LayerRegion region = cache.GetRenderRegion(layer);
+    *projection = DirectX::XMMatrixOrthographicOffCenterLH(
+        region.x, region.x + region.width,
+        region.y + region.height, region.y,
+        0.0f, 1.0f);
+}
+
+void LayerCachePass::EndLayer(ID3D11DeviceContext* context) {
+    context->OMSetRenderTargets(1, &savedRtv, savedDsv);
+    if (savedViewportCount > 0) context->RSSetViewports(savedViewportCount, &savedViewport);
+    SAFE_RELEASE(savedRtv);
+    SAFE_RELEASE(savedDsv);
+}
+
+ID3D11ShaderResourceView* LayerCachePass::GetSrv(int layer) const {
+    return targets[static_cast<size_t>(layer)].srv;
+}
@@ -0,0 +1,54 @@
+﻿/**********************************************************************************
+    LayerCachePass.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef LAYERCACHEPASS_H
+#define LAYERCACHEPASS_H
+
+#include "d3dApp.h"
+#include <vector>
+
+class LayerCache;
+
+//
+// LayerCache の層ごとのレンダーターゲット。BeginLayer と EndLayer の間に描いたものがテクスチャに残る
+// 貼るときは GetSrv を普通のスプライトのテクスチャとして使う
+class LayerCachePass {
+public:
+    LayerCachePass();
+    ~LayerCachePass();
+
+    // 層を足したときや画面の大きさが変わったときは呼び直す（中身は LayerCache 側で描き直しになる）
+    // pixelScale は論理座標 1 あたりのテクセル数。バックバッファと同じにすると拡大でぼけない
+    bool Init(ID3D11Device* device, const LayerCache& cache, float pixelScale);
+    void Release();
+
+    // 今のレンダーターゲットとビューポートを覚えておき、層のテクスチャを透明で塗って描き先にする
+    // projection には GetRenderRegion をテクスチャ全体に写す正射影が入る。深度は使わない
+    void BeginLayer(ID3D11DeviceContext* context, const LayerCache& cache, int layer, DirectX::XMMATRIX* projection);
+    void EndLayer(ID3D11DeviceContext* context);
+
+    ID3D11ShaderResourceView* GetSrv(int layer) const;
+
+private:
+    struct Target {
+        ID3D11Texture2D* texture = nullptr;
+        ID3D11RenderTargetView* rtv = nullptr;
+        ID3D11ShaderResourceView* srv = nullptr;
+        UINT width = 0;
+        UINT height = 0;
+    };
+
+    std::vector<Target> targets;
+    ID3D11RenderTargetView* savedRtv;
+    ID3D11DepthStencilView* savedDsv;
+    D3D11_VIEWPORT savedViewport;
+    UINT savedViewportCount;
+};
+
+
+#endif
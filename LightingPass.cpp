@@ -0,0 +1,105 @@
+﻿/**********************************************************************************
+    LightingPass.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/21
+
+**********************************************************************************/
+
+#include "LightingPass.h"
+#include "Lightmap2D.h"
+#include "BufferUtils.h"
+#include "SpriteBatch.h"
+#include "Profiler.h"
+
+LightingPass::LightingPass()
+    : texture(nullptr),
+    srv(nullptr),
+    clampSampler(nullptr),
+    width(0),
+    height(0)
+{
+
+}
+
+LightingPass::~LightingPass() {
+    Release();
+}
+
+void LightingPass::Release() {
+    SAFE_RELEASE(srv);
+    SAFE_RELEASE(texture);
+    SAFE_RELEASE(clampSampler);
+}
+
+bool LightingPass::Init(ID3D11Device* device, int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width = static_cast<UINT>(width);
+    td.Height = static_cast<UINT>(height);
+    td.MipLevels = 1;
+    td.ArraySize = 1;
+    td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_DYNAMIC;                 // 毎フレーム CPU から書き換える
+    td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    td.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device->CreateTexture2D(&td, nullptr, &texture))) return false;
+    TrackTexture(texture, "LightingPass", "lightmap");
+    if (FAILED(device->CreateShaderResourceView(texture, nullptr, &srv))) return false;
+
+    // 画面端で反対側の色を拾わないようにクランプ
+    D3D11_SAMPLER_DESC sampDesc = {};
+    sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
+    return SUCCEEDED(device->CreateSamplerState(&sampDesc, &clampSampler));
+}
+
+void LightingPass::Upload(ID3D11DeviceContext* context, const Lightmap2D& lightmap) {
+    PROFILE_ZONE("LightingPass::Upload");
+    D3D11_MAPPED_SUBRESOURCE m{};
+    if (FAILED(context->Map(texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) return;
+
+    // RowPitch はテクスチャ幅より大きいことがあるので 1 行ずつコピー
+    const uint32_t* src = lightmap.GetPixels();
+    for (int y = 0; y < height; y++) {
+        memcpy(static_cast<uint8_t*>(m.pData) + static_cast<size_t>(y) * m.RowPitch,
+            src + static_cast<size_t>(y) * static_cast<size_t>(width),
+            static_cast<size_t>(width) * sizeof(uint32_t));
+    }
+    context->Unmap(texture, 0);
+}
+
+void LightingPass::Composite(ID3D11DeviceContext* context, SpriteBatch* batch,
+    const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection,
+    ID3D11BlendState* multiplyBlend, ID3D11SamplerState* restoreSampler,
+    float logicalWidth, float logicalHeight) {
+    PROFILE_ZONE("LightingPass::Composite");
+
+    SpriteQuad q;
+    q.pos[0] = { 0.0f, 0.0f };
+    q.pos[1] = { logicalWidth, 0.0f };
+    q.pos[2] = { logicalWidth, logicalHeight };
+    q.pos[3] = { 0.0f, logicalHeight };
+    q.uv[0] = { 0.0f, 0.0f };
+    q.uv[1] = { 1.0f, 0.0f };
+    q.uv[2] = { 1.0f, 1.0f };
+    q.uv[3] = { 0.0f, 1.0f };
+    q.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    q.depth = 0.0f;
+
+    context->OMSetBlendState(multiplyBlend, nullptr, 0xffffffff);
+    context->PSSetSamplers(0, 1, &clampSampler);
+
+    batch->Begin(context, view, projection);
+    batch->Draw(srv, &q, 1);
+    batch->End();
+
+    context->PSSetSamplers(0, 1, &restoreSampler);
+}
@@ -0,0 +1,45 @@
+﻿/**********************************************************************************
+    LightingPass.h
+
+                                                                LI WENHUI
+                                                                2025/08/21
+
+**********************************************************************************/
+
+#ifndef LIGHTINGPASS_H
+#define LIGHTINGPASS_H
+
+#include "d3dApp.h"
+
+class Lightmap2D;
+class SpriteBatch;
+
+//
+// CPU で作ったライトマップを動的テクスチャに転送し、乗算ブレンドで画面全体に重ねる
+// 低解像度のテクスチャを線形フィルタで引き伸ばすので、そのまま柔らかい影になる
+class LightingPass {
+public:
+    LightingPass();
+    ~LightingPass();
+
+    bool Init(ID3D11Device* device, int width, int height);
+    void Release();
+
+    void Upload(ID3D11DeviceContext* context, const Lightmap2D& lightmap);
+
+    // multiplyBlend で logicalWidth x logicalHeight 全体に描く
+    void Composite(ID3D11DeviceContext* context, SpriteBatch* batch,
+        const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection,
+        ID3D11BlendState* multiplyBlend, ID3D11SamplerState* restoreSampler,
+        float logicalWidth, float logicalHeight);
+
+private:
+    ID3D11Texture2D* texture;
+    ID3D11ShaderResourceView* srv;
+    ID3D11SamplerState* clampSampler;
+    int width;
+    int height;
+};
+
+
+#endif
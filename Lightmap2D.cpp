@@ -0,0 +1,252 @@
+﻿/**********************************************************************************
+    Lightmap2D.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/21
+
+**********************************************************************************/
+
+#include "Lightmap2D.h"
+#include "FieldOfView.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr float kPi = 3.14159265f;
+    constexpr float kBinScale = Lightmap2D::kShadowBins / (2.0f * kPi);
+
+    int AngleToBin(float angle) {
+        int bin = static_cast<int>((angle + kPi) * kBinScale);
+        return ((bin % Lightmap2D::kShadowBins) + Lightmap2D::kShadowBins) % Lightmap2D::kShadowBins;
+    }
+
+    float WrapPi(float a) {
+        while (a > kPi) a -= 2.0f * kPi;
+        while (a < -kPi) a += 2.0f * kPi;
+        return a;
+    }
+
+    // レイと矩形の最初の交点までの距離。当たらなければ無限大
+    // 軸に平行なレイ（dx か dy が 0）は、その軸では原点が矩形の幅に入っているかだけを見る（0 で割ると NaN になる）
+    float RayAabb(float ox, float oy, float dx, float dy, const Aabb& box) {
+        const float inf = std::numeric_limits<float>::infinity();
+        float tmin = -inf, tmax = inf;
+        if (dx != 0.0f) {
+            float invX = 1.0f / dx;
+            float tx0 = (box.minX - ox) * invX, tx1 = (box.maxX - ox) * invX;
+            tmin = std::min(tx0, tx1);
+            tmax = std::max(tx0, tx1);
+        }
+        else if (ox < box.minX || ox > box.maxX) return inf;
+        if (dy != 0.0f) {
+            float invY = 1.0f / dy;
+            float ty0 = (box.minY - oy) * invY, ty1 = (box.maxY - oy) * invY;
+            tmin = std::max(tmin, std::min(ty0, ty1));
+            tmax = std::min(tmax, std::max(ty0, ty1));
+        }
+        else if (oy < box.minY || oy > box.maxY) return inf;
+        if (tmax < 0.0f || tmin > tmax) return inf;
+        return std::max(tmin, 0.0f);
+    }
+
+    bool SameLight(const Light2D& a, const Light2D& b) {
+        return a.x == b.x && a.y == b.y && a.radius == b.radius && a.intensity == b.intensity
+            && a.color.x == b.color.x && a.color.y == b.color.y && a.color.z == b.color.z
+            && a.dirX == b.dirX && a.dirY == b.dirY && a.coneCos == b.coneCos && a.coneSoftness == b.coneSoftness
+            && a.castShadows == b.castShadows;
+    }
+
+    bool SameAabb(const Aabb& a, const Aabb& b) {
+        return a.minX == b.minX && a.minY == b.minY && a.maxX == b.maxX && a.maxY == b.maxY;
+    }
+}
+
+void Lightmap2D::Resize(int width, int height, float worldWidth, float worldHeight) {
+    this->width = width;
+    this->height = height;
+    cellW = worldWidth / static_cast<float>(width);
+    cellH = worldHeight / static_cast<float>(height);
+    lit.assign(static_cast<size_t>(width) * static_cast<size_t>(height), 0xff000000);
+    pixels.assign(lit.size(), 0xff000000);
+    tracked.Set((lit.capacity() + pixels.capacity()) * sizeof(uint32_t) + shadowMaps.capacity() * sizeof(float));
+    built = false;
+}
+
+void Lightmap2D::SetAmbient(const DirectX::XMFLOAT3& ambient) {
+    this->ambient = ambient;
+    built = false;
+}
+
+void Lightmap2D::Invalidate() {
+    built = false;
+}
+
+const uint32_t* Lightmap2D::GetPixels() const {
+    return pixels.data();
+}
+
+int Lightmap2D::GetWidth() const {
+    return width;
+}
+
+int Lightmap2D::GetHeight() const {
+    return height;
+}
+
+void Lightmap2D::BuildShadowMap(const Light2D& light, const Aabb* occluders, size_t occluderCount, float* bins) const {
+    std::fill(bins, bins + kShadowBins, light.radius);
+    if (!light.castShadows) return;
+
+    float r2 = light.radius * light.radius;
+    for (size_t i = 0; i < occluderCount; i++) {
+        const Aabb& box = occluders[i];
+
+        // 光の届かない遮蔽物と、光源を含む遮蔽物は無視
+        float nx = std::clamp(light.x, box.minX, box.maxX) - light.x;
+        float ny = std::clamp(light.y, box.minY, box.maxY) - light.y;
+        if (nx * nx + ny * ny > r2) continue;
+        if (nx == 0.0f && ny == 0.0f) continue;
+
+        // 4 隅の角度から、矩形が占める角度範囲を求める
+        float center = std::atan2((box.minY + box.maxY) * 0.5f - light.y, (box.minX + box.maxX) * 0.5f - light.x);
+        float minD = kPi, maxD = -kPi;
+        const float cx[4] = { box.minX, box.maxX, box.maxX, box.minX };
+        const float cy[4] = { box.minY, box.minY, box.maxY, box.maxY };
+        for (int c = 0; c < 4; c++) {
+            float d = WrapPi(std::atan2(cy[c] - light.y, cx[c] - light.x) - center);
+            minD = std::min(minD, d);
+            maxD = std::max(maxD, d);
+        }
+
+        int b0 = static_cast<int>(std::floor((center + minD + kPi) * kBinScale));
+        int b1 = static_cast<int>(std::floor((center + maxD + kPi) * kBinScale));
+        for (int b = b0; b <= b1; b++) {
+            int bin = ((b % kShadowBins) + kShadowBins) % kShadowBins;
+            float angle = (static_cast<float>(bin) + 0.5f) / kBinScale - kPi;
+            float t = RayAabb(light.x, light.y, std::cos(angle), std::sin(angle), box);
+            bins[bin] = std::min(bins[bin], t);
+        }
+    }
+}
+
+void Lightmap2D::ShadeRows(int y0, int y1, const Light2D* lights, size_t lightCount) {
+    std::vector<float> row(static_cast<size_t>(width) * 3);
+    // 遮蔽物の表面自体は照らされるように半テクセル分ずらす
+    const float bias = 0.5f * std::max(cellW, cellH);
+
+    for (int y = y0; y < y1; y++) {
+        float wy = (static_cast<float>(y) + 0.5f) * cellH;
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = ambient.x;
+            row[x * 3 + 1] = ambient.y;
+            row[x * 3 + 2] = ambient.z;
+        }
+
+        for (size_t l = 0; l < lightCount; l++) {
+            const Light2D& light = lights[l];
+            float dy = wy - light.y;
+            if (std::fabs(dy) >= light.radius) continue;
+
+            const float* bins = shadowMaps.data() + l * kShadowBins;
+            float r2 = light.radius * light.radius;
+            float invR = 1.0f / light.radius;
+            int xBegin = std::max(static_cast<int>((light.x - light.radius) / cellW), 0);
+            int xEnd = std::min(static_cast<int>((light.x + light.radius) / cellW) + 1, width);
+
+            for (int x = xBegin; x < xEnd; x++) {
+                float dx = (static_cast<float>(x) + 0.5f) * cellW - light.x;
+                float d2 = dx * dx + dy * dy;
+                if (d2 >= r2) continue;
+                float d = std::sqrt(d2);
+
+                float atten = 1.0f - d * invR;
+                atten *= atten * light.intensity;
+
+                if (light.coneCos > -1.0f && d > 0.0f) {
+                    float c = (dx * light.dirX + dy * light.dirY) / d;
+                    atten *= std::clamp((c - light.coneCos) / light.coneSoftness, 0.0f, 1.0f);
+                    if (atten <= 0.0f) continue;
+                }
+                if (light.castShadows && d > bins[AngleToBin(std::atan2(dy, dx))] + bias) continue;
+
+                row[x * 3 + 0] += light.color.x * atten;
+                row[x * 3 + 1] += light.color.y * atten;
+                row[x * 3 + 2] += light.color.z * atten;
+            }
+        }
+
+        uint32_t* out = lit.data() + static_cast<size_t>(y) * static_cast<size_t>(width);
+        for (int x = 0; x < width; x++) {
+            uint32_t cr = static_cast<uint32_t>(std::min(row[x * 3 + 0], 1.0f) * 255.0f);
+            uint32_t cg = static_cast<uint32_t>(std::min(row[x * 3 + 1], 1.0f) * 255.0f);
+            uint32_t cb = static_cast<uint32_t>(std::min(row[x * 3 + 2], 1.0f) * 255.0f);
+            out[x] = 0xff000000 | (cb << 16) | (cg << 8) | cr;
+        }
+    }
+}
+
+void Lightmap2D::Build(const Light2D* lights, size_t lightCount,
+    const Aabb* occluders, size_t occluderCount, JobSystem* jobs) {
+    PROFILE_ZONE("Lightmap2D::Build");
+
+    // 入力が前回と同じなら lit はそのまま使える（比べるのはライト数 + 矩形数の分だけ）
+    if (built && builtLights.size() == lightCount && builtOccluders.size() == occluderCount
+        && std::equal(lights, lights + lightCount, builtLights.begin(), SameLight)
+        && std::equal(occluders, occluders + occluderCount, builtOccluders.begin(), SameAabb)) {
+        return;
+    }
+    builtLights.assign(lights, lights + lightCount);
+    builtOccluders.assign(occluders, occluders + occluderCount);
+    built = true;
+
+    if (shadowMaps.size() < lightCount * kShadowBins) {
+        shadowMaps.resize(lightCount * kShadowBins);
+        tracked.Set((lit.capacity() + pixels.capacity()) * sizeof(uint32_t) + shadowMaps.capacity() * sizeof(float));
+    }
+
+    auto shadowJob = [&](size_t begin, size_t end) {
+        for (size_t l = begin; l < end; l++) {
+            BuildShadowMap(lights[l], occluders, occluderCount, shadowMaps.data() + l * kShadowBins);
+        }
+    };
+    auto shadeJob = [&](size_t begin, size_t end) {
+        ShadeRows(static_cast<int>(begin), static_cast<int>(end), lights, lightCount);
+    };
+
+    // 1) ライトごとのシャドウマップ  2) 行ごとの合成。どちらも独立しているので並列に回せる
+    if (jobs) {
+        jobs->ParallelFor(lightCount, 4, shadowJob);
+        jobs->ParallelFor(static_cast<size_t>(height), 8, shadeJob);
+    }
+    else {
+        shadowJob(0, lightCount);
+        shadeJob(0, static_cast<size_t>(height));
+    }
+    pixels = lit;
+}
+
+void Lightmap2D::ApplyVisibility(const FovResult& fov, float tileSize, JobSystem* jobs) {
+    PROFILE_ZONE("Lightmap2D::ApplyVisibility");
+    uint32_t cr = static_cast<uint32_t>(std::min(ambient.x, 1.0f) * 255.0f);
+    uint32_t cg = static_cast<uint32_t>(std::min(ambient.y, 1.0f) * 255.0f);
+    uint32_t cb = static_cast<uint32_t>(std::min(ambient.z, 1.0f) * 255.0f);
+    const uint32_t dark = 0xff000000 | (cb << 16) | (cg << 8) | cr;
+    const float invTile = 1.0f / tileSize;
+
+    auto job = [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; y++) {
+            int ty = static_cast<int>(std::floor((static_cast<float>(y) + 0.5f) * cellH * invTile));
+            const uint32_t* in = lit.data() + y * static_cast<size_t>(width);
+            uint32_t* out = pixels.data() + y * static_cast<size_t>(width);
+            for (int x = 0; x < width; x++) {
+                int tx = static_cast<int>(std::floor((static_cast<float>(x) + 0.5f) * cellW * invTile));
+                out[x] = fov.IsVisible(tx, ty) ? in[x] : dark;
+            }
+        }
+    };
+    if (jobs) jobs->ParallelFor(static_cast<size_t>(height), 8, job);
+    else job(0, static_cast<size_t>(height));
+}
@@ -0,0 +1,79 @@
+﻿/**********************************************************************************
+    Lightmap2D.h
+
+                                                                LI WENHUI
+                                                                2025/08/21
+
+**********************************************************************************/
+
+#ifndef LIGHTMAP2D_H
+#define LIGHTMAP2D_H
+
+#include "Aabb.h"
+#include "ResourceRegistry.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+struct FovResult;
+
+struct Light2D {
+    float x = 0.0f, y = 0.0f;
+    float radius = 300.0f;
+    float intensity = 1.0f;
+    DirectX::XMFLOAT3 color = { 1.0f, 1.0f, 1.0f };
+    // 円錐ライト（懐中電灯）。coneCos は半角の cos、-1 なら全方向の点光源
+    float dirX = 1.0f, dirY = 0.0f;
+    float coneCos = -1.0f;
+    float coneSoftness = 0.1f;     // 縁をぼかす cos の幅
+    bool castShadows = true;
+};
+
+//
+// 画面より低い解像度の CPU ライトマップ
+// ライトごとに角度方向の 1D シャドウマップ（遮蔽物までの距離）を作り、
+// テクセルはそれと比較するだけなので、ライト数が増えても安い
+class Lightmap2D {
+public:
+    static constexpr int kShadowBins = 256;
+
+    // worldW x worldH の範囲を width x height テクセルで覆う
+    void Resize(int width, int height, float worldWidth, float worldHeight);
+    void SetAmbient(const DirectX::XMFLOAT3& ambient);
+
+    // jobs が null なら単一スレッド
+    // ライトと遮蔽物が前回と同じなら作り直さない（止まっているときは何もしない）
+    void Build(const Light2D* lights, size_t lightCount,
+        const Aabb* occluders, size_t occluderCount, JobSystem* jobs);
+    // 次の Build を必ず作り直す
+    void Invalidate();
+
+    // 視界の外（fov で見えないタイル）のテクセルを環境光だけにする。Build の結果は残すので毎フレーム呼んでよい
+    void ApplyVisibility(const FovResult& fov, float tileSize, JobSystem* jobs);
+
+    const uint32_t* GetPixels() const;     // RGBA8
+    int GetWidth() const;
+    int GetHeight() const;
+
+private:
+    void BuildShadowMap(const Light2D& light, const Aabb* occluders, size_t occluderCount, float* bins) const;
+    void ShadeRows(int y0, int y1, const Light2D* lights, size_t lightCount);
+
+    int width = 0;
+    int height = 0;
+    float cellW = 1.0f;
+    float cellH = 1.0f;
+    DirectX::XMFLOAT3 ambient = { 0.05f, 0.05f, 0.08f };
+
+    std::vector<float> shadowMaps;      // lightCount * kShadowBins
+    std::vector<uint32_t> lit;          // Build の結果（視界で削る前）
+    std::vector<uint32_t> pixels;
+    std::vector<Light2D> builtLights;   // lit を作ったときの入力
+    std::vector<Aabb> builtOccluders;
+    bool built = false;
+    TrackedMemory tracked{ MemoryTag::Lighting };
+};
+
+
+#endif
@@ -0,0 +1,195 @@
+﻿/**********************************************************************************
+    ParticleSystem.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/18
+
+**********************************************************************************/
+
+#include "ParticleSystem.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace {
+    // 1 ジョブあたりのパーティクル数（4 の倍数）
+    constexpr size_t kParticlesPerJob = 4096;
+
+    inline XMVECTOR Load4(const std::vector<float>& v, size_t i) {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&v[i]));
+    }
+    inline void Store4(std::vector<float>& v, size_t i, FXMVECTOR x) {
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&v[i]), x);
+    }
+}
+
+ParticleSystem::ParticleSystem(size_t capacity, uint32_t seed)
+    : capacity(capacity),
+    rngState(seed ? seed : 1)
+{
+    // 4 個単位で読み書きするので、末尾の端数分も確保しておく
+    size_t padded = (capacity + 3) & ~static_cast<size_t>(3);
+    for (std::vector<float>* v : { &posX, &posY, &velX, &velY, &accX, &accY, &drag,
+        &age, &ageRate, &r0, &g0, &b0, &a0, &dr, &dg, &db, &da, &size0, &dsize,
+        &r, &g, &b, &a, &size }) {
+        v->assign(padded, 0.0f);
+    }
+    emitterIndex.assign(padded, 0);
+    tracked.Set(padded * (24 * sizeof(float) + sizeof(uint16_t)));
+}
+
+int ParticleSystem::AddEmitter(const EmitterDesc& desc) {
+    emitters.push_back(desc);
+    emitAccumulator.push_back(0.0f);
+    return static_cast<int>(emitters.size() - 1);
+}
+
+EmitterDesc& ParticleSystem::GetEmitter(int emitter) {
+    return emitters[static_cast<size_t>(emitter)];
+}
+
+void ParticleSystem::Burst(int emitter, size_t count) {
+    for (size_t i = 0; i < count && alive < capacity; i++) {
+        Spawn(static_cast<uint16_t>(emitter));
+    }
+}
+
+size_t ParticleSystem::GetAliveCount() const {
+    return alive;
+}
+
+size_t ParticleSystem::GetCapacity() const {
+    return capacity;
+}
+
+float ParticleSystem::Random(float minValue, float maxValue) {
+    // xorshift32（シードが同じなら同じ結果になる）
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    float t = static_cast<float>(rngState >> 8) * (1.0f / 16777216.0f);
+    return minValue + (maxValue - minValue) * t;
+}
+
+void ParticleSystem::Spawn(uint16_t emitter) {
+    const EmitterDesc& e = emitters[emitter];
+    size_t i = alive++;
+
+    posX[i] = e.x + Random(0.0f, e.width);
+    posY[i] = e.y + Random(0.0f, e.height);
+    velX[i] = Random(e.velXMin, e.velXMax);
+    velY[i] = Random(e.velYMin, e.velYMax);
+    accX[i] = e.accelX;
+    accY[i] = e.accelY;
+    drag[i] = e.drag;
+    age[i] = 0.0f;
+    ageRate[i] = 1.0f / std::max(Random(e.lifeMin, e.lifeMax), 0.001f);
+
+    r0[i] = e.colorStart.x;  dr[i] = e.colorEnd.x - e.colorStart.x;
+    g0[i] = e.colorStart.y;  dg[i] = e.colorEnd.y - e.colorStart.y;
+    b0[i] = e.colorStart.z;  db[i] = e.colorEnd.z - e.colorStart.z;
+    a0[i] = e.colorStart.w;  da[i] = e.colorEnd.w - e.colorStart.w;
+    size0[i] = e.sizeStart;  dsize[i] = e.sizeEnd - e.sizeStart;
+    emitterIndex[i] = emitter;
+}
+
+void ParticleSystem::Integrate(size_t begin, size_t end, float deltaTime) {
+    const XMVECTOR dt = XMVectorReplicate(deltaTime);
+    const XMVECTOR one = XMVectorSplatOne();
+
+    for (size_t i = begin; i < end; i += 4) {
+        // 速度 → 減衰 → 位置（半陰的オイラー）
+        XMVECTOR damp = XMVectorMax(XMVectorZero(), XMVectorSubtract(one, XMVectorMultiply(Load4(drag, i), dt)));
+        XMVECTOR vx = XMVectorMultiply(XMVectorMultiplyAdd(Load4(accX, i), dt, Load4(velX, i)), damp);
+        XMVECTOR vy = XMVectorMultiply(XMVectorMultiplyAdd(Load4(accY, i), dt, Load4(velY, i)), damp);
+        Store4(velX, i, vx);
+        Store4(velY, i, vy);
+        Store4(posX, i, XMVectorMultiplyAdd(vx, dt, Load4(posX, i)));
+        Store4(posY, i, XMVectorMultiplyAdd(vy, dt, Load4(posY, i)));
+
+        XMVECTOR t = XMVectorMultiplyAdd(Load4(ageRate, i), dt, Load4(age, i));
+        Store4(age, i, t);
+
+        // 色とサイズは寿命に対して線形補間
+        t = XMVectorSaturate(t);
+        Store4(r, i, XMVectorMultiplyAdd(Load4(dr, i), t, Load4(r0, i)));
+        Store4(g, i, XMVectorMultiplyAdd(Load4(dg, i), t, Load4(g0, i)));
+        Store4(b, i, XMVectorMultiplyAdd(Load4(db, i), t, Load4(b0, i)));
+        Store4(a, i, XMVectorMultiplyAdd(Load4(da, i), t, Load4(a0, i)));
+        Store4(size, i, XMVectorMultiplyAdd(Load4(dsize, i), t, Load4(size0, i)));
+    }
+}
+
+void ParticleSystem::Move(size_t from, size_t to) {
+    for (std::vector<float>* v : { &posX, &posY, &velX, &velY, &accX, &accY, &drag,
+        &age, &ageRate, &r0, &g0, &b0, &a0, &dr, &dg, &db, &da, &size0, &dsize,
+        &r, &g, &b, &a, &size }) {
+        (*v)[to] = (*v)[from];
+    }
+    emitterIndex[to] = emitterIndex[from];
+}
+
+void ParticleSystem::Update(float deltaTime, JobSystem* jobs) {
+    PROFILE_ZONE("ParticleSystem::Update");
+    // 発生（乱数の順序を固定するため単一スレッド）
+    for (size_t e = 0; e < emitters.size(); e++) {
+        if (!emitters[e].enabled) continue;
+        emitAccumulator[e] += emitters[e].rate * deltaTime;
+        size_t count = static_cast<size_t>(emitAccumulator[e]);
+        emitAccumulator[e] -= static_cast<float>(count);
+        for (size_t i = 0; i < count && alive < capacity; i++) {
+            Spawn(static_cast<uint16_t>(e));
+        }
+    }
+
+    size_t padded = (alive + 3) & ~static_cast<size_t>(3);
+    if (jobs) {
+        jobs->ParallelFor(padded, kParticlesPerJob, [this, deltaTime](size_t begin, size_t end) {
+            Integrate(begin, end, deltaTime);
+        });
+    }
+    else {
+        Integrate(0, padded, deltaTime);
+    }
+
+    // 寿命切れは末尾と入れ替えて削除
+    for (size_t i = 0; i < alive;) {
+        if (age[i] >= 1.0f) {
+            alive--;
+            Move(alive, i);
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+size_t ParticleSystem::BuildQuads(ParticleBlend blend, std::vector<SpriteQuad>* out) const {
+    size_t written = 0;
+    for (size_t i = 0; i < alive; i++) {
+        const EmitterDesc& e = emitters[emitterIndex[i]];
+        if (e.blend != blend) continue;
+
+        float hw = size[i] * 0.5f;
+        float hh = hw * e.aspect;
+        float x = posX[i];
+        float y = posY[i];
+
+        SpriteQuad q;
+        q.pos[0] = { x - hw, y - hh };
+        q.pos[1] = { x + hw, y - hh };
+        q.pos[2] = { x + hw, y + hh };
+        q.pos[3] = { x - hw, y + hh };
+        q.uv[0] = { 0.0f, 0.0f };
+        q.uv[1] = { 1.0f, 0.0f };
+        q.uv[2] = { 1.0f, 1.0f };
+        q.uv[3] = { 0.0f, 1.0f };
+        q.color = { r[i], g[i], b[i], a[i] };
+        q.depth = e.depth;
+        out->push_back(q);
+        written++;
+    }
+    return written;
+}
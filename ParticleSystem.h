@@ -0,0 +1,93 @@
+﻿/**********************************************************************************
+    ParticleSystem.h
+
+                                                                LI WENHUI
+                                                                2025/08/18
+
+**********************************************************************************/
+
+#ifndef PARTICLESYSTEM_H
+#define PARTICLESYSTEM_H
+
+#include "ResourceRegistry.h"
+#include "SpriteQuad.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// InitD3D で作ったブレンドステートに対応
+enum class ParticleBlend : uint8_t {
+    Normal,
+    Additive,
+    Screen,
+    Count
+};
+
+struct EmitterDesc {
+    float x = 0.0f, y = 0.0f;               // 発生範囲の左上
+    float width = 0.0f, height = 0.0f;      // 発生範囲（矩形）
+    float rate = 0.0f;                      // 1秒あたりの発生数
+    float lifeMin = 1.0f, lifeMax = 1.0f;
+    float velXMin = 0.0f, velXMax = 0.0f;
+    float velYMin = 0.0f, velYMax = 0.0f;
+    float accelX = 0.0f, accelY = 0.0f;     // 重力・風
+    float drag = 0.0f;                      // 1秒あたりの減速率
+    DirectX::XMFLOAT4 colorStart = { 1.0f, 1.0f, 1.0f, 1.0f };
+    DirectX::XMFLOAT4 colorEnd = { 1.0f, 1.0f, 1.0f, 0.0f };
+    float sizeStart = 4.0f, sizeEnd = 4.0f;
+    float aspect = 1.0f;                    // 高さ / 幅（雨粒は縦長）
+    float depth = 0.0f;
+    ParticleBlend blend = ParticleBlend::Normal;
+    bool enabled = true;
+};
+
+//
+// パーティクルは成分ごとの配列（SoA）に置き、4 個ずつ DirectXMath でまとめて積分する
+// 寿命が尽きたものは末尾と入れ替えて詰めるので、生存数までが常に連続している
+class ParticleSystem {
+public:
+    explicit ParticleSystem(size_t capacity, uint32_t seed = 1);
+
+    int AddEmitter(const EmitterDesc& desc);
+    EmitterDesc& GetEmitter(int emitter);
+    void Burst(int emitter, size_t count);
+
+    // jobs が null なら呼び出しスレッドだけで更新する
+    void Update(float deltaTime, JobSystem* jobs);
+
+    // 指定したブレンドのパーティクルだけを四角形にして out に追加する
+    size_t BuildQuads(ParticleBlend blend, std::vector<SpriteQuad>* out) const;
+
+    size_t GetAliveCount() const;
+    size_t GetCapacity() const;
+
+private:
+    void Spawn(uint16_t emitter);
+    void Integrate(size_t begin, size_t end, float deltaTime);
+    void Move(size_t from, size_t to);
+    float Random(float minValue, float maxValue);
+
+    size_t capacity;
+    size_t alive = 0;
+    uint32_t rngState;
+
+    std::vector<EmitterDesc> emitters;
+    std::vector<float> emitAccumulator;
+
+    // 状態
+    std::vector<float> posX, posY, velX, velY, accX, accY, drag;
+    std::vector<float> age, ageRate;            // age は 0..1 に正規化、ageRate = 1 / 寿命
+    std::vector<float> r0, g0, b0, a0, dr, dg, db, da;
+    std::vector<float> size0, dsize;
+    std::vector<uint16_t> emitterIndex;
+
+    // 積分の出力（描画用）
+    std::vector<float> r, g, b, a, size;
+
+    TrackedMemory tracked{ MemoryTag::Particles };
+};
+
+
+#endif
@@ -9,14 +9,26 @@
 #include "PlayerObject.h"
 #include "BufferUtils.h"
 #include "TextureLoader.h"
+#include "Profiler.h"
+#include "ResourceRegistry.h"
+#include "TextureStreamer.h"
 #include <DirectXMath.h>
 
+namespace {
+	// 多角形がないフレーム用の四角形
+	SpriteMesh MakeRectMesh() {
+		SpriteMesh mesh;
+		mesh.points = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+		mesh.indices = { 0, 1, 2, 0, 2, 3 };
+		return mesh;
+	}
+	const SpriteMesh kRectMesh = MakeRectMesh();
+}
+
 PlayerObject::PlayerObject()
 	: vertexBuffer(nullptr),
 	indexBuffer(nullptr),
 	constantBuffer(nullptr),
-	animationTimer(0.0f),
-	frameIndex(0),
 	indexCount(0)
 {
 	
@@ -38,6 +50,15 @@ void PlayerObject::Release() {
 		}
 	}
 	textureSrvs.clear();
+	if (textures) {
+		for (int id : textureIds) textures->Remove(id);
+	}
+	textureIds.clear();
+	textures = nullptr;
+	clipGutters.clear();
+	clipMasks.clear();
+	clipMeshes.clear();
+	clipMaskMemory.Set(0);
 }
 
 bool PlayerObject::Load(
@@ -45,19 +66,17 @@ bool PlayerObject::Load(
 	ID3D11DeviceContext* context,
 	float width,
 	float height,
-	std::vector<AnimationData>& animationData,
-	bool isAnimated
+	const AnimGraph* animGraph,
+	bool isAnimated,
+	JobSystem* jobs,
+	TextureStreamer* textures
 ) {
-	this->animationData = animationData;
+	PROFILE_ZONE("PlayerObject::Load");
+	this->animGraph = animGraph;
+	ResetAnimGraphInstance(*animGraph, &animInstance);
 
 	InitVertexData(device, context, width, height);
 
-
-	totalFrames = animationData[0].totalFrames;
-	columns = animationData[0].columns;
-	rows = animationData[0].rows;
-	fps = animationData[0].fps;
-
 	//
 	D3D11_BUFFER_DESC cbd = {};
 	cbd.Usage = D3D11_USAGE_DYNAMIC;
@@ -65,26 +84,54 @@ bool PlayerObject::Load(
 	cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
 	cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 	device->CreateBuffer(&cbd, nullptr, &constantBuffer);
-
-
-	textureSrvs.resize(static_cast<size_t>(PlayerAnimationIndex::Count));
-
-
-	for (size_t i = 0; i < animationData.size(); i++) {
-		// テクスチャの読み込み
-		if (FAILED(LoadTextureAndCreateSRV(device, animationData[i].texturePath.c_str(), &textureSrvs[i], &textureWidth, &textureHeight))) {
-			return false;
+	TrackBuffer(constantBuffer, "PlayerObject");
+
+
+	// クリップごとに SRV を 1 つ。インデックスは animGraph->clips と一致
+	// 当たりマスクも読み込みのついでに同じシートから作る
+	textureSrvs.resize(animGraph->clips.size());
+	clipGutters.resize(animGraph->clips.size());
+	clipMasks.resize(animGraph->clips.size());
+	clipMeshes.resize(animGraph->clips.size());
+
+	// テクスチャの読み込み。フレームの周りに余白を足して、線形補間で隣のフレームがにじまないようにする
+	TexturePrepOptions prep;
+	prep.gutter = 2;
+	if (FAILED(LoadTexturesWithMasks(device, animGraph->clips.data(), animGraph->clips.size(), textureSrvs.data(),
+		clipMasks.data(), clipMeshes.data(), clipGutters.data(), jobs, &textureWidth, &textureHeight, 128, prep))) {
+		return false;
+	}
+	if (textures) {
+		// 読み直すときも同じ前処理になるように、シートの並びと一緒に預ける
+		this->textures = textures;
+		textureIds.resize(textureSrvs.size());
+		for (size_t i = 0; i < textureSrvs.size(); i++) {
+			const AnimationData& clip = animGraph->clips[i];
+			textureIds[i] = textures->Adopt(textureSrvs[i], SpriteAlphaMode::Blended, clip.texturePath, prep, clip.columns, clip.rows);
 		}
+		textureSrvs.clear();
 	}
+	else {
+		for (ID3D11ShaderResourceView* srv : textureSrvs) {
+			ResourceSetOwner(srv, "PlayerObject");
+		}
+	}
+	size_t maskBytes = 0;
+	for (const auto& masks : clipMasks) {
+		for (const auto& mask : masks) maskBytes += (mask.bits.capacity() + mask.mirrored.capacity()) * sizeof(uint64_t);
+	}
+	clipMaskMemory.Set(maskBytes);
 
 	this->isAnimated = isAnimated;
 
 	//
 	if (!this->isAnimated) {
-		texOffset[0] = 0.0f;
-		texOffset[1] = 0.0f;
-		texScale[0] = 1.0f;
-		texScale[1] = 1.0f;
+		// シート全体を 1 枚として貼る（余白の分だけ内側）
+		DirectX::XMFLOAT2 gutter = clipGutters.empty() ? DirectX::XMFLOAT2{ 0.0f, 0.0f } : clipGutters[0];
+		texOffset[0] = gutter.x;
+		texOffset[1] = gutter.y;
+		texScale[0] = 1.0f - gutter.x * 2.0f;
+		texScale[1] = 1.0f - gutter.y * 2.0f;
 	}
 
 	objW = width;
@@ -100,8 +147,10 @@ void PlayerObject::InitVertexData(ID3D11Device* device, ID3D11DeviceContext* con
 		{ { width, height, 0.0f }, { 1, 1, 1, 1 }, { 1.0f, 1.0f } },
 		{ { 0.0f,  height, 0.0f }, { 1, 1, 1, 1 }, { 0.0f, 1.0f } }
 	};
-	vertexBuffer = CreateDynamicVertexBuffer(device, 4);
-	indexBuffer = CreateDynamicIndexBuffer(device, 6);
+	// フレームごとの多角形（SpriteMesh）を描くときに書き換えるので、その頂点数まで入れられるようにしておく
+	const size_t maxVertices = static_cast<size_t>(SpriteMeshOptions().maxVertices);
+	vertexBuffer = CreateDynamicVertexBuffer(device, maxVertices, "PlayerObject");
+	indexBuffer = CreateDynamicIndexBuffer(device, (maxVertices - 2) * 3, "PlayerObject");
 	indexCount = 6;
 
 	const UINT indices[] = { 0,1,2,  0,2,3 };
@@ -120,10 +169,10 @@ void PlayerObject::InitVertexData(ID3D11Device* device, ID3D11DeviceContext* con
 
 
 float PlayerObject::GetPosX() const {
-	return modelMatrix.r[3].m128_f32[0];
+	return translationMatrix.r[3].m128_f32[0];
 }
 float PlayerObject::GetPosY() const {
-	return modelMatrix.r[3].m128_f32[1];
+	return translationMatrix.r[3].m128_f32[1];
 }
 
 float PlayerObject::GetW() const {
@@ -141,27 +190,39 @@ void PlayerObject::SetFlip(bool flip) {
 	isFlipX = flip;
 }
 
-void PlayerObject::SetFrameIndex(int idx) { frameIndex = idx; }
+void PlayerObject::SetFrameIndex(int idx) { animInstance.frameIndex = idx; }
 
 void PlayerObject::ResetAnimationTimer() {
-	animationTimer = 0.0f;
+	animInstance.stateTime = 0.0f;
 }
 
-void PlayerObject::SetAnimationData(PlayerAnimationIndex index) {
+void PlayerObject::SetAnimParam(int param, float value) {
+	if (param >= 0 && param < kMaxAnimParams) animInstance.params[param] = value;
+}
 
-	totalFrames = animationData[static_cast<size_t>(index)].totalFrames;
-	columns = animationData[static_cast<size_t>(index)].columns;
-	rows = animationData[static_cast<size_t>(index)].rows;
-	fps = animationData[static_cast<size_t>(index)].fps;
+int PlayerObject::FindAnimParam(const char* name) const {
+	return animGraph ? animGraph->FindParam(name) : -1;
+}
 
-	if (!this->isAnimated) {
-		texOffset[0] = 0.0f;
-		texOffset[1] = 0.0f;
-		texScale[0] = 1.0f;
-		texScale[1] = 1.0f;
-	}
+const AnimGraphInstance& PlayerObject::GetAnimInstance() const {
+	return animInstance;
+}
 
+const CollisionMask* PlayerObject::GetCollisionMask() const {
+	if (!animGraph) return nullptr;
+	const std::vector<CollisionMask>& masks = clipMasks[animGraph->states[animInstance.state].clip];
+	if (animInstance.frameIndex < 0 || animInstance.frameIndex >= static_cast<int>(masks.size())) return nullptr;
+	return &masks[animInstance.frameIndex];
+}
 
+float PlayerObject::GetMaskScaleX() const {
+	const CollisionMask* mask = GetCollisionMask();
+	return mask && mask->width > 0 ? objW / static_cast<float>(mask->width) : 1.0f;
+}
+
+float PlayerObject::GetMaskScaleY() const {
+	const CollisionMask* mask = GetCollisionMask();
+	return mask && mask->height > 0 ? objH / static_cast<float>(mask->height) : 1.0f;
 }
 
 float PlayerObject::GetSpeed() const {
@@ -174,38 +235,34 @@ void PlayerObject::SetSpeed(float speed_new) {
 
 
 void PlayerObject::Update(float deltaTime) {
-	if (!this->isAnimated || this->animationFinished) return;
-
-	animationTimer += deltaTime;
-	if (animationTimer >= (1.0f / fps)) {
-		animationTimer = 0.0f;
-
-        if (this->isLooping) {
-            frameIndex = (frameIndex + 1) % totalFrames;
-        }
-        else {
-            if (frameIndex == totalFrames - 1) {
-                animationFinished = true;
-            }
-            else {
-                frameIndex++;
-            }
-        }
-	}
+	PROFILE_ZONE("PlayerObject::Update");
+	if (!this->isAnimated) return;
 
-	float frameW = 1.0f / static_cast<float>(columns);
-	float frameH = 1.0f / static_cast<float>(rows);
-	int col = frameIndex % columns;
-	int row = frameIndex / columns;
+	// ステートの遷移とフレーム送りはグラフ側で行う
+	EvaluateAnimGraph(*animGraph, &animInstance, 1, deltaTime);
 
-	texOffset[0] = static_cast<float>(col) * frameW;
-	texOffset[1] = static_cast<float>(row) * frameH;
-	texScale[0] = frameW;
-	texScale[1] = frameH;
+	GetFrameUV(animGraph->states[animInstance.state].clip, animInstance.frameIndex, texOffset, texScale);
+}
+
+void PlayerObject::GetFrameUV(size_t clip, int frameIndex, float offset[2], float scale[2]) const {
+	GetAnimFrameUV(animGraph->clips[clip], frameIndex, offset, scale);
+	const DirectX::XMFLOAT2& gutter = clipGutters[clip];
+	offset[0] += gutter.x;
+	offset[1] += gutter.y;
+	scale[0] -= gutter.x * 2.0f;
+	scale[1] -= gutter.y * 2.0f;
 }
 
 void PlayerObject::UpdateConstantBuffer(ID3D11DeviceContext* context,
 	const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection) {
+	PROFILE_ZONE("PlayerObject::UpdateConstantBuffer");
+
+	WriteConstantBuffer(context, view, projection, texOffset, texScale, 1.0f);
+}
+
+void PlayerObject::WriteConstantBuffer(ID3D11DeviceContext* context,
+	const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection,
+	const float offset[2], const float scale[2], float alpha) {
 
 	D3D11_MAPPED_SUBRESOURCE mappedResource;
 
@@ -216,21 +273,23 @@ void PlayerObject::UpdateConstantBuffer(ID3D11DeviceContext* context,
 		cb->model = DirectX::XMMatrixTranspose(modelMatrix);
 		cb->view = DirectX::XMMatrixTranspose(view);
 		cb->projection = DirectX::XMMatrixTranspose(projection);
-		cb->texOffset[0] = texOffset[0];
-		cb->texOffset[1] = texOffset[1];
-		cb->texScale[0] = texScale[0];
-		cb->texScale[1] = texScale[1];
+		cb->texOffset[0] = offset[0];
+		cb->texOffset[1] = offset[1];
+		cb->texScale[0] = scale[0];
+		cb->texScale[1] = scale[1];
 		cb->uFlipX = isFlipX ? 1 : 0;
+		cb->alpha = alpha;
 		context->Unmap(constantBuffer, 0);
 	}
 }
 
 void PlayerObject::Render(ID3D11DeviceContext* context, const DirectX::XMMATRIX& view,
 	const DirectX::XMMATRIX& projection) {
+	PROFILE_ZONE("PlayerObject::Render");
 
-	UpdateConstantBuffer(context, view, projection);
+	// 向きは反転フラグだけで表現する（ステートごとの分岐は不要）
+	SetFlip(direction == PlayerDirection::Left);
 
-	
 	// 
 	UINT stride = sizeof(Vertex);
 	// 
@@ -241,39 +300,69 @@ void PlayerObject::Render(ID3D11DeviceContext* context, const DirectX::XMMATRIX&
 	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
 	// 
 	context->VSSetConstantBuffers(0, 1, &constantBuffer);
+	context->PSSetConstantBuffers(0, 1, &constantBuffer);
+
+	float weight = isAnimated ? GetAnimBlendWeight(animInstance) : 1.0f;
+
+	// クロスフェード中は前のステートのクリップを先に描く
+	if (weight < 1.0f) {
+		size_t prevClip = animGraph->states[animInstance.prevState].clip;
+		float prevOffset[2], prevScale[2];
+		GetFrameUV(prevClip, animInstance.prevFrameIndex, prevOffset, prevScale);
+
+		WriteConstantBuffer(context, view, projection, prevOffset, prevScale, 1.0f - weight);
+		ID3D11ShaderResourceView* prevSrv = UseClipTexture(prevClip);
+		context->PSSetShaderResources(0, 1, &prevSrv);
+		ResourceTouch(prevSrv);
+		if (isAnimated) WriteFrameMesh(context, prevClip, animInstance.prevFrameIndex);
+		if (indexCount > 0) context->DrawIndexed(indexCount, 0, 0);
+	}
+
+	size_t clip = isAnimated ? animGraph->states[animInstance.state].clip : 0;
+	WriteConstantBuffer(context, view, projection, texOffset, texScale, weight);
+	ID3D11ShaderResourceView* srv = UseClipTexture(clip);
+	context->PSSetShaderResources(0, 1, &srv);
+	ResourceTouch(srv);
+	if (isAnimated) WriteFrameMesh(context, clip, animInstance.frameIndex);
 	//
-	
-	if (state == PlayerAnimationState::Idle) {
-		if (direction == PlayerDirection::Left) {
-            SetFlip(true);
-			context->PSSetShaderResources(0, 1, &textureSrvs[static_cast<size_t>(PlayerAnimationIndex::Idle)]);
-		}
-		else if (direction == PlayerDirection::Right) {
-            SetFlip(false);
-			context->PSSetShaderResources(0, 1, &textureSrvs[static_cast<size_t>(PlayerAnimationIndex::Idle)]);
-		}
+	if (indexCount > 0) context->DrawIndexed(indexCount, 0, 0);
+}
 
+ID3D11ShaderResourceView* PlayerObject::UseClipTexture(size_t clip) {
+	return textures ? textures->Use(textureIds[clip]) : textureSrvs[clip];
+}
+
+void PlayerObject::WriteFrameMesh(ID3D11DeviceContext* context, size_t clip, int frameIndex) {
+	const std::vector<SpriteMesh>& meshes = clipMeshes[clip];
+	bool hasMesh = frameIndex >= 0 && static_cast<size_t>(frameIndex) < meshes.size();
+	const SpriteMesh& mesh = hasMesh ? meshes[static_cast<size_t>(frameIndex)] : kRectMesh;
+
+	// UV は 0..1 のまま（フレームへの変換と反転はシェーダーで）。反転するときは多角形も左右を入れ替える
+	SpriteQuad quad;
+	quad.pos[0] = { 0.0f, 0.0f };
+	quad.pos[1] = { objW, 0.0f };
+	quad.pos[2] = { objW, objH };
+	quad.pos[3] = { 0.0f, objH };
+	quad.uv[0] = { 0.0f, 0.0f };
+	quad.uv[1] = { 1.0f, 0.0f };
+	quad.uv[2] = { 1.0f, 1.0f };
+	quad.uv[3] = { 0.0f, 1.0f };
+	quad.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	quad.depth = 0.0f;
+
+	meshVertices.clear();
+	meshIndices.clear();
+	AppendSpriteMeshVertices(mesh, quad, isFlipX, &meshVertices, &meshIndices);
+	indexCount = static_cast<UINT>(meshIndices.size());
+	if (indexCount == 0) return;
+
+	D3D11_MAPPED_SUBRESOURCE m{};
+	if (SUCCEEDED(context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) {
+		memcpy(m.pData, meshVertices.data(), meshVertices.size() * sizeof(Vertex));
+		context->Unmap(vertexBuffer, 0);
 	}
-	else if (state == PlayerAnimationState::Run) {
-		if (direction == PlayerDirection::Left) {
-            SetFlip(true);
-			context->PSSetShaderResources(0, 1, &textureSrvs[static_cast<size_t>(PlayerAnimationIndex::Run)]);
-		}
-		else if (direction == PlayerDirection::Right) {
-            SetFlip(false);
-			context->PSSetShaderResources(0, 1, &textureSrvs[static_cast<size_t>(PlayerAnimationIndex::Run)]);
-		}
-	}
-	else if (state == PlayerAnimationState::Jump) {
-		if (direction == PlayerDirection::Left) {
-            SetFlip(true);
-			context->PSSetShaderResources(0, 1, &textureSrvs[static_cast<size_t>(PlayerAnimationIndex::Jump)]);
-		}
-		else if (direction == PlayerDirection::Right) {
-            SetFlip(false);
-			context->PSSetShaderResources(0, 1, &textureSrvs[static_cast<size_t>(PlayerAnimationIndex::Jump)]);
-		}
+	if (SUCCEEDED(context->Map(indexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) {
+		memcpy(m.pData, meshIndices.data(), meshIndices.size() * sizeof(uint32_t));
+		context->Unmap(indexBuffer, 0);
 	}
-	//
-	context->DrawIndexed(indexCount, 0, 0);
 }
@@ -12,24 +12,20 @@
 #include "Vertex.h"
 #include "ConstantBuffer.h"
 #include "AnimationData.h"
+#include "AnimationGraph.h"
+#include "CollisionMask.h"
+#include "SpriteMesh.h"
+#include "ResourceRegistry.h"
 #include <vector>
 #include "d3dApp.h"
 
-enum class PlayerAnimationState {
-    Idle,
-    Run,
-    Jump
-};
+class JobSystem;
+class TextureStreamer;
+
 enum class PlayerDirection {
     Left,
     Right
 };
-enum class PlayerAnimationIndex {
-    Idle = 0,
-    Run,
-    Jump,
-    Count
-};
 
 class PlayerObject {
 public:
@@ -41,8 +37,10 @@ public:
 		ID3D11DeviceContext* context,
 		float width,
 		float height,
-		std::vector<AnimationData>& animationData,
-		bool isAnimated
+		const AnimGraph* animGraph,
+		bool isAnimated,
+		JobSystem* jobs = nullptr,     // あればクリップのシートの前処理を並列にする
+		TextureStreamer* textures = nullptr    // あればシートを預け、使っていないクリップは予算に合わせて追い出す
 	);
 
 	void Update(float deltaTime);
@@ -71,17 +69,31 @@ public:
 
 	void ResetAnimationTimer();
 
-	void SetAnimationData(PlayerAnimationIndex index);
+	void SetAnimParam(int param, float value);
+	int FindAnimParam(const char* name) const;
+	const AnimGraphInstance& GetAnimInstance() const;
+
+	// 今表示しているフレームの当たりマスクと、その 1 ピクセルの画面上の幅と高さ（絵の縦横比はフレームと違うことがある）
+	const CollisionMask* GetCollisionMask() const;
+	float GetMaskScaleX() const;
+	float GetMaskScaleY() const;
 
 	float GetSpeed() const;
 	void SetSpeed(float speed_new);
 	bool isAnimated = false;
 	
-	PlayerAnimationState state = PlayerAnimationState::Idle;
 	PlayerDirection direction = PlayerDirection::Right;
 
 private:
 	void InitVertexData(ID3D11Device* device, ID3D11DeviceContext* context, float width, float height);
+	void WriteFrameMesh(ID3D11DeviceContext* context, size_t clip, int frameIndex);
+	// GetAnimFrameUV に、読み込み時に足したフレームの余白を反映したもの
+	void GetFrameUV(size_t clip, int frameIndex, float offset[2], float scale[2]) const;
+	// 描く直前に受け取る（預けたときは追い出されていれば読み直す）
+	ID3D11ShaderResourceView* UseClipTexture(size_t clip);
+	void WriteConstantBuffer(ID3D11DeviceContext* context,
+		const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection,
+		const float offset[2], const float scale[2], float alpha);
 
 	ID3D11Buffer* vertexBuffer;
 	ID3D11Buffer* indexBuffer;
@@ -89,23 +101,23 @@ private:
 	
 	float texOffset[2] = { 0.0f, 0.0f };
 	float texScale[2] = { 1.0f, 1.0f };
-	float fps = 8.0f;
-	float animationTimer;
-	int frameIndex;
-	int totalFrames = 1;
-	int columns = 1;
-	int rows = 1;
 	float speed = 0.0f;
 	float objW = 0.0f;
 	float objH = 0.0f;
 	bool isFlipX = false;
-    bool isLooping = true; 
-    bool animationFinished = false;
-
-
-	std::vector<AnimationData> animationData;
 
-	std::vector<ID3D11ShaderResourceView*> textureSrvs;
+	const AnimGraph* animGraph = nullptr;
+	AnimGraphInstance animInstance;
+
+	std::vector<ID3D11ShaderResourceView*> textureSrvs;     // textures に預けたときは空
+	TextureStreamer* textures = nullptr;
+	std::vector<int> textureIds;                            // textures の番号。clips と同じ並び
+	std::vector<DirectX::XMFLOAT2> clipGutters;            // シートごとのフレームの余白（UV）
+	std::vector<std::vector<CollisionMask>> clipMasks;     // clips と同じ並び、フレームごと
+	TrackedMemory clipMaskMemory{ MemoryTag::Collision };
+	std::vector<std::vector<SpriteMesh>> clipMeshes;       // 絵のある部分だけを囲む多角形。clipMasks と同じ並び
+	std::vector<Vertex> meshVertices;
+	std::vector<uint32_t> meshIndices;
 
 	UINT indexCount;
 
@@ -0,0 +1,159 @@
+﻿/**********************************************************************************
+    Profiler.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/01
+
+**********************************************************************************/
+
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct ProfileEvent {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    const size_t kRingSize = 1 << 16;      // スレッドごと。古いものから上書き
+
+    struct ThreadRing {
+        ProfileEvent events[kRingSize];
+        std::atomic<uint64_t> head{ 0 };
+        std::atomic<bool> inUse{ true };
+        std::string name;
+        uint32_t id = 0;
+    };
+
+    // リングはスレッドが終わっても残し（記録を書き出せるように）、次に来たスレッドが使い回す
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+    thread_local ThreadRing* localRing = nullptr;
+
+    struct RingRelease {
+        ~RingRelease() {
+            if (localRing) localRing->inUse.store(false);
+        }
+    };
+    thread_local RingRelease ringRelease;
+
+    volatile uint64_t timestampSink = 0;      // ProfilerMeasureOverhead のループを消されないように
+
+    // タイムスタンプを時間に直すための起点
+    const uint64_t startTicks = ProfilerTimestamp();
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    ThreadRing* AcquireRing() {
+        (void)&ringRelease;     // thread_local のデストラクタを登録させる
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        for (auto& ring : rings) {
+            bool expected = false;
+            if (ring->inUse.compare_exchange_strong(expected, true)) {
+                ring->name.clear();
+                localRing = ring.get();
+                return localRing;
+            }
+        }
+        rings.push_back(std::make_unique<ThreadRing>());
+        rings.back()->id = static_cast<uint32_t>(rings.size());
+        localRing = rings.back().get();
+        return localRing;
+    }
+
+    void WriteEscaped(std::ofstream& file, const char* text) {
+        for (const char* p = text; *p; p++) {
+            if (*p == '"' || *p == '\\') file << '\\';
+            file << *p;
+        }
+    }
+}
+
+
+void ProfilerRecord(const char* name, uint64_t begin, uint64_t end) {
+    ThreadRing* ring = localRing ? localRing : AcquireRing();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head & (kRingSize - 1)] = { name, begin, end };
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void ProfilerSetThreadName(const char* name) {
+    ThreadRing* ring = localRing ? localRing : AcquireRing();
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    ring->name = name;
+}
+
+bool ProfilerWriteChromeTrace(const wchar_t* path) {
+    std::ofstream file{ std::filesystem::path(path) };
+    if (!file) return false;
+
+    // 起点からの経過で 1 カウントあたりのマイクロ秒を求める
+    uint64_t nowTicks = ProfilerTimestamp();
+    double elapsedUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+    double usPerTick = nowTicks > startTicks ? elapsedUs / static_cast<double>(nowTicks - startTicks) : 0.001;
+
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& ring : rings) {
+        if (!ring->name.empty()) {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id
+                << ",\"args\":{\"name\":\"";
+            WriteEscaped(file, ring->name.c_str());
+            file << "\"}}";
+            first = false;
+        }
+
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t count = head < kRingSize ? head : kRingSize;
+        for (uint64_t i = head - count; i < head; i++) {
+            const ProfileEvent& e = ring->events[i & (kRingSize - 1)];
+            if (e.begin < startTicks || e.end < e.begin) continue;
+            file << (first ? "" : ",\n") << "{\"name\":\"";
+            WriteEscaped(file, e.name);
+            file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->id
+                << ",\"ts\":" << static_cast<double>(e.begin - startTicks) * usPerTick
+                << ",\"dur\":" << static_cast<double>(e.end - e.begin) * usPerTick << "}";
+            first = false;
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(file);
+}
+
+void ProfilerClear() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (auto& ring : rings) ring->head.store(0, std::memory_order_release);
+}
+
+double ProfilerMeasureOverhead(int iterations, double* timestampNs) {
+    const double count = static_cast<double>(iterations > 0 ? iterations : 1);
+    if (timestampNs) {
+        uint64_t sum = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) sum += ProfilerTimestamp();
+        auto t1 = std::chrono::steady_clock::now();
+        timestampSink = sum;
+        *timestampNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+    }
+
+    // 測定で呼び出しスレッドのリングは埋まるので、終わったら空にする
+    ThreadRing* ring = localRing ? localRing : AcquireRing();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        ProfileScope zone("ProfilerOverhead");
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    ring->head.store(0, std::memory_order_release);
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / count;
+}
@@ -0,0 +1,93 @@
+﻿/**********************************************************************************
+    Profiler.h
+
+                                                                LI WENHUI
+                                                                2025/09/01
+
+**********************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+
+// 出荷ビルドでは GAME_SHIPPING を定義してゾーンごと消す
+#ifndef GAME_SHIPPING
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_USE_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_USE_RDTSC 1
+#else
+#include <chrono>
+#define PROFILER_USE_RDTSC 0
+#endif
+
+// 単位は rdtsc のカウント（なければ steady_clock のナノ秒）。書き出すときにマイクロ秒へ直す
+inline uint64_t ProfilerTimestamp() {
+#if PROFILER_USE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// 終わったゾーンを呼び出しスレッドのリングに 1 件書く。name は文字列リテラルなど寿命の長いもの
+void ProfilerRecord(const char* name, uint64_t begin, uint64_t end);
+
+// トレースに出すスレッド名（各スレッドの最初に一度）
+void ProfilerSetThreadName(const char* name);
+
+// 全スレッドのリングに残っている分を Chrome trace (Perfetto でも読める) の JSON で書き出す
+// 他のスレッドがゾーンを書いている最中だと、その数件は欠けることがある
+bool ProfilerWriteChromeTrace(const wchar_t* path);
+
+// 記録を捨てる
+void ProfilerClear();
+
+// ゾーン 1 つの出入りにかかる時間（ナノ秒）を測る。timestampNs には ProfilerTimestamp 1 回分を返す
+// ゾーンはタイムスタンプを 2 回取るので、その 2 回分が下限（仮想マシンでは rdtsc が遅いことがある）
+double ProfilerMeasureOverhead(int iterations, double* timestampNs = nullptr);
+
+//
+// スコープの間をゾーンとして記録する。入れ子はタイムスタンプの包含関係でそのまま階層になる
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(name)
+        , begin(ProfilerTimestamp())
+    {
+
+    }
+
+    ~ProfileScope() {
+        ProfilerRecord(name, begin, ProfilerTimestamp());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t begin;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone, __COUNTER__)(name)
+#define PROFILE_THREAD(name) ProfilerSetThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+
+#endif
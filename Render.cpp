@@ -9,18 +9,170 @@
 #include "Render.h"
 #include "PlayerObject.h"
 #include "StateInfo.h"
+#include "SpriteBatch.h"
+#include "SpritePass.h"
+#include "Skeleton2D.h"
+#include "ParticleSystem.h"
+#include "TileMap.h"
+#include "Lightmap2D.h"
+#include "FieldOfView.h"
+#include "LightingPass.h"
+#include "LayerCache.h"
+#include "LayerCachePass.h"
+#include "DynamicResolution.h"
+#include "TextRenderer.h"
+#include "TextureStreamer.h"
+#include "FramePacer.h"
+#include "FlowField.h"
+#include "CharacterController.h"
+#include "GameWorld.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+#include "ResourceRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
 
+namespace {
+    std::vector<SpriteQuad> skeletonQuads;
+    std::vector<SpriteQuad> particleQuads;
+    std::vector<SpriteQuad> tileQuads;
+    std::vector<SpriteQuad> chaserQuads;
+    SpritePassQueue spritePasses;
+
+    // 深度は 0 が手前、1 が奥。プレイヤー（頂点の z が 0）とライティングはいつも一番手前
+    const float kTileDepth = 0.9f;
+    const float kChaserDepth = 0.5f;
+
+    // パスの並びのまま SpriteBatch に流す。テクスチャが続く間は 1 回の描画にまとまる
+    void DrawSpritePass(StateInfo* pState, SpriteAlphaMode mode) {
+        const std::vector<SpritePassItem>& items = spritePasses.GetPass(mode);
+        if (items.empty()) return;
+
+        ID3D11BlendState* blendStates[] = {
+            pState->blendStateNormal,
+            pState->blendStateAdditive,
+            pState->blendStateScreen
+        };
+        const std::vector<SpriteQuad>& quads = spritePasses.GetQuads();
+        SpriteBatch* batch = pState->spriteBatch.get();
+        int blend = -1;
+        batch->Begin(pState->context, pState->view, pState->projection);
+        for (const SpritePassItem& item : items) {
+            // 半透明はブレンドが変わるところで流してステートを替える
+            if (mode == SpriteAlphaMode::Blended && item.blend != blend) {
+                batch->End();
+                blend = item.blend;
+                pState->context->OMSetBlendState(blendStates[blend], nullptr, 0xffffffff);
+                batch->Begin(pState->context, pState->view, pState->projection);
+            }
+            batch->Draw(static_cast<ID3D11ShaderResourceView*>(item.texture), &quads[item.quad], 1);
+        }
+        batch->End();
+    }
+
+    // タイルが変わったフレームだけ層のテクスチャに描き直す。ブレンドなしで、抜けは透明のまま残る
+    void UpdateTileLayer(StateInfo* pState) {
+        LayerCache* cache = pState->layerCache.get();
+        cache->SetRevision(pState->tileLayer, pState->world->tileMap->GetRevision());
+        if (cache->Prepare(pState->tileLayer, 0.0f, 0.0f) != LayerCacheResult::Redraw) return;
+
+        PROFILE_ZONE("Redraw Tile Layer");
+        tileQuads.clear();
+        pState->world->tileMap->BuildQuads({ 0.22f, 0.2f, 0.24f, 1.0f }, 0.0f, &tileQuads);
+
+        DirectX::XMMATRIX projection;
+        pState->layerCachePass->BeginLayer(pState->context, *cache, pState->tileLayer, &projection);
+        pState->context->OMSetBlendState(pState->blendStateOpaque, nullptr, 0xffffffff);
+        pState->spriteBatch->Begin(pState->context, DirectX::XMMatrixIdentity(), projection);
+        pState->spriteBatch->Draw(nullptr, tileQuads.data(), tileQuads.size());
+        pState->spriteBatch->End();
+        pState->layerCachePass->EndLayer(pState->context);
+    }
+
+    // スコアと距離、F3 でフレームの統計。文字列が変わらなければ並べ直しもしない
+    void DrawTextOverlay(StateInfo* pState) {
+        PROFILE_ZONE("Text Overlay");
+        TextRenderer* text = pState->text.get();
+        char line[256];
+
+        // 論理座標 100 を 1 m とし、1 m で 10 点
+        float meters = pState->distanceTravelled * 0.01f;
+        int seconds = static_cast<int>(pState->playTime);
+        std::snprintf(line, sizeof(line), "%.0f m   %d:%02d", meters, seconds / 60, seconds % 60);
+        text->DrawString(pState->hudFont, line, 32.0f, 24.0f, { 1.0f, 1.0f, 1.0f, 1.0f });
+        std::snprintf(line, sizeof(line), "SCORE %d", static_cast<int>(meters * 10.0f));
+        text->DrawString(pState->hudFont, line, pState->logicalWidth - 32.0f, 24.0f, { 1.0f, 0.85f, 0.3f, 1.0f },
+            0.0f, TextAlign::Right);
+
+        if (!pState->showDebugOverlay) return;
+
+        // 数字の幅がそろう等幅で、行ごとに別の文字列にしておく（変わった行だけ並べ直しになる）
+        const DirectX::XMFLOAT4 color = { 0.85f, 1.0f, 0.85f, 1.0f };
+        const float lineHeight = text->GetLineHeight(pState->debugFont);
+        float y = 96.0f;
+        auto emit = [&]() {
+            text->DrawString(pState->debugFont, line, 32.0f, y, color);
+            y += lineHeight;
+        };
+
+        if (pState->telemetry) {
+            FrameMetricStats frame = pState->telemetry->GetStats(FrameMetric::Frame);
+            FrameMetricStats update = pState->telemetry->GetStats(FrameMetric::Update);
+            FrameMetricStats submit = pState->telemetry->GetStats(FrameMetric::RenderSubmit);
+            FrameMetricStats gpu = pState->telemetry->GetStats(FrameMetric::GpuScene);
+            std::snprintf(line, sizeof(line), "fps    %6.1f  frame p50 %6.2f  p99 %6.2f  max %6.2f ms",
+                frame.p50 > 0.0f ? 1000.0f / frame.p50 : 0.0f, frame.p50, frame.p99, frame.max);
+            emit();
+            std::snprintf(line, sizeof(line), "cpu    update p99 %6.2f  submit p99 %6.2f ms", update.p99, submit.p99);
+            emit();
+            std::snprintf(line, sizeof(line), "gpu    scene p50 %6.2f  p99 %6.2f ms", gpu.p50, gpu.p99);
+            emit();
+        }
+        std::snprintf(line, sizeof(line), "scale  %4.2f  changes %u", pState->dynamicResolution->GetScale(),
+            pState->dynamicResolution->GetScaler().GetChangeCount());
+        emit();
+        if (pState->pacer) {
+            std::snprintf(line, sizeof(line), "pacer  %6.2f ms  missed %llu  input %5.1f ms", pState->pacer->GetTargetMs(),
+                static_cast<unsigned long long>(pState->pacer->GetMissedCount()), pState->inputLatencyMs);
+            emit();
+        }
+        LayerCacheStats layers = pState->layerCache->GetTotalStats();
+        std::snprintf(line, sizeof(line), "layers hit %5.1f%%  redraws %llu", layers.GetHitRate() * 100.0,
+            static_cast<unsigned long long>(layers.redraws));
+        emit();
+        GlyphCacheStats glyphs = text->GetCache().GetStats();
+        std::snprintf(line, sizeof(line), "glyphs %zu  rasterized %llu  evicted %llu  layouts %zu",
+            glyphs.cachedGlyphs, static_cast<unsigned long long>(glyphs.rasterized),
+            static_cast<unsigned long long>(glyphs.evicted), glyphs.cachedLayouts);
+        emit();
+        ResourceUsage gpuMemory = ResourceGetUsage(ResourcePool::Gpu);
+        ResourceUsage cpuMemory = ResourceGetUsage(ResourcePool::Cpu);
+        std::snprintf(line, sizeof(line), "memory gpu %6.1f MB (%zu)  cpu %6.1f MB",
+            static_cast<double>(gpuMemory.used) / (1024.0 * 1024.0), gpuMemory.count,
+            static_cast<double>(cpuMemory.used) / (1024.0 * 1024.0));
+        emit();
+        const TextureResidencyStats& residency = pState->textures->GetResidency().GetStats();
+        std::snprintf(line, sizeof(line), "texres %6.1f MB (%zu)  peak %6.1f MB  miss %llu  prefetch %llu  evict %llu  down %llu",
+            static_cast<double>(residency.residentBytes) / (1024.0 * 1024.0), residency.residentCount,
+            static_cast<double>(residency.peakBytes) / (1024.0 * 1024.0), static_cast<unsigned long long>(residency.demandMisses),
+            static_cast<unsigned long long>(residency.prefetches), static_cast<unsigned long long>(residency.evictions),
+            static_cast<unsigned long long>(residency.downgrades));
+        emit();
+    }
+}
 
 
 void Render(HWND hwnd, StateInfo* pState) {
+    PROFILE_ZONE("Render");
+    auto submitStart = std::chrono::steady_clock::now();
  
 
-    // レンダーターゲットビューと深度/ステンシルビューをバインド
-    pState->context->OMSetRenderTargets(1, &pState->rtv, pState->depthStencilView);
-
-    // 背景色をクリア
+    // シーンのテクスチャと深度/ステンシルビューをバインドし、背景色をクリア
+    // ビューポートは描画解像度の倍率分だけ（最後に Upscale でバックバッファへ引き伸ばす）
     float clearColor[4] = { 1.0f, 1.0f, 0.88f, 1.0f };
-    pState->context->ClearRenderTargetView(pState->rtv, clearColor);
+    pState->dynamicResolution->BeginScene(pState->context, pState->depthStencilView, clearColor);
+    pState->text->BeginFrame();
 
     // 深度とステンシルバッファをクリア。1.0fは深度のデフォルトで最遠の値。
     pState->context->ClearDepthStencilView(pState->depthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
@@ -44,6 +196,83 @@ void Render(HWND hwnd, StateInfo* pState) {
     // GPUに頂点をどのようにプリミティブ（図形）として描画するかを伝える。プリミティブタイプは三角形リスト（D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST）
     pState->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
+    // PSSetSamplers(開始スロット, サンプラー数, サンプラー配列ポインタ)
+    // s0レジスタはスロット0に対応
+    pState->context->PSSetSamplers(0, 1, &pState->samplerState);
+
+    // 画面外のテクスチャへの描き直し（描き先は終わったらバックバッファに戻る）
+    UpdateTileLayer(pState);
+
+    // スプライトは先に全部集めて、不透明・アルファテスト・半透明のパスに分ける
+    spritePasses.Clear();
+
+    // タイル（今は白テクスチャの塗りつぶし）は、キャッシュした層を画面 1 枚の四角形で貼る
+    // タイルのない所は透明なので、アルファテストで抜いて深度も書かない
+    SpriteQuad tileLayer;
+    pState->layerCache->BuildCompositeQuad(pState->tileLayer, 0.0f, 0.0f, kTileDepth, &tileLayer);
+    spritePasses.Add(pState->layerCachePass->GetSrv(pState->tileLayer), SpriteAlphaMode::AlphaTested, 0, &tileLayer, 1);
+
+    // 追跡者（まだ絵がないので当たり判定の箱をそのまま塗る）
+    if (!pState->world->chasers.empty()) {
+        chaserQuads.clear();
+        for (const ChaseAgent& chaser : pState->world->chasers) {
+            Aabb box = pState->world->characters->GetBounds(chaser.body);
+            SpriteQuad q;
+            q.pos[0] = { box.minX, box.minY };
+            q.pos[1] = { box.maxX, box.minY };
+            q.pos[2] = { box.maxX, box.maxY };
+            q.pos[3] = { box.minX, box.maxY };
+            q.uv[0] = { 0.0f, 0.0f };
+            q.uv[1] = { 1.0f, 0.0f };
+            q.uv[2] = { 1.0f, 1.0f };
+            q.uv[3] = { 0.0f, 1.0f };
+            q.color = chaser.touchingPlayer ? DirectX::XMFLOAT4{ 1.0f, 0.85f, 0.3f, 1.0f } : DirectX::XMFLOAT4{ 0.75f, 0.18f, 0.2f, 1.0f };
+            q.depth = kChaserDepth;
+            chaserQuads.push_back(q);
+        }
+        spritePasses.Add(nullptr, SpriteAlphaMode::Opaque, 0, chaserQuads.data(), chaserQuads.size());
+    }
+
+    // スケルトンはアトラスごとにまとまるので、同じ種類が続けば 1 回の描画で済む
+    // 画面の外と、プレイヤーから見えない所にいるものは積まない（アトラスを使ったことにならないので、離れれば追い出される）
+    const Aabb cameraRect = { 0.0f, 0.0f, pState->logicalWidth, pState->logicalHeight };
+    const FovResult& playerView = pState->viewers[static_cast<size_t>(pState->playerViewer)].result;
+    const float tileSize = pState->world->tileMap->GetTileSize();
+    for (const SkeletonInstance& skeleton : pState->skeletons) {
+        skeletonQuads.clear();
+        if (BuildSkeletonQuads(skeleton, &skeletonQuads) == 0) continue;
+        Aabb bounds = GetSpriteQuadBounds(skeletonQuads.data(), skeletonQuads.size());
+        if (!AabbOverlap(bounds, cameraRect) || !playerView.IsAreaVisible(bounds, tileSize)) continue;
+        if (skeleton.data->atlasTexture >= 0) {
+            // 描画キューに積むときに使ったことにする（追い出されていればここで読み直す）
+            ID3D11ShaderResourceView* atlas = pState->textures->Use(skeleton.data->atlasTexture);
+            spritePasses.Add(atlas, pState->textures->GetAlphaMode(skeleton.data->atlasTexture), 0, skeletonQuads.data(), skeletonQuads.size());
+        }
+        else {
+            spritePasses.Add(skeleton.data->atlasSrv, skeleton.data->atlasAlphaMode, 0, skeletonQuads.data(), skeletonQuads.size());
+        }
+    }
+
+    // パーティクルは白テクスチャ＋頂点カラーで、いつも半透明
+    if (pState->particles && pState->particles->GetAliveCount() > 0) {
+        for (size_t b = 0; b < static_cast<size_t>(ParticleBlend::Count); b++) {
+            particleQuads.clear();
+            if (pState->particles->BuildQuads(static_cast<ParticleBlend>(b), &particleQuads) == 0) continue;
+            spritePasses.Add(nullptr, SpriteAlphaMode::Blended, static_cast<uint8_t>(b), particleQuads.data(), particleQuads.size());
+        }
+    }
+    spritePasses.Sort();
+
+    // 不透明：ブレンドなしで手前から描き、深度を書く。奥で隠れるピクセルは early-Z で捨てられる
+    pState->context->OMSetBlendState(pState->blendStateOpaque, nullptr, 0xffffffff);
+    pState->context->OMSetDepthStencilState(pState->depthStencilStateOpaque, 0);
+    DrawSpritePass(pState, SpriteAlphaMode::Opaque);
+
+    // アルファテスト：不透明のあとに描いて、隠れている分は同じく early-Z で捨てる
+    pState->context->PSSetShader(pState->pixelShaderAlphaTest, nullptr, 0);
+    DrawSpritePass(pState, SpriteAlphaMode::AlphaTested);
+    pState->context->PSSetShader(pState->pixelShader, nullptr, 0);
+
     // --- ブレンドステートをバインド ---
     // 2番目のパラメータは定数配列。ブレンド記述でD3D11_BLEND_BLEND_FACTORやD3D11_BLEND_INV_BLEND_FACTORを使う場合に利用。
     // 通常、アルファブレンドの場合はnullptrか全て1の配列でOK。
@@ -54,18 +283,61 @@ void Render(HWND hwnd, StateInfo* pState) {
     // 2番目（StencilRef）はここでは重要でないので0でOK。
     pState->context->OMSetDepthStencilState(pState->depthStencilStateTransparent, 0);
 
-    // PSSetSamplers(開始スロット, サンプラー数, サンプラー配列ポインタ)
-    // s0レジスタはスロット0に対応
-    pState->context->PSSetSamplers(0, 1, &pState->samplerState);
-
+    // 半透明：深度は読むだけで、奥から手前へ重ねる
     pState->player->Render(pState->context, pState->view, pState->projection);
+    DrawSpritePass(pState, SpriteAlphaMode::Blended);
+    pState->context->OMSetBlendState(pState->blendStateNormal, nullptr, 0xffffffff);
+
+    // ライティング：タイルの遮蔽物はタイルが変わったときだけ集め直し、プレイヤーと追跡者の箱は毎フレーム後ろに足す
+    // （どれも動かなければ Build は前回の結果をそのまま使う）
+    if (pState->occluderRevision != pState->world->tileMap->GetRevision()) {
+        pState->occluders.clear();
+        pState->world->tileMap->CollectOccluders({ 0.0f, 0.0f, pState->logicalWidth, pState->logicalHeight }, &pState->occluders);
+        pState->tileOccluderCount = pState->occluders.size();
+        pState->occluderRevision = pState->world->tileMap->GetRevision();
+    }
+    pState->occluders.resize(pState->tileOccluderCount);
+    const CharacterController* characters = pState->world->characters.get();
+    pState->occluders.push_back(characters->GetBounds(pState->world->playerBody));
+    for (const ChaseAgent& chaser : pState->world->chasers) pState->occluders.push_back(characters->GetBounds(chaser.body));
+    pState->lightmap->Build(pState->lights.data(), pState->lights.size(),
+        pState->occluders.data(), pState->occluders.size(), pState->jobs.get());
+    pState->lightmap->ApplyVisibility(pState->viewers[static_cast<size_t>(pState->playerViewer)].result,
+        pState->world->tileMap->GetTileSize(), pState->jobs.get());
+    pState->lightingPass->Upload(pState->context, *pState->lightmap);
+    pState->lightingPass->Composite(pState->context, pState->spriteBatch.get(),
+        pState->view, pState->projection, pState->blendStateMultiply, pState->samplerState,
+        pState->logicalWidth, pState->logicalHeight);
+    pState->context->OMSetBlendState(pState->blendStateNormal, nullptr, 0xffffffff);
 
     //for (auto& obj : pState->sceneObjects)
     //{
     //    obj->Render(pState->context, pState->view, pState->projection);
     //}
 
+    // 描いた範囲をバックバッファ全体に引き伸ばす
+    pState->dynamicResolution->Upscale(pState->context, pState->rtv, pState->spriteBatch.get(), pState->projection,
+        pState->blendStateOpaque, pState->samplerState, pState->logicalWidth, pState->logicalHeight);
+    pState->context->OMSetBlendState(pState->blendStateNormal, nullptr, 0xffffffff);
+
+    // 文字は引き伸ばした後にバックバッファの解像度で描く。全部の文字列で 1 回の描画
+    DrawTextOverlay(pState);
+    pState->text->Flush(pState->context, pState->spriteBatch.get(), DirectX::XMMatrixIdentity(), pState->projection);
+
     //// バックバッファ（描画が終わったバッファ）とフロントバッファ（画面に表示されているバッファ）を交換
-    pState->swapChain->Present(1, 0);
+    auto presentStart = std::chrono::steady_clock::now();
+    {
+        PROFILE_ZONE("Present");
+        HRESULT hr = pState->swapChain->Present(pState->presentInterval, 0);
+        pState->presentOccluded = hr == DXGI_STATUS_OCCLUDED;
+    }
+    float gpuMs = pState->dynamicResolution->EndFrame(pState->context);
+
+    if (pState->telemetry) {
+        auto presentEnd = std::chrono::steady_clock::now();
+        pState->telemetry->Record(FrameMetric::RenderSubmit, std::chrono::duration<float, std::milli>(presentStart - submitStart).count());
+        pState->telemetry->Record(FrameMetric::PresentWait, std::chrono::duration<float, std::milli>(presentEnd - presentStart).count());
+        if (gpuMs >= 0.0f) pState->telemetry->Record(FrameMetric::GpuScene, gpuMs);
+    }
 
 }
\ No newline at end of file
@@ -0,0 +1,198 @@
+﻿/**********************************************************************************
+    Replay.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/30
+
+**********************************************************************************/
+
+#include "Replay.h"
+#include "GameWorld.h"
+#include "Varint.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+    const uint8_t kMagic[4] = { 'R', 'P', 'L', 'Y' };
+    const uint32_t kVersion = 1;
+}
+
+
+void ReplayRecorder::Begin(const ReplayHeader& header) {
+    this->header = header;
+    this->header.tickCount = 0;
+    stream.clear();
+    idleTicks = 0;
+    held = 0;
+}
+
+void ReplayRecorder::RecordTick(const InputFrame& input) {
+    uint8_t diff = static_cast<uint8_t>(input.held ^ held);
+    if (diff == 0 && input.pressed == 0) {
+        idleTicks++;
+    }
+    else {
+        WriteVarint(&stream, idleTicks);
+        WriteVarint(&stream, static_cast<uint32_t>(diff) | (static_cast<uint32_t>(input.pressed) << 8));
+        idleTicks = 0;
+        held = input.held;
+    }
+    header.tickCount++;
+}
+
+uint32_t ReplayRecorder::GetRecordedTicks() const {
+    return header.tickCount;
+}
+
+void ReplayRecorder::Encode(uint64_t finalHash, std::vector<uint8_t>* out) const {
+    out->assign(kMagic, kMagic + 4);
+    WriteVarint(out, kVersion);
+    WriteVarint(out, header.seed);
+    uint32_t stepBits = 0;
+    std::memcpy(&stepBits, &header.fixedStep, sizeof(stepBits));
+    WriteVarint(out, stepBits);
+    WriteVarint(out, header.tickCount);
+    WriteU64(out, finalHash);
+    WriteVarint(out, header.assets.size());
+    for (const ReplayAsset& asset : header.assets) {
+        WriteVarint(out, asset.name.size());
+        out->insert(out->end(), asset.name.begin(), asset.name.end());
+        WriteU64(out, asset.hash);
+    }
+    // 最後の変化の後の idle な tick は tick 数からわかるので書かない
+    out->insert(out->end(), stream.begin(), stream.end());
+}
+
+bool ReplayRecorder::Save(const wchar_t* path, uint64_t finalHash, std::string* error) const {
+    std::vector<uint8_t> bytes;
+    Encode(finalHash, &bytes);
+    std::ofstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+
+bool ReplayPlayer::Decode(const uint8_t* data, size_t size, std::string* error) {
+    if (size < 4 || std::memcmp(data, kMagic, 4) != 0) {
+        if (error) *error = "not a replay file";
+        return false;
+    }
+    ByteReader reader{ data, size, 4 };
+    if (reader.Varint() != kVersion) {
+        if (error) *error = "unsupported replay version";
+        return false;
+    }
+
+    ReplayHeader parsed;
+    parsed.seed = static_cast<uint32_t>(reader.Varint());
+    uint32_t stepBits = static_cast<uint32_t>(reader.Varint());
+    std::memcpy(&parsed.fixedStep, &stepBits, sizeof(stepBits));
+    parsed.tickCount = static_cast<uint32_t>(reader.Varint());
+    parsed.finalHash = reader.U64();
+    uint64_t assetCount = reader.Varint();
+    for (uint64_t i = 0; i < assetCount && reader.ok; i++) {
+        ReplayAsset asset;
+        uint64_t length = reader.Varint();
+        if (length > size - reader.pos) { reader.ok = false; break; }
+        asset.name.assign(reinterpret_cast<const char*>(data + reader.pos), static_cast<size_t>(length));
+        reader.pos += static_cast<size_t>(length);
+        asset.hash = reader.U64();
+        parsed.assets.push_back(asset);
+    }
+    if (!reader.ok) {
+        if (error) *error = "truncated replay header";
+        return false;
+    }
+
+    header = parsed;
+    stream.assign(data + reader.pos, data + size);
+    Rewind();
+    return true;
+}
+
+bool ReplayPlayer::Load(const wchar_t* path, std::string* error) {
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return Decode(bytes.data(), bytes.size(), error);
+}
+
+const ReplayHeader& ReplayPlayer::GetHeader() const {
+    return header;
+}
+
+bool ReplayPlayer::Next(InputFrame* input) {
+    if (played >= header.tickCount) return false;
+
+    if (idleTicks == 0 && !hasChange && cursor < stream.size()) {
+        ByteReader reader{ stream.data(), stream.size(), cursor };
+        idleTicks = static_cast<uint32_t>(reader.Varint());
+        change = static_cast<uint32_t>(reader.Varint());
+        hasChange = reader.ok;
+        cursor = reader.ok ? reader.pos : stream.size();
+        if (!reader.ok) idleTicks = 0;
+    }
+
+    *input = InputFrame();
+    if (idleTicks > 0) {
+        idleTicks--;
+    }
+    else if (hasChange) {
+        held = static_cast<uint8_t>(held ^ (change & 0xff));
+        input->pressed = static_cast<uint8_t>(change >> 8);
+        hasChange = false;
+    }
+    input->held = held;
+    played++;
+    return true;
+}
+
+void ReplayPlayer::Rewind() {
+    cursor = 0;
+    played = 0;
+    idleTicks = 0;
+    change = 0;
+    hasChange = false;
+    held = 0;
+}
+
+
+void RunReplay(ReplayPlayer* replay, GameWorld* world, JobSystem* jobs, ReplayTiming* out) {
+    const float step = replay->GetHeader().fixedStep;
+    out->tickMs.clear();
+    out->tickMs.reserve(replay->GetHeader().tickCount);
+
+    replay->Rewind();
+    auto start = std::chrono::steady_clock::now();
+    InputFrame input;
+    while (replay->Next(&input)) {
+        auto t0 = std::chrono::steady_clock::now();
+        StepGameWorld(world, input, step, jobs);
+        auto t1 = std::chrono::steady_clock::now();
+        out->tickMs.push_back(std::chrono::duration<float, std::milli>(t1 - t0).count());
+    }
+    out->totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    out->finalHash = HashGameWorld(*world);
+    out->hashMatched = replay->GetHeader().finalHash == 0 || replay->GetHeader().finalHash == out->finalHash;
+}
+
+bool WriteReplayTiming(const wchar_t* path, const ReplayTiming& timing) {
+    std::ofstream file{ std::filesystem::path(path) };
+    if (!file) return false;
+    file << "tick,ms\n";
+    for (size_t i = 0; i < timing.tickMs.size(); i++) {
+        file << i << ',' << timing.tickMs[i] << '\n';
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,91 @@
+﻿/**********************************************************************************
+    Replay.h
+
+                                                                LI WENHUI
+                                                                2025/08/30
+
+**********************************************************************************/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "InputSystem.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GameWorld;
+class JobSystem;
+
+struct ReplayAsset {
+    std::string name;
+    uint64_t hash = 0;
+};
+
+struct ReplayHeader {
+    uint32_t seed = 1;
+    float fixedStep = 1.0f / 120.0f;
+    uint32_t tickCount = 0;
+    uint64_t finalHash = 0;         // 記録の終わりの HashGameWorld（0 なら確認しない）
+    std::vector<ReplayAsset> assets;    // 先頭は使ったマップ（名前は読み込んだパス）
+};
+
+//
+// リプレイのファイル形式
+//   "RPLY", 版, seed, fixedStep, tick 数, finalHash, アセット（名前とハッシュ）
+//   以降は入力が変わった tick だけ: varint(前の記録から変化のなかった tick 数), varint(held の差分 | pressed << 8)
+// 押しっぱなしの間は何も書かないので、数分のプレイでも数 KB に収まる
+class ReplayRecorder {
+public:
+    void Begin(const ReplayHeader& header);
+    void RecordTick(const InputFrame& input);
+    uint32_t GetRecordedTicks() const;
+
+    void Encode(uint64_t finalHash, std::vector<uint8_t>* out) const;
+    bool Save(const wchar_t* path, uint64_t finalHash, std::string* error = nullptr) const;
+
+private:
+    ReplayHeader header;
+    std::vector<uint8_t> stream;
+    uint32_t idleTicks = 0;
+    uint8_t held = 0;
+};
+
+class ReplayPlayer {
+public:
+    bool Decode(const uint8_t* data, size_t size, std::string* error = nullptr);
+    bool Load(const wchar_t* path, std::string* error = nullptr);
+
+    const ReplayHeader& GetHeader() const;
+
+    // 次の tick の入力。最後まで進んだら false
+    bool Next(InputFrame* input);
+    void Rewind();
+
+private:
+    ReplayHeader header;
+    std::vector<uint8_t> stream;
+    size_t cursor = 0;
+    uint32_t played = 0;
+    uint32_t idleTicks = 0;
+    uint32_t change = 0;
+    bool hasChange = false;
+    uint8_t held = 0;
+};
+
+// ヘッドレス再生の結果。tickMs は tick ごとのシミュレーション時間
+struct ReplayTiming {
+    std::vector<float> tickMs;
+    double totalMs = 0.0;
+    uint64_t finalHash = 0;
+    bool hashMatched = false;
+};
+
+// world は InitGameWorld 済みであること。描画なしで最大速度で最後まで進める
+void RunReplay(ReplayPlayer* replay, GameWorld* world, JobSystem* jobs, ReplayTiming* out);
+
+bool WriteReplayTiming(const wchar_t* path, const ReplayTiming& timing);
+
+
+#endif
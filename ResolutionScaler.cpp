@@ -0,0 +1,138 @@
+﻿/**********************************************************************************
+    ResolutionScaler.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "ResolutionScaler.h"
+#include <algorithm>
+#include <cmath>
+
+
+ResolutionScaler::ResolutionScaler(const ResolutionScalerDesc& desc) {
+    SetDesc(desc);
+}
+
+void ResolutionScaler::SetDesc(const ResolutionScalerDesc& newDesc) {
+    desc = newDesc;
+    desc.minScale = std::clamp(desc.minScale, 0.1f, 1.0f);
+    desc.maxScale = std::clamp(desc.maxScale, desc.minScale, 1.0f);
+    desc.step = std::max(desc.step, 0.01f);
+    desc.upThreshold = std::min(desc.upThreshold, desc.downThreshold);
+    Reset();
+}
+
+const ResolutionScalerDesc& ResolutionScaler::GetDesc() const {
+    return desc;
+}
+
+void ResolutionScaler::Reset() {
+    scale = desc.maxScale;
+    averageMs = 0.0f;
+    hasAverage = false;
+    settle = 0;
+    lightFrames = 0;
+}
+
+bool ResolutionScaler::Update(float frameMs) {
+    if (!(frameMs >= 0.0f)) return false;       // 測れなかったフレーム（NaN も）
+    averageMs = hasAverage ? averageMs + (frameMs - averageMs) * desc.smoothing : frameMs;
+    hasAverage = true;
+
+    if (settle > 0) {
+        settle--;
+        return false;
+    }
+
+    float next = scale;
+    if (averageMs > desc.targetMs * desc.downThreshold) {
+        // 描画の時間はおおよそピクセル数（倍率の 2 乗）に比例するので、上げ下げの境目の真ん中を狙う
+        float aimMs = desc.targetMs * (desc.downThreshold + desc.upThreshold) * 0.5f;
+        float wanted = scale * std::sqrt(aimMs / averageMs);
+        next = std::min(Quantize(wanted), Quantize(scale - desc.step));
+        lightFrames = 0;
+    }
+    else if (averageMs < desc.targetMs * desc.upThreshold) {
+        if (++lightFrames >= desc.upFrames) {
+            next = Quantize(scale + desc.step);
+            lightFrames = 0;
+        }
+    }
+    else {
+        lightFrames = 0;
+    }
+
+    next = std::clamp(next, desc.minScale, desc.maxScale);
+    if (next == scale) return false;
+
+    // 前の倍率での平均は当てにならないので測り直す
+    scale = next;
+    hasAverage = false;
+    settle = desc.settleFrames;
+    changes++;
+    return true;
+}
+
+float ResolutionScaler::GetScale() const {
+    return scale;
+}
+
+float ResolutionScaler::GetAverageMs() const {
+    return averageMs;
+}
+
+uint32_t ResolutionScaler::GetChangeCount() const {
+    return changes;
+}
+
+float ResolutionScaler::Quantize(float value) const {
+    // 刻みの境目ちょうどの値が誤差で 1 段下にならないよう、少しだけ足してから切り捨てる
+    return std::floor(value / desc.step + 1e-3f) * desc.step;
+}
+
+
+ResizeCoalescer::ResizeCoalescer(double quietMs)
+    : quietMs(quietMs) {
+}
+
+void ResizeCoalescer::Request(uint32_t newWidth, uint32_t newHeight, double nowMs) {
+    if (newWidth == 0 || newHeight == 0) return;    // 最小化
+    requests++;
+    width = newWidth;
+    height = newHeight;
+    lastRequestMs = nowMs;
+    pending = true;
+}
+
+void ResizeCoalescer::BeginInteractive() {
+    interactive = true;
+}
+
+void ResizeCoalescer::EndInteractive(double nowMs) {
+    interactive = false;
+    // 離したらすぐ作り直す
+    lastRequestMs = nowMs - quietMs;
+}
+
+bool ResizeCoalescer::Poll(double nowMs, uint32_t* outWidth, uint32_t* outHeight) {
+    if (!pending || interactive || nowMs - lastRequestMs < quietMs) return false;
+    pending = false;
+    applies++;
+    *outWidth = width;
+    *outHeight = height;
+    return true;
+}
+
+bool ResizeCoalescer::IsPending() const {
+    return pending;
+}
+
+uint32_t ResizeCoalescer::GetRequestCount() const {
+    return requests;
+}
+
+uint32_t ResizeCoalescer::GetApplyCount() const {
+    return applies;
+}
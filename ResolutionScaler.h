@@ -0,0 +1,90 @@
+﻿/**********************************************************************************
+    ResolutionScaler.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef RESOLUTIONSCALER_H
+#define RESOLUTIONSCALER_H
+
+#include <cstdint>
+
+//
+// 測った描画時間からシーンの描画解像度の倍率（縦横それぞれ）を決める
+// 重ければすぐ下げ、軽い状態がしばらく続いたときだけ 1 段ずつ上げる
+// 上げ下げの境目を離し、変えた直後はしばらく待つので、境目の近くで行ったり来たりしない
+// D3D は使わない（DynamicResolution が GPU の時間を測って渡す）
+struct ResolutionScalerDesc {
+    float targetMs = 16.6f;         // 1 フレームに使ってよい時間
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float step = 0.05f;             // 倍率はこの刻みに丸める（上げるときはこの幅ずつ）
+    float downThreshold = 0.95f;    // 平均が targetMs のこの割合を超えたら下げる
+    float upThreshold = 0.75f;      // 平均がこの割合を下回る状態が upFrames 続いたら上げる
+    int upFrames = 60;
+    int settleFrames = 15;          // 変えた後、次の判定までに待つフレーム数
+    float smoothing = 0.1f;         // 指数移動平均の係数
+};
+
+class ResolutionScaler {
+public:
+    explicit ResolutionScaler(const ResolutionScalerDesc& desc = ResolutionScalerDesc());
+
+    void SetDesc(const ResolutionScalerDesc& desc);
+    const ResolutionScalerDesc& GetDesc() const;
+
+    // maxScale から始め直す
+    void Reset();
+
+    // 1 フレーム分の描画時間を渡す。倍率が変わったら true
+    bool Update(float frameMs);
+
+    float GetScale() const;
+    float GetAverageMs() const;
+    uint32_t GetChangeCount() const;
+
+private:
+    float Quantize(float scale) const;
+
+    ResolutionScalerDesc desc;
+    float scale = 1.0f;
+    float averageMs = 0.0f;
+    bool hasAverage = false;
+    int settle = 0;
+    int lightFrames = 0;
+    uint32_t changes = 0;
+};
+
+//
+// ウィンドウの枠をドラッグしている間は WM_SIZE が何十回も来るので、作り直しは最後の大きさで 1 回にまとめる
+// ドラッグ中は離すまで、それ以外（最大化など）は quietMs だけ大きさが変わらなかったら作り直す
+class ResizeCoalescer {
+public:
+    explicit ResizeCoalescer(double quietMs = 100.0);
+
+    void Request(uint32_t width, uint32_t height, double nowMs);
+    void BeginInteractive();
+    void EndInteractive(double nowMs);
+
+    // 作り直すときなら true を返して大きさを渡す（同じ要求は 1 回だけ）
+    bool Poll(double nowMs, uint32_t* width, uint32_t* height);
+
+    bool IsPending() const;
+    uint32_t GetRequestCount() const;
+    uint32_t GetApplyCount() const;
+
+private:
+    double quietMs;
+    bool pending = false;
+    bool interactive = false;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    double lastRequestMs = 0.0;
+    uint32_t requests = 0;
+    uint32_t applies = 0;
+};
+
+
+#endif
@@ -0,0 +1,233 @@
+﻿/**********************************************************************************
+    ResourceRegistry.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/05
+
+**********************************************************************************/
+
+#include "ResourceRegistry.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+    const int kPoolCount = static_cast<int>(ResourcePool::Count);
+    const int kTagCount = static_cast<int>(MemoryTag::Count);
+
+    const char* const kKindNames[] = { "VertexBuffer", "IndexBuffer", "ConstantBuffer", "Texture", "DepthStencil" };
+    const char* const kTagNames[] = { "General", "Animation", "Collision", "Particles", "World", "Lighting" };
+    const char* const kPoolNames[] = { "GPU", "CPU" };
+
+    std::mutex registryMutex;
+    std::unordered_map<const void*, ResourceInfo> resources;
+    uint64_t gpuUsed = 0;
+    uint64_t peaks[kPoolCount] = {};
+    uint64_t budgets[kPoolCount] = {};
+    bool overBudget[kPoolCount] = {};
+    std::atomic<uint32_t> frame{ 0 };
+    ResourceEvictionCallback evictionCallback;
+    ResourceWarningCallback warningCallback;
+
+    // CPU はどのスレッドからも増減するので atomic だけで持つ
+    std::atomic<int64_t> tagBytes[kTagCount] = {};
+
+    uint64_t CpuUsed() {
+        int64_t total = 0;
+        for (const auto& bytes : tagBytes) total += bytes.load(std::memory_order_relaxed);
+        return total > 0 ? static_cast<uint64_t>(total) : 0;
+    }
+
+    double ToMegabytes(uint64_t bytes) {
+        return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+}
+
+
+bool ResourceRegister(const void* handle, ResourceKind kind, uint64_t bytes, uint32_t format, const char* owner, const std::string& name) {
+    if (!handle) return false;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto found = resources.find(handle);
+    bool added = found == resources.end();
+    if (!added) gpuUsed -= found->second.bytes;
+
+    ResourceInfo& info = resources[handle];
+    info.handle = handle;
+    info.kind = kind;
+    info.bytes = bytes;
+    info.format = format;
+    info.owner = owner ? owner : "";
+    info.name = name;
+    if (added) {
+        info.createdFrame = frame.load(std::memory_order_relaxed);
+        info.lastUsedFrame = info.createdFrame;
+    }
+    gpuUsed += bytes;
+    peaks[static_cast<int>(ResourcePool::Gpu)] = std::max(peaks[static_cast<int>(ResourcePool::Gpu)], gpuUsed);
+    return added;
+}
+
+void ResourceUnregister(const void* handle) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto found = resources.find(handle);
+    if (found == resources.end()) return;
+    gpuUsed -= found->second.bytes;
+    resources.erase(found);
+}
+
+void ResourceSetOwner(const void* handle, const char* owner) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto found = resources.find(handle);
+    if (found != resources.end()) found->second.owner = owner ? owner : "";
+}
+
+void ResourceTouch(const void* handle) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto found = resources.find(handle);
+    if (found != resources.end()) found->second.lastUsedFrame = frame.load(std::memory_order_relaxed);
+}
+
+void ResourceBeginFrame() {
+    frame.fetch_add(1, std::memory_order_relaxed);
+
+    // コールバックの中でリソースを解放できるよう、ロックを外してから呼ぶ
+    for (int p = 0; p < kPoolCount; p++) {
+        ResourcePool pool = static_cast<ResourcePool>(p);
+        ResourceUsage usage = ResourceGetUsage(pool);
+        if (usage.budget == 0 || usage.used <= usage.budget) {
+            overBudget[p] = false;
+            continue;
+        }
+
+        // 警告は超えたときに一度だけ。退避は下回るまで毎フレーム頼む
+        if (!overBudget[p] && warningCallback) {
+            char message[160];
+            std::snprintf(message, sizeof(message), "%s memory over budget: %.1f MB / %.1f MB\n",
+                kPoolNames[p], ToMegabytes(usage.used), ToMegabytes(usage.budget));
+            warningCallback(message);
+        }
+        overBudget[p] = true;
+
+        if (evictionCallback) {
+            std::vector<ResourceInfo> candidates;
+            if (pool == ResourcePool::Gpu) {
+                ResourceSnapshot(&candidates);
+                std::stable_sort(candidates.begin(), candidates.end(), [](const ResourceInfo& a, const ResourceInfo& b) {
+                    return a.lastUsedFrame < b.lastUsedFrame;
+                });
+            }
+            evictionCallback(pool, usage.used - usage.budget, candidates);
+        }
+    }
+}
+
+uint32_t ResourceGetFrame() {
+    return frame.load(std::memory_order_relaxed);
+}
+
+void ResourceSetBudget(ResourcePool pool, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    budgets[static_cast<int>(pool)] = bytes;
+}
+
+void ResourceSetEvictionCallback(const ResourceEvictionCallback& callback) {
+    evictionCallback = callback;
+}
+
+void ResourceSetWarningCallback(const ResourceWarningCallback& callback) {
+    warningCallback = callback;
+}
+
+ResourceUsage ResourceGetUsage(ResourcePool pool) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    int p = static_cast<int>(pool);
+    ResourceUsage usage;
+    if (pool == ResourcePool::Gpu) {
+        usage.used = gpuUsed;
+        usage.count = resources.size();
+    }
+    else {
+        usage.used = CpuUsed();
+        peaks[p] = std::max(peaks[p], usage.used);
+    }
+    usage.peak = peaks[p];
+    usage.budget = budgets[p];
+    return usage;
+}
+
+int64_t ResourceGetTagBytes(MemoryTag tag) {
+    return tagBytes[static_cast<int>(tag)].load(std::memory_order_relaxed);
+}
+
+void ResourceSnapshot(std::vector<ResourceInfo>* out) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    out->clear();
+    out->reserve(resources.size());
+    for (const auto& entry : resources) out->push_back(entry.second);
+    std::sort(out->begin(), out->end(), [](const ResourceInfo& a, const ResourceInfo& b) {
+        return a.bytes != b.bytes ? a.bytes > b.bytes : a.handle < b.handle;
+    });
+}
+
+void ResourceTrackMemory(MemoryTag tag, int64_t bytes) {
+    if (bytes != 0) tagBytes[static_cast<int>(tag)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+std::string ResourceFormatSummary() {
+    std::string text;
+    char line[256];
+    for (int p = 0; p < kPoolCount; p++) {
+        ResourceUsage usage = ResourceGetUsage(static_cast<ResourcePool>(p));
+        std::snprintf(line, sizeof(line), "%s: %.2f MB (peak %.2f MB, budget %.0f MB)\n",
+            kPoolNames[p], ToMegabytes(usage.used), ToMegabytes(usage.peak), ToMegabytes(usage.budget));
+        text += line;
+    }
+    for (int t = 0; t < kTagCount; t++) {
+        int64_t bytes = tagBytes[t].load(std::memory_order_relaxed);
+        if (bytes == 0) continue;
+        std::snprintf(line, sizeof(line), "  cpu %-10s %10.2f MB\n", kTagNames[t], static_cast<double>(bytes) / (1024.0 * 1024.0));
+        text += line;
+    }
+
+    std::vector<ResourceInfo> list;
+    ResourceSnapshot(&list);
+    uint32_t now = ResourceGetFrame();
+    for (const ResourceInfo& info : list) {
+        std::snprintf(line, sizeof(line), "  gpu %-14s %10.2f KB  fmt %3u  age %6u  %s %s\n",
+            GetResourceKindName(info.kind), static_cast<double>(info.bytes) / 1024.0, info.format,
+            now - info.createdFrame, info.owner, info.name.c_str());
+        text += line;
+    }
+    return text;
+}
+
+bool ResourceWriteReport(const wchar_t* path) {
+    std::ofstream file{ std::filesystem::path(path) };
+    if (!file) return false;
+
+    uint32_t now = ResourceGetFrame();
+    file << "pool,kind,owner,name,bytes,format,ageFrames,idleFrames\n";
+    std::vector<ResourceInfo> list;
+    ResourceSnapshot(&list);
+    for (const ResourceInfo& info : list) {
+        file << "GPU," << GetResourceKindName(info.kind) << ',' << info.owner << ",\"" << info.name << "\","
+            << info.bytes << ',' << info.format << ',' << (now - info.createdFrame) << ',' << (now - info.lastUsedFrame) << '\n';
+    }
+    for (int t = 0; t < kTagCount; t++) {
+        file << "CPU,," << kTagNames[t] << ",," << tagBytes[t].load(std::memory_order_relaxed) << ",,,\n";
+    }
+    return static_cast<bool>(file);
+}
+
+const char* GetResourceKindName(ResourceKind kind) {
+    return kind < ResourceKind::Count ? kKindNames[static_cast<int>(kind)] : "";
+}
+
+const char* GetMemoryTagName(MemoryTag tag) {
+    return tag < MemoryTag::Count ? kTagNames[static_cast<int>(tag)] : "";
+}
@@ -0,0 +1,125 @@
+﻿/**********************************************************************************
+    ResourceRegistry.h
+
+                                                                LI WENHUI
+                                                                2025/09/05
+
+**********************************************************************************/
+
+#ifndef RESOURCEREGISTRY_H
+#define RESOURCEREGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// GPU のリソースは作成ごとに登録し、CPU のヒープはサブシステムごとに合計だけを持つ
+enum class ResourcePool : uint8_t {
+    Gpu,
+    Cpu,
+    Count
+};
+
+enum class ResourceKind : uint8_t {
+    VertexBuffer,
+    IndexBuffer,
+    ConstantBuffer,
+    Texture,
+    DepthStencil,
+    Count
+};
+
+enum class MemoryTag : uint8_t {
+    General,
+    Animation,
+    Collision,
+    Particles,
+    World,
+    Lighting,
+    Count
+};
+
+struct ResourceInfo {
+    const void* handle = nullptr;       // バッファか SRV のポインタ（破棄されたら登録も消える）
+    ResourceKind kind = ResourceKind::Texture;
+    uint64_t bytes = 0;                 // 見積もり（ミップと配列を含む）
+    uint32_t format = 0;                // DXGI_FORMAT。バッファは 0
+    const char* owner = "";             // 作った側（文字列リテラル）
+    std::string name;                   // ファイル名など
+    uint32_t createdFrame = 0;
+    uint32_t lastUsedFrame = 0;
+};
+
+struct ResourceUsage {
+    uint64_t used = 0;
+    uint64_t peak = 0;
+    uint64_t budget = 0;                // 0 なら無制限
+    size_t count = 0;                   // GPU のみ。登録中のリソース数
+};
+
+// 予算を超えたフレームごとに呼ばれる。candidates は GPU なら使われていない順（CPU は空）
+// 解放すれば（Release されれば）登録は自動で消えるので、戻り値はない
+using ResourceEvictionCallback = std::function<void(ResourcePool pool, uint64_t overBytes, const std::vector<ResourceInfo>& candidates)>;
+using ResourceWarningCallback = std::function<void(const char* message)>;
+
+// 新しく登録したら true（同じ handle がすでにあれば中身を更新して false）
+bool ResourceRegister(const void* handle, ResourceKind kind, uint64_t bytes, uint32_t format, const char* owner, const std::string& name);
+void ResourceUnregister(const void* handle);
+void ResourceSetOwner(const void* handle, const char* owner);
+
+// 描画で使ったとき。退避の候補を選ぶのに使う
+void ResourceTouch(const void* handle);
+
+// 毎フレームの最初に一度。フレーム番号を進め、予算を調べる
+void ResourceBeginFrame();
+uint32_t ResourceGetFrame();
+
+void ResourceSetBudget(ResourcePool pool, uint64_t bytes);
+void ResourceSetEvictionCallback(const ResourceEvictionCallback& callback);
+void ResourceSetWarningCallback(const ResourceWarningCallback& callback);
+
+ResourceUsage ResourceGetUsage(ResourcePool pool);
+int64_t ResourceGetTagBytes(MemoryTag tag);
+void ResourceSnapshot(std::vector<ResourceInfo>* out);      // 大きい順
+
+// CPU ヒープの増減（どのスレッドからでもよい）
+void ResourceTrackMemory(MemoryTag tag, int64_t bytes);
+
+// 合計と、プール・タグ・リソースの一覧
+std::string ResourceFormatSummary();
+bool ResourceWriteReport(const wchar_t* path);
+
+const char* GetResourceKindName(ResourceKind kind);
+const char* GetMemoryTagName(MemoryTag tag);
+
+//
+// メンバーに置いて、持っている分のバイト数を tag に計上する。破棄で戻す
+class TrackedMemory {
+public:
+    explicit TrackedMemory(MemoryTag tag = MemoryTag::General) : tag(tag) {}
+    TrackedMemory(const TrackedMemory& other) : tag(other.tag) { Set(other.bytes); }
+    TrackedMemory& operator=(const TrackedMemory& other) {
+        if (this != &other) {
+            Set(0);
+            tag = other.tag;
+            Set(other.bytes);
+        }
+        return *this;
+    }
+    ~TrackedMemory() { Set(0); }
+
+    void Set(size_t newBytes) {
+        ResourceTrackMemory(tag, static_cast<int64_t>(newBytes) - static_cast<int64_t>(bytes));
+        bytes = newBytes;
+    }
+    size_t Get() const { return bytes; }
+
+private:
+    MemoryTag tag;
+    size_t bytes = 0;
+};
+
+
+#endif
@@ -0,0 +1,333 @@
+﻿/**********************************************************************************
+    Skeleton2D.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/15
+
+**********************************************************************************/
+
+#include "Skeleton2D.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+/*
+    スケルトン定義の書式（1行1命令、# 以降はコメント）
+
+        atlas     <texturePath> <width> <height>
+        region    <name> <x> <y> <w> <h>                         ピクセル単位
+        bone      <name> <parent|-> <x> <y> <rotation> [sx sy]
+        slot      <name> <bone> <region> <x> <y> <rotation> [sx sy] [r g b a]
+        animation <name> <duration>
+        key       <bone> translate <time> <x> <y> [curve]
+        key       <bone> rotate    <time> <degrees>   [curve]
+        key       <bone> scale     <time> <sx> <sy>   [curve]
+
+    curve は linear（省略時）/ stepped / bezier cx1 cy1 cx2 cy2
+    キーの値は初期姿勢からの差分（scale は倍率）。slot は書いた順に描画される。
+*/
+
+using namespace DirectX;
+
+namespace {
+
+    bool Fail(std::string* error, int line, const std::string& message) {
+        if (error) *error = "line " + std::to_string(line) + ": " + message;
+        return false;
+    }
+
+    template <typename T>
+    int FindByName(const std::vector<T>& items, const std::string& name) {
+        for (size_t i = 0; i < items.size(); i++) {
+            if (items[i].name == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    // -180..180 に正規化
+    float WrapDegrees(float deg) {
+        deg = std::fmod(deg + 180.0f, 360.0f);
+        if (deg < 0.0f) deg += 360.0f;
+        return deg - 180.0f;
+    }
+
+    // タイムライン上の値をサンプリングする
+    void SampleTimeline(const BoneTimeline& tl, float time, float out[2]) {
+        const std::vector<BoneKey>& keys = tl.keys;
+        if (time <= keys.front().time) {
+            out[0] = keys.front().value[0];
+            out[1] = keys.front().value[1];
+            return;
+        }
+        if (time >= keys.back().time) {
+            out[0] = keys.back().value[0];
+            out[1] = keys.back().value[1];
+            return;
+        }
+
+        auto next = std::upper_bound(keys.begin(), keys.end(), time,
+            [](float t, const BoneKey& k) { return t < k.time; });
+        const BoneKey& k1 = *next;
+        const BoneKey& k0 = *(next - 1);
+
+        float alpha = (time - k0.time) / (k1.time - k0.time);
+        if (k0.curve == CurveType::Stepped) alpha = 0.0f;
+        else if (k0.curve == CurveType::Bezier) alpha = SampleBezierCurve(alpha, k0.cx1, k0.cy1, k0.cx2, k0.cy2);
+
+        if (tl.channel == BoneChannel::Rotate) {
+            out[0] = k0.value[0] + WrapDegrees(k1.value[0] - k0.value[0]) * alpha;
+            out[1] = 0.0f;
+            return;
+        }
+        out[0] = k0.value[0] + (k1.value[0] - k0.value[0]) * alpha;
+        out[1] = k0.value[1] + (k1.value[1] - k0.value[1]) * alpha;
+    }
+
+    XMMATRIX LocalMatrix(float x, float y, float rotation, float sx, float sy) {
+        return XMMatrixAffineTransformation2D(
+            XMVectorSet(sx, sy, 1.0f, 1.0f),
+            XMVectorZero(),
+            XMConvertToRadians(rotation),
+            XMVectorSet(x, y, 0.0f, 0.0f));
+    }
+}
+
+
+int SkeletonData::FindBone(const char* name) const {
+    return FindByName(bones, name);
+}
+
+int SkeletonData::FindAnimation(const char* name) const {
+    return FindByName(animations, name);
+}
+
+
+float SampleBezierCurve(float t, float cx1, float cy1, float cx2, float cy2) {
+    // x(s) = t となる s をニュートン法で求め、y(s) を返す
+    auto bez = [](float s, float p1, float p2) {
+        float inv = 1.0f - s;
+        return 3.0f * inv * inv * s * p1 + 3.0f * inv * s * s * p2 + s * s * s;
+    };
+    auto bezDeriv = [](float s, float p1, float p2) {
+        float inv = 1.0f - s;
+        return 3.0f * inv * inv * p1 + 6.0f * inv * s * (p2 - p1) + 3.0f * s * s * (1.0f - p2);
+    };
+
+    float s = t;
+    for (int i = 0; i < 6; i++) {
+        float dx = bez(s, cx1, cx2) - t;
+        float d = bezDeriv(s, cx1, cx2);
+        if (std::fabs(dx) < 1e-5f || std::fabs(d) < 1e-6f) break;
+        s = std::clamp(s - dx / d, 0.0f, 1.0f);
+    }
+    return bez(s, cy1, cy2);
+}
+
+bool ParseSkeletonData(const std::string& source, SkeletonData* outData, std::string* error) {
+    SkeletonData data;
+    SkeletonAnimation* anim = nullptr;
+
+    std::istringstream input(source);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(input, line)) {
+        lineNo++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream tokens(line);
+        std::string cmd;
+        if (!(tokens >> cmd)) continue;
+
+        if (cmd == "atlas") {
+            std::string path;
+            if (!(tokens >> path >> data.atlasWidth >> data.atlasHeight)) return Fail(error, lineNo, "atlas needs path, width, height");
+            data.atlasPath = std::filesystem::u8path(path).wstring();
+        }
+        else if (cmd == "region") {
+            AtlasRegion r{};
+            float x, y;
+            if (!(tokens >> r.name >> x >> y >> r.width >> r.height)) return Fail(error, lineNo, "region needs name, x, y, w, h");
+            r.u0 = x / data.atlasWidth;
+            r.v0 = y / data.atlasHeight;
+            r.u1 = (x + r.width) / data.atlasWidth;
+            r.v1 = (y + r.height) / data.atlasHeight;
+            data.regions.push_back(r);
+        }
+        else if (cmd == "bone") {
+            SkeletonBone b{};
+            std::string parent;
+            if (!(tokens >> b.name >> parent >> b.x >> b.y >> b.rotation)) return Fail(error, lineNo, "bone needs name, parent, x, y, rotation");
+            if (!(tokens >> b.scaleX >> b.scaleY)) { b.scaleX = 1.0f; b.scaleY = 1.0f; }
+            b.parent = (parent == "-") ? -1 : FindByName(data.bones, parent);
+            if (parent != "-" && b.parent < 0) return Fail(error, lineNo, "parent bone must be defined first");
+            data.bones.push_back(b);
+        }
+        else if (cmd == "slot") {
+            SkeletonSlot s{};
+            std::string bone, region;
+            if (!(tokens >> s.name >> bone >> region >> s.x >> s.y >> s.rotation)) return Fail(error, lineNo, "slot needs name, bone, region, x, y, rotation");
+            if (!(tokens >> s.scaleX >> s.scaleY)) { s.scaleX = 1.0f; s.scaleY = 1.0f; }
+            if (!(tokens >> s.color.x >> s.color.y >> s.color.z >> s.color.w)) s.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+            s.bone = FindByName(data.bones, bone);
+            s.region = FindByName(data.regions, region);
+            if (s.bone < 0 || s.region < 0) return Fail(error, lineNo, "unknown bone or region");
+            data.slots.push_back(s);
+        }
+        else if (cmd == "animation") {
+            SkeletonAnimation a{};
+            if (!(tokens >> a.name >> a.duration)) return Fail(error, lineNo, "animation needs name, duration");
+            data.animations.push_back(a);
+            anim = &data.animations.back();
+        }
+        else if (cmd == "key") {
+            if (!anim) return Fail(error, lineNo, "key before animation");
+            std::string bone, channel, curve;
+            BoneKey k{};
+            if (!(tokens >> bone >> channel >> k.time >> k.value[0])) return Fail(error, lineNo, "key needs bone, channel, time, value");
+
+            BoneChannel ch;
+            if (channel == "translate") ch = BoneChannel::Translate;
+            else if (channel == "rotate") ch = BoneChannel::Rotate;
+            else if (channel == "scale") ch = BoneChannel::Scale;
+            else return Fail(error, lineNo, "unknown channel '" + channel + "'");
+            if (ch != BoneChannel::Rotate && !(tokens >> k.value[1])) return Fail(error, lineNo, "key needs two values");
+
+            k.curve = CurveType::Linear;
+            if (tokens >> curve) {
+                if (curve == "stepped") k.curve = CurveType::Stepped;
+                else if (curve == "bezier") {
+                    k.curve = CurveType::Bezier;
+                    if (!(tokens >> k.cx1 >> k.cy1 >> k.cx2 >> k.cy2)) return Fail(error, lineNo, "bezier needs 4 values");
+                }
+                else if (curve != "linear") return Fail(error, lineNo, "unknown curve '" + curve + "'");
+            }
+
+            int b = FindByName(data.bones, bone);
+            if (b < 0) return Fail(error, lineNo, "unknown bone '" + bone + "'");
+
+            BoneTimeline* tl = nullptr;
+            for (BoneTimeline& t : anim->timelines) {
+                if (t.bone == b && t.channel == ch) tl = &t;
+            }
+            if (!tl) {
+                anim->timelines.push_back({ b, ch, {} });
+                tl = &anim->timelines.back();
+            }
+            tl->keys.push_back(k);
+        }
+        else {
+            return Fail(error, lineNo, "unknown command '" + cmd + "'");
+        }
+    }
+
+    for (SkeletonAnimation& a : data.animations) {
+        for (BoneTimeline& t : a.timelines) {
+            std::stable_sort(t.keys.begin(), t.keys.end(),
+                [](const BoneKey& l, const BoneKey& r) { return l.time < r.time; });
+        }
+    }
+
+    data.setupPose.reserve(data.bones.size());
+    for (const SkeletonBone& b : data.bones) data.setupPose.push_back({ b.x, b.y, b.rotation, b.scaleX, b.scaleY });
+
+    *outData = std::move(data);
+    return true;
+}
+
+bool LoadSkeletonData(const wchar_t* path, SkeletonData* outData, std::string* error) {
+    PROFILE_ZONE("LoadSkeletonData");
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return ParseSkeletonData(buffer.str(), outData, error);
+}
+
+void InitSkeletonInstance(const SkeletonData* data, SkeletonInstance* instance) {
+    instance->data = data;
+    instance->animation = data->animations.empty() ? -1 : 0;
+    instance->time = 0.0f;
+    instance->local = data->setupPose;
+    instance->world.assign(data->bones.size(), XMMatrixIdentity());
+}
+
+void UpdateSkeletons(SkeletonInstance* instances, size_t count, float deltaTime) {
+    PROFILE_ZONE("UpdateSkeletons");
+    for (size_t i = 0; i < count; i++) {
+        SkeletonInstance& inst = instances[i];
+        const SkeletonData& data = *inst.data;
+
+        // 初期姿勢に戻してからタイムラインの差分を重ねる
+        std::copy(data.setupPose.begin(), data.setupPose.end(), inst.local.begin());
+
+        if (inst.animation >= 0) {
+            const SkeletonAnimation& anim = data.animations[static_cast<size_t>(inst.animation)];
+            inst.time += deltaTime;
+            if (anim.duration > 0.0f) inst.time = std::fmod(inst.time, anim.duration);
+
+            for (const BoneTimeline& tl : anim.timelines) {
+                float v[2];
+                SampleTimeline(tl, inst.time, v);
+                BonePose& b = inst.local[static_cast<size_t>(tl.bone)];
+                switch (tl.channel) {
+                case BoneChannel::Translate: b.x += v[0]; b.y += v[1]; break;
+                case BoneChannel::Rotate:    b.rotation += v[0]; break;
+                case BoneChannel::Scale:     b.scaleX *= v[0]; b.scaleY *= v[1]; break;
+                }
+            }
+        }
+
+        // 親が先に並んでいるので、前から順に掛けるだけでワールド行列が決まる
+        XMMATRIX root = LocalMatrix(inst.x, inst.y, 0.0f, inst.flipX ? -inst.scale : inst.scale, inst.scale);
+        for (size_t b = 0; b < inst.local.size(); b++) {
+            const BonePose& pose = inst.local[b];
+            XMMATRIX local = LocalMatrix(pose.x, pose.y, pose.rotation, pose.scaleX, pose.scaleY);
+            int parentBone = data.bones[b].parent;
+            const XMMATRIX& parent = parentBone < 0 ? root : inst.world[static_cast<size_t>(parentBone)];
+            inst.world[b] = XMMatrixMultiply(local, parent);
+        }
+    }
+}
+
+size_t BuildSkeletonQuads(const SkeletonInstance& instance, std::vector<SpriteQuad>* out) {
+    const SkeletonData& data = *instance.data;
+
+    for (const SkeletonSlot& slot : data.slots) {
+        const AtlasRegion& r = data.regions[static_cast<size_t>(slot.region)];
+        XMMATRIX m = XMMatrixMultiply(
+            LocalMatrix(slot.x, slot.y, slot.rotation, slot.scaleX, slot.scaleY),
+            instance.world[static_cast<size_t>(slot.bone)]);
+
+        float hw = r.width * 0.5f;
+        float hh = r.height * 0.5f;
+        const float corners[4][2] = { { -hw, -hh }, { hw, -hh }, { hw, hh }, { -hw, hh } };
+
+        SpriteQuad q{};
+        for (int c = 0; c < 4; c++) {
+            XMStoreFloat2(&q.pos[c], XMVector2Transform(XMVectorSet(corners[c][0], corners[c][1], 0.0f, 0.0f), m));
+        }
+        q.uv[0] = { r.u0, r.v0 };
+        q.uv[1] = { r.u1, r.v0 };
+        q.uv[2] = { r.u1, r.v1 };
+        q.uv[3] = { r.u0, r.v1 };
+        q.color = slot.color;
+        q.depth = instance.depth;
+
+        // 反転で巻き順が逆になるとカリングされるので、1 と 3 を入れ替えて時計回りに戻す
+        float cross = (q.pos[1].x - q.pos[0].x) * (q.pos[2].y - q.pos[0].y)
+            - (q.pos[1].y - q.pos[0].y) * (q.pos[2].x - q.pos[0].x);
+        if (cross < 0.0f) {
+            std::swap(q.pos[1], q.pos[3]);
+            std::swap(q.uv[1], q.uv[3]);
+        }
+        out->push_back(q);
+    }
+    return data.slots.size();
+}
@@ -0,0 +1,139 @@
+﻿/**********************************************************************************
+    Skeleton2D.h
+
+                                                                LI WENHUI
+                                                                2025/08/15
+
+**********************************************************************************/
+
+#ifndef SKELETON2D_H
+#define SKELETON2D_H
+
+#include "SpriteQuad.h"
+#include "SpritePass.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ID3D11ShaderResourceView;
+
+/*
+    2D スケルタルアニメーション
+    フレームごとの全身画像の代わりに、アトラス上のパーツ（リージョン）をボーンに
+    貼り付けて動かす。テクスチャはパーツ分だけで済む。
+*/
+
+// ボーンの初期姿勢（親からの相対）。bones は必ず親が先に並ぶ
+struct SkeletonBone {
+    std::string name;
+    int parent;         // -1 = ルート
+    float x, y;
+    float rotation;     // 度
+    float scaleX, scaleY;
+};
+
+// アニメーション中に変わる部分だけ（毎フレーム初期姿勢から写すので、名前の文字列は持たない）
+struct BonePose {
+    float x, y;
+    float rotation;
+    float scaleX, scaleY;
+};
+
+struct AtlasRegion {
+    std::string name;
+    float u0, v0, u1, v1;
+    float width, height;    // ピクセル
+};
+
+// スロット = 描画順に並んだ貼り付け先。attachment はボーン空間での配置
+struct SkeletonSlot {
+    std::string name;
+    int bone;
+    int region;
+    float x, y, rotation, scaleX, scaleY;
+    DirectX::XMFLOAT4 color;
+};
+
+enum class CurveType : uint8_t {
+    Linear,
+    Stepped,
+    Bezier
+};
+
+enum class BoneChannel : uint8_t {
+    Translate,
+    Rotate,
+    Scale
+};
+
+struct BoneKey {
+    float time;
+    float value[2];     // Rotate は value[0] のみ使う
+    CurveType curve;    // このキーから次のキーまでの補間
+    float cx1, cy1, cx2, cy2;
+};
+
+struct BoneTimeline {
+    int bone;
+    BoneChannel channel;
+    std::vector<BoneKey> keys;
+};
+
+struct SkeletonAnimation {
+    std::string name;
+    float duration;
+    std::vector<BoneTimeline> timelines;
+};
+
+struct SkeletonData {
+    std::wstring atlasPath;
+    float atlasWidth = 1.0f;
+    float atlasHeight = 1.0f;
+    ID3D11ShaderResourceView* atlasSrv = nullptr;   // GPU 側でロードしたときだけ設定される
+    int atlasTexture = -1;                          // TextureStreamer に預けたときの番号（このときは atlasSrv を使わない）
+    SpriteAlphaMode atlasAlphaMode = SpriteAlphaMode::Blended;
+
+    std::vector<SkeletonBone> bones;
+    std::vector<BonePose> setupPose;                // bones の初期姿勢だけを並べたもの
+    std::vector<AtlasRegion> regions;
+    std::vector<SkeletonSlot> slots;
+    std::vector<SkeletonAnimation> animations;
+
+    int FindBone(const char* name) const;
+    int FindAnimation(const char* name) const;
+};
+
+//
+// 1 体分の再生状態とワールド行列
+struct SkeletonInstance {
+    const SkeletonData* data = nullptr;
+    int animation = -1;
+    float time = 0.0f;
+    float x = 0.0f, y = 0.0f;
+    float scale = 1.0f;
+    float depth = 0.0f;
+    bool flipX = false;
+
+    std::vector<BonePose> local;                // サンプリング後の相対姿勢
+    std::vector<DirectX::XMMATRIX> world;       // ボーンのワールド行列
+};
+
+bool LoadSkeletonData(const wchar_t* path, SkeletonData* outData, std::string* error = nullptr);
+bool ParseSkeletonData(const std::string& source, SkeletonData* outData, std::string* error = nullptr);
+
+void InitSkeletonInstance(const SkeletonData* data, SkeletonInstance* instance);
+
+//
+// アニメーションを進めてボーンのワールド行列を計算する
+void UpdateSkeletons(SkeletonInstance* instances, size_t count, float deltaTime);
+
+//
+// スロットの描画順に四角形を出力する。戻り値は出力した数
+size_t BuildSkeletonQuads(const SkeletonInstance& instance, std::vector<SpriteQuad>* out);
+
+// ベジェ曲線（0..1 に正規化した制御点）の値を求める
+float SampleBezierCurve(float t, float cx1, float cy1, float cx2, float cy2);
+
+
+#endif
@@ -0,0 +1,208 @@
+﻿/**********************************************************************************
+    SpriteBatch.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/15
+
+**********************************************************************************/
+
+#include "SpriteBatch.h"
+#include "BufferUtils.h"
+#include "ConstantBuffer.h"
+#include "Profiler.h"
+#include "ResourceRegistry.h"
+
+SpriteBatch::SpriteBatch()
+    : context(nullptr),
+    vertexBuffer(nullptr),
+    indexBuffer(nullptr),
+    meshIndexBuffer(nullptr),
+    constantBuffer(nullptr),
+    whiteSrv(nullptr),
+    currentSrv(nullptr),
+    maxQuads(0),
+    drawCalls(0),
+    meshMode(false)
+{
+
+}
+
+SpriteBatch::~SpriteBatch() {
+    Release();
+}
+
+void SpriteBatch::Release() {
+    SAFE_RELEASE(vertexBuffer);
+    SAFE_RELEASE(indexBuffer);
+    SAFE_RELEASE(meshIndexBuffer);
+    SAFE_RELEASE(constantBuffer);
+    SAFE_RELEASE(whiteSrv);
+    vertices.clear();
+    meshIndices.clear();
+}
+
+bool SpriteBatch::Init(ID3D11Device* device, ID3D11DeviceContext* context, size_t maxQuads) {
+    this->maxQuads = maxQuads;
+    vertices.reserve(maxQuads * 4);
+
+    vertexBuffer = CreateDynamicVertexBuffer(device, maxQuads * 4, "SpriteBatch");
+    indexBuffer = CreateDynamicIndexBuffer(device, maxQuads * 6, "SpriteBatch");
+    meshIndexBuffer = CreateDynamicIndexBuffer(device, maxQuads * 6, "SpriteBatch");
+    if (!vertexBuffer || !indexBuffer || !meshIndexBuffer) return false;
+    meshIndices.reserve(maxQuads * 6);
+
+    // インデックスは四角形ごとに同じ並びなので最初に一度だけ書き込む
+    D3D11_MAPPED_SUBRESOURCE m{};
+    if (FAILED(context->Map(indexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) return false;
+    UINT* indices = static_cast<UINT*>(m.pData);
+    for (size_t q = 0; q < maxQuads; q++) {
+        UINT base = static_cast<UINT>(q * 4);
+        indices[q * 6 + 0] = base + 0;
+        indices[q * 6 + 1] = base + 1;
+        indices[q * 6 + 2] = base + 2;
+        indices[q * 6 + 3] = base + 0;
+        indices[q * 6 + 4] = base + 2;
+        indices[q * 6 + 5] = base + 3;
+    }
+    context->Unmap(indexBuffer, 0);
+
+    D3D11_BUFFER_DESC cbd = {};
+    cbd.Usage = D3D11_USAGE_DYNAMIC;
+    cbd.ByteWidth = sizeof(ConstantBuffer);
+    cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    if (FAILED(device->CreateBuffer(&cbd, nullptr, &constantBuffer))) return false;
+    TrackBuffer(constantBuffer, "SpriteBatch");
+
+    // 1x1 の白テクスチャ
+    const UINT white = 0xffffffff;
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width = 1;
+    td.Height = 1;
+    td.MipLevels = 1;
+    td.ArraySize = 1;
+    td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_IMMUTABLE;
+    td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    D3D11_SUBRESOURCE_DATA init = { &white, sizeof(UINT), 0 };
+    ID3D11Texture2D* whiteTex = nullptr;
+    if (FAILED(device->CreateTexture2D(&td, &init, &whiteTex))) return false;
+    HRESULT hr = device->CreateShaderResourceView(whiteTex, nullptr, &whiteSrv);
+    whiteTex->Release();
+    TrackShaderResourceView(whiteSrv, "SpriteBatch", "white");
+    return SUCCEEDED(hr);
+}
+
+void SpriteBatch::Begin(ID3D11DeviceContext* context, const DirectX::XMMATRIX& view,
+    const DirectX::XMMATRIX& projection) {
+    this->context = context;
+    currentSrv = nullptr;
+    drawCalls = 0;
+    vertices.clear();
+    meshIndices.clear();
+    meshMode = false;
+
+    // 頂点はワールド座標で完成しているので model は単位行列、UV 変換もなし
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (SUCCEEDED(context->Map(constantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+        ConstantBuffer* cb = (ConstantBuffer*)mapped.pData;
+        cb->model = DirectX::XMMatrixIdentity();
+        cb->view = DirectX::XMMatrixTranspose(view);
+        cb->projection = DirectX::XMMatrixTranspose(projection);
+        cb->texOffset[0] = 0.0f;
+        cb->texOffset[1] = 0.0f;
+        cb->texScale[0] = 1.0f;
+        cb->texScale[1] = 1.0f;
+        cb->uFlipX = 0;
+        cb->alpha = 1.0f;
+        context->Unmap(constantBuffer, 0);
+    }
+}
+
+void SpriteBatch::Draw(ID3D11ShaderResourceView* srv, const SpriteQuad* quads, size_t count) {
+    if (!srv) srv = whiteSrv;
+    if (srv != currentSrv || meshMode) {
+        Flush();
+        currentSrv = srv;
+        meshMode = false;
+    }
+
+    // バッファに入るだけまとめて展開し、いっぱいになったら流す
+    while (count > 0) {
+        size_t room = maxQuads - vertices.size() / 4;
+        if (room == 0) {
+            Flush();
+            if (!vertices.empty() || maxQuads == 0) return;     // Init / Begin の前などで流せないときは捨てる
+            continue;
+        }
+        size_t n = count < room ? count : room;
+        AppendSpriteVertices(quads, n, &vertices);
+        quads += n;
+        count -= n;
+    }
+}
+
+void SpriteBatch::DrawMesh(ID3D11ShaderResourceView* srv, const SpriteMesh& mesh, const SpriteQuad& quad) {
+    if (mesh.IsEmpty()) return;         // 全部透明なフレーム
+    if (!srv) srv = whiteSrv;
+    if (srv != currentSrv || !meshMode) {
+        Flush();
+        currentSrv = srv;
+        meshMode = true;
+    }
+
+    // 頂点とインデックスのどちらかが入りきらなければ先に流す（大きさは四角形のときと同じ）
+    if (vertices.size() + mesh.points.size() > maxQuads * 4 || meshIndices.size() + mesh.indices.size() > maxQuads * 6) {
+        Flush();
+        if (!vertices.empty() || mesh.points.size() > maxQuads * 4 || mesh.indices.size() > maxQuads * 6) return;
+    }
+    AppendSpriteMeshVertices(mesh, quad, false, &vertices, &meshIndices);
+}
+
+void SpriteBatch::End() {
+    Flush();
+    context = nullptr;
+}
+
+void SpriteBatch::Flush() {
+    PROFILE_ZONE("SpriteBatch::Flush");
+    if (vertices.empty() || !context) return;
+
+    D3D11_MAPPED_SUBRESOURCE m{};
+    if (SUCCEEDED(context->Map(vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) {
+        memcpy(m.pData, vertices.data(), vertices.size() * sizeof(Vertex));
+        context->Unmap(vertexBuffer, 0);
+    }
+
+    UINT indexCount = static_cast<UINT>(vertices.size() / 4 * 6);
+    if (meshMode) {
+        if (SUCCEEDED(context->Map(meshIndexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &m))) {
+            memcpy(m.pData, meshIndices.data(), meshIndices.size() * sizeof(uint32_t));
+            context->Unmap(meshIndexBuffer, 0);
+        }
+        indexCount = static_cast<UINT>(meshIndices.size());
+    }
+
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+    context->IASetIndexBuffer(meshMode ? meshIndexBuffer : indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    context->VSSetConstantBuffers(0, 1, &constantBuffer);
+    context->PSSetConstantBuffers(0, 1, &constantBuffer);
+    context->PSSetShaderResources(0, 1, &currentSrv);
+    ResourceTouch(currentSrv);
+
+    context->DrawIndexed(indexCount, 0, 0);
+    drawCalls++;
+    vertices.clear();
+    meshIndices.clear();
+}
+
+ID3D11ShaderResourceView* SpriteBatch::GetWhiteTexture() const {
+    return whiteSrv;
+}
+
+UINT SpriteBatch::GetDrawCallCount() const {
+    return drawCalls;
+}
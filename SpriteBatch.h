@@ -0,0 +1,60 @@
+﻿/**********************************************************************************
+    SpriteBatch.h
+
+                                                                LI WENHUI
+                                                                2025/08/15
+
+**********************************************************************************/
+
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include "d3dApp.h"
+#include "SpriteMesh.h"
+#include "SpriteQuad.h"
+#include "Vertex.h"
+#include <vector>
+
+//
+// 同じテクスチャが続く間は頂点を CPU 側にためて、まとめて 1 回の DrawIndexed で描く
+// ブレンドステートと深度ステートは呼び出し側で設定する
+class SpriteBatch {
+public:
+    SpriteBatch();
+    ~SpriteBatch();
+
+    bool Init(ID3D11Device* device, ID3D11DeviceContext* context, size_t maxQuads);
+    void Release();
+
+    void Begin(ID3D11DeviceContext* context, const DirectX::XMMATRIX& view,
+        const DirectX::XMMATRIX& projection);
+    void Draw(ID3D11ShaderResourceView* srv, const SpriteQuad* quads, size_t count);
+    // 四角形の代わりに、絵のある部分だけの多角形（SpriteMesh）で描く。透明な余白を塗らない
+    void DrawMesh(ID3D11ShaderResourceView* srv, const SpriteMesh& mesh, const SpriteQuad& quad);
+    void End();
+
+    // テクスチャなしの矩形（パーティクルや塗りつぶし）用の 1x1 白テクスチャ
+    ID3D11ShaderResourceView* GetWhiteTexture() const;
+
+    UINT GetDrawCallCount() const;
+
+private:
+    void Flush();
+
+    ID3D11DeviceContext* context;
+    ID3D11Buffer* vertexBuffer;
+    ID3D11Buffer* indexBuffer;
+    ID3D11Buffer* meshIndexBuffer;      // 多角形用。毎回書き換える
+    ID3D11Buffer* constantBuffer;
+    ID3D11ShaderResourceView* whiteSrv;
+    ID3D11ShaderResourceView* currentSrv;
+
+    size_t maxQuads;
+    UINT drawCalls;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> meshIndices;
+    bool meshMode;                      // 今ためているのが多角形か
+};
+
+
+#endif
@@ -0,0 +1,258 @@
+﻿/**********************************************************************************
+    SpriteMesh.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/07
+
+**********************************************************************************/
+
+#include "SpriteMesh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    struct Point {
+        float x, y;
+    };
+
+    float Cross(const Point& o, const Point& a, const Point& b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    float Area(const std::vector<Point>& polygon) {
+        float area = 0.0f;
+        for (size_t i = 0; i < polygon.size(); i++) {
+            const Point& a = polygon[i];
+            const Point& b = polygon[(i + 1) % polygon.size()];
+            area += a.x * b.y - b.x * a.y;
+        }
+        return area * 0.5f;
+    }
+
+    // Andrew の単調連鎖。面積が正になる向き（y 下向きの画面では時計回り）で返す
+    std::vector<Point> ConvexHull(std::vector<Point> points) {
+        std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+            return a.x != b.x ? a.x < b.x : a.y < b.y;
+        });
+        points.erase(std::unique(points.begin(), points.end(), [](const Point& a, const Point& b) {
+            return a.x == b.x && a.y == b.y;
+        }), points.end());
+        if (points.size() < 3) return points;
+
+        std::vector<Point> hull(points.size() * 2);
+        size_t k = 0;
+        for (size_t i = 0; i < points.size(); i++) {
+            while (k >= 2 && Cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0f) k--;
+            hull[k++] = points[i];
+        }
+        for (size_t i = points.size() - 1, lower = k + 1; i > 0; i--) {
+            while (k >= lower && Cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0f) k--;
+            hull[k++] = points[i - 1];
+        }
+        hull.resize(k - 1);
+        return hull;
+    }
+
+    // 辺 i -> i+1 を消して、前後の辺を延ばした交点に置き換える。増える面積を返す（できなければ負）
+    float CollapseCost(const std::vector<Point>& polygon, size_t i, Point* out) {
+        size_t n = polygon.size();
+        const Point& a = polygon[(i + n - 1) % n];
+        const Point& b = polygon[i];
+        const Point& c = polygon[(i + 1) % n];
+        const Point& d = polygon[(i + 2) % n];
+        float d0x = b.x - a.x, d0y = b.y - a.y;
+        float d1x = c.x - d.x, d1y = c.y - d.y;
+        float denominator = d0x * d1y - d0y * d1x;
+        if (std::fabs(denominator) < 1e-6f) return -1.0f;
+        // b + d0 * t = c + d1 * u（t, u とも正なら両方の辺の先で交わる）
+        float t = ((c.x - b.x) * d1y - (c.y - b.y) * d1x) / denominator;
+        float u = ((c.x - b.x) * d0y - (c.y - b.y) * d0x) / denominator;
+        if (t <= 0.0f || u <= 0.0f) return -1.0f;
+        *out = { b.x + d0x * t, b.y + d0y * t };
+        return std::fabs(Cross(b, *out, c)) * 0.5f;
+    }
+
+    // Sutherland-Hodgman で矩形に切る。凸多角形なので凸のまま
+    std::vector<Point> ClipToRect(const std::vector<Point>& polygon, float width, float height) {
+        std::vector<Point> result = polygon;
+        for (int edge = 0; edge < 4; edge++) {
+            auto inside = [&](const Point& p) {
+                switch (edge) {
+                case 0: return p.x >= 0.0f;
+                case 1: return p.x <= width;
+                case 2: return p.y >= 0.0f;
+                default: return p.y <= height;
+                }
+            };
+            auto intersect = [&](const Point& p, const Point& q) {
+                float t;
+                switch (edge) {
+                case 0: t = (0.0f - p.x) / (q.x - p.x); break;
+                case 1: t = (width - p.x) / (q.x - p.x); break;
+                case 2: t = (0.0f - p.y) / (q.y - p.y); break;
+                default: t = (height - p.y) / (q.y - p.y); break;
+                }
+                return Point{ p.x + (q.x - p.x) * t, p.y + (q.y - p.y) * t };
+            };
+            std::vector<Point> input;
+            input.swap(result);
+            for (size_t i = 0; i < input.size(); i++) {
+                const Point& p = input[i];
+                const Point& q = input[(i + 1) % input.size()];
+                if (inside(p)) {
+                    result.push_back(p);
+                    if (!inside(q)) result.push_back(intersect(p, q));
+                }
+                else if (inside(q)) {
+                    result.push_back(intersect(p, q));
+                }
+            }
+            if (result.empty()) break;
+        }
+        return result;
+    }
+
+    DirectX::XMFLOAT2 Bilinear(const DirectX::XMFLOAT2* corners, float s, float t) {
+        float topX = corners[0].x + (corners[1].x - corners[0].x) * s;
+        float topY = corners[0].y + (corners[1].y - corners[0].y) * s;
+        float bottomX = corners[3].x + (corners[2].x - corners[3].x) * s;
+        float bottomY = corners[3].y + (corners[2].y - corners[3].y) * s;
+        return { topX + (bottomX - topX) * t, topY + (bottomY - topY) * t };
+    }
+}
+
+
+void BuildSpriteMesh(const uint8_t* pixels, size_t rowPitch, int x, int y, int width, int height,
+    const SpriteMeshOptions& options, SpriteMesh* out) {
+    out->points.clear();
+    out->indices.clear();
+    out->coverage = 0.0f;
+    if (width <= 0 || height <= 0) return;
+
+    // 行ごとに絵のある左右の端を取り、ピクセルの角を凸包の候補にする
+    std::vector<Point> candidates;
+    int top = height, bottom = -1;
+    float minX = static_cast<float>(width), maxX = 0.0f;
+    const float pad = static_cast<float>(options.padding);
+    for (int row = 0; row < height; row++) {
+        const uint8_t* p = pixels + static_cast<size_t>(y + row) * rowPitch + static_cast<size_t>(x) * 4 + 3;
+        int left = -1, right = -1;
+        for (int col = 0; col < width; col++) {
+            if (p[static_cast<size_t>(col) * 4] > options.alphaThreshold) {
+                if (left < 0) left = col;
+                right = col;
+            }
+        }
+        if (left < 0) continue;
+        float x0 = static_cast<float>(left) - pad, x1 = static_cast<float>(right + 1) + pad;
+        float y0 = static_cast<float>(row) - pad, y1 = static_cast<float>(row + 1) + pad;
+        candidates.push_back({ x0, y0 });
+        candidates.push_back({ x1, y0 });
+        candidates.push_back({ x0, y1 });
+        candidates.push_back({ x1, y1 });
+        top = std::min(top, row);
+        bottom = std::max(bottom, row);
+        minX = std::min(minX, x0);
+        maxX = std::max(maxX, x1);
+    }
+    if (bottom < 0) return;
+
+    const float w = static_cast<float>(width), h = static_cast<float>(height);
+    const int maxVertices = std::max(options.maxVertices, 4);
+
+    // 候補は絵のある範囲の外接矩形。凸包を縮めた形のほうが安ければそちらを使う
+    std::vector<Point> best = ClipToRect({
+        { minX, static_cast<float>(top) - pad }, { maxX, static_cast<float>(top) - pad },
+        { maxX, static_cast<float>(bottom + 1) + pad }, { minX, static_cast<float>(bottom + 1) + pad } }, w, h);
+    float bestCost = Area(best) + options.vertexCostPixels * static_cast<float>(best.size());
+
+    // 増える面積が一番小さい辺から潰していき、途中のどの形も候補にする
+    std::vector<Point> polygon = ConvexHull(std::move(candidates));
+    while (polygon.size() >= 3) {
+        if (static_cast<int>(polygon.size()) <= maxVertices) {
+            std::vector<Point> clipped = ClipToRect(polygon, w, h);
+            if (clipped.size() >= 3 && static_cast<int>(clipped.size()) <= maxVertices) {
+                float cost = Area(clipped) + options.vertexCostPixels * static_cast<float>(clipped.size());
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = clipped;
+                }
+            }
+        }
+        if (polygon.size() == 3) break;
+
+        size_t bestEdge = polygon.size();
+        float bestAdded = std::numeric_limits<float>::max();
+        Point bestPoint = {};
+        for (size_t i = 0; i < polygon.size(); i++) {
+            Point p;
+            float added = CollapseCost(polygon, i, &p);
+            if (added >= 0.0f && added < bestAdded) {
+                bestAdded = added;
+                bestEdge = i;
+                bestPoint = p;
+            }
+        }
+        if (bestEdge == polygon.size()) break;
+
+        // i と i+1 を交点 1 つに置き換える
+        size_t next = (bestEdge + 1) % polygon.size();
+        polygon[bestEdge] = bestPoint;
+        polygon.erase(polygon.begin() + static_cast<std::ptrdiff_t>(next));
+    }
+
+    out->points.reserve(best.size());
+    for (const Point& p : best) out->points.push_back({ p.x / w, p.y / h });
+    for (size_t i = 1; i + 1 < best.size(); i++) {
+        out->indices.push_back(0);
+        out->indices.push_back(static_cast<uint16_t>(i));
+        out->indices.push_back(static_cast<uint16_t>(i + 1));
+    }
+    out->coverage = Area(best) / (w * h);
+}
+
+void BuildSpriteMeshes(const uint8_t* pixels, int width, int height, size_t rowPitch,
+    int columns, int rows, int frames, const SpriteMeshOptions& options, std::vector<SpriteMesh>* out) {
+    out->clear();
+    if (columns <= 0 || rows <= 0) return;
+    int frameW = width / columns;
+    int frameH = height / rows;
+    int count = std::min(frames, columns * rows);
+    out->resize(static_cast<size_t>(std::max(count, 0)));
+    for (int f = 0; f < count; f++) {
+        BuildSpriteMesh(pixels, rowPitch, (f % columns) * frameW, (f / columns) * frameH, frameW, frameH,
+            options, &(*out)[static_cast<size_t>(f)]);
+    }
+}
+
+void AppendSpriteMeshVertices(const SpriteMesh& mesh, const SpriteQuad& quad, bool flipX,
+    std::vector<Vertex>* vertices, std::vector<uint32_t>* indices) {
+    if (mesh.IsEmpty()) return;
+
+    // UV が逆向きの四角形は、テクスチャ上の点を反対側の位置に置く
+    bool mirrorX = (quad.uv[1].x < quad.uv[0].x) != flipX;
+    bool mirrorY = quad.uv[3].y < quad.uv[0].y;
+    size_t base = vertices->size();
+    vertices->resize(base + mesh.points.size());
+    Vertex* v = vertices->data() + base;
+    for (const DirectX::XMFLOAT2& p : mesh.points) {
+        float s = mirrorX ? 1.0f - p.x : p.x;
+        float t = mirrorY ? 1.0f - p.y : p.y;
+        DirectX::XMFLOAT2 pos = Bilinear(quad.pos, s, t);
+        *v++ = { { pos.x, pos.y, quad.depth }, quad.color, Bilinear(quad.uv, s, t) };
+    }
+
+    // 片方だけ裏返したときは三角形の向きも逆になるので、カリングされないように並びを戻す
+    bool reverse = mirrorX != mirrorY;
+    size_t first = indices->size();
+    size_t triangles = mesh.indices.size() / 3;
+    indices->resize(first + triangles * 3);
+    uint32_t* out = indices->data() + first;
+    for (size_t i = 0; i < triangles * 3; i += 3) {
+        *out++ = static_cast<uint32_t>(base) + mesh.indices[i];
+        *out++ = static_cast<uint32_t>(base) + mesh.indices[reverse ? i + 2 : i + 1];
+        *out++ = static_cast<uint32_t>(base) + mesh.indices[reverse ? i + 1 : i + 2];
+    }
+}
@@ -0,0 +1,56 @@
+﻿/**********************************************************************************
+    SpriteMesh.h
+
+                                                                LI WENHUI
+                                                                2025/09/07
+
+**********************************************************************************/
+
+#ifndef SPRITEMESH_H
+#define SPRITEMESH_H
+
+#include "SpriteQuad.h"
+#include "Vertex.h"
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// スプライト 1 フレーム分の、絵のある部分だけを囲む凸多角形
+// 四角形のままだと透明な余白も塗ってブレンドするので、その分のフィルを減らす
+// 点はフレーム内の 0..1（左上が 0）。向きは四角形の 左上→右上→右下 と同じ
+struct SpriteMesh {
+    std::vector<DirectX::XMFLOAT2> points;
+    std::vector<uint16_t> indices;      // 三角形リスト（扇形）
+    float coverage = 1.0f;              // フレームの面積に対する多角形の面積
+
+    bool IsEmpty() const { return points.size() < 3; }
+};
+
+struct SpriteMeshOptions {
+    int maxVertices = 8;
+    // 頂点 1 つを何ピクセルの塗りと同じとみなすか。大きいほど頂点の少ない形を選ぶ
+    float vertexCostPixels = 48.0f;
+    // バイリニアでにじむ分、絵の外側に広げるピクセル数
+    int padding = 1;
+    uint8_t alphaThreshold = 0;         // これより大きいアルファを絵とみなす
+};
+
+// RGBA8 / BGRA8（アルファは 4 バイト目）の矩形から作る。全部透明なら点は空
+void BuildSpriteMesh(const uint8_t* pixels, size_t rowPitch, int x, int y, int width, int height,
+    const SpriteMeshOptions& options, SpriteMesh* out);
+
+// columns x rows に割ったシートの、先頭から frames 枚分（BuildCollisionMasks と同じ割り方）
+void BuildSpriteMeshes(const uint8_t* pixels, int width, int height, size_t rowPitch,
+    int columns, int rows, int frames, const SpriteMeshOptions& options, std::vector<SpriteMesh>* out);
+
+//
+// quad の 4 隅を補間して mesh の頂点を作り、vertices と indices の後ろに足す
+// quad の UV が左右（上下）逆なら多角形も裏返す。flipX はシェーダーの uFlipX で反転するとき
+// 空のメッシュは何も足さない
+void AppendSpriteMeshVertices(const SpriteMesh& mesh, const SpriteQuad& quad, bool flipX,
+    std::vector<Vertex>* vertices, std::vector<uint32_t>* indices);
+
+
+#endif
@@ -0,0 +1,150 @@
+﻿/**********************************************************************************
+    SpritePass.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/06
+
+**********************************************************************************/
+
+#include "SpritePass.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    const char* const kModeNames[] = { "opaque", "alphaTested", "blended" };
+
+    // 深度を 24 ビットに丸める（範囲外は端に寄せる）
+    uint64_t QuantizeDepth(float depth) {
+        float d = std::clamp(depth, 0.0f, 1.0f);
+        return static_cast<uint64_t>(d * 16777215.0f);
+    }
+
+    struct PixelRect {
+        int x0, y0, x1, y1;     // x1, y1 は含まない
+    };
+
+    // ピクセルの中心が入るものを塗る（D3D の塗りつぶし規則とほぼ同じ）
+    bool ToPixelRect(const SpriteQuad& q, float left, float top, float scaleX, float scaleY, int resolutionX, int resolutionY,
+        PixelRect* out) {
+        float minX = q.pos[0].x, maxX = q.pos[0].x, minY = q.pos[0].y, maxY = q.pos[0].y;
+        for (int c = 1; c < 4; c++) {
+            minX = std::min(minX, q.pos[c].x);
+            maxX = std::max(maxX, q.pos[c].x);
+            minY = std::min(minY, q.pos[c].y);
+            maxY = std::max(maxY, q.pos[c].y);
+        }
+        out->x0 = std::max(0, static_cast<int>(std::ceil((minX - left) * scaleX - 0.5f)));
+        out->y0 = std::max(0, static_cast<int>(std::ceil((minY - top) * scaleY - 0.5f)));
+        out->x1 = std::min(resolutionX, static_cast<int>(std::ceil((maxX - left) * scaleX - 0.5f)));
+        out->y1 = std::min(resolutionY, static_cast<int>(std::ceil((maxY - top) * scaleY - 0.5f)));
+        return out->x0 < out->x1 && out->y0 < out->y1;
+    }
+}
+
+
+const char* GetSpriteAlphaModeName(SpriteAlphaMode mode) {
+    return mode < SpriteAlphaMode::Count ? kModeNames[static_cast<int>(mode)] : "";
+}
+
+SpriteAlphaMode ClassifySpriteAlpha(const uint8_t* pixels, size_t rowPitch, int x, int y, int width, int height,
+    uint8_t tolerance) {
+    const uint8_t high = static_cast<uint8_t>(255 - tolerance);
+    bool hasHole = false;
+    for (int row = 0; row < height; row++) {
+        const uint8_t* p = pixels + static_cast<size_t>(y + row) * rowPitch + static_cast<size_t>(x) * 4 + 3;
+        for (int col = 0; col < width; col++, p += 4) {
+            if (*p >= high) continue;
+            if (*p > tolerance) return SpriteAlphaMode::Blended;
+            hasHole = true;
+        }
+    }
+    return hasHole ? SpriteAlphaMode::AlphaTested : SpriteAlphaMode::Opaque;
+}
+
+void SpritePassQueue::Clear() {
+    quads.clear();
+    for (auto& pass : passes) pass.clear();
+}
+
+void SpritePassQueue::Add(void* texture, SpriteAlphaMode mode, uint8_t blend, const SpriteQuad* source, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        SpriteAlphaMode m = source[i].color.w < 1.0f ? SpriteAlphaMode::Blended : mode;
+        passes[static_cast<int>(m)].push_back({ texture, static_cast<uint32_t>(quads.size()), blend });
+        quads.push_back(source[i]);
+    }
+}
+
+void SpritePassQueue::Sort() {
+    PROFILE_ZONE("SpritePassQueue::Sort");
+    // 番号は足した順なので、深度が同じときの順番にそのまま使える
+    auto frontToBack = [this](const SpritePassItem& a, const SpritePassItem& b) {
+        uint64_t da = QuantizeDepth(quads[a.quad].depth), db = QuantizeDepth(quads[b.quad].depth);
+        return da != db ? da < db : a.quad > b.quad;
+    };
+    auto backToFront = [this](const SpritePassItem& a, const SpritePassItem& b) {
+        uint64_t da = QuantizeDepth(quads[a.quad].depth), db = QuantizeDepth(quads[b.quad].depth);
+        return da != db ? da > db : a.quad < b.quad;
+    };
+    std::sort(passes[0].begin(), passes[0].end(), frontToBack);
+    std::sort(passes[1].begin(), passes[1].end(), frontToBack);
+    std::sort(passes[2].begin(), passes[2].end(), backToFront);
+}
+
+const std::vector<SpritePassItem>& SpritePassQueue::GetPass(SpriteAlphaMode mode) const {
+    return passes[static_cast<int>(mode)];
+}
+
+const std::vector<SpriteQuad>& SpritePassQueue::GetQuads() const {
+    return quads;
+}
+
+void MeasureOverdraw(const SpritePassQueue& queue, bool usePasses, float left, float top, float width, float height,
+    int resolutionX, int resolutionY, OverdrawStats* out) {
+    PROFILE_ZONE("MeasureOverdraw");
+    *out = OverdrawStats();
+    if (resolutionX <= 0 || resolutionY <= 0 || width <= 0.0f || height <= 0.0f) return;
+
+    const float scaleX = static_cast<float>(resolutionX) / width;
+    const float scaleY = static_cast<float>(resolutionY) / height;
+    const size_t pixelCount = static_cast<size_t>(resolutionX) * static_cast<size_t>(resolutionY);
+    std::vector<float> depth(pixelCount, 1.0f);
+    std::vector<uint8_t> touched(pixelCount, 0);
+    const std::vector<SpriteQuad>& quads = queue.GetQuads();
+
+    // writeDepth なら LESS で書き込み、そうでなければ LESS_EQUAL で読むだけ（d3dApp の深度ステートと同じ）
+    auto fill = [&](const SpriteQuad& q, bool depthTest, bool writeDepth) {
+        PixelRect r;
+        if (!ToPixelRect(q, left, top, scaleX, scaleY, resolutionX, resolutionY, &r)) return;
+        for (int y = r.y0; y < r.y1; y++) {
+            size_t row = static_cast<size_t>(y) * static_cast<size_t>(resolutionX);
+            for (int x = r.x0; x < r.x1; x++) {
+                size_t p = row + static_cast<size_t>(x);
+                bool pass = !depthTest || (writeDepth ? q.depth < depth[p] : q.depth <= depth[p]);
+                if (!pass) {
+                    out->rejected++;
+                    continue;
+                }
+                out->shaded++;
+                touched[p] = 1;
+                if (writeDepth) depth[p] = q.depth;
+            }
+        }
+    };
+
+    if (usePasses) {
+        for (int m = 0; m < static_cast<int>(SpriteAlphaMode::Count); m++) {
+            bool writeDepth = m != static_cast<int>(SpriteAlphaMode::Blended);
+            for (const SpritePassItem& item : queue.GetPass(static_cast<SpriteAlphaMode>(m))) {
+                fill(quads[item.quad], true, writeDepth);
+            }
+        }
+    }
+    else {
+        for (const SpriteQuad& q : quads) fill(q, false, false);
+    }
+
+    out->pixels = pixelCount;
+    for (uint8_t t : touched) out->covered += t;
+}
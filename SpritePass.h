@@ -0,0 +1,80 @@
+﻿/**********************************************************************************
+    SpritePass.h
+
+                                                                LI WENHUI
+                                                                2025/09/06
+
+**********************************************************************************/
+
+#ifndef SPRITEPASS_H
+#define SPRITEPASS_H
+
+#include "SpriteQuad.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// スプライトのアルファの使い方。読み込むときにピクセルから決める
+//   Opaque      : 全部不透明。ブレンドなし、深度を書いて手前から描く
+//   AlphaTested : 0 か 255 だけ。抜けを clip して、あとは Opaque と同じ
+//   Blended     : 中間のアルファがある。深度は書かず、奥から手前に重ねる
+enum class SpriteAlphaMode : uint8_t {
+    Opaque,
+    AlphaTested,
+    Blended,
+    Count
+};
+
+const char* GetSpriteAlphaModeName(SpriteAlphaMode mode);
+
+// RGBA8 / BGRA8（アルファは 4 バイト目）の矩形を調べる。tolerance 以内なら 0 / 255 とみなす
+SpriteAlphaMode ClassifySpriteAlpha(const uint8_t* pixels, size_t rowPitch, int x, int y, int width, int height,
+    uint8_t tolerance = 8);
+
+//
+// 1 フレーム分のスプライトをパスごとに分けて並べる
+// 不透明とアルファテストは手前から奥へ（同じ深度なら後から足したものを先に。深度テスト LESS で
+// 後から描いたものが上になるのと同じ結果になる）。半透明は奥から手前へ、同じ深度なら足した順
+// 深度は 0 が手前、1 が奥（正射影の near / far）
+struct SpritePassItem {
+    void* texture;          // SRV。nullptr なら白テクスチャ
+    uint32_t quad;          // GetQuads() の番号
+    uint8_t blend;          // 半透明パスのブレンド（ParticleBlend と同じ並び）
+};
+
+class SpritePassQueue {
+public:
+    void Clear();
+
+    // 四角形はコピーする。頂点カラーのアルファが 1 未満のものは mode によらず半透明へ
+    void Add(void* texture, SpriteAlphaMode mode, uint8_t blend, const SpriteQuad* quads, size_t count);
+    void Sort();
+
+    const std::vector<SpritePassItem>& GetPass(SpriteAlphaMode mode) const;
+    const std::vector<SpriteQuad>& GetQuads() const;
+
+private:
+    std::vector<SpriteQuad> quads;
+    std::vector<SpritePassItem> passes[static_cast<int>(SpriteAlphaMode::Count)];
+};
+
+//
+// CPU で塗って、ピクセルシェーダーが何回走るかを数える
+struct OverdrawStats {
+    uint64_t pixels = 0;        // 測った範囲のピクセル数
+    uint64_t covered = 0;       // 1 回以上塗られたピクセル
+    uint64_t shaded = 0;        // 深度テストを通った（シェーダーが走った）数
+    uint64_t rejected = 0;      // 深度テストで弾かれた数（early-Z で済む）
+
+    double GetOverdraw() const { return covered ? static_cast<double>(shaded) / static_cast<double>(covered) : 0.0; }
+};
+
+// (left, top) から width x height の範囲を resolutionX x resolutionY のグリッドで測る
+// usePasses が false なら、今までどおり全部を足した順に深度なしで重ねたときの数
+// 四角形は外接矩形で塗り、アルファテストの抜けも塗ったものとして数える（どちらも多めに出る）
+void MeasureOverdraw(const SpritePassQueue& queue, bool usePasses, float left, float top, float width, float height,
+    int resolutionX, int resolutionY, OverdrawStats* out);
+
+
+#endif
@@ -0,0 +1,56 @@
+﻿/**********************************************************************************
+    SpriteQuad.h
+
+                                                                LI WENHUI
+                                                                2025/08/15
+
+**********************************************************************************/
+
+#ifndef SPRITEQUAD_H
+#define SPRITEQUAD_H
+
+#include "Vertex.h"
+#include "Aabb.h"
+#include <DirectXMath.h>
+#include <vector>
+
+//
+// スプライトバッチに渡す 1 枚分の四角形（ワールド座標で完成済み）
+// D3D に依存しないので、スケルトンやパーティクルはヘッドレスでもこれを出力できる
+struct SpriteQuad {
+    DirectX::XMFLOAT2 pos[4];   // 左上, 右上, 右下, 左下
+    DirectX::XMFLOAT2 uv[4];
+    DirectX::XMFLOAT4 color;
+    float depth;
+};
+
+// 四角形を頂点 4 つずつに展開して out の後ろに足す（SpriteBatch の CPU 側の処理）
+inline void AppendSpriteVertices(const SpriteQuad* quads, size_t count, std::vector<Vertex>* out) {
+    size_t base = out->size();
+    out->resize(base + count * 4);
+    Vertex* v = out->data() + base;
+    for (size_t i = 0; i < count; i++) {
+        const SpriteQuad& q = quads[i];
+        for (int c = 0; c < 4; c++) {
+            *v++ = { { q.pos[c].x, q.pos[c].y, q.depth }, q.color, q.uv[c] };
+        }
+    }
+}
+
+// 四角形をまとめて囲む矩形（count は 1 以上）。画面外やほかの範囲との判定に使う
+inline Aabb GetSpriteQuadBounds(const SpriteQuad* quads, size_t count) {
+    Aabb bounds = { quads[0].pos[0].x, quads[0].pos[0].y, quads[0].pos[0].x, quads[0].pos[0].y };
+    for (size_t i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c++) {
+            const DirectX::XMFLOAT2& p = quads[i].pos[c];
+            if (p.x < bounds.minX) bounds.minX = p.x;
+            if (p.y < bounds.minY) bounds.minY = p.y;
+            if (p.x > bounds.maxX) bounds.maxX = p.x;
+            if (p.y > bounds.maxY) bounds.maxY = p.y;
+        }
+    }
+    return bounds;
+}
+
+
+#endif
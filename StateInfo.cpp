@@ -1,6 +1,25 @@
 ﻿
 #include "StateInfo.h"
 #include "PlayerObject.h"
+#include "AnimationGraph.h"
+#include "SpriteBatch.h"
+#include "Skeleton2D.h"
+#include "JobSystem.h"
+#include "ParticleSystem.h"
+#include "Lightmap2D.h"
+#include "LightingPass.h"
+#include "LayerCache.h"
+#include "LayerCachePass.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "TextRenderer.h"
+#include "TextureStreamer.h"
+#include "FieldOfView.h"
+#include "GameWorld.h"
+#include "CollisionMask.h"
+#include "InputSystem.h"
+#include "Replay.h"
+#include "Telemetry.h"
 
 StateInfo::~StateInfo() {
 	SAFE_RELEASE(blendStateNormal);
@@ -13,8 +13,34 @@
 #include <d3d11.h>//ID3D11Device
 #include <DirectXMath.h>
 #include <memory>
+#include <string>
+#include <vector>
+#include "Aabb.h"
 
 struct PlayerObject;
+struct AnimGraph;
+class SpriteBatch;
+struct SkeletonData;
+struct SkeletonInstance;
+class JobSystem;
+class ParticleSystem;
+class Lightmap2D;
+class LightingPass;
+class LayerCache;
+class LayerCachePass;
+class DynamicResolution;
+class ResizeCoalescer;
+class FramePacer;
+class TextRenderer;
+class TextureStreamer;
+struct Light2D;
+struct FovViewer;
+struct GameWorld;
+class ReplayRecorder;
+struct CollisionMask;
+class InputSystem;
+class KeyboardSource;
+class FrameTelemetry;
 
 #define SAFE_RELEASE(p) { if(p) { (p)->Release(); (p) = nullptr; } }
 
@@ -29,11 +55,14 @@ struct StateInfo {
     ID3D11InputLayout* inputLayout = nullptr;
     ID3D11VertexShader* vertexShader = nullptr;
     ID3D11PixelShader* pixelShader = nullptr; 
+    ID3D11PixelShader* pixelShaderAlphaTest = nullptr;     // 抜けを clip する（SpritePass の AlphaTested）
     ID3D11SamplerState* samplerState = nullptr;
     ID3D11DepthStencilState* depthStencilStateTransparent = nullptr;
+    ID3D11DepthStencilState* depthStencilStateOpaque = nullptr;    // 深度を書く（不透明・アルファテスト）
     ID3D11DepthStencilView* depthStencilView = nullptr;
 
 
+	ID3D11BlendState* blendStateOpaque = nullptr;      // ブレンドなし
 	ID3D11BlendState* blendStateNormal = nullptr;
 	ID3D11BlendState* blendStateAdditive = nullptr;
 	ID3D11BlendState* blendStateMultiply = nullptr;
@@ -41,6 +70,25 @@ struct StateInfo {
 
 
 
+    // シーンは倍率を掛けた解像度で描いてからバックバッファに引き伸ばす
+    // WM_SIZE はまとめて、最後の大きさで 1 回だけ作り直す
+    std::unique_ptr<DynamicResolution> dynamicResolution;
+    std::unique_ptr<ResizeCoalescer> resizeCoalescer;
+    float fixedRenderScale = 0.0f;      // -render-scale。0 なら GPU の時間から決める
+
+    // フレームの間隔。-fps があればその間隔まで待ち、最小化・非アクティブのときは落とす
+    std::unique_ptr<FramePacer> pacer;
+    UINT presentInterval = 1;           // -vsync 0 で 0
+    bool presentOccluded = false;       // 前の Present が「見えていない」と返した
+
+    // 画面の文字（スコアと距離、F3 でデバッグ表示）。グリフは最初に使ったときだけラスタライズする
+    std::unique_ptr<TextRenderer> text;
+    int hudFont = -1;
+    int debugFont = -1;
+    bool showDebugOverlay = false;
+    float distanceTravelled = 0.0f;     // プレイヤーが横に進んだ距離の合計（論理座標）
+    float playTime = 0.0f;
+
     //
     float logicalWidth = 1888.0f;
     float logicalHeight = 1062.0f;
@@ -50,8 +98,65 @@ struct StateInfo {
     DirectX::XMMATRIX projection = DirectX::XMMatrixIdentity();
 
 
+    // ファイルから読むテクスチャ（プレイヤーのシート、スケルトンのアトラス）。予算を超えたら長く使っていないものから追い出す
+    std::unique_ptr<TextureStreamer> textures;
+    uint64_t textureBudgetMb = 256;     // -texture-budget
+
+    std::unique_ptr<AnimGraph> playerAnimGraph;
     std::unique_ptr<PlayerObject> player;
 
+    std::unique_ptr<SpriteBatch> spriteBatch;
+
+    // スケルトンの共有データ（アトラス込み）と配置済みのインスタンス
+    std::vector<std::unique_ptr<SkeletonData>> skeletonData;
+    std::vector<SkeletonInstance> skeletons;
+
+    std::unique_ptr<JobSystem> jobs;
+    std::unique_ptr<ParticleSystem> particles;
+    int rainEmitter = -1;
+
+    // タイル・移動・追跡者などのシミュレーション。固定ステップで入力だけから進む
+    std::unique_ptr<GameWorld> world;
+
+    // 暗闇とライト。ライトマップは logicalWidth / lightmapScale の解像度
+    std::unique_ptr<Lightmap2D> lightmap;
+    std::unique_ptr<LightingPass> lightingPass;
+    std::vector<Light2D> lights;
+    std::vector<Aabb> occluders;        // 前から tileOccluderCount 個がタイル、その後ろがキャラクター
+    size_t tileOccluderCount = 0;
+    uint32_t occluderRevision = 0;
+    int flashlight = -1;
+    int lightmapScale = 8;
+
+    // めったに変わらない層はテクスチャに描いておいて貼るだけにする（今はタイル）
+    std::unique_ptr<LayerCache> layerCache;
+    std::unique_ptr<LayerCachePass> layerCachePass;
+    int tileLayer = -1;
+
+    // 視界。AI も含めた視点をまとめて更新し、プレイヤーの視界は暗闇のマスクに使う
+    std::vector<FovViewer> viewers;
+    int playerViewer = -1;
+
+    // 追跡者の当たりマスク（プレイヤーの絵と同じ縮尺の箱）。縮尺はクリップごとに違うので、変わったら作り直す
+    std::unique_ptr<CollisionMask> chaserMask;
+    float chaserMaskScaleX = 0.0f;
+    float chaserMaskScaleY = 0.0f;
+
+    // 入力。キーボードはウィンドウのメッセージから時刻つきで積み、シミュレーションの tick ごとに取り出す
+    std::unique_ptr<InputSystem> input;
+    std::unique_ptr<KeyboardSource> keyboard;
+    float inputLatencyMs = 0.0f;    // 入力から Present までの時間（平滑化）
+
+    // -record で起動したときだけ。終了時に recordPath へ書き出す
+    std::unique_ptr<ReplayRecorder> recorder;
+    std::wstring recordPath;
+
+    // フレーム時間の集計。-telemetry のときはファイルにも書く（破棄時に残りを書き出す）
+    std::unique_ptr<FrameTelemetry> telemetry;
+
+    // -resources のときだけ。終了時（解放前）にリソースの一覧を CSV で書き出す
+    std::wstring resourceReportPath;
+
    
     ~StateInfo();
 };
@@ -0,0 +1,485 @@
+﻿/**********************************************************************************
+    StressScene.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/04
+
+**********************************************************************************/
+
+#include "StressScene.h"
+#include "AnimationGraph.h"
+#include "CollisionMask.h"
+#include "GameWorld.h"
+#include "JobSystem.h"
+#include "LayerCache.h"
+#include "ParticleSystem.h"
+#include "Profiler.h"
+#include "SpritePass.h"
+#include "SpriteQuad.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace {
+
+    const size_t kBatchQuads = 4096;           // d3dApp で作る SpriteBatch と同じ
+    const uint32_t kWhiteTexture = 0xff;       // パーティクル（SpriteBatch の白テクスチャ）
+    const int kSizeClasses = 4;
+    const float kSizeScale[kSizeClasses] = { 0.5f, 0.8f, 1.1f, 1.5f };
+
+    const char* const kStageNames[] = {
+        "animate", "move", "collide", "particles", "layers", "buildQuads", "sort", "batch"
+    };
+
+    uint32_t NextRandom(uint32_t* state) {
+        uint32_t x = *state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        *state = x;
+        return x;
+    }
+
+    float RandomRange(uint32_t* state, float minValue, float maxValue) {
+        return minValue + (maxValue - minValue) * static_cast<float>(NextRandom(state) & 0xffffff) / 16777215.0f;
+    }
+
+    // スプライトは成分ごとの配列で持つ
+    struct StressSprites {
+        std::vector<float> x, y, vx, vy;
+        std::vector<float> phase;               // 走る・止まるを切り替える周期のずれ
+        std::vector<uint8_t> sizeClass, layer, blend;
+        std::vector<AnimGraphInstance> anim;
+        std::vector<float> uv;                  // スプライトごとに offset.xy, scale.xy
+        std::vector<uint32_t> colliders;        // 当たり判定を持つスプライトの番号
+    };
+
+    void ForRange(JobSystem* jobs, size_t count, size_t grain, const std::function<void(size_t, size_t)>& func) {
+        if (jobs) jobs->ParallelFor(count, grain, func);
+        else func(0, count);
+    }
+
+    // 層の中身。四角形は層の座標で置いてあり、描き直すときは範囲に入るものだけ展開する
+    struct StressLayer {
+        int id = -1;
+        std::vector<SpriteQuad> quads;
+    };
+
+    bool Overlaps(const SpriteQuad& q, float x, float y, float width, float height) {
+        return q.pos[2].x > x && q.pos[0].x < x + width && q.pos[2].y > y && q.pos[0].y < y + height;
+    }
+
+    bool IsRunning(float time, float phase) {
+        return std::fmod(time + phase, 4.0f) < 3.0f;
+    }
+
+    StressStageTiming ToTiming(const HdrHistogram& histogram, double totalUs, uint32_t frames) {
+        StressStageTiming timing;
+        timing.meanMs = frames ? totalUs * 0.001 / static_cast<double>(frames) : 0.0;
+        timing.p99Ms = static_cast<double>(histogram.GetPercentile(99.0)) * 0.001;
+        timing.maxMs = static_cast<double>(histogram.GetMax()) * 0.001;
+        return timing;
+    }
+}
+
+
+const char* GetStressStageName(StressStage stage) {
+    return stage < StressStage::Count ? kStageNames[static_cast<int>(stage)] : "";
+}
+
+bool RunStressScene(const AnimGraph& graph, const StressSceneDesc& desc, StressResult* out, std::string* error) {
+    PROFILE_ZONE("RunStressScene");
+    if (graph.clips.empty() || graph.states.empty()) {
+        if (error) *error = "animation graph has no clips";
+        return false;
+    }
+    if (desc.sprites == 0 || desc.sprites > (1u << 20) || desc.depthLayers <= 0 || desc.depthLayers > 255) {
+        if (error) *error = "sprite count or layer count out of range";
+        return false;
+    }
+
+    const size_t count = desc.sprites;
+    const int speedParam = graph.FindParam("speed");
+    uint32_t rng = desc.seed * 2654435761u + 1;
+
+    // 密度が一定になるように、画面何枚分の世界にするかを決める
+    double screens = std::max(1.0, static_cast<double>(desc.sprites) / static_cast<double>(std::max(desc.spritesPerScreen, 1u)));
+    float worldScale = static_cast<float>(std::sqrt(screens));
+    float worldW = desc.screenWidth * worldScale;
+    float worldH = desc.screenHeight * worldScale;
+
+    float sizeW[kSizeClasses], sizeH[kSizeClasses];
+    std::vector<CollisionMask> masks(kSizeClasses);
+    for (int c = 0; c < kSizeClasses; c++) {
+        sizeW[c] = desc.spriteWidth * kSizeScale[c];
+        sizeH[c] = desc.spriteHeight * kSizeScale[c];
+        masks[c] = MakeBoxMask(static_cast<int>(sizeW[c]), static_cast<int>(sizeH[c]));
+    }
+
+    // シーンを作る。乱数は seed からこの順に引くだけなので、同じ seed なら同じシーン
+    StressSprites s;
+    s.x.resize(count);
+    s.y.resize(count);
+    s.vx.resize(count);
+    s.vy.resize(count);
+    s.phase.resize(count);
+    s.sizeClass.resize(count);
+    s.layer.resize(count);
+    s.blend.resize(count);
+    s.anim.resize(count);
+    s.uv.resize(count * 4);
+    for (size_t i = 0; i < count; i++) {
+        s.sizeClass[i] = static_cast<uint8_t>(NextRandom(&rng) % kSizeClasses);
+        s.x[i] = RandomRange(&rng, 0.0f, worldW - sizeW[s.sizeClass[i]]);
+        s.y[i] = RandomRange(&rng, 0.0f, worldH - sizeH[s.sizeClass[i]]);
+        s.vx[i] = RandomRange(&rng, -240.0f, 240.0f);
+        s.vy[i] = RandomRange(&rng, -60.0f, 60.0f);
+        s.phase[i] = RandomRange(&rng, 0.0f, 4.0f);
+        s.layer[i] = static_cast<uint8_t>(NextRandom(&rng) % static_cast<uint32_t>(desc.depthLayers));
+
+        float b = RandomRange(&rng, 0.0f, 1.0f);
+        s.blend[i] = static_cast<uint8_t>(b < desc.additiveShare ? ParticleBlend::Additive
+            : b < desc.additiveShare + desc.screenShare ? ParticleBlend::Screen : ParticleBlend::Normal);
+
+        ResetAnimGraphInstance(graph, &s.anim[i]);
+        // 同じ絵が揃って動かないよう、開始時刻をずらす
+        s.anim[i].stateTime = RandomRange(&rng, 0.0f, 2.0f);
+
+        if (RandomRange(&rng, 0.0f, 1.0f) < desc.colliderShare) s.colliders.push_back(static_cast<uint32_t>(i));
+    }
+
+    ParticleSystem particles(desc.particleCapacity, desc.seed);
+    for (uint32_t e = 0; e < desc.emitters; e++) {
+        EmitterDesc emitter;
+        emitter.x = worldW * static_cast<float>(e) / static_cast<float>(desc.emitters);
+        emitter.y = RandomRange(&rng, 0.0f, worldH * 0.5f);
+        emitter.width = worldW / static_cast<float>(desc.emitters);
+        emitter.height = 32.0f;
+        emitter.lifeMin = 0.8f;
+        emitter.lifeMax = 1.2f;
+        emitter.rate = static_cast<float>(desc.particleCapacity) / static_cast<float>(desc.emitters) / 1.2f;
+        emitter.velXMin = -40.0f;
+        emitter.velXMax = 40.0f;
+        emitter.velYMin = -300.0f;
+        emitter.velYMax = -120.0f;
+        emitter.accelY = 400.0f;
+        emitter.blend = static_cast<ParticleBlend>(e % static_cast<uint32_t>(ParticleBlend::Count));
+        particles.AddEmitter(emitter);
+    }
+
+    // 層はシーンの乱数とは別の列から作る（層の設定を変えてもスプライトの動きは変わらない）
+    LayerCache layerCache;
+    layerCache.SetViewport(desc.screenWidth, desc.screenHeight);
+    std::vector<StressLayer> layers(desc.backgroundLayers + 1);
+    uint32_t layerRng = desc.seed * 747796405u + 2891336453u;
+    for (size_t l = 0; l < layers.size(); l++) {
+        bool hud = l == desc.backgroundLayers;
+        LayerDesc layerDesc;
+        layerDesc.name = hud ? "hud" : "background";
+        layerDesc.parallaxX = hud ? 0.0f : static_cast<float>(l + 1) / static_cast<float>(desc.backgroundLayers + 1);
+        layerDesc.parallaxY = layerDesc.parallaxX;
+        layerDesc.margin = hud ? 0.0f : desc.layerMargin;
+        layers[l].id = layerCache.AddLayer(layerDesc);
+
+        // カメラが届く範囲（層の座標）に散らす
+        float extentW = (worldW - desc.screenWidth) * layerDesc.parallaxX + desc.screenWidth;
+        float extentH = desc.screenHeight;
+        uint32_t quadCount = hud ? desc.layerQuads / 10 : desc.layerQuads;
+        layers[l].quads.resize(quadCount);
+        for (SpriteQuad& q : layers[l].quads) {
+            float w = RandomRange(&layerRng, 16.0f, 128.0f), h = RandomRange(&layerRng, 16.0f, 128.0f);
+            float x = RandomRange(&layerRng, 0.0f, extentW - w), y = RandomRange(&layerRng, 0.0f, extentH - h);
+            q.pos[0] = { x, y };
+            q.pos[1] = { x + w, y };
+            q.pos[2] = { x + w, y + h };
+            q.pos[3] = { x, y + h };
+            q.uv[0] = { 0.0f, 0.0f };
+            q.uv[1] = { 1.0f, 0.0f };
+            q.uv[2] = { 1.0f, 1.0f };
+            q.uv[3] = { 0.0f, 1.0f };
+            q.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+            q.depth = 1.0f - static_cast<float>(l) * 0.01f;
+        }
+    }
+    std::vector<Vertex> layerVertices;
+    uint64_t totalLayerQuads = 0, totalLayerQuadsUncached = 0, totalLayerRedraws = 0;
+
+    unsigned threads = desc.threads ? desc.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    std::unique_ptr<JobSystem> jobs;
+    if (threads > 1) jobs = std::make_unique<JobSystem>(threads - 1);
+
+    std::vector<MaskInstance> instances(s.colliders.size());
+    std::vector<std::pair<uint32_t, uint32_t>> overlaps;
+    std::vector<SpriteQuad> quads;
+    std::vector<SpriteQuad> particleQuads;
+    size_t particleBlendEnd[static_cast<int>(ParticleBlend::Count)] = {};
+    std::vector<uint64_t> keys;
+    std::vector<Vertex> vertices;
+    SpritePassQueue passes;
+    OverdrawStats painterStats, passStats;
+    vertices.reserve(kBatchQuads * 4);
+
+    const int stageCount = static_cast<int>(StressStage::Count);
+    std::vector<HdrHistogram> histograms(stageCount + 1);
+    std::vector<double> totalUs(stageCount + 1, 0.0);
+    uint64_t totalQuads = 0, totalDrawCalls = 0, totalOverlaps = 0, totalParticles = 0;
+    const float dt = desc.deltaTime;
+
+    auto timed = [&](int stage, const std::function<void()>& func) {
+        auto t0 = std::chrono::steady_clock::now();
+        func();
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        histograms[stage].Record(static_cast<uint64_t>(us));
+        totalUs[stage] += us;
+    };
+
+    for (uint32_t frame = 0; frame < desc.frames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+        float time = static_cast<float>(frame) * dt;
+
+        timed(static_cast<int>(StressStage::Animate), [&] {
+            PROFILE_ZONE("Stress Animate");
+            ForRange(jobs.get(), count, 2048, [&](size_t begin, size_t end) {
+                if (speedParam >= 0) {
+                    for (size_t i = begin; i < end; i++) {
+                        s.anim[i].params[speedParam] = IsRunning(time, s.phase[i]) ? std::fabs(s.vx[i]) : 0.0f;
+                    }
+                }
+                EvaluateAnimGraph(graph, &s.anim[begin], end - begin, dt);
+                for (size_t i = begin; i < end; i++) {
+                    const AnimationData& clip = graph.clips[graph.states[s.anim[i].state].clip];
+                    GetAnimFrameUV(clip, s.anim[i].frameIndex, &s.uv[i * 4], &s.uv[i * 4 + 2]);
+                }
+            });
+        });
+
+        timed(static_cast<int>(StressStage::Move), [&] {
+            PROFILE_ZONE("Stress Move");
+            ForRange(jobs.get(), count, 4096, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    if (!IsRunning(time, s.phase[i])) continue;
+                    float maxX = worldW - sizeW[s.sizeClass[i]];
+                    float maxY = worldH - sizeH[s.sizeClass[i]];
+                    s.x[i] += s.vx[i] * dt;
+                    s.y[i] += s.vy[i] * dt;
+                    if (s.x[i] < 0.0f || s.x[i] > maxX) { s.vx[i] = -s.vx[i]; s.x[i] = std::clamp(s.x[i], 0.0f, maxX); }
+                    if (s.y[i] < 0.0f || s.y[i] > maxY) { s.vy[i] = -s.vy[i]; s.y[i] = std::clamp(s.y[i], 0.0f, maxY); }
+                }
+            });
+        });
+
+        timed(static_cast<int>(StressStage::Collide), [&] {
+            PROFILE_ZONE("Stress Collide");
+            for (size_t c = 0; c < s.colliders.size(); c++) {
+                uint32_t i = s.colliders[c];
+                instances[c] = { &masks[s.sizeClass[i]], static_cast<int>(s.x[i]), static_cast<int>(s.y[i]), s.vx[i] < 0.0f };
+            }
+            overlaps.clear();
+            totalOverlaps += FindMaskOverlaps(instances.data(), instances.size(), &overlaps);
+        });
+
+        timed(static_cast<int>(StressStage::Particles), [&] {
+            particles.Update(dt, jobs.get());
+            totalParticles += particles.GetAliveCount();
+        });
+
+        // カメラは世界の端から端を往復する
+        float cameraRange = std::max(worldW - desc.screenWidth, 0.0f);
+        float cameraX = 0.0f;
+        if (cameraRange > 0.0f) {
+            cameraX = std::fmod(time * desc.cameraSpeed, cameraRange * 2.0f);
+            if (cameraX > cameraRange) cameraX = cameraRange * 2.0f - cameraX;
+        }
+        if (desc.hudInterval > 0 && frame % desc.hudInterval == 0) layerCache.Invalidate(layers.back().id);
+
+        timed(static_cast<int>(StressStage::Layers), [&] {
+            PROFILE_ZONE("Stress Layers");
+            layerVertices.clear();
+            for (const StressLayer& layer : layers) {
+                if (layerCache.Prepare(layer.id, cameraX, 0.0f) == LayerCacheResult::Redraw) {
+                    LayerRegion region = layerCache.GetRenderRegion(layer.id);
+                    for (const SpriteQuad& q : layer.quads) {
+                        if (!Overlaps(q, region.x, region.y, region.width, region.height)) continue;
+                        AppendSpriteVertices(&q, 1, &layerVertices);
+                    }
+                    totalLayerRedraws++;
+                }
+                SpriteQuad composite;
+                layerCache.BuildCompositeQuad(layer.id, cameraX, 0.0f, 1.0f, &composite);
+                AppendSpriteVertices(&composite, 1, &layerVertices);
+            }
+            totalLayerQuads += layerVertices.size() / 4;
+        });
+
+        timed(static_cast<int>(StressStage::BuildQuads), [&] {
+            PROFILE_ZONE("Stress BuildQuads");
+            quads.resize(count);
+            ForRange(jobs.get(), count, 4096, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    SpriteQuad& q = quads[i];
+                    float x0 = s.x[i], y0 = s.y[i];
+                    float x1 = x0 + sizeW[s.sizeClass[i]], y1 = y0 + sizeH[s.sizeClass[i]];
+                    float u0 = s.uv[i * 4], v0 = s.uv[i * 4 + 1];
+                    float u1 = u0 + s.uv[i * 4 + 2], v1 = v0 + s.uv[i * 4 + 3];
+                    if (s.vx[i] < 0.0f) std::swap(u0, u1);     // シェーダーの uFlipX と同じ
+                    q.pos[0] = { x0, y0 };
+                    q.pos[1] = { x1, y0 };
+                    q.pos[2] = { x1, y1 };
+                    q.pos[3] = { x0, y1 };
+                    q.uv[0] = { u0, v0 };
+                    q.uv[1] = { u1, v0 };
+                    q.uv[2] = { u1, v1 };
+                    q.uv[3] = { u0, v1 };
+                    q.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+                    q.depth = static_cast<float>(s.layer[i]) / static_cast<float>(desc.depthLayers);
+                }
+            });
+            particleQuads.clear();
+            for (int b = 0; b < static_cast<int>(ParticleBlend::Count); b++) {
+                particles.BuildQuads(static_cast<ParticleBlend>(b), &particleQuads);
+                particleBlendEnd[b] = particleQuads.size();
+            }
+        });
+
+        timed(static_cast<int>(StressStage::Sort), [&] {
+            PROFILE_ZONE("Stress Sort");
+            // 上位から 深度レイヤー | ブレンド | テクスチャ | 番号。パーティクルは一番上のレイヤー
+            size_t total = count + particleQuads.size();
+            keys.resize(total);
+            ForRange(jobs.get(), count, 8192, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    uint64_t texture = graph.states[s.anim[i].state].clip;
+                    keys[i] = (static_cast<uint64_t>(s.layer[i]) << 48) | (static_cast<uint64_t>(s.blend[i]) << 40)
+                        | (texture << 32) | i;
+                }
+            });
+            // パーティクルはブレンドごとに続けて作ってあるので、そのままの順で並んでいる
+            uint64_t blend = 0;
+            for (size_t p = 0; p < particleQuads.size(); p++) {
+                while (p >= particleBlendEnd[blend]) blend++;
+                keys[count + p] = (static_cast<uint64_t>(desc.depthLayers) << 48) | (blend << 40)
+                    | (static_cast<uint64_t>(kWhiteTexture) << 32) | (count + p);
+            }
+            std::sort(keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(count));
+        });
+
+        timed(static_cast<int>(StressStage::Batch), [&] {
+            PROFILE_ZONE("Stress Batch");
+            // ブレンドかテクスチャが変わるか、バッファがいっぱいになったら 1 回のドローコール
+            uint64_t state = ~0ull;
+            uint64_t drawCalls = 0;
+            vertices.clear();
+            for (uint64_t key : keys) {
+                uint64_t keyState = (key >> 32) & 0xffff;
+                size_t index = static_cast<size_t>(key & 0xffffffffu);
+                if (keyState != state || vertices.size() >= kBatchQuads * 4) {
+                    if (!vertices.empty()) drawCalls++;
+                    vertices.clear();
+                    state = keyState;
+                }
+                const SpriteQuad& q = index < count ? quads[index] : particleQuads[index - count];
+                AppendSpriteVertices(&q, 1, &vertices);
+            }
+            if (!vertices.empty()) drawCalls++;
+            totalDrawCalls += drawCalls;
+            totalQuads += keys.size();
+        });
+
+        double frameUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - frameStart).count();
+        histograms[stageCount].Record(static_cast<uint64_t>(frameUs));
+        totalUs[stageCount] += frameUs;
+
+        // キャッシュしなければ、毎フレーム画面に入る四角形を全部描くことになる（時間には含めない）
+        for (const StressLayer& layer : layers) {
+            const LayerDesc& layerDesc = layerCache.GetDesc(layer.id);
+            float scrollX = std::round(cameraX * layerDesc.parallaxX);
+            for (const SpriteQuad& q : layer.quads) {
+                totalLayerQuadsUncached += Overlaps(q, scrollX, 0.0f, desc.screenWidth, desc.screenHeight) ? 1 : 0;
+            }
+        }
+
+        // 重なりは最後のフレームだけ測る（時間には含めない）
+        if (frame + 1 == desc.frames) {
+            passes.Clear();
+            for (size_t i = 0; i < count; i++) {
+                // 乱数を引くとシーンが変わるので、アルファの使い方は番号から決める
+                float share = static_cast<float>((static_cast<uint32_t>(i) * 2654435761u) >> 8) / 16777216.0f;
+                SpriteAlphaMode mode = s.blend[i] != static_cast<uint8_t>(ParticleBlend::Normal) ? SpriteAlphaMode::Blended
+                    : share < desc.opaqueShare ? SpriteAlphaMode::Opaque
+                    : share < desc.opaqueShare + desc.alphaTestedShare ? SpriteAlphaMode::AlphaTested : SpriteAlphaMode::Blended;
+                void* texture = reinterpret_cast<void*>(static_cast<uintptr_t>(graph.states[s.anim[i].state].clip + 1));
+                passes.Add(texture, mode, s.blend[i], &quads[i], 1);
+            }
+            size_t particleBegin = 0;
+            for (int b = 0; b < static_cast<int>(ParticleBlend::Count); b++) {
+                passes.Add(nullptr, SpriteAlphaMode::Blended, static_cast<uint8_t>(b), particleQuads.data() + particleBegin,
+                    particleBlendEnd[b] - particleBegin);
+                particleBegin = particleBlendEnd[b];
+            }
+            passes.Sort();
+            int resolutionX = static_cast<int>(desc.screenWidth);
+            int resolutionY = static_cast<int>(desc.screenHeight);
+            MeasureOverdraw(passes, false, 0.0f, 0.0f, desc.screenWidth, desc.screenHeight, resolutionX, resolutionY, &painterStats);
+            MeasureOverdraw(passes, true, 0.0f, 0.0f, desc.screenWidth, desc.screenHeight, resolutionX, resolutionY, &passStats);
+        }
+    }
+
+    out->sprites = desc.sprites;
+    out->frames = desc.frames;
+    out->threads = threads;
+    out->worldWidth = worldW;
+    out->worldHeight = worldH;
+    for (int i = 0; i < stageCount; i++) out->stages[i] = ToTiming(histograms[i], totalUs[i], desc.frames);
+    out->frame = ToTiming(histograms[stageCount], totalUs[stageCount], desc.frames);
+    double frames = desc.frames ? static_cast<double>(desc.frames) : 1.0;
+    out->quads = static_cast<double>(totalQuads) / frames;
+    out->drawCalls = static_cast<double>(totalDrawCalls) / frames;
+    out->overlaps = static_cast<double>(totalOverlaps) / frames;
+    out->particles = static_cast<double>(totalParticles) / frames;
+    out->overdrawPainter = painterStats.GetOverdraw();
+    out->overdrawPasses = passStats.GetOverdraw();
+    out->layerHitRate = layerCache.GetTotalStats().GetHitRate();
+    out->layerRedraws = static_cast<double>(totalLayerRedraws) / frames;
+    out->layerQuads = static_cast<double>(totalLayerQuads) / frames;
+    out->layerQuadsUncached = static_cast<double>(totalLayerQuadsUncached) / frames;
+    uint64_t fragments = passStats.shaded + passStats.rejected;
+    out->earlyZRejected = fragments ? static_cast<double>(passStats.rejected) / static_cast<double>(fragments) : 0.0;
+
+    uint64_t hash = HashBytes(s.x.data(), s.x.size() * sizeof(float));
+    hash = HashBytes(s.y.data(), s.y.size() * sizeof(float), hash);
+    for (const AnimGraphInstance& a : s.anim) {
+        hash = HashBytes(&a.state, sizeof(a.state), hash);
+        hash = HashBytes(&a.frameIndex, sizeof(a.frameIndex), hash);
+    }
+    out->finalHash = hash;
+    return true;
+}
+
+bool WriteStressResults(const wchar_t* path, const std::vector<StressResult>& results) {
+    std::ofstream file{ std::filesystem::path(path) };
+    if (!file) return false;
+    file << "sprites,frames,threads,worldWidth,worldHeight,frameMs,frameP99Ms";
+    for (int i = 0; i < static_cast<int>(StressStage::Count); i++) {
+        const char* name = GetStressStageName(static_cast<StressStage>(i));
+        file << ',' << name << "Ms," << name << "P99Ms";
+    }
+    file << ",quads,drawCalls,overlaps,particles,overdrawPainter,overdrawPasses,earlyZRejected,"
+        "layerHitRate,layerRedraws,layerQuads,layerQuadsUncached,hash\n";
+    for (const StressResult& r : results) {
+        file << r.sprites << ',' << r.frames << ',' << r.threads << ',' << r.worldWidth << ',' << r.worldHeight << ','
+            << r.frame.meanMs << ',' << r.frame.p99Ms;
+        for (const StressStageTiming& stage : r.stages) file << ',' << stage.meanMs << ',' << stage.p99Ms;
+        file << ',' << r.quads << ',' << r.drawCalls << ',' << r.overlaps << ',' << r.particles << ','
+            << r.overdrawPainter << ',' << r.overdrawPasses << ',' << r.earlyZRejected << ','
+            << r.layerHitRate << ',' << r.layerRedraws << ',' << r.layerQuads << ',' << r.layerQuadsUncached << ','
+            << std::hex << r.finalHash << std::dec << '\n';
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,113 @@
+﻿/**********************************************************************************
+    StressScene.h
+
+                                                                LI WENHUI
+                                                                2025/09/04
+
+**********************************************************************************/
+
+#ifndef STRESSSCENE_H
+#define STRESSSCENE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AnimGraph;
+
+struct StressSceneDesc {
+    uint32_t sprites = 10000;           // 1 .. 1M
+    uint32_t seed = 1;
+    uint32_t frames = 300;
+    float deltaTime = 1.0f / 60.0f;
+
+    // 画面 1 枚（logicalWidth x logicalHeight）あたりのスプライト数。これを超える分は世界を広げて密度を保つ
+    float screenWidth = 1888.0f;
+    float screenHeight = 1062.0f;
+    uint32_t spritesPerScreen = 2000;
+
+    float spriteWidth = 48.0f;          // 0.5 〜 1.5 倍でばらつかせる
+    float spriteHeight = 64.0f;
+    int depthLayers = 8;
+    float additiveShare = 0.2f;         // 加算ブレンドの割合
+    float screenShare = 0.1f;           // スクリーンブレンドの割合（残りは通常）
+    float colliderShare = 0.1f;         // 動く当たり判定を持つ割合
+    float opaqueShare = 0.5f;           // 通常ブレンドのうち不透明の割合
+    float alphaTestedShare = 0.3f;      // 通常ブレンドのうちアルファテストの割合（残りは半透明）
+
+    // テクスチャにキャッシュする層（LayerCache）。奥から backgroundLayers 枚の遠景と HUD 1 枚
+    // カメラは世界を左右に往復し、HUD は hudInterval フレームごとに中身が変わる
+    uint32_t backgroundLayers = 3;
+    uint32_t layerQuads = 2000;         // 層 1 枚あたりの四角形（HUD はその 1/10）
+    float layerMargin = 256.0f;
+    float cameraSpeed = 240.0f;
+    uint32_t hudInterval = 30;
+
+    uint32_t emitters = 8;
+    size_t particleCapacity = 65536;
+
+    unsigned threads = 0;               // 0 ならハードウェアスレッド数
+};
+
+// 1 フレームの処理の段階。描画の CPU 側（四角形作り、並べ替え、頂点の展開）までを測る
+enum class StressStage : uint8_t {
+    Animate,        // アニメーショングラフの評価と UV
+    Move,
+    Collide,        // 当たり判定を持つものだけ、ソート＆スイープ
+    Particles,
+    Layers,         // 層のキャッシュの判定と、描き直す層の頂点の展開
+    BuildQuads,
+    Sort,           // 描画順（深度、ブレンド、テクスチャ）のキー
+    Batch,          // SpriteBatch と同じ区切りで頂点に展開し、ドローコールを数える
+    Count
+};
+
+struct StressStageTiming {
+    double meanMs = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+struct StressResult {
+    uint32_t sprites = 0;
+    uint32_t frames = 0;
+    unsigned threads = 0;
+    float worldWidth = 0.0f;
+    float worldHeight = 0.0f;
+    StressStageTiming stages[static_cast<int>(StressStage::Count)];
+    StressStageTiming frame;
+
+    // 1 フレームあたりの平均
+    double quads = 0.0;
+    double drawCalls = 0.0;
+    double overlaps = 0.0;
+    double particles = 0.0;
+
+    // 最後のフレームの最初の画面 1 枚分で、1 ピクセルあたりシェーダーが何回走るか（SpritePass）
+    // painter は全部を奥から重ねたとき、passes は不透明を手前から深度付きで描いたとき
+    double overdrawPainter = 0.0;
+    double overdrawPasses = 0.0;
+    double earlyZRejected = 0.0;        // passes で深度テストに弾かれた割合
+
+    // 層のキャッシュ。layerQuads は描き直しと貼り付けで実際に展開した数、uncached は毎フレーム全部描いたときの数
+    double layerHitRate = 0.0;
+    double layerRedraws = 0.0;
+    double layerQuads = 0.0;
+    double layerQuadsUncached = 0.0;
+
+    uint64_t finalHash = 0;             // 最後のスプライトの状態。seed が同じならスレッド数によらず一致する
+};
+
+const char* GetStressStageName(StressStage stage);
+
+//
+// seed から決まるシーンを作り、frames フレーム分を進めて段階ごとの時間を測る
+// スプライトは graph のクリップ（AnimationData）をそのまま使う。D3D は使わない
+bool RunStressScene(const AnimGraph& graph, const StressSceneDesc& desc, StressResult* out, std::string* error);
+
+// スプライト数ごとに 1 行の CSV（負荷曲線）
+bool WriteStressResults(const wchar_t* path, const std::vector<StressResult>& results);
+
+
+#endif
@@ -0,0 +1,325 @@
+﻿/**********************************************************************************
+    Telemetry.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/02
+
+**********************************************************************************/
+
+#include "Telemetry.h"
+#include "Varint.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+    const uint8_t kMagic[4] = { 'F', 'T', 'E', 'L' };
+    const uint32_t kVersion = 1;
+    const int kMetricCount = static_cast<int>(FrameMetric::Count);
+    const char* const kMetricNames[kMetricCount] = { "frame", "update", "submit", "present", "gpu" };
+
+    int HighestBit(uint64_t value) {
+        int bit = 0;
+        while (value >>= 1) bit++;
+        return bit;
+    }
+
+    uint64_t ToMicroseconds(float ms) {
+        return ms > 0.0f ? static_cast<uint64_t>(std::llround(static_cast<double>(ms) * 1000.0)) : 0;
+    }
+
+    float ToMilliseconds(uint64_t us) {
+        return static_cast<float>(static_cast<double>(us) * 0.001);
+    }
+}
+
+
+HdrHistogram::HdrHistogram() {
+    Reset();
+}
+
+int HdrHistogram::IndexOf(uint64_t value) {
+    if (value < kSubBuckets) return static_cast<int>(value);
+    int shift = HighestBit(value) - 6;
+    int index = kSubBuckets + (shift - 1) * 64 + static_cast<int>((value >> shift) - 64);
+    return index < kBucketCount ? index : kBucketCount - 1;
+}
+
+uint64_t HdrHistogram::HighestValueAt(int index) {
+    if (index < kSubBuckets) return static_cast<uint64_t>(index);
+    int shift = (index - kSubBuckets) / 64 + 1;
+    uint64_t sub = static_cast<uint64_t>((index - kSubBuckets) % 64 + 64);
+    return ((sub + 1) << shift) - 1;
+}
+
+void HdrHistogram::Record(uint64_t value) {
+    counts[IndexOf(value)].fetch_add(1, std::memory_order_relaxed);
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+void HdrHistogram::Reset() {
+    for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::TakeBucket(int index) {
+    return counts[index].exchange(0, std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::GetBucket(int index) const {
+    return counts[index].load(std::memory_order_relaxed);
+}
+
+void HdrHistogram::AddBucket(int index, uint64_t count) {
+    counts[index].fetch_add(count, std::memory_order_relaxed);
+    if (count == 0) return;
+    uint64_t value = HighestValueAt(index);
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+void HdrHistogram::Add(const HdrHistogram& other) {
+    for (int i = 0; i < kBucketCount; i++) {
+        uint64_t c = other.GetBucket(i);
+        if (c) counts[i].fetch_add(c, std::memory_order_relaxed);
+    }
+    uint64_t value = other.GetMax();
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+uint64_t HdrHistogram::GetCount() const {
+    uint64_t total = 0;
+    for (const auto& c : counts) total += c.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t HdrHistogram::GetMax() const {
+    return max.load(std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::TakeMax() {
+    return max.exchange(0, std::memory_order_relaxed);
+}
+
+uint64_t HdrHistogram::GetPercentile(double percentile) const {
+    uint64_t total = GetCount();
+    if (total == 0) return 0;
+    uint64_t target = static_cast<uint64_t>(std::ceil(percentile * 0.01 * static_cast<double>(total)));
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; i++) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t value = HighestValueAt(i);
+            uint64_t top = GetMax();
+            return value < top ? value : top;
+        }
+    }
+    return GetMax();
+}
+
+
+const char* GetFrameMetricName(FrameMetric metric) {
+    return metric < FrameMetric::Count ? kMetricNames[static_cast<int>(metric)] : "";
+}
+
+
+FrameTelemetry::FrameTelemetry() {
+    for (Metric& m : metrics) {
+        for (int i = 0; i < kMaxThresholds; i++) {
+            m.hitchesTotal[i].store(0);
+            m.hitchesInterval[i].store(0);
+        }
+    }
+    // 既定は 60Hz で 1 / 2 / 6 フレーム落ち相当
+    const float frame[] = { 25.0f, 50.0f, 100.0f };
+    const float work[] = { 8.0f, 16.7f };
+    SetHitchThresholds(FrameMetric::Frame, frame, 3);
+    SetHitchThresholds(FrameMetric::Update, work, 2);
+    SetHitchThresholds(FrameMetric::RenderSubmit, work, 2);
+    SetHitchThresholds(FrameMetric::PresentWait, frame, 3);
+    SetHitchThresholds(FrameMetric::GpuScene, work, 2);
+}
+
+FrameTelemetry::~FrameTelemetry() {
+    if (writer.joinable()) {
+        Flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_all();
+        writer.join();
+    }
+}
+
+void FrameTelemetry::SetHitchThresholds(FrameMetric metric, const float* thresholdsMs, int count) {
+    Metric& m = metrics[static_cast<int>(metric)];
+    m.thresholdCount = count < kMaxThresholds ? count : kMaxThresholds;
+    for (int i = 0; i < m.thresholdCount; i++) m.thresholdsUs[i] = ToMicroseconds(thresholdsMs[i]);
+}
+
+void FrameTelemetry::Record(FrameMetric metric, float ms) {
+    Metric& m = metrics[static_cast<int>(metric)];
+    uint64_t us = ToMicroseconds(ms);
+    m.total.Record(us);
+    m.interval.Record(us);
+    for (int i = 0; i < m.thresholdCount; i++) {
+        if (us <= m.thresholdsUs[i]) continue;
+        m.hitchesTotal[i].fetch_add(1, std::memory_order_relaxed);
+        m.hitchesInterval[i].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrameMetricStats FrameTelemetry::GetStats(FrameMetric metric) const {
+    const Metric& m = metrics[static_cast<int>(metric)];
+    FrameMetricStats stats;
+    stats.count = m.total.GetCount();
+    stats.p50 = ToMilliseconds(m.total.GetPercentile(50.0));
+    stats.p99 = ToMilliseconds(m.total.GetPercentile(99.0));
+    stats.p999 = ToMilliseconds(m.total.GetPercentile(99.9));
+    stats.max = ToMilliseconds(m.total.GetMax());
+    stats.thresholdCount = m.thresholdCount;
+    for (int i = 0; i < m.thresholdCount; i++) {
+        stats.thresholds[i] = ToMilliseconds(m.thresholdsUs[i]);
+        stats.hitches[i] = m.hitchesTotal[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void FrameTelemetry::SetSnapshotFile(const std::wstring& path, float intervalSeconds) {
+    this->path = path;
+    interval = intervalSeconds > 0.0f ? intervalSeconds : 60.0f;
+    sinceFlush = 0.0f;
+    if (!path.empty() && !writer.joinable()) {
+        writer = std::thread(&FrameTelemetry::WriterLoop, this);
+    }
+}
+
+void FrameTelemetry::Tick(float deltaSeconds) {
+    if (path.empty()) return;
+    sinceFlush += deltaSeconds;
+    if (sinceFlush < interval) return;
+    Flush();
+}
+
+void FrameTelemetry::Flush() {
+    if (path.empty()) return;
+    sinceFlush = 0.0f;
+    std::vector<uint8_t> snapshot;
+    EncodeSnapshot(&snapshot);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(snapshot));
+    }
+    wake.notify_one();
+}
+
+//
+// スナップショット 1 件
+//   varint(以降のバイト数), "FTEL", 版, 時刻(UNIX ミリ秒), 通し番号, 項目数
+//   項目ごと: 件数, 最大(us), しきい値の数, [しきい値(us), 回数]..., 0 でないバケット数, [前のバケットからの差, 件数]...
+void FrameTelemetry::EncodeSnapshot(std::vector<uint8_t>* out) {
+    std::vector<uint8_t> body;
+    body.insert(body.end(), kMagic, kMagic + 4);
+    WriteVarint(&body, kVersion);
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    WriteU64(&body, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count()));
+    WriteVarint(&body, sequence++);
+    WriteVarint(&body, kMetricCount);
+
+    std::vector<std::pair<int, uint64_t>> buckets;
+    for (Metric& m : metrics) {
+        buckets.clear();
+        uint64_t count = 0;
+        for (int i = 0; i < HdrHistogram::kBucketCount; i++) {
+            uint64_t c = m.interval.TakeBucket(i);
+            if (!c) continue;
+            buckets.push_back({ i, c });
+            count += c;
+        }
+        WriteVarint(&body, count);
+        WriteVarint(&body, m.interval.TakeMax());
+        WriteVarint(&body, static_cast<uint64_t>(m.thresholdCount));
+        for (int i = 0; i < m.thresholdCount; i++) {
+            WriteVarint(&body, m.thresholdsUs[i]);
+            WriteVarint(&body, m.hitchesInterval[i].exchange(0, std::memory_order_relaxed));
+        }
+        WriteVarint(&body, buckets.size());
+        int previous = 0;
+        for (const auto& bucket : buckets) {
+            WriteVarint(&body, static_cast<uint64_t>(bucket.first - previous));
+            WriteVarint(&body, bucket.second);
+            previous = bucket.first;
+        }
+    }
+
+    out->clear();
+    WriteVarint(out, body.size());
+    out->insert(out->end(), body.begin(), body.end());
+}
+
+void FrameTelemetry::WriterLoop() {
+    for (;;) {
+        std::vector<std::vector<uint8_t>> work;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || !pending.empty(); });
+            if (pending.empty() && quit) return;
+            work.swap(pending);
+        }
+        std::ofstream file(std::filesystem::path(path), std::ios::binary | std::ios::app);
+        for (const auto& snapshot : work) {
+            file.write(reinterpret_cast<const char*>(snapshot.data()), static_cast<std::streamsize>(snapshot.size()));
+        }
+    }
+}
+
+
+bool AggregateTelemetry(const uint8_t* data, size_t size, HdrHistogram* metrics, uint64_t* hitches, uint32_t* snapshotCount) {
+    ByteReader reader{ data, size };
+    uint32_t snapshots = 0;
+    while (reader.ok && reader.pos < size) {
+        uint64_t length = reader.Varint();
+        if (!reader.ok || length > size - reader.pos) return false;
+        ByteReader body{ data + reader.pos, static_cast<size_t>(length) };
+        reader.pos += static_cast<size_t>(length);
+
+        if (length < 4 || std::memcmp(body.data, kMagic, 4) != 0) return false;
+        body.pos = 4;
+        if (body.Varint() != kVersion) return false;
+        body.U64();         // 時刻
+        body.Varint();      // 通し番号
+        uint64_t metricCount = body.Varint();
+        for (uint64_t m = 0; m < metricCount && body.ok; m++) {
+            body.Varint();  // 件数（バケットの合計と同じ）
+            body.Varint();  // 最大（バケットから戻す）
+            uint64_t thresholdCount = body.Varint();
+            for (uint64_t t = 0; t < thresholdCount && body.ok; t++) {
+                body.Varint();
+                uint64_t hits = body.Varint();
+                if (hitches && m < static_cast<uint64_t>(kMetricCount) && t < FrameTelemetry::kMaxThresholds) {
+                    hitches[m * FrameTelemetry::kMaxThresholds + t] += hits;
+                }
+            }
+            uint64_t bucketCount = body.Varint();
+            int index = 0;
+            for (uint64_t b = 0; b < bucketCount && body.ok; b++) {
+                index += static_cast<int>(body.Varint());
+                uint64_t count = body.Varint();
+                if (m < static_cast<uint64_t>(kMetricCount) && index < HdrHistogram::kBucketCount) {
+                    metrics[m].AddBucket(index, count);
+                }
+            }
+        }
+        if (!body.ok) return false;
+        snapshots++;
+    }
+    if (snapshotCount) *snapshotCount = snapshots;
+    return reader.ok;
+}
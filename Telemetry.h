@@ -0,0 +1,139 @@
+﻿/**********************************************************************************
+    Telemetry.h
+
+                                                                LI WENHUI
+                                                                2025/09/02
+
+**********************************************************************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// 対数・線形の 2 段のバケットを持つヒストグラム（HDR）。値はマイクロ秒
+// 2^k ごとの区間を 64 等分するので、どの大きさでも誤差は 1.6% 以内。約 67 秒まで
+// Record は atomic の加算だけなので、どのスレッドからでもロックなしで呼べる
+// 件数は 64bit（多数の端末のスナップショットを AggregateTelemetry で足しても溢れない）
+class HdrHistogram {
+public:
+    static const int kSubBuckets = 128;
+    static const int kBucketCount = 1344;
+
+    HdrHistogram();
+
+    void Record(uint64_t value);
+    void Reset();
+
+    // スナップショット用。バケットを読みながら 0 に戻す
+    uint64_t TakeBucket(int index);
+    uint64_t GetBucket(int index) const;
+    void AddBucket(int index, uint64_t count);
+    void Add(const HdrHistogram& other);
+
+    uint64_t GetCount() const;
+    uint64_t GetMax() const;
+    uint64_t TakeMax();
+
+    // percentile は 0..100。そのバケットに入る最大の値を返す
+    uint64_t GetPercentile(double percentile) const;
+
+    static int IndexOf(uint64_t value);
+    static uint64_t HighestValueAt(int index);
+
+private:
+    std::atomic<uint64_t> counts[kBucketCount];
+    std::atomic<uint64_t> max{ 0 };
+};
+
+enum class FrameMetric : uint8_t {
+    Frame,              // フレーム間隔
+    Update,             // 入力からシミュレーション、描画前までの更新
+    RenderSubmit,       // 描画コマンドの発行（Present を除く）
+    PresentWait,        // Present で待った時間
+    GpuScene,           // GPU でシーンを描いて引き伸ばすまで（タイムスタンプ、数フレーム遅れ）
+    Count
+};
+
+const char* GetFrameMetricName(FrameMetric metric);
+
+struct FrameMetricStats {
+    uint64_t count = 0;
+    float p50 = 0.0f;               // ミリ秒
+    float p99 = 0.0f;
+    float p999 = 0.0f;
+    float max = 0.0f;
+    int thresholdCount = 0;
+    float thresholds[4] = {};       // ヒッチとみなす時間（ミリ秒）
+    uint64_t hitches[4] = {};       // それを超えた回数
+};
+
+//
+// フレームまわりの時間を集計し、決まった間隔でその区間の分をバイナリでファイルへ追記する
+// 書き込みは別スレッドなので、メインループが止まることはない
+class FrameTelemetry {
+public:
+    static const int kMaxThresholds = 4;
+
+    FrameTelemetry();
+    ~FrameTelemetry();
+
+    FrameTelemetry(const FrameTelemetry&) = delete;
+    FrameTelemetry& operator=(const FrameTelemetry&) = delete;
+
+    // Record を呼び始める前に設定すること
+    void SetHitchThresholds(FrameMetric metric, const float* thresholdsMs, int count);
+
+    void Record(FrameMetric metric, float ms);
+
+    // 起動してからの合計
+    FrameMetricStats GetStats(FrameMetric metric) const;
+
+    // intervalSeconds ごとに path へ追記する（空なら書かない）
+    void SetSnapshotFile(const std::wstring& path, float intervalSeconds);
+
+    // 毎フレーム呼ぶ。間隔が来たらスナップショットを作って書き込みスレッドへ渡す
+    void Tick(float deltaSeconds);
+    void Flush();
+
+private:
+    struct Metric {
+        HdrHistogram total;
+        HdrHistogram interval;
+        int thresholdCount = 0;
+        uint64_t thresholdsUs[kMaxThresholds] = {};
+        std::atomic<uint64_t> hitchesTotal[kMaxThresholds];
+        std::atomic<uint64_t> hitchesInterval[kMaxThresholds];
+    };
+
+    void EncodeSnapshot(std::vector<uint8_t>* out);
+    void WriterLoop();
+
+    Metric metrics[static_cast<int>(FrameMetric::Count)];
+
+    std::wstring path;
+    float interval = 60.0f;
+    float sinceFlush = 0.0f;
+    uint32_t sequence = 0;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::vector<uint8_t>> pending;
+    bool quit = false;
+};
+
+// スナップショットを並べたファイルの中身を metrics[FrameMetric::Count] に足し込む（オフラインの集計用）
+// hitches は [Count * kMaxThresholds]（nullptr なら数えない）
+bool AggregateTelemetry(const uint8_t* data, size_t size, HdrHistogram* metrics, uint64_t* hitches, uint32_t* snapshotCount);
+
+
+#endif
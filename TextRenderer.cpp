@@ -0,0 +1,211 @@
+﻿/**********************************************************************************
+    TextRenderer.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "TextRenderer.h"
+#include "BufferUtils.h"
+#include "SpriteBatch.h"
+#include "Profiler.h"
+#include <unordered_map>
+
+//
+// GDI の 1 書体 1 サイズ。メモリ DC に選んでおき、グリフは 65 階調のグレーで取り出す
+class TextRenderer::GdiGlyphSource : public GlyphSource {
+public:
+    ~GdiGlyphSource() override {
+        if (dc) {
+            if (oldFont) SelectObject(dc, oldFont);
+            DeleteDC(dc);
+        }
+        if (font) DeleteObject(font);
+    }
+
+    bool Create(const wchar_t* face, int pixelHeight, bool bold) {
+        dc = CreateCompatibleDC(nullptr);
+        if (!dc) return false;
+        // 高さを負で渡すと、行間を除いた文字の高さになる
+        font = CreateFontW(-pixelHeight, 0, 0, 0, bold ? FW_BOLD : FW_NORMAL, FALSE, FALSE, FALSE,
+            DEFAULT_CHARSET, OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_DONTCARE, face);
+        if (!font) return false;
+        oldFont = static_cast<HFONT>(SelectObject(dc, font));
+
+        TEXTMETRICW tm = {};
+        if (!GetTextMetricsW(dc, &tm)) return false;
+        ascent = static_cast<float>(tm.tmAscent);
+        lineHeight = static_cast<float>(tm.tmHeight + tm.tmExternalLeading);
+        // 斜体やはみ出す字形のために少し余裕を持たせる
+        maxWidth = tm.tmMaxCharWidth + 2;
+        maxHeight = tm.tmHeight + 2;
+
+        DWORD pairCount = GetKerningPairsW(dc, 0, nullptr);
+        if (pairCount > 0) {
+            std::vector<KERNINGPAIR> pairs(pairCount);
+            pairCount = GetKerningPairsW(dc, pairCount, pairs.data());
+            for (DWORD i = 0; i < pairCount; i++) {
+                if (pairs[i].iKernAmount == 0) continue;
+                uint64_t key = (static_cast<uint64_t>(pairs[i].wFirst) << 32) | pairs[i].wSecond;
+                kerning[key] = static_cast<float>(pairs[i].iKernAmount);
+            }
+        }
+        return true;
+    }
+
+    float GetAscent() const override { return ascent; }
+    float GetLineHeight() const override { return lineHeight; }
+    int GetMaxGlyphWidth() const override { return maxWidth; }
+    int GetMaxGlyphHeight() const override { return maxHeight; }
+
+    bool Rasterize(uint32_t codepoint, GlyphBitmap* out) override {
+        // GetGlyphOutlineW は UTF-16 の 1 単位しか受け取らない
+        if (codepoint > 0xFFFF) return false;
+
+        static const MAT2 identity = { { 0, 1 }, { 0, 0 }, { 0, 0 }, { 0, 1 } };
+        GLYPHMETRICS gm = {};
+        DWORD size = GetGlyphOutlineW(dc, codepoint, GGO_GRAY8_BITMAP, &gm, 0, nullptr, &identity);
+        if (size == GDI_ERROR) return false;
+        out->advance = static_cast<float>(gm.gmCellIncX);
+        out->offsetX = gm.gmptGlyphOrigin.x;
+        out->offsetY = -gm.gmptGlyphOrigin.y;
+        // 空白は絵がない（サイズ 0 が返る）
+        if (size == 0) return true;
+
+        buffer.resize(size);
+        if (GetGlyphOutlineW(dc, codepoint, GGO_GRAY8_BITMAP, &gm, size, buffer.data(), &identity) == GDI_ERROR) return false;
+
+        // 行は 4 バイト境界にそろっている。値は 0..64
+        int width = static_cast<int>(gm.gmBlackBoxX);
+        int height = static_cast<int>(gm.gmBlackBoxY);
+        int pitch = (width + 3) & ~3;
+        out->width = width;
+        out->height = height;
+        out->coverage.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+        for (int y = 0; y < height; y++) {
+            const uint8_t* src = &buffer[static_cast<size_t>(y) * static_cast<size_t>(pitch)];
+            uint8_t* dst = &out->coverage[static_cast<size_t>(y) * static_cast<size_t>(width)];
+            for (int x = 0; x < width; x++) {
+                dst[x] = static_cast<uint8_t>(src[x] >= 64 ? 255 : (src[x] * 255 + 32) / 64);
+            }
+        }
+        return true;
+    }
+
+    float GetKerning(uint32_t left, uint32_t right) override {
+        if (kerning.empty()) return 0.0f;
+        auto found = kerning.find((static_cast<uint64_t>(left) << 32) | right);
+        return found != kerning.end() ? found->second : 0.0f;
+    }
+
+private:
+    HDC dc = nullptr;
+    HFONT font = nullptr;
+    HFONT oldFont = nullptr;
+    float ascent = 0.0f;
+    float lineHeight = 0.0f;
+    int maxWidth = 0;
+    int maxHeight = 0;
+    std::unordered_map<uint64_t, float> kerning;
+    std::vector<uint8_t> buffer;
+};
+
+
+TextRenderer::TextRenderer()
+    : texture(nullptr),
+    srv(nullptr)
+{
+
+}
+
+TextRenderer::~TextRenderer() {
+    Release();
+}
+
+void TextRenderer::Release() {
+    SAFE_RELEASE(srv);
+    SAFE_RELEASE(texture);
+    cache.reset();
+    sources.clear();
+    quads.clear();
+}
+
+bool TextRenderer::Init(ID3D11Device* device, int atlasWidth, int atlasHeight) {
+    Release();
+    cache = std::make_unique<GlyphCache>(atlasWidth, atlasHeight);
+
+    // 中身は最初の Flush でまとめて送る
+    D3D11_TEXTURE2D_DESC td = {};
+    td.Width = static_cast<UINT>(atlasWidth);
+    td.Height = static_cast<UINT>(atlasHeight);
+    td.MipLevels = 1;
+    td.ArraySize = 1;
+    td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_DEFAULT;
+    td.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    D3D11_SUBRESOURCE_DATA init = {};
+    init.pSysMem = cache->GetPixels();
+    init.SysMemPitch = static_cast<UINT>(atlasWidth) * 4;
+    if (FAILED(device->CreateTexture2D(&td, &init, &texture))) return false;
+    TrackTexture(texture, "TextRenderer", "glyph atlas");
+    return SUCCEEDED(device->CreateShaderResourceView(texture, nullptr, &srv));
+}
+
+int TextRenderer::AddFont(const wchar_t* face, int pixelHeight, float unitsPerPixel, bool bold) {
+    if (!cache) return -1;
+    auto source = std::make_unique<GdiGlyphSource>();
+    if (!source->Create(face, pixelHeight, bold)) return -1;
+    int font = cache->AddFont(source.get(), unitsPerPixel);
+    sources.push_back(std::move(source));
+    return font;
+}
+
+float TextRenderer::GetLineHeight(int font) const {
+    return cache->GetLineHeight(font);
+}
+
+void TextRenderer::BeginFrame() {
+    if (!cache) return;
+    cache->BeginFrame();
+    quads.clear();
+}
+
+void TextRenderer::DrawString(int font, const std::string& utf8, float x, float y, const DirectX::XMFLOAT4& color,
+    float maxWidth, TextAlign align) {
+    if (!cache || font < 0) return;
+    cache->BuildQuads(font, utf8, x, y, color, 0.0f, &quads, maxWidth, align);
+}
+
+void TextRenderer::Flush(ID3D11DeviceContext* context, SpriteBatch* batch, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection) {
+    if (!cache || !srv) return;
+    PROFILE_ZONE("TextRenderer::Flush");
+
+    // 新しくラスタライズしたグリフがあれば、その範囲だけ送る
+    int x, y, width, height;
+    if (cache->TakeDirtyRect(&x, &y, &width, &height)) {
+        UINT pitch = static_cast<UINT>(cache->GetAtlasWidth()) * 4;
+        D3D11_BOX box = {};
+        box.left = static_cast<UINT>(x);
+        box.top = static_cast<UINT>(y);
+        box.right = static_cast<UINT>(x + width);
+        box.bottom = static_cast<UINT>(y + height);
+        box.back = 1;
+        const uint8_t* src = cache->GetPixels() + static_cast<size_t>(y) * pitch + static_cast<size_t>(x) * 4;
+        context->UpdateSubresource(texture, 0, &box, src, pitch, 0);
+    }
+
+    if (quads.empty()) return;
+    batch->Begin(context, view, projection);
+    batch->Draw(srv, quads.data(), quads.size());
+    batch->End();
+}
+
+const GlyphCache& TextRenderer::GetCache() const {
+    return *cache;
+}
+
+size_t TextRenderer::GetQueuedQuads() const {
+    return quads.size();
+}
@@ -0,0 +1,59 @@
+﻿/**********************************************************************************
+    TextRenderer.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include "d3dApp.h"
+#include "GlyphCache.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class SpriteBatch;
+
+//
+// GlyphCache のアトラスをテクスチャに持ち、フレーム中に頼まれた文字列をまとめて 1 回で描く
+// グリフは GDI で初めて使うときだけラスタライズし、変わった範囲だけ UpdateSubresource で送る
+class TextRenderer {
+public:
+    TextRenderer();
+    ~TextRenderer();
+
+    bool Init(ID3D11Device* device, int atlasWidth = 1024, int atlasHeight = 1024);
+    void Release();
+
+    // pixelHeight はバックバッファ上のピクセル数。unitsPerPixel はピクセルから論理座標への倍率。失敗なら -1
+    int AddFont(const wchar_t* face, int pixelHeight, float unitsPerPixel, bool bold = false);
+    float GetLineHeight(int font) const;
+
+    // 毎フレーム最初に 1 回。前のフレームの文字列を捨てる
+    void BeginFrame();
+
+    // (x, y) を 1 行目の上端として積む。右揃えなら x が右端、中央揃えなら中心
+    void DrawString(int font, const std::string& utf8, float x, float y, const DirectX::XMFLOAT4& color,
+        float maxWidth = 0.0f, TextAlign align = TextAlign::Left);
+
+    // アトラスの変わった範囲を送り、積んだ文字列を描く。ブレンドは呼ぶ前に設定しておく
+    void Flush(ID3D11DeviceContext* context, SpriteBatch* batch, const DirectX::XMMATRIX& view, const DirectX::XMMATRIX& projection);
+
+    const GlyphCache& GetCache() const;
+    size_t GetQueuedQuads() const;
+
+private:
+    class GdiGlyphSource;
+
+    std::unique_ptr<GlyphCache> cache;
+    std::vector<std::unique_ptr<GdiGlyphSource>> sources;
+    std::vector<SpriteQuad> quads;
+    ID3D11Texture2D* texture;
+    ID3D11ShaderResourceView* srv;
+};
+
+
+#endif
@@ -7,8 +7,69 @@
 **********************************************************************************/
 
 #include "TextureLoader.h"
+#include "AnimationData.h"
+#include "AssetCooker.h"
+#include "BufferUtils.h"
+#include "CollisionMask.h"
+#include "SpriteMesh.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <cstring>
+#include <filesystem>
 
-HRESULT LoadTextureAndCreateSRV(ID3D11Device* device, const wchar_t* filename, ID3D11ShaderResourceView** srv, float* outWidth, float* outHeight) {
+namespace {
+
+    // 8bit RGBA / BGRA（アルファは 4 バイト目）の最初の画像。それ以外の形式は converted に変換して返す
+    HRESULT GetRgba8Image(const DirectX::ScratchImage& scratchImage, DirectX::ScratchImage& converted, const DirectX::Image** out) {
+        const DirectX::TexMetadata& metadata = scratchImage.GetMetadata();
+        const DirectX::Image* image = scratchImage.GetImage(0, 0, 0);
+        if (metadata.format != DXGI_FORMAT_R8G8B8A8_UNORM && metadata.format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB &&
+            metadata.format != DXGI_FORMAT_B8G8R8A8_UNORM && metadata.format != DXGI_FORMAT_B8G8R8A8_UNORM_SRGB) {
+            HRESULT hr = DirectX::Convert(*image, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+            if (FAILED(hr)) return hr;
+            image = converted.GetImage(0, 0, 0);
+        }
+        *out = image;
+        return S_OK;
+    }
+
+    TexturePrepInput MakePrepInput(const DirectX::Image& image, int columns, int rows) {
+        TexturePrepInput input;
+        input.pixels = image.pixels;
+        input.width = static_cast<int>(image.width);
+        input.height = static_cast<int>(image.height);
+        input.rowPitch = image.rowPitch;
+        input.columns = columns;
+        input.rows = rows;
+        return input;
+    }
+
+    // 前処理の済んだピクセルから 1 ミップの SRV を作る
+    HRESULT CreatePreparedSRV(ID3D11Device* device, const TexturePrepOutput& prepared, DXGI_FORMAT format,
+        ID3D11ShaderResourceView** srv) {
+        DirectX::Image image = {};
+        image.width = static_cast<size_t>(prepared.width);
+        image.height = static_cast<size_t>(prepared.height);
+        image.format = format;
+        image.rowPitch = image.width * 4;
+        image.slicePitch = image.rowPitch * image.height;
+        image.pixels = const_cast<uint8_t*>(prepared.pixels.data());
+
+        DirectX::TexMetadata metadata = {};
+        metadata.width = image.width;
+        metadata.height = image.height;
+        metadata.depth = 1;
+        metadata.arraySize = 1;
+        metadata.mipLevels = 1;
+        metadata.format = format;
+        metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+        return DirectX::CreateShaderResourceView(device, &image, 1, metadata, srv);
+    }
+}
+
+HRESULT LoadTextureAndCreateSRV(ID3D11Device* device, const wchar_t* filename, ID3D11ShaderResourceView** srv, float* outWidth, float* outHeight,
+    SpriteAlphaMode* outAlphaMode, const TexturePrepOptions& prep, int columns, int rows) {
+    PROFILE_ZONE("LoadTextureAndCreateSRV");
     DirectX::TexMetadata metadata;
     DirectX::ScratchImage scratchImage;
     HRESULT hr;
@@ -30,9 +91,146 @@ HRESULT LoadTextureAndCreateSRV(ID3D11Device* device, const wchar_t* filename, I
     if (outWidth)  *outWidth = static_cast<float>(metadata.width);
     if (outHeight) *outHeight = static_cast<float>(metadata.height);
 
-    // 読み込んだ画像データからShader Resource Viewを作成
-    // この関数は自動的にmipmapsやテクスチャフォーマットの変換を行う
-    hr = DirectX::CreateShaderResourceView(device, scratchImage.GetImages(), scratchImage.GetImageCount(), metadata, srv);
+    // アルファの使い方は元のピクセルで決め、GPU には前処理（premultiply など）の済んだものを送る
+    DirectX::ScratchImage converted;
+    const DirectX::Image* image = nullptr;
+    hr = GetRgba8Image(scratchImage, converted, &image);
+    if (FAILED(hr)) return hr;
+    if (outAlphaMode) {
+        *outAlphaMode = ClassifySpriteAlpha(image->pixels, image->rowPitch, 0, 0,
+            static_cast<int>(image->width), static_cast<int>(image->height));
+    }
+
+    TexturePrepOutput prepared;
+    PrepareTexture(MakePrepInput(*image, columns, rows), prep, &prepared);
+    hr = CreatePreparedSRV(device, prepared, image->format, srv);
+    if (SUCCEEDED(hr)) TrackShaderResourceView(*srv, "Texture", std::filesystem::path(filename).u8string());
     return hr;
 }
 
+HRESULT GetPreparedTextureSize(const wchar_t* filename, const TexturePrepOptions& prep, int columns, int rows, int* outWidth, int* outHeight) {
+    DirectX::TexMetadata metadata;
+    HRESULT hr = DirectX::GetMetadataFromWICFile(filename, DirectX::WIC_FLAGS_NONE, metadata);
+    if (FAILED(hr)) return hr;
+
+    // PrepareTexture と同じ決め方
+    int width = static_cast<int>(metadata.width);
+    int height = static_cast<int>(metadata.height);
+    columns = columns > 0 ? columns : 1;
+    rows = rows > 0 ? rows : 1;
+    if (prep.gutter > 0 && width % columns == 0 && height % rows == 0) {
+        width += columns * prep.gutter * 2;
+        height += rows * prep.gutter * 2;
+    }
+    for (int level = 0; level < prep.downsample; level++) {
+        if (width % (columns * 2) != 0 || height % (rows * 2) != 0) break;
+        width /= 2;
+        height /= 2;
+    }
+    *outWidth = width;
+    *outHeight = height;
+    return S_OK;
+}
+
+HRESULT LoadTexturesWithMasks(ID3D11Device* device, const AnimationData* clips, size_t count, ID3D11ShaderResourceView** srvs,
+    std::vector<CollisionMask>* masks, std::vector<SpriteMesh>* meshes, DirectX::XMFLOAT2* gutters, JobSystem* jobs,
+    float* outWidth, float* outHeight, uint8_t alphaThreshold, const TexturePrepOptions& prep) {
+    PROFILE_ZONE("LoadTexturesWithMasks");
+
+    // デコードは WIC（COM）なので呼び出しスレッドで順番に
+    std::vector<DirectX::ScratchImage> scratchImages(count);
+    std::vector<DirectX::ScratchImage> converted(count);
+    std::vector<const DirectX::Image*> images(count);
+    std::vector<TexturePrepInput> inputs(count);
+    for (size_t i = 0; i < count; i++) {
+        DirectX::TexMetadata metadata;
+        HRESULT hr = DirectX::LoadFromWICFile(clips[i].texturePath.c_str(), DirectX::WIC_FLAGS_NONE, &metadata, scratchImages[i]);
+        if (FAILED(hr)) return hr;
+
+        if (outWidth)  *outWidth = static_cast<float>(metadata.width);
+        if (outHeight) *outHeight = static_cast<float>(metadata.height);
+
+        // マスクは 8bit RGBA / BGRA（アルファは 4 バイト目）から作る。それ以外の形式は変換してから
+        hr = GetRgba8Image(scratchImages[i], converted[i], &images[i]);
+        if (FAILED(hr)) return hr;
+        inputs[i] = MakePrepInput(*images[i], clips[i].columns, clips[i].rows);
+    }
+
+    // マスクと多角形は元のピクセル（straight alpha、余白なし）から、GPU に送る分は前処理してから作る
+    // どれもシートごとに独立しているので、シート単位で並列にする
+    std::vector<TexturePrepOutput> prepared(count);
+    auto job = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const DirectX::Image* image = images[i];
+            const AnimationData& clip = clips[i];
+            BuildCollisionMasks(image->pixels, static_cast<int>(image->width), static_cast<int>(image->height), image->rowPitch,
+                clip.columns, clip.rows, clip.totalFrames, alphaThreshold, &masks[i]);
+            if (meshes) {
+                BuildSpriteMeshes(image->pixels, static_cast<int>(image->width), static_cast<int>(image->height), image->rowPitch,
+                    clip.columns, clip.rows, clip.totalFrames, SpriteMeshOptions(), &meshes[i]);
+            }
+            PrepareTexture(inputs[i], prep, &prepared[i]);
+        }
+    };
+    if (jobs && count > 1) jobs->ParallelFor(count, 1, job);
+    else job(0, count);
+
+    for (size_t i = 0; i < count; i++) {
+        HRESULT hr = CreatePreparedSRV(device, prepared[i], images[i]->format, &srvs[i]);
+        if (FAILED(hr)) return hr;
+        TrackShaderResourceView(srvs[i], "Texture", std::filesystem::path(clips[i].texturePath).u8string());
+        if (gutters) gutters[i] = { prepared[i].gutterU, prepared[i].gutterV };
+    }
+    return S_OK;
+}
+
+CookRule MakeTextureCookRule() {
+    CookRule rule;
+    rule.name = "texture";
+    rule.extension = ".png";
+    rule.outputExtension = ".ctex";
+    rule.version = 1;
+    rule.cook = [](const CookInput& input, std::vector<uint8_t>* output, std::string* error) {
+        PROFILE_ZONE("CookTexture");
+        TexturePrepOptions prep;
+        int columns = 1, rows = 1;
+        std::vector<uint8_t> settings;
+        if (input.ReadDependency(input.path + ".prep", &settings)) {
+            ParseTexturePrepSettings(std::string(settings.begin(), settings.end()), &prep, &columns, &rows);
+        }
+
+        // WIC は COM を使う。ジョブのスレッドごとに初期化する
+        HRESULT co = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        DirectX::TexMetadata metadata;
+        DirectX::ScratchImage scratchImage;
+        DirectX::ScratchImage converted;
+        const DirectX::Image* image = nullptr;
+        HRESULT hr = DirectX::LoadFromWICMemory(input.bytes.data(), input.bytes.size(), DirectX::WIC_FLAGS_NONE, &metadata, scratchImage);
+        if (SUCCEEDED(hr)) hr = GetRgba8Image(scratchImage, converted, &image);
+        if (SUCCEEDED(co)) CoUninitialize();
+        if (FAILED(hr)) {
+            *error = "cannot decode image";
+            return false;
+        }
+
+        CookedTextureHeader header = {};
+        header.magic = 0x58455443;      // "CTEX"
+        header.version = 1;
+        header.alphaMode = static_cast<uint8_t>(ClassifySpriteAlpha(image->pixels, image->rowPitch, 0, 0,
+            static_cast<int>(image->width), static_cast<int>(image->height)));
+
+        TexturePrepOutput prepared;
+        PrepareTexture(MakePrepInput(*image, columns, rows), prep, &prepared);
+        header.width = static_cast<uint32_t>(prepared.width);
+        header.height = static_cast<uint32_t>(prepared.height);
+        header.format = static_cast<uint32_t>(image->format);
+        header.gutterU = prepared.gutterU;
+        header.gutterV = prepared.gutterV;
+
+        output->resize(sizeof(header) + prepared.pixels.size());
+        std::memcpy(output->data(), &header, sizeof(header));
+        std::memcpy(output->data() + sizeof(header), prepared.pixels.data(), prepared.pixels.size());
+        return true;
+    };
+    return rule;
+}
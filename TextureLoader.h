@@ -11,13 +11,54 @@
 
 #include <d3d11.h>
 #include <DirectXTex.h>
+#include <DirectXMath.h>
+#include "SpritePass.h"
+#include "TexturePrep.h"
+#include <cstdint>
+#include <vector>
 
+struct AnimationData;
+struct CollisionMask;
+struct CookRule;
+struct SpriteMesh;
+class JobSystem;
 
 
 
 
+
+// outAlphaMode を渡すと、ピクセルからスプライトのアルファの使い方（不透明・アルファテスト・半透明）も決める
+// GPU には prep で整えたピクセルを送る（既定は premultiplied alpha。ブレンドは ONE / INV_SRC_ALPHA）
+// columns x rows はシートのフレームの数（prep.gutter の余白をフレームごとに足す）。幅と高さは元の画像の大きさ
 HRESULT LoadTextureAndCreateSRV(ID3D11Device* device, const wchar_t* filename, ID3D11ShaderResourceView** srv, float* outWidth = nullptr,
-    float* outHeight = nullptr);
+    float* outHeight = nullptr, SpriteAlphaMode* outAlphaMode = nullptr, const TexturePrepOptions& prep = TexturePrepOptions(),
+    int columns = 1, int rows = 1);
+
+// ヘッダーだけ読んで、LoadTextureAndCreateSRV が作るテクスチャの大きさ（余白と縮小の後）を求める
+HRESULT GetPreparedTextureSize(const wchar_t* filename, const TexturePrepOptions& prep, int columns, int rows, int* outWidth, int* outHeight);
+
+// アニメーションのシートを count 枚読み込んで SRV を作り、同じピクセルからフレームごとの当たりマスクも作る
+// meshes を渡すと、フレームごとの絵のある部分を囲む多角形（SpriteMesh）も作る
+// マスク・多角形・前処理は jobs があればシートごとに並列。配列はどれも count 個
+// prep.gutter でフレームに余白を足したときは、gutters にシートごとの UV の余白が入る（GetAnimFrameUV の結果に足す）
+HRESULT LoadTexturesWithMasks(ID3D11Device* device, const AnimationData* clips, size_t count, ID3D11ShaderResourceView** srvs,
+    std::vector<CollisionMask>* masks, std::vector<SpriteMesh>* meshes, DirectX::XMFLOAT2* gutters, JobSystem* jobs,
+    float* outWidth = nullptr, float* outHeight = nullptr, uint8_t alphaThreshold = 128, const TexturePrepOptions& prep = TexturePrepOptions());
+
+// 変換済みのテクスチャ（.ctex）の先頭。続けて width x height の RGBA8（前処理済み）が詰めて並ぶ
+struct CookedTextureHeader {
+    uint32_t magic;             // "CTEX"
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t format;            // DXGI_FORMAT（RGBA8 か BGRA8。sRGB かどうかも元の画像のまま）
+    float gutterU;
+    float gutterV;
+    uint8_t alphaMode;          // SpriteAlphaMode（前処理の前のピクセルで決めたもの）
+    uint8_t reserved[3];
+};
 
+// AssetCooker の規則（.png → .ctex）。設定は隣の <画像>.prep から読み、それも依存になる（なければ premultiply だけ）
+CookRule MakeTextureCookRule();
 
 #endif
\ No newline at end of file
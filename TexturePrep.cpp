@@ -0,0 +1,496 @@
+﻿/**********************************************************************************
+    TexturePrep.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "TexturePrep.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TEXTUREPREP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+    // x / 255 を四捨五入（x は 255 * 255 まで）。SSE2 版も同じ式なので結果は一致する
+    inline uint32_t Div255(uint32_t x) {
+        x += 128;
+        return (x + (x >> 8)) >> 8;
+    }
+
+    struct SrgbTables {
+        uint16_t toLinear[256];
+        uint8_t toSrgb[4096];
+
+        SrgbTables() {
+            for (int i = 0; i < 256; i++) {
+                double c = i / 255.0;
+                double l = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+                toLinear[i] = static_cast<uint16_t>(std::lround(l * 4095.0));
+            }
+            for (int i = 0; i < 4096; i++) {
+                double l = i / 4095.0;
+                double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+                toSrgb[i] = static_cast<uint8_t>(std::lround(c * 255.0));
+            }
+        }
+    };
+
+    const SrgbTables& GetSrgbTables() {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+#if TEXTUREPREP_SSE2
+    // 1 回分を行ごとにまとめて計算する。色の決まったピクセルを (r, g, b, 1)、ほかを 0 にした 16bit の面を作っておくと、
+    // 縦 3 行・横 3 ピクセルを足すだけで周りの色の合計と数が出る。割り算は float だが、
+    // 割り切れないときの商は整数から 1/9 以上離れているので、切り捨てればスカラー版の整数の割り算と同じ値になる
+    // 前の回で何も埋まらなかった行は面を作り直さず、上下とも変わらず色のないピクセルもない行は見ない
+    void BleedTransparentEdgesSse2(uint8_t* pixels, int width, int height, size_t rowPitch, int passes) {
+        const size_t w = static_cast<size_t>(width);
+        const size_t h = static_cast<size_t>(height);
+        const size_t padded = (w + 2) * 4;              // 左右に 0 のピクセルを 1 つずつ置いた 1 行分の 16bit 数
+        // フレームごとに呼ばれるので作業用のバッファはスレッドごとに使い回す（毎回確保するとページフォールトのほうが重い）
+        thread_local std::vector<uint8_t> known, changed, nextChanged;
+        thread_local std::vector<uint16_t> weighted, column;
+        thread_local std::vector<uint32_t> open;        // 行ごとの色のないピクセル数
+        known.resize(w * h);
+        weighted.resize(padded * h);
+        column.resize(padded);
+        open.assign(h, 0);
+        changed.assign(h, 1);
+        nextChanged.assign(h, 0);
+        for (size_t y = 0; y < h; y++) {
+            // 左右の 0 のピクセル（中は最初の回で全部書く）
+            std::memset(weighted.data() + y * padded, 0, 4 * sizeof(uint16_t));
+            std::memset(weighted.data() + y * padded + padded - 4, 0, 4 * sizeof(uint16_t));
+        }
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i alphaOne = _mm_set1_epi32(0x01000000);
+        const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+        auto loadKnown = [&](const uint8_t* k) {
+            int32_t bits;
+            std::memcpy(&bits, k, 4);
+            return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+        };
+
+        for (size_t y = 0; y < h; y++) {
+            const uint8_t* row = pixels + y * rowPitch;
+            uint8_t* k = known.data() + y * w;
+            uint32_t count = 0;
+            size_t x = 0;
+            for (; x + 4 <= w; x += 4) {
+                __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+                __m128i empty = _mm_cmpeq_epi32(_mm_srli_epi32(px, 24), zero);
+                __m128i on = _mm_andnot_si128(empty, one);
+                int32_t bits = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(on, zero), zero));
+                std::memcpy(k + x, &bits, 4);
+                static const uint8_t kBitCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+                count += kBitCount[_mm_movemask_ps(_mm_castsi128_ps(empty))];
+            }
+            for (; x < w; x++) {
+                k[x] = row[x * 4 + 3] != 0 ? 1 : 0;
+                count += row[x * 4 + 3] == 0 ? 1 : 0;
+            }
+            open[y] = count;
+        }
+
+        for (int pass = 0; pass < passes; pass++) {
+            // 1) 色の決まったピクセルだけを残した面（前の回で埋まった行だけ）
+            for (size_t y = 0; y < h; y++) {
+                if (!changed[y]) continue;
+                const uint8_t* row = pixels + y * rowPitch;
+                const uint8_t* k = known.data() + y * w;
+                uint16_t* out = weighted.data() + y * padded + 4;
+                size_t x = 0;
+                for (; x + 4 <= w; x += 4) {
+                    __m128i mask = _mm_cmpeq_epi32(loadKnown(k + x), one);
+                    __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+                    px = _mm_and_si128(_mm_or_si128(_mm_and_si128(px, rgbMask), alphaOne), mask);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4), _mm_unpacklo_epi8(px, zero));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x * 4 + 8), _mm_unpackhi_epi8(px, zero));
+                }
+                for (; x < w; x++) {
+                    bool on = k[x] == 1;
+                    for (int c = 0; c < 3; c++) out[x * 4 + c] = on ? row[x * 4 + c] : 0;
+                    out[x * 4 + 3] = on ? 1 : 0;
+                }
+            }
+
+            // 2) 縦に 3 行足してから横に 3 ピクセル足す。まだ色がなく、周りに 1 つでもあるピクセルを埋める
+            bool any = false;
+            for (size_t y = 0; y < h; y++) {
+                nextChanged[y] = 0;
+                if (open[y] == 0) continue;
+                if (!changed[y] && !(y > 0 && changed[y - 1]) && !(y + 1 < h && changed[y + 1])) continue;
+
+                const uint16_t* mid = weighted.data() + y * padded;
+                const uint16_t* up = y > 0 ? mid - padded : nullptr;
+                const uint16_t* down = y + 1 < h ? mid + padded : nullptr;
+                size_t i = 0;
+                for (; i + 8 <= padded; i += 8) {
+                    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + i));
+                    if (up) s = _mm_add_epi16(s, _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + i)));
+                    if (down) s = _mm_add_epi16(s, _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + i)));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(column.data() + i), s);
+                }
+                for (; i < padded; i++) column[i] = static_cast<uint16_t>(mid[i] + (up ? up[i] : 0) + (down ? down[i] : 0));
+
+                uint8_t* row = pixels + y * rowPitch;
+                uint8_t* k = known.data() + y * w;
+                const uint16_t* c = column.data();
+                uint32_t filled = 0;
+                size_t x = 0;
+                for (; x + 4 <= w; x += 4) {
+                    __m128i empty = _mm_cmpeq_epi32(loadKnown(k + x), zero);
+                    if (_mm_movemask_epi8(empty) == 0) continue;
+                    __m128i sum[2];
+                    for (int half = 0; half < 2; half++) {
+                        const uint16_t* p = c + (x + static_cast<size_t>(half) * 2) * 4;
+                        sum[half] = _mm_add_epi16(_mm_add_epi16(
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4))),
+                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8)));
+                    }
+                    // 数（4 番目の 16bit、9 まで）が 0 でなく、まだ色のないピクセル
+                    __m128i count = _mm_srli_epi32(_mm_packus_epi16(sum[0], sum[1]), 24);
+                    __m128i fill = _mm_andnot_si128(_mm_cmpeq_epi32(count, zero), empty);
+                    int bits = _mm_movemask_ps(_mm_castsi128_ps(fill));
+                    if (bits == 0) continue;
+
+                    __m128i q[4];
+                    for (int p = 0; p < 4; p++) {
+                        __m128i s = (p & 1) ? _mm_unpackhi_epi16(sum[p >> 1], zero) : _mm_unpacklo_epi16(sum[p >> 1], zero);
+                        __m128i n = _mm_shuffle_epi32(s, 0xff);
+                        __m128 num = _mm_cvtepi32_ps(_mm_add_epi32(s, _mm_srli_epi32(n, 1)));
+                        // 数が 0 のピクセルは書かないので、割る数を 1 にしておくだけ
+                        q[p] = _mm_cvttps_epi32(_mm_div_ps(num, _mm_cvtepi32_ps(_mm_max_epi16(n, one))));
+                    }
+                    __m128i color = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+                    __m128i m = _mm_and_si128(fill, rgbMask);
+                    __m128i* dst = reinterpret_cast<__m128i*>(row + x * 4);
+                    __m128i old = _mm_loadu_si128(dst);
+                    _mm_storeu_si128(dst, _mm_or_si128(_mm_andnot_si128(m, old), _mm_and_si128(m, color)));
+                    for (int p = 0; p < 4; p++) {
+                        if (bits & (1 << p)) {
+                            k[x + static_cast<size_t>(p)] = 1;
+                            filled++;
+                        }
+                    }
+                }
+                for (; x < w; x++) {
+                    if (k[x] != 0) continue;
+                    uint32_t s[4];
+                    for (int ch = 0; ch < 4; ch++) s[ch] = static_cast<uint32_t>(c[x * 4 + ch]) + c[x * 4 + 4 + ch] + c[x * 4 + 8 + ch];
+                    uint32_t n = s[3];
+                    if (n == 0) continue;
+                    for (int ch = 0; ch < 3; ch++) row[x * 4 + ch] = static_cast<uint8_t>((s[ch] + n / 2) / n);
+                    k[x] = 1;
+                    filled++;
+                }
+                if (filled > 0) {
+                    open[y] -= filled;
+                    nextChanged[y] = 1;
+                    any = true;
+                }
+            }
+            if (!any) return;
+            changed.swap(nextChanged);
+        }
+    }
+#endif
+}
+
+
+void PremultiplyAlpha(uint8_t* pixels, size_t count) {
+    size_t i = 0;
+#if TEXTUREPREP_SSE2
+    // 16bit に広げて 2 ピクセルずつ掛ける。アルファのレーンは 255 を掛けて元の値に戻す
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgbMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i round = _mm_set1_epi16(128);
+    for (; i + 4 <= count; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+        __m128i lo = _mm_unpacklo_epi8(px, zero);
+        __m128i hi = _mm_unpackhi_epi8(px, zero);
+        __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xFF), 0xFF);
+        __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xFF), 0xFF);
+        alo = _mm_or_si128(_mm_and_si128(alo, rgbMask), alphaOne);
+        ahi = _mm_or_si128(_mm_and_si128(ahi, rgbMask), alphaOne);
+        lo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), round);
+        hi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; i++) {
+        uint8_t* p = pixels + i * 4;
+        uint32_t a = p[3];
+        p[0] = static_cast<uint8_t>(Div255(p[0] * a));
+        p[1] = static_cast<uint8_t>(Div255(p[1] * a));
+        p[2] = static_cast<uint8_t>(Div255(p[2] * a));
+    }
+}
+
+void PremultiplyAlphaLinear(uint8_t* pixels, size_t count) {
+    const SrgbTables& t = GetSrgbTables();
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* p = pixels + i * 4;
+        uint32_t a = p[3];
+        if (a == 255) continue;
+        p[0] = t.toSrgb[Div255(t.toLinear[p[0]] * a)];
+        p[1] = t.toSrgb[Div255(t.toLinear[p[1]] * a)];
+        p[2] = t.toSrgb[Div255(t.toLinear[p[2]] * a)];
+    }
+}
+
+uint16_t SrgbToLinear12(uint8_t srgb) {
+    return GetSrgbTables().toLinear[srgb];
+}
+
+uint8_t Linear12ToSrgb(uint16_t linear) {
+    return GetSrgbTables().toSrgb[linear < 4096 ? linear : 4095];
+}
+
+void DownsampleHalf(const uint8_t* src, int width, int height, uint8_t* dst) {
+    int dstW = width / 2;
+    int dstH = height / 2;
+    size_t srcPitch = static_cast<size_t>(width) * 4;
+    for (int y = 0; y < dstH; y++) {
+        const uint8_t* row0 = src + static_cast<size_t>(y * 2) * srcPitch;
+        const uint8_t* row1 = row0 + srcPitch;
+        uint8_t* out = dst + static_cast<size_t>(y) * dstW * 4;
+        int x = 0;
+#if TEXTUREPREP_SSE2
+        // 2 行 x 4 ピクセルを 16bit で足し、隣どうしを足して 2 ピクセル分にする（丸めはスカラー版と同じ）
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(2);
+        for (; x + 2 <= dstW; x += 2) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), round), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(sum, zero));
+        }
+#endif
+        for (; x < dstW; x++) {
+            const uint8_t* a = row0 + x * 8;
+            const uint8_t* b = row1 + x * 8;
+            for (int c = 0; c < 4; c++) {
+                out[x * 4 + c] = static_cast<uint8_t>((a[c] + a[c + 4] + b[c] + b[c + 4] + 2) >> 2);
+            }
+        }
+    }
+}
+
+void BleedTransparentEdges(uint8_t* pixels, int width, int height, size_t rowPitch, int passes) {
+    if (width <= 0 || height <= 0 || passes <= 0) return;
+#if TEXTUREPREP_SSE2
+    BleedTransparentEdgesSse2(pixels, width, height, rowPitch, passes);
+#else
+    // 0 = 色がない、1 = 色が決まっている、2 = この回で埋めた（次の回までは隣に使わない）
+    const size_t w = static_cast<size_t>(width);
+    std::vector<uint8_t> known(w * static_cast<size_t>(height));
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = pixels + static_cast<size_t>(y) * rowPitch;
+        for (int x = 0; x < width; x++) known[static_cast<size_t>(y) * w + static_cast<size_t>(x)] = row[x * 4 + 3] != 0 ? 1 : 0;
+    }
+
+    // 埋める候補は色のあるピクセルの隣だけ。最初に一度だけ全体を見て、あとは埋めたところの隣から探す
+    std::vector<uint32_t> frontier, next;
+    auto pushNeighbors = [&](int x, int y, std::vector<uint32_t>* out) {
+        for (int dy = -1; dy <= 1; dy++) {
+            int ny = y + dy;
+            if (ny < 0 || ny >= height) continue;
+            for (int dx = -1; dx <= 1; dx++) {
+                int nx = x + dx;
+                if (nx < 0 || nx >= width) continue;
+                size_t index = static_cast<size_t>(ny) * w + static_cast<size_t>(nx);
+                if (known[index] == 0) {
+                    known[index] = 3;       // 候補に入れた印（同じピクセルを二度入れない）
+                    out->push_back(static_cast<uint32_t>(index));
+                }
+            }
+        }
+    };
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (known[static_cast<size_t>(y) * w + static_cast<size_t>(x)] == 1) pushNeighbors(x, y, &frontier);
+        }
+    }
+
+    std::vector<uint32_t> filled;
+    for (int pass = 0; pass < passes && !frontier.empty(); pass++) {
+        filled.clear();
+        for (uint32_t index : frontier) {
+            int x = static_cast<int>(index % w);
+            int y = static_cast<int>(index / w);
+            uint32_t r = 0, g = 0, b = 0, n = 0;
+            for (int dy = -1; dy <= 1; dy++) {
+                int ny = y + dy;
+                if (ny < 0 || ny >= height) continue;
+                const uint8_t* nrow = pixels + static_cast<size_t>(ny) * rowPitch;
+                for (int dx = -1; dx <= 1; dx++) {
+                    int nx = x + dx;
+                    if (nx < 0 || nx >= width) continue;
+                    if (known[static_cast<size_t>(ny) * w + static_cast<size_t>(nx)] != 1) continue;
+                    r += nrow[nx * 4];
+                    g += nrow[nx * 4 + 1];
+                    b += nrow[nx * 4 + 2];
+                    n++;
+                }
+            }
+            uint8_t* p = pixels + static_cast<size_t>(y) * rowPitch + static_cast<size_t>(x) * 4;
+            p[0] = static_cast<uint8_t>((r + n / 2) / n);
+            p[1] = static_cast<uint8_t>((g + n / 2) / n);
+            p[2] = static_cast<uint8_t>((b + n / 2) / n);
+            filled.push_back(index);
+        }
+        for (uint32_t index : filled) known[index] = 1;
+        next.clear();
+        if (pass + 1 < passes) {
+            for (uint32_t index : filled) pushNeighbors(static_cast<int>(index % w), static_cast<int>(index / w), &next);
+        }
+        frontier.swap(next);
+    }
+#endif
+}
+
+void CopyWithFrameGutters(const uint8_t* src, int width, int height, size_t rowPitch, int columns, int rows, int gutter,
+    std::vector<uint8_t>* dst, int* dstWidth, int* dstHeight) {
+    int frameW = width / columns;
+    int frameH = height / rows;
+    int cellW = frameW + gutter * 2;
+    int cellH = frameH + gutter * 2;
+    *dstWidth = cellW * columns;
+    *dstHeight = cellH * rows;
+    size_t dstPitch = static_cast<size_t>(*dstWidth) * 4;
+    dst->resize(dstPitch * static_cast<size_t>(*dstHeight));
+    if (frameW <= 0 || frameH <= 0) return;
+
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < columns; col++) {
+            // 余白の行は、フレームの一番上・下の行をそのまま繰り返す
+            for (int y = 0; y < cellH; y++) {
+                int sy = y - gutter;
+                sy = sy < 0 ? 0 : (sy >= frameH ? frameH - 1 : sy);
+                const uint8_t* s = src + static_cast<size_t>(row * frameH + sy) * rowPitch + static_cast<size_t>(col * frameW) * 4;
+                uint8_t* d = dst->data() + static_cast<size_t>(row * cellH + y) * dstPitch + static_cast<size_t>(col * cellW) * 4;
+                for (int x = 0; x < gutter; x++) std::memcpy(d + x * 4, s, 4);
+                std::memcpy(d + gutter * 4, s, static_cast<size_t>(frameW) * 4);
+                const uint8_t* last = s + static_cast<size_t>(frameW - 1) * 4;
+                for (int x = 0; x < gutter; x++) std::memcpy(d + static_cast<size_t>(gutter + frameW + x) * 4, last, 4);
+            }
+        }
+    }
+}
+
+void PrepareTexture(const TexturePrepInput& input, const TexturePrepOptions& options, TexturePrepOutput* out) {
+    PROFILE_ZONE("PrepareTexture");
+    int columns = input.columns > 0 ? input.columns : 1;
+    int rows = input.rows > 0 ? input.rows : 1;
+    // 割り切れないシートはフレームの境目が分からないので、余白は足さない
+    int gutter = (input.width % columns == 0 && input.height % rows == 0) ? options.gutter : 0;
+    if (gutter < 0) gutter = 0;
+
+    const uint8_t* src = input.pixels;
+    size_t srcPitch = input.rowPitch;
+    std::vector<uint8_t> bled;
+    if (!options.premultiply && options.bleedPasses > 0) {
+        // にじませるのはフレームの中だけ（隣のフレームの色を持ってこない）
+        bled.resize(static_cast<size_t>(input.width) * static_cast<size_t>(input.height) * 4);
+        for (int y = 0; y < input.height; y++) {
+            std::memcpy(bled.data() + static_cast<size_t>(y) * input.width * 4, src + static_cast<size_t>(y) * srcPitch,
+                static_cast<size_t>(input.width) * 4);
+        }
+        srcPitch = static_cast<size_t>(input.width) * 4;
+        int frameW = input.width / columns;
+        int frameH = input.height / rows;
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < columns; col++) {
+                BleedTransparentEdges(bled.data() + static_cast<size_t>(row * frameH) * srcPitch + static_cast<size_t>(col * frameW) * 4,
+                    frameW, frameH, srcPitch, options.bleedPasses);
+            }
+        }
+        src = bled.data();
+    }
+
+    if (gutter > 0) {
+        CopyWithFrameGutters(src, input.width, input.height, srcPitch, columns, rows, gutter, &out->pixels, &out->width, &out->height);
+        out->gutterU = static_cast<float>(gutter) / static_cast<float>(out->width);
+        out->gutterV = static_cast<float>(gutter) / static_cast<float>(out->height);
+    }
+    else {
+        out->width = input.width;
+        out->height = input.height;
+        out->gutterU = 0.0f;
+        out->gutterV = 0.0f;
+        size_t pitch = static_cast<size_t>(input.width) * 4;
+        out->pixels.resize(pitch * static_cast<size_t>(input.height));
+        for (int y = 0; y < input.height; y++) {
+            std::memcpy(out->pixels.data() + static_cast<size_t>(y) * pitch, src + static_cast<size_t>(y) * srcPitch, pitch);
+        }
+    }
+
+    if (options.premultiply) {
+        size_t count = static_cast<size_t>(out->width) * static_cast<size_t>(out->height);
+        if (options.linearPremultiply) PremultiplyAlphaLinear(out->pixels.data(), count);
+        else PremultiplyAlpha(out->pixels.data(), count);
+    }
+
+    // 余白の割合は変わらないので gutterU / gutterV はそのまま使える
+    std::vector<uint8_t> half;
+    for (int level = 0; level < options.downsample; level++) {
+        if (out->width % (columns * 2) != 0 || out->height % (rows * 2) != 0) break;
+        half.resize(out->pixels.size() / 4);
+        DownsampleHalf(out->pixels.data(), out->width, out->height, half.data());
+        out->pixels.swap(half);
+        out->width /= 2;
+        out->height /= 2;
+    }
+}
+
+void ParseTexturePrepSettings(const std::string& text, TexturePrepOptions* options, int* columns, int* rows) {
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream in(line);
+        std::string name;
+        int value = 0;
+        if (!(in >> name >> value)) continue;
+        if (name == "columns") *columns = value;
+        else if (name == "rows") *rows = value;
+        else if (name == "gutter") options->gutter = value;
+        else if (name == "bleed") options->bleedPasses = value;
+        else if (name == "premultiply") options->premultiply = value != 0;
+        else if (name == "linear") options->linearPremultiply = value != 0;
+        else if (name == "downsample") options->downsample = value;
+    }
+}
+
+void PrepareTextures(const TexturePrepInput* inputs, size_t count, const TexturePrepOptions& options,
+    TexturePrepOutput* outs, JobSystem* jobs) {
+    PROFILE_ZONE("PrepareTextures");
+    auto job = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) PrepareTexture(inputs[i], options, &outs[i]);
+    };
+    if (jobs && count > 1) jobs->ParallelFor(count, 1, job);
+    else job(0, count);
+}
@@ -0,0 +1,83 @@
+﻿/**********************************************************************************
+    TexturePrep.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef TEXTUREPREP_H
+#define TEXTUREPREP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+struct TexturePrepOptions {
+    bool premultiply = true;        // ブレンドは ONE / INV_SRC_ALPHA になる
+    bool linearPremultiply = false; // sRGB をいったん線形に戻してから掛ける（縁が暗くなりにくい）
+    // straight のまま使うとき、透明なピクセルの色を隣から広げる回数（premultiply すると色は 0 になるので使わない）
+    int bleedPasses = 0;
+    // フレームの周りに足すピクセル数。端の色を繰り返すので、線形補間で隣のフレームを拾わない
+    int gutter = 0;
+    // 最後に幅と高さを半分にする回数（メモリが足りないときの縮小版。フレームが割り切れなくなる手前で止める）
+    int downsample = 0;
+};
+
+// 8bit RGBA / BGRA（アルファは 4 バイト目）の入力。columns x rows のフレームに分かれたシート（1 x 1 なら 1 枚絵）
+struct TexturePrepInput {
+    const uint8_t* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t rowPitch = 0;
+    int columns = 1;
+    int rows = 1;
+};
+
+struct TexturePrepOutput {
+    std::vector<uint8_t> pixels;    // width x height x 4、詰めて並ぶ
+    int width = 0;
+    int height = 0;
+    // シートの幅・高さに対するフレームの余白。UV はフレームごとに offset += gutter、scale -= 2 * gutter
+    float gutterU = 0.0f;
+    float gutterV = 0.0f;
+};
+
+//
+// 読み込んだ画像を GPU に送る前に整える（フレームの余白、色のにじませ、アルファの乗算の順）
+// 1 枚は 1 スレッドで処理し、jobs があれば画像ごとに並列にする
+void PrepareTexture(const TexturePrepInput& input, const TexturePrepOptions& options, TexturePrepOutput* out);
+void PrepareTextures(const TexturePrepInput* inputs, size_t count, const TexturePrepOptions& options,
+    TexturePrepOutput* outs, JobSystem* jobs);
+
+// 画像ごとのインポート設定（AssetCooker では <画像>.prep）。1 行に「名前 値」で、'#' から行末はコメント
+// columns rows gutter bleed premultiply linear downsample。知らない名前は無視し、書いていないものは今の値のまま
+void ParseTexturePrepSettings(const std::string& text, TexturePrepOptions* options, int* columns, int* rows);
+
+// 以下は 1 段ずつのカーネル。pixels は詰めて並んだ RGBA8、count はピクセル数
+// SSE2 があれば 4 ピクセルずつ処理する（結果はスカラー版と同じ）
+void PremultiplyAlpha(uint8_t* pixels, size_t count);
+// 線形空間で掛ける版。SSE2 には表引きの命令がないので表を使うスカラー版だけ
+void PremultiplyAlphaLinear(uint8_t* pixels, size_t count);
+
+// sRGB と線形の変換表（線形は 0..4095 の 12bit。8bit では暗い側の階調が足りない）
+uint16_t SrgbToLinear12(uint8_t srgb);
+uint8_t Linear12ToSrgb(uint16_t linear);
+
+// 2x2 の平均で幅と高さを半分にする（width と height は偶数）。dst は (width / 2) x (height / 2) で詰めて並ぶ
+// premultiplied のまま平均してよい（straight だと透明なピクセルの色も混ざる）
+void DownsampleHalf(const uint8_t* src, int width, int height, uint8_t* dst);
+
+// アルファが 0 のピクセルの RGB を、色のある隣のピクセルの平均で埋める。1 回で 1 ピクセルずつ広がる
+void BleedTransparentEdges(uint8_t* pixels, int width, int height, size_t rowPitch, int passes);
+
+// フレームごとに周りへ gutter ピクセルの余白を足して dst に並べる。dst は
+// columns * (frameW + 2 * gutter) x rows * (frameH + 2 * gutter) で詰めて並ぶ
+void CopyWithFrameGutters(const uint8_t* src, int width, int height, size_t rowPitch, int columns, int rows, int gutter,
+    std::vector<uint8_t>* dst, int* dstWidth, int* dstHeight);
+
+
+#endif
@@ -0,0 +1,260 @@
+﻿/**********************************************************************************
+    TextureResidency.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "TextureResidency.h"
+#include "Profiler.h"
+#include <algorithm>
+
+TextureResidency::TextureResidency(const TextureResidencyDesc& desc)
+    : desc(desc)
+{
+
+}
+
+void TextureResidency::SetDesc(const TextureResidencyDesc& newDesc) {
+    desc = newDesc;
+}
+
+const TextureResidencyDesc& TextureResidency::GetDesc() const {
+    return desc;
+}
+
+int TextureResidency::AddTexture(uint64_t fullBytes, uint64_t reducedBytes, bool pinned) {
+    int texture;
+    if (!freeList.empty()) {
+        texture = freeList.back();
+        freeList.pop_back();
+    }
+    else {
+        texture = static_cast<int>(entries.size());
+        entries.emplace_back();
+    }
+    Entry& e = entries[static_cast<size_t>(texture)];
+    e = Entry();
+    e.fullBytes = fullBytes;
+    e.reducedBytes = reducedBytes < fullBytes ? reducedBytes : fullBytes;
+    e.pinned = pinned;
+    e.alive = true;
+    return texture;
+}
+
+void TextureResidency::RemoveTexture(int texture) {
+    Entry& e = entries[static_cast<size_t>(texture)];
+    if (!e.alive) return;
+    SetLevel(texture, TextureLevel::None);
+    e.alive = false;
+    for (std::vector<int>& list : chunks) {
+        list.erase(std::remove(list.begin(), list.end(), texture), list.end());
+    }
+    freeList.push_back(texture);
+}
+
+void TextureResidency::AddChunkTexture(int chunk, int texture) {
+    if (chunk < 0) return;
+    if (static_cast<size_t>(chunk) >= chunks.size()) chunks.resize(static_cast<size_t>(chunk) + 1);
+    std::vector<int>& list = chunks[static_cast<size_t>(chunk)];
+    entries[static_cast<size_t>(texture)].chunked = true;
+    if (std::find(list.begin(), list.end(), texture) == list.end()) list.push_back(texture);
+}
+
+void TextureResidency::BeginFrame() {
+    frame++;
+    prefetchedThisFrame = 0;
+}
+
+void TextureResidency::MarkUsed(int texture) {
+    Entry& e = entries[static_cast<size_t>(texture)];
+    if (e.lastUsed == frame) return;
+    e.lastUsed = frame;
+    if (e.level != TextureLevel::Full) {
+        stats.demandMisses++;
+        demand.push_back(texture);
+    }
+}
+
+void TextureResidency::SetFocus(int chunk, int direction) {
+    focusChunk = chunk;
+    focusDirection = direction < 0 ? -1 : (direction > 0 ? 1 : 0);
+}
+
+void TextureResidency::RequestFree(uint64_t bytes) {
+    pendingFree += bytes;
+}
+
+uint64_t TextureResidency::GetBytes(const Entry& e, TextureLevel level) const {
+    return level == TextureLevel::Full ? e.fullBytes : (level == TextureLevel::Reduced ? e.reducedBytes : 0);
+}
+
+bool TextureResidency::IsBusy(const Entry& e) const {
+    return e.pinned || frame - e.lastUsed < desc.minIdleFrames || e.wantedFrame == frame;
+}
+
+void TextureResidency::Change(int texture, TextureLevel level, bool prefetch, std::vector<TextureResidencyRequest>* out) {
+    Entry& e = entries[static_cast<size_t>(texture)];
+    if (e.level == level) return;
+    if (level == TextureLevel::Full) {
+        stats.loads++;
+        if (prefetch) stats.prefetches++;
+    }
+    else if (level == TextureLevel::None) stats.evictions++;
+    else if (e.level == TextureLevel::Full) stats.downgrades++;
+    SetLevel(texture, level);
+    out->push_back({ texture, level, prefetch });
+}
+
+uint64_t TextureResidency::Evict(uint64_t needed, int exclude, std::vector<TextureResidencyRequest>* out) {
+    order.clear();
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& e = entries[i];
+        if (!e.alive || e.level == TextureLevel::None || IsBusy(e) || static_cast<int>(i) == exclude) continue;
+        order.push_back(static_cast<int>(i));
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return entries[static_cast<size_t>(a)].lastUsed < entries[static_cast<size_t>(b)].lastUsed;
+    });
+
+    uint64_t freed = 0;
+    for (int texture : order) {
+        if (freed >= needed) break;
+        freed += GetBytes(entries[static_cast<size_t>(texture)], entries[static_cast<size_t>(texture)].level);
+        Change(texture, TextureLevel::None, false, out);
+    }
+    return freed;
+}
+
+uint64_t TextureResidency::Downgrade(uint64_t needed, int exclude, std::vector<TextureResidencyRequest>* out) {
+    // 使っているものも対象（追い出すと描けなくなるので縮小版にする）。古い順
+    order.clear();
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& e = entries[i];
+        if (!e.alive || e.pinned || e.level != TextureLevel::Full || static_cast<int>(i) == exclude) continue;
+        if (e.reducedBytes >= e.fullBytes) continue;
+        order.push_back(static_cast<int>(i));
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return entries[static_cast<size_t>(a)].lastUsed < entries[static_cast<size_t>(b)].lastUsed;
+    });
+
+    uint64_t freed = 0;
+    for (int texture : order) {
+        if (freed >= needed) break;
+        const Entry& e = entries[static_cast<size_t>(texture)];
+        freed += e.fullBytes - e.reducedBytes;
+        Change(texture, TextureLevel::Reduced, false, out);
+    }
+    return freed;
+}
+
+void TextureResidency::Update(std::vector<TextureResidencyRequest>* out) {
+    PROFILE_ZONE("TextureResidency::Update");
+    out->clear();
+
+    // 先読みの範囲（進む向きの先から近い順）。範囲内のものはこのフレームは追い出さない
+    int windowChunks[16];
+    int windowCount = 0;
+    int ahead = focusDirection >= 0 ? 1 : -1;
+    int aheadCount = focusDirection != 0 ? desc.prefetchAhead : desc.prefetchBehind;
+    windowChunks[windowCount++] = focusChunk;
+    for (int d = 1; d <= aheadCount && windowCount < 16; d++) windowChunks[windowCount++] = focusChunk + ahead * d;
+    for (int d = 1; d <= desc.prefetchBehind && windowCount < 16; d++) windowChunks[windowCount++] = focusChunk - ahead * d;
+    for (int w = 0; w < windowCount; w++) {
+        int chunk = windowChunks[w];
+        if (chunk < 0 || static_cast<size_t>(chunk) >= chunks.size()) continue;
+        for (int texture : chunks[static_cast<size_t>(chunk)]) entries[static_cast<size_t>(texture)].wantedFrame = frame;
+    }
+
+    // 離れたチャンクの分は、描画でも先読みでも長く要らなかったものから空けておく
+    // 何百フレーム待つものなので、全部を見るのは 16 フレームに 1 回で足りる
+    if (desc.evictIdleFrames > 0 && frame % 16 == 0) {
+        for (size_t i = 0; i < entries.size(); i++) {
+            const Entry& e = entries[i];
+            if (!e.chunked || e.level == TextureLevel::None || e.pinned) continue;
+            if (frame - std::max(e.lastUsed, e.wantedFrame) < desc.evictIdleFrames) continue;
+            Change(static_cast<int>(i), TextureLevel::None, false, out);
+        }
+    }
+
+    // 外から頼まれた分は、使っていないものを追い出し、足りなければ縮小版に落とす
+    if (pendingFree > 0) {
+        uint64_t freed = Evict(pendingFree, -1, out);
+        if (freed < pendingFree && desc.reducedFallback) Downgrade(pendingFree - freed, -1, out);
+        pendingFree = 0;
+    }
+
+    // 描画に要るもの。予算に入らなければ古いものを追い出し、それでも無理なら縮小版で我慢する
+    // 描けないよりはよいので、縮小版は予算を超えても載せる（次のフレーム以降で追い出される）
+    for (int texture : demand) {
+        Entry& e = entries[static_cast<size_t>(texture)];
+        if (!e.alive || e.level == TextureLevel::Full) continue;
+        uint64_t need = e.fullBytes - GetBytes(e, e.level);
+        if (residentBytes + need > desc.budgetBytes) Evict(residentBytes + need - desc.budgetBytes, texture, out);
+        if (residentBytes + need <= desc.budgetBytes || !desc.reducedFallback) {
+            Change(texture, TextureLevel::Full, false, out);
+            continue;
+        }
+        if (e.level == TextureLevel::Reduced) continue;
+        need = e.reducedBytes;
+        if (residentBytes + need > desc.budgetBytes) Downgrade(residentBytes + need - desc.budgetBytes, texture, out);
+        Change(texture, TextureLevel::Reduced, false, out);
+    }
+    demand.clear();
+
+    // 先読みは予算の中だけ。範囲内と使っているものは追い出さない
+    for (int w = 0; w < windowCount && prefetchedThisFrame < desc.maxPrefetchPerFrame; w++) {
+        int chunk = windowChunks[w];
+        if (chunk < 0 || static_cast<size_t>(chunk) >= chunks.size()) continue;
+        for (int texture : chunks[static_cast<size_t>(chunk)]) {
+            if (prefetchedThisFrame >= desc.maxPrefetchPerFrame) break;
+            Entry& e = entries[static_cast<size_t>(texture)];
+            if (e.level == TextureLevel::Full) continue;
+            uint64_t need = e.fullBytes - GetBytes(e, e.level);
+            if (residentBytes + need > desc.budgetBytes) Evict(residentBytes + need - desc.budgetBytes, texture, out);
+            if (residentBytes + need > desc.budgetBytes) continue;
+            Change(texture, TextureLevel::Full, true, out);
+            prefetchedThisFrame++;
+        }
+    }
+}
+
+void TextureResidency::SetLevel(int texture, TextureLevel level) {
+    Entry& e = entries[static_cast<size_t>(texture)];
+    if (e.level == level) return;
+    if (e.level != TextureLevel::None) stats.residentCount--;
+    if (level != TextureLevel::None) stats.residentCount++;
+    residentBytes = residentBytes - GetBytes(e, e.level) + GetBytes(e, level);
+    e.level = level;
+    stats.residentBytes = residentBytes;
+    stats.peakBytes = std::max(stats.peakBytes, residentBytes);
+}
+
+TextureLevel TextureResidency::GetImmediateLevel(int texture) const {
+    const Entry& e = entries[static_cast<size_t>(texture)];
+    uint64_t need = e.fullBytes - GetBytes(e, e.level);
+    if (residentBytes + need <= desc.budgetBytes || !desc.reducedFallback) return TextureLevel::Full;
+    return e.level == TextureLevel::None ? TextureLevel::Reduced : e.level;
+}
+
+TextureLevel TextureResidency::GetLevel(int texture) const {
+    return entries[static_cast<size_t>(texture)].level;
+}
+
+uint32_t TextureResidency::GetLastUsedFrame(int texture) const {
+    return entries[static_cast<size_t>(texture)].lastUsed;
+}
+
+uint32_t TextureResidency::GetFrame() const {
+    return frame;
+}
+
+uint64_t TextureResidency::GetResidentBytes() const {
+    return residentBytes;
+}
+
+const TextureResidencyStats& TextureResidency::GetStats() const {
+    return stats;
+}
@@ -0,0 +1,136 @@
+﻿/**********************************************************************************
+    TextureResidency.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef TEXTURERESIDENCY_H
+#define TEXTURERESIDENCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TextureLevel : uint8_t {
+    None,       // 載っていない
+    Reduced,    // 縮小版（ミップを落としたもの）だけ
+    Full,
+};
+
+struct TextureResidencyDesc {
+    uint64_t budgetBytes = 256ull << 20;
+    // 最後に使ってからこのフレーム数が経つまでは追い出さない（同じフレームで使い直すものを捨てない）
+    uint32_t minIdleFrames = 2;
+    // 進んでいる方向のこのチャンク数先まで（戻る側は behind まで）を先読みする
+    int prefetchAhead = 2;
+    int prefetchBehind = 1;
+    // 1 フレームに読み込む数（描画に要るものは数えない）
+    int maxPrefetchPerFrame = 2;
+    // チャンクに登録したものは、使わず先読みの範囲にも入らないままこのフレーム数経てば予算に関係なく追い出す（0 なら予算を超えたときだけ）
+    uint32_t evictIdleFrames = 300;
+    // 予算に入らないとき、使っているテクスチャは追い出さずに縮小版へ落とす
+    bool reducedFallback = true;
+};
+
+// Update が返す、このフレームにしてほしいこと。level に合わせて読み込み・作り直し・解放をする
+struct TextureResidencyRequest {
+    int texture;
+    TextureLevel level;
+    bool prefetch;              // 先読み（描画ではまだ使っていない）
+};
+
+struct TextureResidencyStats {
+    uint64_t loads = 0;             // Full にした回数（先読みを含む）
+    uint64_t prefetches = 0;
+    uint64_t demandMisses = 0;      // 使おうとしたときに Full がなかった回数
+    uint64_t evictions = 0;
+    uint64_t downgrades = 0;        // Full から縮小版へ落とした回数
+    uint64_t residentBytes = 0;
+    uint64_t peakBytes = 0;
+    size_t residentCount = 0;
+};
+
+//
+// テクスチャをどれだけ載せておくかを決める（D3D は使わない。読み込みと解放は TextureStreamer が行う）
+// 描画で使ったフレームを覚えておき、予算を超えるときは一番長く使っていないものから追い出す
+// チャンクに登録したものは、離れてしばらく経てば予算に余裕があっても追い出す
+// ワールドのチャンクごとに使うテクスチャを登録しておくと、プレイヤーが向かう先のチャンクの分を先に読む
+class TextureResidency {
+public:
+    explicit TextureResidency(const TextureResidencyDesc& desc = TextureResidencyDesc());
+
+    void SetDesc(const TextureResidencyDesc& desc);
+    const TextureResidencyDesc& GetDesc() const;
+
+    // pinned は追い出さない（HUD のフォントなど）。返すのはテクスチャの番号
+    int AddTexture(uint64_t fullBytes, uint64_t reducedBytes, bool pinned = false);
+    void RemoveTexture(int texture);
+    void AddChunkTexture(int chunk, int texture);
+
+    // 毎フレーム最初に 1 回
+    void BeginFrame();
+
+    // 描画キューに積んだとき。載っていなければ次の Update で最優先で読む
+    void MarkUsed(int texture);
+
+    // プレイヤーのいるチャンクと進む向き（-1, 0, 1）。0 なら両側とも prefetchBehind まで
+    void SetFocus(int chunk, int direction);
+
+    // 外から頼まれた分（ResourceSetEvictionCallback の超過分など）。次の Update で使っていないものから空ける
+    void RequestFree(uint64_t bytes);
+
+    // 今フレームの読み込み・追い出しを決める。返した分はもうその状態になったものとして数える
+    // 読み込みに失敗したときは SetLevel で戻す
+    void Update(std::vector<TextureResidencyRequest>* out);
+
+    // 実際の状態を直接書き換える（失敗したときと、Update を待たずにその場で読んだとき）
+    void SetLevel(int texture, TextureLevel level);
+
+    // フレームの途中でその場で読むときの段階。ほかのテクスチャは追い出さないので、予算に入らなければ縮小版
+    // （描画キューに積んだ SRV を途中で解放しないため。空けるのは次の Update）
+    TextureLevel GetImmediateLevel(int texture) const;
+
+    TextureLevel GetLevel(int texture) const;
+    uint32_t GetLastUsedFrame(int texture) const;
+    uint32_t GetFrame() const;
+    uint64_t GetResidentBytes() const;
+    const TextureResidencyStats& GetStats() const;
+
+private:
+    struct Entry {
+        uint64_t fullBytes = 0;
+        uint64_t reducedBytes = 0;
+        uint32_t lastUsed = 0;
+        uint32_t wantedFrame = 0;       // 先読みの範囲に入っていた最後のフレーム
+        TextureLevel level = TextureLevel::None;
+        bool pinned = false;
+        bool chunked = false;           // どこかのチャンクに登録してある
+        bool alive = false;
+    };
+
+    uint64_t GetBytes(const Entry& e, TextureLevel level) const;
+    bool IsBusy(const Entry& e) const;
+    // exclude 以外の使っていないものを古い順に追い出して、needed バイト空ける。空いたバイト数を返す
+    uint64_t Evict(uint64_t needed, int exclude, std::vector<TextureResidencyRequest>* out);
+    uint64_t Downgrade(uint64_t needed, int exclude, std::vector<TextureResidencyRequest>* out);
+    void Change(int texture, TextureLevel level, bool prefetch, std::vector<TextureResidencyRequest>* out);
+
+    TextureResidencyDesc desc;
+    std::vector<Entry> entries;
+    std::vector<int> freeList;
+    std::vector<std::vector<int>> chunks;       // チャンクごとのテクスチャ
+    std::vector<int> demand;                    // 今フレーム使ったのに Full でないもの
+    std::vector<int> order;                     // Evict の作業用
+    uint32_t frame = 1;
+    int focusChunk = 0;
+    int focusDirection = 0;
+    uint64_t pendingFree = 0;
+    int prefetchedThisFrame = 0;
+    uint64_t residentBytes = 0;
+    TextureResidencyStats stats;
+};
+
+
+#endif
@@ -0,0 +1,167 @@
+﻿/**********************************************************************************
+    TextureStreamer.cpp
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#include "TextureStreamer.h"
+#include "TextureLoader.h"
+#include "Profiler.h"
+#include "ResourceRegistry.h"
+
+TextureStreamer::TextureStreamer(const TextureResidencyDesc& desc)
+    : device(nullptr),
+    residency(desc)
+{
+
+}
+
+TextureStreamer::~TextureStreamer() {
+    Release();
+}
+
+void TextureStreamer::Init(ID3D11Device* newDevice) {
+    device = newDevice;
+}
+
+void TextureStreamer::Release() {
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].alive) Remove(static_cast<int>(i));
+    }
+    entries.clear();
+}
+
+int TextureStreamer::AddEntry(const std::wstring& path, const TexturePrepOptions& prep, int columns, int rows,
+    int width, int height, bool pinned) {
+    // 縮小版は 1 段だけ。割り切れないシートは縮めないので Full と同じ大きさになる
+    TexturePrepOptions reducedPrep = prep;
+    reducedPrep.downsample = 1;
+    columns = columns > 0 ? columns : 1;
+    rows = rows > 0 ? rows : 1;
+    uint64_t fullBytes = static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4;
+    uint64_t reducedBytes = (width % (columns * 2) == 0 && height % (rows * 2) == 0) ? fullBytes / 4 : fullBytes;
+
+    int texture = residency.AddTexture(fullBytes, reducedBytes, pinned);
+    if (static_cast<size_t>(texture) >= entries.size()) entries.resize(static_cast<size_t>(texture) + 1);
+    Entry& e = entries[static_cast<size_t>(texture)];
+    e = Entry();
+    e.path = path;
+    e.prep = prep;
+    e.prep.downsample = 0;
+    e.columns = columns;
+    e.rows = rows;
+    e.alive = true;
+    return texture;
+}
+
+int TextureStreamer::Add(const std::wstring& path, const TexturePrepOptions& prep, int columns, int rows, bool pinned) {
+    int width = 0, height = 0;
+    TexturePrepOptions fullPrep = prep;
+    fullPrep.downsample = 0;
+    if (FAILED(GetPreparedTextureSize(path.c_str(), fullPrep, columns, rows, &width, &height))) return -1;
+    return AddEntry(path, prep, columns, rows, width, height, pinned);
+}
+
+int TextureStreamer::Adopt(ID3D11ShaderResourceView* srv, SpriteAlphaMode alphaMode, const std::wstring& path,
+    const TexturePrepOptions& prep, int columns, int rows, bool pinned) {
+    if (!srv) return -1;
+    ID3D11Resource* resource = nullptr;
+    srv->GetResource(&resource);
+    ID3D11Texture2D* texture2d = nullptr;
+    D3D11_TEXTURE2D_DESC desc = {};
+    if (resource && SUCCEEDED(resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&texture2d)))) {
+        texture2d->GetDesc(&desc);
+        texture2d->Release();
+    }
+    SAFE_RELEASE(resource);
+
+    int texture = AddEntry(path, prep, columns, rows, static_cast<int>(desc.Width), static_cast<int>(desc.Height), pinned);
+    Entry& e = entries[static_cast<size_t>(texture)];
+    e.srv = srv;
+    e.level = TextureLevel::Full;
+    e.alphaMode = alphaMode;
+    ResourceSetOwner(srv, "TextureStreamer");
+    residency.SetLevel(texture, TextureLevel::Full);
+    return texture;
+}
+
+void TextureStreamer::Remove(int texture) {
+    if (texture < 0 || static_cast<size_t>(texture) >= entries.size()) return;
+    Entry& e = entries[static_cast<size_t>(texture)];
+    if (!e.alive) return;
+    SAFE_RELEASE(e.srv);
+    e.alive = false;
+    residency.RemoveTexture(texture);
+}
+
+void TextureStreamer::MapToChunk(int texture, int chunk) {
+    if (texture < 0) return;
+    residency.AddChunkTexture(chunk, texture);
+}
+
+ID3D11ShaderResourceView* TextureStreamer::Use(int texture) {
+    if (texture < 0) return nullptr;
+    residency.MarkUsed(texture);
+    Entry& e = entries[static_cast<size_t>(texture)];
+    if (!e.srv) {
+        // 載っていないと描けないので、フレームの途中でもこれだけは読む
+        // ほかの SRV はもう描画キューに積んであるかもしれないので、追い出しや縮小は次の Update まで待つ
+        TextureLevel level = residency.GetImmediateLevel(texture);
+        if (Load(texture, level)) residency.SetLevel(texture, level);
+    }
+    return e.srv;
+}
+
+SpriteAlphaMode TextureStreamer::GetAlphaMode(int texture) const {
+    return entries[static_cast<size_t>(texture)].alphaMode;
+}
+
+void TextureStreamer::Update(int focusChunk, int direction) {
+    PROFILE_ZONE("TextureStreamer::Update");
+    residency.SetFocus(focusChunk, direction);
+    Apply();
+    residency.BeginFrame();
+}
+
+void TextureStreamer::OnMemoryPressure(uint64_t overBytes) {
+    residency.RequestFree(overBytes);
+}
+
+const TextureResidency& TextureStreamer::GetResidency() const {
+    return residency;
+}
+
+void TextureStreamer::Apply() {
+    residency.Update(&requests);
+    for (const TextureResidencyRequest& request : requests) {
+        Entry& e = entries[static_cast<size_t>(request.texture)];
+        if (request.level == TextureLevel::None) {
+            SAFE_RELEASE(e.srv);
+            e.level = TextureLevel::None;
+            continue;
+        }
+        // 読めなければ前のまま（TextureResidency の数え方も戻す）
+        if (!Load(request.texture, request.level)) residency.SetLevel(request.texture, e.level);
+    }
+}
+
+bool TextureStreamer::Load(int texture, TextureLevel level) {
+    PROFILE_ZONE("TextureStreamer::Load");
+    if (!device) return false;
+    Entry& e = entries[static_cast<size_t>(texture)];
+    TexturePrepOptions prep = e.prep;
+    prep.downsample = level == TextureLevel::Reduced ? 1 : 0;
+    ID3D11ShaderResourceView* srv = nullptr;
+    SpriteAlphaMode alphaMode = e.alphaMode;
+    if (FAILED(LoadTextureAndCreateSRV(device, e.path.c_str(), &srv, nullptr, nullptr, &alphaMode, prep, e.columns, e.rows))) {
+        return false;
+    }
+    ResourceSetOwner(srv, "TextureStreamer");
+    SAFE_RELEASE(e.srv);
+    e.srv = srv;
+    e.level = level;
+    e.alphaMode = alphaMode;
+    return true;
+}
@@ -0,0 +1,79 @@
+﻿/**********************************************************************************
+    TextureStreamer.h
+
+                                                                LI WENHUI
+                                                                2025/09/08
+
+**********************************************************************************/
+
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include "d3dApp.h"
+#include "SpritePass.h"
+#include "TexturePrep.h"
+#include "TextureResidency.h"
+#include <string>
+#include <vector>
+
+//
+// ファイルから読むテクスチャを TextureResidency の決めたとおりに読み込み・解放する
+// 描画では SRV を持ち続けずに、毎フレーム Use で受け取る（追い出された後は読み直しになる）
+// 読み込みは同期。描画で要るのに載っていないものだけはその場で読み、先読みは Update で 1 フレームに数枚まで
+// 解放と作り直しは Update の中だけ（描画キューは SRV を参照を持たずに指すので、フレームの途中では解放しない）
+// 縮小版は幅と高さを半分にしたもの（PNG のシートにはミップがないので、読み込むときに作る）
+class TextureStreamer {
+public:
+    explicit TextureStreamer(const TextureResidencyDesc& desc = TextureResidencyDesc());
+    ~TextureStreamer();
+
+    // device は呼び出し側が持ち続ける
+    void Init(ID3D11Device* device);
+    void Release();
+
+    // まだ読まない（大きさはファイルのヘッダーから）。初めて Use したときか、先読みで読む。失敗したら -1
+    int Add(const std::wstring& path, const TexturePrepOptions& prep, int columns = 1, int rows = 1, bool pinned = false);
+    // 読み込み済みの SRV を預かる（当たりマスクなどを同じピクセルから作るときは、呼び出し側で先に読む）
+    int Adopt(ID3D11ShaderResourceView* srv, SpriteAlphaMode alphaMode, const std::wstring& path,
+        const TexturePrepOptions& prep, int columns = 1, int rows = 1, bool pinned = false);
+    void Remove(int texture);
+
+    // このチャンクに入る前に読んでおく
+    void MapToChunk(int texture, int chunk);
+
+    // 描画キューに積むときに呼ぶ。載っていなければその場でこれだけ読む（予算が足りなければ縮小版。空けるのは次の Update）
+    ID3D11ShaderResourceView* Use(int texture);
+    SpriteAlphaMode GetAlphaMode(int texture) const;
+
+    // 毎フレーム描画の前に 1 回。前のフレームで使ったものを元に、先読みと追い出しをする
+    void Update(int focusChunk, int direction);
+
+    // ResourceRegistry の予算を超えたとき（ResourceSetEvictionCallback から）
+    void OnMemoryPressure(uint64_t overBytes);
+
+    const TextureResidency& GetResidency() const;
+
+private:
+    struct Entry {
+        std::wstring path;
+        TexturePrepOptions prep;
+        int columns = 1;
+        int rows = 1;
+        ID3D11ShaderResourceView* srv = nullptr;
+        TextureLevel level = TextureLevel::None;    // srv に実際に入っているもの
+        SpriteAlphaMode alphaMode = SpriteAlphaMode::Blended;
+        bool alive = false;
+    };
+
+    int AddEntry(const std::wstring& path, const TexturePrepOptions& prep, int columns, int rows, int width, int height, bool pinned);
+    void Apply();
+    bool Load(int texture, TextureLevel level);
+
+    ID3D11Device* device;
+    TextureResidency residency;
+    std::vector<Entry> entries;                 // TextureResidency の番号と同じ並び
+    std::vector<TextureResidencyRequest> requests;
+};
+
+
+#endif
@@ -0,0 +1,168 @@
+﻿/**********************************************************************************
+    TileMap.cpp
+
+                                                                LI WENHUI
+                                                                2025/08/21
+
+**********************************************************************************/
+
+#include "TileMap.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+void TileMap::Resize(int width, int height, float tileSize) {
+    this->width = width;
+    this->height = height;
+    this->tileSize = tileSize;
+    tiles.assign(static_cast<size_t>(width) * static_cast<size_t>(height), TileType::Empty);
+    revision++;
+    chunkRevisions.assign(static_cast<size_t>(GetChunkCountX()) * static_cast<size_t>(GetChunkCountY()), revision);
+}
+
+bool TileMap::ParseText(const std::string& source, float tileSize, std::string* error) {
+    std::vector<std::string> rows;
+    std::istringstream input(source);
+    std::string line;
+    size_t maxWidth = 0;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == ';') continue;
+        maxWidth = std::max(maxWidth, line.size());
+        rows.push_back(line);
+    }
+    if (rows.empty()) {
+        if (error) *error = "map is empty";
+        return false;
+    }
+
+    Resize(static_cast<int>(maxWidth), static_cast<int>(rows.size()), tileSize);
+    for (size_t y = 0; y < rows.size(); y++) {
+        for (size_t x = 0; x < rows[y].size(); x++) {
+            TileType t = TileType::Empty;
+            switch (rows[y][x]) {
+            case '#': t = TileType::Solid; break;
+            case '-': t = TileType::OneWay; break;
+            case '/': t = TileType::SlopeUp; break;
+            case '\\': t = TileType::SlopeDown; break;
+            case '.': case ' ': break;
+            default:
+                if (error) *error = "line " + std::to_string(y + 1) + ": unknown tile '" + rows[y][x] + "'";
+                return false;
+            }
+            tiles[y * maxWidth + x] = t;
+        }
+    }
+    return true;
+}
+
+bool TileMap::LoadFromText(const wchar_t* path, float tileSize, std::string* error) {
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return ParseText(buffer.str(), tileSize, error);
+}
+
+int TileMap::GetWidth() const { return width; }
+int TileMap::GetHeight() const { return height; }
+float TileMap::GetTileSize() const { return tileSize; }
+
+TileType TileMap::GetTile(int x, int y) const {
+    if (y >= height) return TileType::Solid;
+    if (x < 0 || y < 0 || x >= width) return TileType::Empty;
+    return tiles[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)];
+}
+
+void TileMap::SetTile(int x, int y, TileType type) {
+    if (x < 0 || y < 0 || x >= width || y >= height) return;
+    tiles[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)] = type;
+    revision++;
+    chunkRevisions[static_cast<size_t>((y / kChunkSize) * GetChunkCountX() + x / kChunkSize)] = revision;
+}
+
+bool TileMap::IsOpaque(int x, int y) const {
+    TileType t = GetTile(x, y);
+    return t == TileType::Solid || t == TileType::SlopeUp || t == TileType::SlopeDown;
+}
+
+int TileMap::WorldToTileX(float x) const {
+    return static_cast<int>(std::floor(x / tileSize));
+}
+
+int TileMap::WorldToTileY(float y) const {
+    return static_cast<int>(std::floor(y / tileSize));
+}
+
+uint32_t TileMap::GetRevision() const {
+    return revision;
+}
+
+uint32_t TileMap::GetChunkRevision(int chunkX, int chunkY) const {
+    if (chunkX < 0 || chunkY < 0 || chunkX >= GetChunkCountX() || chunkY >= GetChunkCountY()) return 0;
+    return chunkRevisions[static_cast<size_t>(chunkY * GetChunkCountX() + chunkX)];
+}
+
+int TileMap::GetChunkCountX() const {
+    return (width + kChunkSize - 1) / kChunkSize;
+}
+
+int TileMap::GetChunkCountY() const {
+    return (height + kChunkSize - 1) / kChunkSize;
+}
+
+void TileMap::CollectOccluders(const Aabb& area, std::vector<Aabb>* out) const {
+    int x0 = std::max(WorldToTileX(area.minX), 0);
+    int y0 = std::max(WorldToTileY(area.minY), 0);
+    int x1 = std::min(WorldToTileX(area.maxX), width - 1);
+    int y1 = std::min(WorldToTileY(area.maxY), height - 1);
+
+    for (int y = y0; y <= y1; y++) {
+        int x = x0;
+        while (x <= x1) {
+            if (!IsOpaque(x, y)) { x++; continue; }
+            int start = x;
+            while (x <= x1 && IsOpaque(x, y)) x++;
+            out->push_back({
+                static_cast<float>(start) * tileSize, static_cast<float>(y) * tileSize,
+                static_cast<float>(x) * tileSize, static_cast<float>(y + 1) * tileSize });
+        }
+    }
+}
+
+void TileMap::BuildQuads(const DirectX::XMFLOAT4& color, float depth, std::vector<SpriteQuad>* out) const {
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            TileType t = GetTile(x, y);
+            if (t == TileType::Empty) continue;
+
+            float l = static_cast<float>(x) * tileSize;
+            float tp = static_cast<float>(y) * tileSize;
+            float r = l + tileSize;
+            float b = tp + tileSize;
+            if (t == TileType::OneWay) b = tp + tileSize * 0.25f;
+
+            SpriteQuad q;
+            q.pos[0] = { l, tp };
+            q.pos[1] = { r, tp };
+            q.pos[2] = { r, b };
+            q.pos[3] = { l, b };
+            // 坂は角を 1 つ潰して三角形にする
+            if (t == TileType::SlopeUp) q.pos[0] = q.pos[1];
+            if (t == TileType::SlopeDown) q.pos[1] = q.pos[0];
+
+            q.uv[0] = { 0.0f, 0.0f };
+            q.uv[1] = { 1.0f, 0.0f };
+            q.uv[2] = { 1.0f, 1.0f };
+            q.uv[3] = { 0.0f, 1.0f };
+            q.color = color;
+            q.depth = depth;
+            out->push_back(q);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+﻿/**********************************************************************************
+    TileMap.h
+
+                                                                LI WENHUI
+                                                                2025/08/21
+
+**********************************************************************************/
+
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include "Aabb.h"
+#include "SpriteQuad.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class TileType : uint8_t {
+    Empty,
+    Solid,
+    OneWay,     // 上からだけ乗れる足場
+    SlopeUp,    // 右上がり（/）
+    SlopeDown   // 右下がり（\）
+};
+
+//
+// 固定サイズのタイルグリッド。変更はチャンク単位のリビジョンで追跡する
+// （視界や経路探索は自分の周りのチャンクが変わったときだけ再計算すればよい）
+class TileMap {
+public:
+    static constexpr int kChunkSize = 16;
+
+    void Resize(int width, int height, float tileSize);
+
+    // '#' 壁, '-' 一方通行, '/' '\' 坂, '.' 空
+    bool ParseText(const std::string& source, float tileSize, std::string* error = nullptr);
+    bool LoadFromText(const wchar_t* path, float tileSize, std::string* error = nullptr);
+
+    int GetWidth() const;
+    int GetHeight() const;
+    float GetTileSize() const;
+
+    // 範囲外は、下端より下だけ壁扱い（落下で抜けないように）、それ以外は空
+    TileType GetTile(int x, int y) const;
+    void SetTile(int x, int y, TileType type);
+
+    // 光と視線を遮るか
+    bool IsOpaque(int x, int y) const;
+
+    int WorldToTileX(float x) const;
+    int WorldToTileY(float y) const;
+
+    uint32_t GetRevision() const;
+    uint32_t GetChunkRevision(int chunkX, int chunkY) const;
+    int GetChunkCountX() const;
+    int GetChunkCountY() const;
+
+    // 遮蔽物として使う矩形。横に連続する不透明タイルは 1 つにまとめる
+    void CollectOccluders(const Aabb& area, std::vector<Aabb>* out) const;
+
+    // 塗りつぶし表示用（坂は三角形）
+    void BuildQuads(const DirectX::XMFLOAT4& color, float depth, std::vector<SpriteQuad>* out) const;
+
+private:
+    int width = 0;
+    int height = 0;
+    float tileSize = 32.0f;
+    uint32_t revision = 0;
+    std::vector<TileType> tiles;
+    std::vector<uint32_t> chunkRevisions;
+};
+
+
+#endif
@@ -9,14 +9,164 @@
 #include "UpdateAll.h"
 #include "StateInfo.h"
 #include "PlayerObject.h"
+#include "Skeleton2D.h"
+#include "ParticleSystem.h"
+#include "Lightmap2D.h"
+#include "TileMap.h"
+#include "FieldOfView.h"
+#include "FlowField.h"
+#include "CharacterController.h"
+#include "GameWorld.h"
+#include "CollisionMask.h"
+#include "InputSystem.h"
+#include "Replay.h"
+#include "TextureStreamer.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    std::vector<MaskInstance> instances;
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+}
 
 
 void UpdatePlayer(StateInfo* pState, float deltaTime) {
+    PROFILE_ZONE("UpdatePlayer");
 
     pState->player->Update(deltaTime);
 
 }
 
-void UpdatePlayeState(StateInfo* pState, float deltaTime, bool leftPressed, bool rightPressed, bool spacePressed) {
+void UpdateSimulation(StateInfo* pState, float deltaTime, const InputFrame& input) {
+    PROFILE_ZONE("UpdateSimulation");
+
+    StepGameWorld(pState->world.get(), input, deltaTime, pState->jobs.get());
+    if (pState->recorder) pState->recorder->RecordTick(input);
+
+}
+
+void UpdateHits(StateInfo* pState) {
+    PROFILE_ZONE("UpdateHits");
+
+    // プレイヤーの絵のピクセルを 1 マスとするグリッドで、今のフレームのマスクと追跡者の箱を比べる
+    // マスの幅と高さは別々（絵をフレームと違う縦横比で描いていることがある）
+    PlayerObject* player = pState->player.get();
+    const CollisionMask* mask = player->GetCollisionMask();
+    GameWorld* world = pState->world.get();
+    for (ChaseAgent& chaser : world->chasers) chaser.touchingPlayer = false;
+    if (!mask || world->chasers.empty()) return;
+
+    const float scaleX = player->GetMaskScaleX();
+    const float scaleY = player->GetMaskScaleY();
+    if (!pState->chaserMask || pState->chaserMaskScaleX != scaleX || pState->chaserMaskScaleY != scaleY) {
+        Aabb box = world->characters->GetBounds(world->chasers[0].body);
+        pState->chaserMask = std::make_unique<CollisionMask>(MakeBoxMask(
+            std::max(1, static_cast<int>(std::lround((box.maxX - box.minX) / scaleX))),
+            std::max(1, static_cast<int>(std::lround((box.maxY - box.minY) / scaleY)))));
+        pState->chaserMaskScaleX = scaleX;
+        pState->chaserMaskScaleY = scaleY;
+    }
+
+    instances.clear();
+    pairs.clear();
+
+    MaskInstance self;
+    self.mask = mask;
+    self.x = static_cast<int>(std::lround(player->GetPosX() / scaleX));
+    self.y = static_cast<int>(std::lround(player->GetPosY() / scaleY));
+    self.flipX = player->direction == PlayerDirection::Left;    // 描画の uFlipX と同じ
+    instances.push_back(self);
+    for (const ChaseAgent& chaser : world->chasers) {
+        Aabb box = world->characters->GetBounds(chaser.body);
+        MaskInstance m;
+        m.mask = pState->chaserMask.get();
+        m.x = static_cast<int>(std::lround(box.minX / scaleX));
+        m.y = static_cast<int>(std::lround(box.minY / scaleY));
+        instances.push_back(m);
+    }
+
+    FindMaskOverlaps(instances.data(), instances.size(), &pairs);
+    for (const auto& pair : pairs) {
+        if (pair.first == 0) world->chasers[pair.second - 1].touchingPlayer = true;
+    }
+
+}
+
+void UpdateSkeletons(StateInfo* pState, float deltaTime) {
+    PROFILE_ZONE("UpdateSkeletons");
+
+    UpdateSkeletons(pState->skeletons.data(), pState->skeletons.size(), deltaTime);
+
+}
+
+void UpdateParticles(StateInfo* pState, float deltaTime) {
+    PROFILE_ZONE("UpdateParticles");
+
+    pState->particles->Update(deltaTime, pState->jobs.get());
+
+}
+
+void UpdateLights(StateInfo* pState) {
+    PROFILE_ZONE("UpdateLights");
+
+    // 懐中電灯はプレイヤーの胸の高さから向いている方向へ
+    PlayerObject* player = pState->player.get();
+    Light2D& flashlight = pState->lights[static_cast<size_t>(pState->flashlight)];
+    flashlight.x = player->GetPosX() + player->GetW() * 0.5f;
+    flashlight.y = player->GetPosY() + player->GetH() * 0.55f;
+    flashlight.dirX = player->direction == PlayerDirection::Left ? -1.0f : 1.0f;
+    flashlight.dirY = 0.0f;
+
+}
+
+void UpdateVisibility(StateInfo* pState) {
+    PROFILE_ZONE("UpdateVisibility");
+
+    // 目の高さのタイルを視点にする。セルが変わらなければ再計算されない
+    PlayerObject* player = pState->player.get();
+    FovViewer& view = pState->viewers[static_cast<size_t>(pState->playerViewer)];
+    const TileMap& map = *pState->world->tileMap;
+    view.tileX = map.WorldToTileX(player->GetPosX() + player->GetW() * 0.5f);
+    view.tileY = map.WorldToTileY(player->GetPosY() + player->GetH() * 0.55f);
+
+    UpdateFovViewers(map, pState->viewers.data(), pState->viewers.size(), pState->jobs.get());
+
+}
+
+void UpdatePlayerState(StateInfo* pState, float deltaTime) {
+    PROFILE_ZONE("UpdatePlayerState");
+
+    PlayerObject* player = pState->player.get();
+    const GameWorld* world = pState->world.get();
+    const CharacterController* characters = world->characters.get();
+
+    // 絵は足元の中央が体の位置に来るように置く
+    player->SetPos(characters->GetX(world->playerBody) - player->GetW() * 0.5f,
+        characters->GetY(world->playerBody) - player->GetH());
+    player->direction = world->playerFacing < 0 ? PlayerDirection::Left : PlayerDirection::Right;
+
+    // アニメーションには実際の速度を渡す。ステートの切り替えはグラフ側で決まる
+    float speed = std::fabs(characters->GetVelocityX(world->playerBody));
+    player->SetAnimParam(player->FindAnimParam("speed"), speed);
+
+    // HUD の距離とスコア。表示用なので GameWorld には持たせない（リプレイのハッシュに入らない）
+    pState->distanceTravelled += speed * deltaTime;
+    pState->playTime += deltaTime;
+}
+
+void UpdateTextureStreaming(StateInfo* pState) {
+    PROFILE_ZONE("UpdateTextureStreaming");
+
+    const GameWorld* world = pState->world.get();
+    const TileMap& map = *world->tileMap;
+    const CharacterController* characters = world->characters.get();
+
+    // チャンクごとのテクスチャは InitD3D で登録してある
+    // 止まっているときは向きを決めない（両側を同じ数だけ読む）
+    float velocityX = characters->GetVelocityX(world->playerBody);
+    int direction = std::fabs(velocityX) > 1.0f ? (velocityX < 0.0f ? -1 : 1) : 0;
+    int chunk = map.WorldToTileX(characters->GetX(world->playerBody)) / TileMap::kChunkSize;
+    pState->textures->Update(chunk, direction);
 
 }
@@ -10,10 +10,28 @@
 #define UPDATEALL_H
 
 struct StateInfo;
+struct InputFrame;
 
 void UpdatePlayer(StateInfo* pState, float deltaTime);
 
-void UpdatePlayerState(StateInfo* pState, float deltaTime, bool leftPressed, bool rightPressed, bool spacePressed);
+// 固定ステップの 1 tick。リプレイを記録中ならその入力も残す
+void UpdateSimulation(StateInfo* pState, float deltaTime, const InputFrame& input);
+
+void UpdateHits(StateInfo* pState);
+
+void UpdateSkeletons(StateInfo* pState, float deltaTime);
+
+void UpdateParticles(StateInfo* pState, float deltaTime);
+
+void UpdateLights(StateInfo* pState);
+
+void UpdateVisibility(StateInfo* pState);
+
+// シミュレーションの結果をプレイヤーの絵とアニメーションに反映する
+void UpdatePlayerState(StateInfo* pState, float deltaTime);
+
+// プレイヤーのいるチャンクと進む向きから、テクスチャの先読みと追い出しをする（描画の前に）
+void UpdateTextureStreaming(StateInfo* pState);
 
 
 
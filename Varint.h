@@ -0,0 +1,59 @@
+﻿/**********************************************************************************
+    Varint.h
+
+                                                                LI WENHUI
+                                                                2025/09/02
+
+**********************************************************************************/
+
+#ifndef VARINT_H
+#define VARINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 7 ビットずつ、下位から。続きがあれば最上位ビットを立てる
+inline void WriteVarint(std::vector<uint8_t>* out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<uint8_t>(value));
+}
+
+// リトルエンディアンの 8 バイト
+inline void WriteU64(std::vector<uint8_t>* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out->push_back(static_cast<uint8_t>(value >> (i * 8)));
+}
+
+//
+// 読み出し位置を持つだけの簡単なリーダー。範囲外に出たら ok が false になる
+struct ByteReader {
+    const uint8_t* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    uint64_t Varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos >= size) break;
+            uint8_t b = data[pos++];
+            value |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    uint64_t U64() {
+        if (size - pos < 8) { ok = false; return 0; }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(data[pos++]) << (i * 8);
+        return value;
+    }
+};
+
+
+#endif
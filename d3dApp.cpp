@@ -10,11 +10,31 @@
 #include "d3dApp.h"
 #include "ConstantBuffer.h"
 #include "PlayerObject.h"
+#include "AnimationGraph.h"
+#include "SpriteBatch.h"
+#include "Skeleton2D.h"
+#include "TextureLoader.h"
+#include "JobSystem.h"
+#include "ParticleSystem.h"
+#include "GameWorld.h"
+#include "TileMap.h"
+#include "Lightmap2D.h"
+#include "FieldOfView.h"
+#include "LightingPass.h"
+#include "LayerCache.h"
+#include "LayerCachePass.h"
+#include "DynamicResolution.h"
+#include "TextRenderer.h"
+#include "TextureStreamer.h"
+#include "Profiler.h"
+#include "BufferUtils.h"
+#include "ResourceRegistry.h"
 #include <vector>
 #include <memory>
 
 
 bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWidth, float clientHeight) {
+    PROFILE_ZONE("InitD3D");
     /*
        元のモデル座標（モデル中心が原点）
             ↓ worldMatrix（平行移動・拡大縮小）
@@ -125,6 +145,7 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
         MessageBox(hwnd, L"Failed to create depth stencil buffer.", L"Error", MB_OK);     // 作成失敗時はエラーメッセージ
         return false;
     }
+    TrackTexture(depthStencilBuffer, "SwapChain", "depth");
 
     // 深度/ステンシルビュー
     D3D11_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};                       // 深度ステンシルビューの設定構造体を初期化
@@ -262,6 +283,21 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
     psBlob->Release();
     if (FAILED(hr)) return false;
 
+    // アルファテスト用のピクセルシェーダ（同じファイルの PSAlphaTest）
+    ID3DBlob* alphaTestBlob = nullptr;
+    hr = D3DCompileFromFile(L"shader.hlsl", nullptr, nullptr, "PSAlphaTest", "ps_5_0",
+        D3DCOMPILE_ENABLE_STRICTNESS | D3DCOMPILE_DEBUG, 0, &alphaTestBlob, &errorBlob);
+    if (FAILED(hr)) {
+        if (errorBlob) errorBlob->Release();
+        MessageBox(hwnd, L"Failed to compile alpha test pixel shader.", L"Error", MB_OK);
+        return false;
+    }
+    if (errorBlob) errorBlob->Release();
+    hr = pState->device->CreatePixelShader(alphaTestBlob->GetBufferPointer(), alphaTestBlob->GetBufferSize(),
+        nullptr, &pState->pixelShaderAlphaTest);
+    alphaTestBlob->Release();
+    if (FAILED(hr)) return false;
+
     // 定数バッファ（Constant Buffer）
     D3D11_BUFFER_DESC cbd = {};// 記述構造体を初期化し、GPUにどんなバッファを作るか伝える
     cbd.Usage = D3D11_USAGE_DYNAMIC;// 用途はDYNAMIC：CPUが毎フレーム値を更新（例：行列）、GPUが読み取る
@@ -274,9 +310,10 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
     // --- テクスチャサンプラーステート作成 ---
     D3D11_SAMPLER_DESC sampDesc = {};
     sampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR; // 線形フィルタ・一般用途向き
-    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;     // U座標範囲外でリピート
-    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;     // V座標範囲外でリピート
-    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;     // W座標範囲外でリピート（2Dはあまり影響なし）
+    // 繰り返すテクスチャはないので、シートの端で反対側の端を拾わないようクランプ
+    sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
+    sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
     sampDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
     sampDesc.MinLOD = 0;
     sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
@@ -287,23 +324,30 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
     }
 
     // --- 透明ブレンドステート作成 ---
+    // テクスチャは読み込み時に premultiplied alpha にしてあり、頂点カラーはシェーダーで掛ける
+    // なので色はもうαを掛けた値で、ソース側は ONE のまま足す
     D3D11_BLEND_DESC blendDesc = {};
     // Normal
     // RenderTarget[0] は最初のレンダーターゲット
     blendDesc.RenderTarget[0].BlendEnable = TRUE; // ブレンド有効
-    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA; // ソースのα値
+    blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE; // αを掛け済みのソース
     blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA; // 1-ソースのα値
     blendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD; // ソース+デスティネーション
     blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE; // α成分（通常1）
-    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO; // α成分（通常0）
+    blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA; // α成分も同じく重ねる
     blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD; // α加算
     // D3D11_COLOR_WRITE_ENABLE_ALL は全色成分(RGBA)書込可
     blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
     pState->device->CreateBlendState(&blendDesc, &pState->blendStateNormal);
+
+    // Opaque（不透明・アルファテストのパス）
+    D3D11_BLEND_DESC blendDescOpaque = blendDesc;
+    blendDescOpaque.RenderTarget[0].BlendEnable = FALSE;
+    pState->device->CreateBlendState(&blendDescOpaque, &pState->blendStateOpaque);
  
     // Additive
 	D3D11_BLEND_DESC blendDescAdd = blendDesc;
-	blendDescAdd.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	blendDescAdd.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
 	blendDescAdd.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
 	blendDescAdd.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
 	pState->device->CreateBlendState(&blendDescAdd, &pState->blendStateAdditive);
@@ -311,7 +355,7 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
 	// Multiply
 	D3D11_BLEND_DESC blendDescMul = blendDesc;
 	blendDescMul.RenderTarget[0].SrcBlend = D3D11_BLEND_DEST_COLOR;
-	blendDescMul.RenderTarget[0].DestBlend = D3D11_BLEND_ZERO;
+	blendDescMul.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;    // 透明なところは下をそのまま残す
 	blendDescMul.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
 	pState->device->CreateBlendState(&blendDescMul, &pState->blendStateMultiply);
 
@@ -329,7 +373,8 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
     transparentDepthStencilDesc.DepthEnable = TRUE; // 深度テストは有効（不透明物体との比較）
     //// **深度書き込み無効化** 透明物体が奥の物体のZ値を「塗りつぶす」のを防ぐ
     transparentDepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
-    transparentDepthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS;
+    // 同じ深度の不透明物体の上には重ねられるように LESS_EQUAL
+    transparentDepthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
     transparentDepthStencilDesc.StencilEnable = FALSE;
 
     hr = pState->device->CreateDepthStencilState(&transparentDepthStencilDesc, &pState->depthStencilStateTransparent);
@@ -338,23 +383,170 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
         return false;
     }
 
+    // 不透明物体用：手前から描いて深度を書き、奥で隠れるピクセルは early-Z で捨てる
+    D3D11_DEPTH_STENCIL_DESC opaqueDepthStencilDesc = transparentDepthStencilDesc;
+    opaqueDepthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+    opaqueDepthStencilDesc.DepthFunc = D3D11_COMPARISON_LESS;
+    hr = pState->device->CreateDepthStencilState(&opaqueDepthStencilDesc, &pState->depthStencilStateOpaque);
+    if (FAILED(hr)) {
+        MessageBox(hwnd, L"Failed to create opaque depth stencil state.", L"Error", MB_OK);
+        return false;
+    }
+
 
 
-    std::vector<AnimationData> animationData;
-	animationData.push_back({
-	  L"assets\\player_idle.png",
-	  10,
-	  5,
-	  2,
-	  10.0f
-	});
-	animationData.push_back({
-	  L"assets\\player_run.png",
-	  8,
-	  4,
-	  2,
-	  24.0f
-	});
+    // アニメーショングラフ（クリップ・ステート・遷移）はデータから読み込む
+    pState->playerAnimGraph = std::make_unique<AnimGraph>();
+    std::string graphError;
+    if (!LoadAnimGraph(L"assets\\player.animgraph", pState->playerAnimGraph.get(), &graphError)) {
+        std::wstring message(graphError.begin(), graphError.end());
+        MessageBox(hwnd, message.c_str(), L"Failed to load assets\\player.animgraph", MB_OK);
+        return false;
+    }
+
+    // スケルトンやエフェクトなど、ワールド座標の四角形をまとめて描く
+    pState->spriteBatch = std::make_unique<SpriteBatch>();
+    if (!pState->spriteBatch->Init(pState->device, pState->context, 4096)) {
+        MessageBox(hwnd, L"Failed to create sprite batch.", L"Error", MB_OK);
+        return false;
+    }
+
+    pState->jobs = std::make_unique<JobSystem>();
+
+    // ファイルから読むテクスチャ。GPU の予算を超えたときは、まず使っていないテクスチャを手放す
+    TextureResidencyDesc textureDesc;
+    textureDesc.budgetBytes = pState->textureBudgetMb << 20;
+    pState->textures = std::make_unique<TextureStreamer>(textureDesc);
+    pState->textures->Init(pState->device);
+    TextureStreamer* textures = pState->textures.get();
+    ResourceSetEvictionCallback([textures](ResourcePool pool, uint64_t overBytes, const std::vector<ResourceInfo>& candidates) {
+        (void)candidates;
+        if (pool == ResourcePool::Gpu) textures->OnMemoryPressure(overBytes);
+    });
+
+    // 雨（画面上端の外側から斜めに降らせる）
+    pState->particles = std::make_unique<ParticleSystem>(65536);
+    EmitterDesc rain;
+    rain.x = -200.0f;
+    rain.y = -60.0f;
+    rain.width = pState->logicalWidth + 400.0f;
+    rain.rate = 1200.0f;
+    rain.lifeMin = 0.7f;
+    rain.lifeMax = 0.9f;
+    rain.velXMin = -260.0f;
+    rain.velXMax = -200.0f;
+    rain.velYMin = 1500.0f;
+    rain.velYMax = 1800.0f;
+    rain.colorStart = { 0.45f, 0.5f, 0.6f, 0.55f };
+    rain.colorEnd = { 0.45f, 0.5f, 0.6f, 0.3f };
+    rain.sizeStart = 2.0f;
+    rain.sizeEnd = 2.0f;
+    rain.aspect = 10.0f;
+    pState->rainEmitter = pState->particles->AddEmitter(rain);
+
+    std::string mapText;
+    if (!ReadAssetText(L"assets\\level01.txt", &mapText)) {
+        MessageBox(hwnd, L"cannot open file", L"Failed to load assets\\level01.txt", MB_OK);
+        return false;
+    }
+
+    // ライトマップは 1/lightmapScale の解像度で作り、描画時に引き伸ばす
+    int lightmapW = (static_cast<int>(pState->logicalWidth) + pState->lightmapScale - 1) / pState->lightmapScale;
+    int lightmapH = (static_cast<int>(pState->logicalHeight) + pState->lightmapScale - 1) / pState->lightmapScale;
+    pState->lightmap = std::make_unique<Lightmap2D>();
+    pState->lightmap->Resize(lightmapW, lightmapH,
+        static_cast<float>(lightmapW * pState->lightmapScale), static_cast<float>(lightmapH * pState->lightmapScale));
+    pState->lightingPass = std::make_unique<LightingPass>();
+    if (!pState->lightingPass->Init(pState->device, lightmapW, lightmapH)) {
+        MessageBox(hwnd, L"Failed to create lightmap texture.", L"Error", MB_OK);
+        return false;
+    }
+
+    // タイルはカメラと一緒に動き、編集されたときだけ描き直す（カメラが動くようになったら margin を足す）
+    pState->layerCache = std::make_unique<LayerCache>();
+    pState->layerCache->SetViewport(pState->logicalWidth, pState->logicalHeight);
+    LayerDesc tileLayer;
+    tileLayer.name = "tiles";
+    pState->tileLayer = pState->layerCache->AddLayer(tileLayer);
+    pState->layerCachePass = std::make_unique<LayerCachePass>();
+    if (!pState->layerCachePass->Init(pState->device, *pState->layerCache, clientWidth / pState->logicalWidth)) {
+        MessageBox(hwnd, L"Failed to create layer cache targets.", L"Error", MB_OK);
+        return false;
+    }
+
+    // 描画解像度は GPU の時間が画面の更新間隔に収まるように決める
+    ResolutionScalerDesc scalerDesc;
+    DEVMODE displayMode = {};
+    displayMode.dmSize = sizeof(displayMode);
+    if (EnumDisplaySettings(nullptr, ENUM_CURRENT_SETTINGS, &displayMode) && displayMode.dmDisplayFrequency > 1) {
+        scalerDesc.targetMs = 1000.0f / static_cast<float>(displayMode.dmDisplayFrequency);
+    }
+    pState->dynamicResolution = std::make_unique<DynamicResolution>();
+    if (!pState->dynamicResolution->Init(pState->device, static_cast<UINT>(clientWidth), static_cast<UINT>(clientHeight), scalerDesc)) {
+        MessageBox(hwnd, L"Failed to create scene render target.", L"Error", MB_OK);
+        return false;
+    }
+    pState->dynamicResolution->SetFixedScale(pState->fixedRenderScale);
+
+    // 文字はバックバッファの解像度でラスタライズする（引き伸ばさないのでぼけない）
+    pState->text = std::make_unique<TextRenderer>();
+    if (!CreateTextFonts(pState, clientWidth)) {
+        MessageBox(hwnd, L"Failed to create glyph atlas.", L"Error", MB_OK);
+        return false;
+    }
+
+    // 懐中電灯（プレイヤーに追従）と街灯
+    Light2D flashlight;
+    flashlight.radius = 900.0f;
+    flashlight.intensity = 1.6f;
+    flashlight.color = { 1.0f, 0.95f, 0.8f };
+    flashlight.coneCos = 0.85f;
+    flashlight.coneSoftness = 0.08f;
+    pState->flashlight = static_cast<int>(pState->lights.size());
+    pState->lights.push_back(flashlight);
+
+    Light2D lamp;
+    lamp.radius = 420.0f;
+    lamp.color = { 1.0f, 0.6f, 0.35f };
+    lamp.x = 760.0f;
+    lamp.y = 560.0f;
+    pState->lights.push_back(lamp);
+    lamp.x = 1500.0f;
+    lamp.y = 620.0f;
+    lamp.color = { 0.5f, 0.6f, 1.0f };
+    pState->lights.push_back(lamp);
+
+    // 街灯のまわりを飛ぶ蛾。はばたきがそろわないように再生位置をずらす
+    int moth = LoadSkeletonAsset(hwnd, pState, L"assets\\moth.skel");
+    if (moth < 0) return false;
+    for (size_t i = 1; i < pState->lights.size(); i++) {
+        for (int k = 0; k < 2; k++) {
+            SkeletonInstance instance;
+            InitSkeletonInstance(pState->skeletonData[static_cast<size_t>(moth)].get(), &instance);
+            instance.x = pState->lights[i].x + (k == 0 ? -36.0f : 28.0f);
+            instance.y = pState->lights[i].y - 40.0f + 18.0f * static_cast<float>(k);
+            instance.time = 0.37f * static_cast<float>(i * 2 + k);
+            instance.flipX = k == 1;
+            instance.depth = 0.3f;
+            pState->skeletons.push_back(std::move(instance));
+        }
+    }
+
+    // 右端の柱の上のカラス（アトラスは柱のチャンクに近づいたときに読む）
+    int crow = LoadSkeletonAsset(hwnd, pState, L"assets\\crow.skel");
+    if (crow < 0) return false;
+    SkeletonInstance crowInstance;
+    InitSkeletonInstance(pState->skeletonData[static_cast<size_t>(crow)].get(), &crowInstance);
+    crowInstance.x = 1744.0f;
+    crowInstance.y = 800.0f;
+    crowInstance.flipX = true;
+    crowInstance.depth = 0.3f;
+    pState->skeletons.push_back(std::move(crowInstance));
+
+    FovViewer playerView;
+    playerView.radius = 24;
+    pState->playerViewer = static_cast<int>(pState->viewers.size());
+    pState->viewers.push_back(playerView);
 
 	pState->player = std::make_unique<PlayerObject>();
     pState->player->SetSpeed(200.0f);
@@ -364,9 +556,31 @@ bool InitD3D(HWND hwnd, ID3D11Device* device, StateInfo* pState, float clientWid
         pState->context,
 		288.0f * 3.0f,//864.0f
 		128.0f * 3.0f,//384.0f
-		animationData,
-        true
+		pState->playerAnimGraph.get(),
+        true,
+        pState->jobs.get(),
+        pState->textures.get()
 	);
+
+    // 当たり判定は絵の下端中央に立つ細い箱（坂を上るには幅がタイル以下）
+    // 追跡者は上から落として配置する
+    GameWorldDesc worldDesc;
+    worldDesc.playerX = pState->player->GetPosX() + pState->player->GetW() * 0.5f;
+    worldDesc.playerY = pState->player->GetPosY() + pState->player->GetH();
+    worldDesc.playerSpeed = pState->player->GetSpeed();
+    pState->world = std::make_unique<GameWorld>();
+    std::string mapError;
+    if (!InitGameWorld(pState->world.get(), mapText, worldDesc, pState->jobs.get(), &mapError)) {
+        std::wstring message(mapError.begin(), mapError.end());
+        MessageBox(hwnd, message.c_str(), L"Failed to load assets\\level01.txt", MB_OK);
+        return false;
+    }
+
+    // スケルトンのアトラスは、置いたチャンクに入る前に読んでおく（置いたら動かないので最初に 1 回だけ登録する）
+    const TileMap& map = *pState->world->tileMap;
+    for (const SkeletonInstance& skeleton : pState->skeletons) {
+        pState->textures->MapToChunk(skeleton.data->atlasTexture, map.WorldToTileX(skeleton.x) / TileMap::kChunkSize);
+    }
  
 
 
@@ -385,18 +599,39 @@ void CleanupD3D(StateInfo* s) {
 
 	// 销毁玩家对象
 	if (s->player) s->player.reset();
+	if (s->playerAnimGraph) s->playerAnimGraph.reset();
+	s->skeletons.clear();
+	for (auto& data : s->skeletonData) {
+		SAFE_RELEASE(data->atlasSrv);
+	}
+	s->skeletonData.clear();
+	ResourceSetEvictionCallback(nullptr);
+	if (s->textures) s->textures.reset();
+	if (s->spriteBatch) s->spriteBatch.reset();
+	if (s->particles) s->particles.reset();
+	if (s->lightingPass) s->lightingPass.reset();
+	if (s->layerCachePass) s->layerCachePass.reset();
+	if (s->dynamicResolution) s->dynamicResolution.reset();
+	if (s->text) s->text.reset();
+	if (s->layerCache) s->layerCache.reset();
+	if (s->lightmap) s->lightmap.reset();
+	if (s->world) s->world.reset();
+	if (s->jobs) s->jobs.reset();
 
 	// 释放各类状态/视图等（OM/DS/采样器/着色器/布局/RTV）
 	if (s->blendStateScreen) { s->blendStateScreen->Release();   s->blendStateScreen = nullptr; }
 	if (s->blendStateMultiply) { s->blendStateMultiply->Release(); s->blendStateMultiply = nullptr; }
 	if (s->blendStateAdditive) { s->blendStateAdditive->Release(); s->blendStateAdditive = nullptr; }
 	if (s->blendStateNormal) { s->blendStateNormal->Release();   s->blendStateNormal = nullptr; }
+	if (s->blendStateOpaque) { s->blendStateOpaque->Release();   s->blendStateOpaque = nullptr; }
 
 	if (s->depthStencilStateTransparent) { s->depthStencilStateTransparent->Release(); s->depthStencilStateTransparent = nullptr; }
+	if (s->depthStencilStateOpaque) { s->depthStencilStateOpaque->Release(); s->depthStencilStateOpaque = nullptr; }
 	if (s->depthStencilView) { s->depthStencilView->Release();             s->depthStencilView = nullptr; }
 
 	if (s->samplerState) { s->samplerState->Release(); s->samplerState = nullptr; }
 	if (s->pixelShader) { s->pixelShader->Release();  s->pixelShader = nullptr; }
+	if (s->pixelShaderAlphaTest) { s->pixelShaderAlphaTest->Release();  s->pixelShaderAlphaTest = nullptr; }
 	if (s->vertexShader) { s->vertexShader->Release(); s->vertexShader = nullptr; }
 	if (s->inputLayout) { s->inputLayout->Release();  s->inputLayout = nullptr; }
 	if (s->rtv) { s->rtv->Release();          s->rtv = nullptr; }
@@ -418,6 +653,11 @@ void CleanupD3D(StateInfo* s) {
 	}
 
 #ifdef _DEBUG
+	// ここまでで全部解放されていれば空になる。残っていれば作成元ごとに出す
+	if (ResourceGetUsage(ResourcePool::Gpu).count > 0) {
+		OutputDebugStringA("ResourceRegistry: resources still alive at shutdown\n");
+		OutputDebugStringA(ResourceFormatSummary().c_str());
+	}
 	if (s->device) {
 		ID3D11Debug* debug = nullptr;
 		if (SUCCEEDED(s->device->QueryInterface(__uuidof(ID3D11Debug), (void**)&debug))) {
@@ -471,6 +711,7 @@ void OnResize(HWND hwnd, StateInfo* pState, UINT width, UINT height)
     dsvDesc.Texture2D.MipSlice = 0;
 
     if (SUCCEEDED(hr) && depthStencilBuffer) {
+        TrackTexture(depthStencilBuffer, "SwapChain", "depth");
         pState->device->CreateDepthStencilView(depthStencilBuffer, &dsvDesc, &pState->depthStencilView);
         depthStencilBuffer->Release();
     }
@@ -493,4 +734,53 @@ void OnResize(HWND hwnd, StateInfo* pState, UINT width, UINT height)
         pState->logicalHeight, 0.0f,
         0.0f, 1.0f);
 
+    if (pState->dynamicResolution && !pState->dynamicResolution->Resize(pState->device, width, height)) {
+        MessageBox(hwnd, L"Failed to create scene render target during resize.", L"Error", MB_OK);
+    }
+
+    // 層のテクスチャをバックバッファの解像度に合わせて作り直し、全部描き直す
+    if (pState->layerCache && pState->layerCachePass) {
+        pState->layerCache->InvalidateAll();
+        if (!pState->layerCachePass->Init(pState->device, *pState->layerCache, static_cast<float>(width) / pState->logicalWidth)) {
+            MessageBox(hwnd, L"Failed to create layer cache targets during resize.", L"Error", MB_OK);
+        }
+    }
+
+    // グリフのピクセル数が変わるので、アトラスごと作り直す（次に使ったときにラスタライズし直す）
+    if (pState->text && !CreateTextFonts(pState, static_cast<float>(width))) {
+        MessageBox(hwnd, L"Failed to create glyph atlas during resize.", L"Error", MB_OK);
+    }
+}
+
+
+bool CreateTextFonts(StateInfo* pState, float clientWidth)
+{
+    if (!pState->text->Init(pState->device)) return false;
+
+    // 大きさは論理座標で決め、ピクセル数は今の画面の倍率から出す
+    float unitsPerPixel = pState->logicalWidth / clientWidth;
+    pState->hudFont = pState->text->AddFont(L"Segoe UI", static_cast<int>(36.0f / unitsPerPixel + 0.5f), unitsPerPixel, true);
+    pState->debugFont = pState->text->AddFont(L"Consolas", static_cast<int>(18.0f / unitsPerPixel + 0.5f), unitsPerPixel);
+    return pState->hudFont >= 0 && pState->debugFont >= 0;
+}
+
+
+int LoadSkeletonAsset(HWND hwnd, StateInfo* pState, const wchar_t* path)
+{
+    PROFILE_ZONE("LoadSkeletonAsset");
+    auto data = std::make_unique<SkeletonData>();
+    std::string error;
+    if (!LoadSkeletonData(path, data.get(), &error)) {
+        std::wstring message(error.begin(), error.end());
+        MessageBox(hwnd, message.c_str(), path, MB_OK);
+        return -1;
+    }
+    // アトラスは最初に描くときに読む（近くにいなくなれば追い出される）
+    data->atlasTexture = pState->textures->Add(data->atlasPath, TexturePrepOptions());
+    if (data->atlasTexture < 0) {
+        MessageBox(hwnd, L"Failed to load skeleton atlas.", path, MB_OK);
+        return -1;
+    }
+    pState->skeletonData.push_back(std::move(data));
+    return static_cast<int>(pState->skeletonData.size() - 1);
 }
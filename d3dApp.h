@@ -31,5 +31,13 @@ void CleanupD3D(StateInfo* state);
 // ウィンドウサイズ変更時の処理
 void OnResize(HWND hwnd, StateInfo* state, UINT width, UINT height);
 
+//
+// 文字のアトラスを作り直し、HUD とデバッグ表示の書体をバックバッファの解像度で用意する
+bool CreateTextFonts(StateInfo* state, float clientWidth);
+
+//
+// スケルトン定義とアトラスを読み込んで state->skeletonData に追加する。失敗時は -1
+int LoadSkeletonAsset(HWND hwnd, StateInfo* state, const wchar_t* path);
+
 
 #endif  
\ No newline at end of file
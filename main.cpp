@@ -13,12 +13,29 @@
 #include <windows.h>
 #include <ShellScalingAPI.h> //dpi
 #pragma comment(lib, "Shcore.lib")//Shcore.lib の静的リンクライブラリ
+#include <shellapi.h> //CommandLineToArgvW
+#pragma comment(lib, "Shell32.lib")
+#pragma comment(lib, "Winmm.lib")//timeBeginPeriod
 #include "StateInfo.h"
 #include "d3dApp.h"
 #include "Timer.h"
 #include "Render.h"
 #include "PlayerObject.h"  
 #include "UpdateAll.h"
+#include "InputSystem.h"
+#include "GameWorld.h"
+#include "Replay.h"
+#include "Headless.h"
+#include "AssetCooker.h"
+#include "TextureLoader.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+#include "ResourceRegistry.h"
+#include "ResolutionScaler.h"
+#include "FramePacer.h"
+#include <cstdio>
+#include <string>
+#include <vector>
 
 
 
@@ -27,6 +44,8 @@ void GetScaledWindowSizeAndPosition(float logicalWidth, float logicalHeight,
     int& outW, int& outH, int& outLeft, int& outTop, DWORD C_WND_STYLE);
 inline StateInfo* GetAppState(HWND hwnd);
 void UpdateViewport(ID3D11DeviceContext* context, HWND hwnd);
+int64_t GetMessageInputTime();
+void WriteToolLog(const std::string& log);
 
 
 // ウィンドウプロシージャ関数
@@ -49,6 +68,70 @@ int WINAPI wWinMain(
     (void)hPrevInstance; // 使わないが、警告回避のため明示的に参照
     (void)pCmdLine;      // 同上
 
+    // -record <file> : プレイを記録して終了時に書き出す
+    // -profile <file> : 終了時にプロファイラーの記録を Chrome trace の JSON で書き出す
+    // -telemetry <file> : フレーム時間のヒストグラムを 60 秒ごとにバイナリで追記する
+    // -resources <file> : 終了時に GPU リソースと CPU ヒープの一覧を CSV で書き出す
+    // -gpu-budget <MB> / -cpu-budget <MB> : メモリ予算（超えたら警告して退避を頼む）
+    // -texture-budget <MB> : ファイルから読むテクスチャの予算（超えたら長く使っていないものから追い出す）
+    // -render-scale <0.1..1> : 描画解像度の倍率を固定する（省略時は GPU の時間から決める）
+    // -fps <hz> : この間隔まで待つ（省略時は垂直同期まかせ）。-vsync 0 : 垂直同期を待たない
+    // -replay / -batch はウィンドウを作らずに GameWorld だけを動かす（Headless.h）
+    // -cook <dir> : 変わったアセットだけを変換して -cook-out（既定は cooked）に書き出して終わる（AssetCooker.h）
+    std::vector<std::wstring> args;
+    std::wstring recordPath;
+    std::wstring profilePath;
+    std::wstring telemetryPath;
+    std::wstring resourcesPath;
+    // 下位の筐体はメモリ 2GB なので、既定は GPU と CPU で合わせて 1.5GB に収める
+    uint64_t gpuBudgetMb = 512;
+    uint64_t cpuBudgetMb = 1024;
+    uint64_t textureBudgetMb = 256;
+    float renderScale = 0.0f;
+    FramePacerDesc pacerDesc;
+    UINT presentInterval = 1;
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    for (int i = 1; argv && i < argc; i++) {
+        args.push_back(argv[i]);
+        if (wcscmp(argv[i], L"-record") == 0 && i + 1 < argc) recordPath = argv[i + 1];
+        if (wcscmp(argv[i], L"-profile") == 0 && i + 1 < argc) profilePath = argv[i + 1];
+        if (wcscmp(argv[i], L"-telemetry") == 0 && i + 1 < argc) telemetryPath = argv[i + 1];
+        if (wcscmp(argv[i], L"-resources") == 0 && i + 1 < argc) resourcesPath = argv[i + 1];
+        if (wcscmp(argv[i], L"-gpu-budget") == 0 && i + 1 < argc) gpuBudgetMb = _wcstoui64(argv[i + 1], nullptr, 10);
+        if (wcscmp(argv[i], L"-cpu-budget") == 0 && i + 1 < argc) cpuBudgetMb = _wcstoui64(argv[i + 1], nullptr, 10);
+        if (wcscmp(argv[i], L"-texture-budget") == 0 && i + 1 < argc) textureBudgetMb = _wcstoui64(argv[i + 1], nullptr, 10);
+        if (wcscmp(argv[i], L"-render-scale") == 0 && i + 1 < argc) renderScale = static_cast<float>(_wtof(argv[i + 1]));
+        if (wcscmp(argv[i], L"-fps") == 0 && i + 1 < argc) pacerDesc.targetHz = static_cast<float>(_wtof(argv[i + 1]));
+        if (wcscmp(argv[i], L"-vsync") == 0 && i + 1 < argc) presentInterval = _wtoi(argv[i + 1]) != 0 ? 1 : 0;
+    }
+    if (argv) LocalFree(argv);
+
+    PROFILE_THREAD("Main");
+#if PROFILER_ENABLED
+    if (!profilePath.empty()) {
+        double timestampNs = 0.0;
+        double zoneNs = ProfilerMeasureOverhead(1000000, &timestampNs);
+        char line[128];
+        std::snprintf(line, sizeof(line), "profile: %.1f ns per zone (timestamp %.1f ns)\n", zoneNs, timestampNs);
+        OutputDebugStringA(line);
+    }
+#endif
+
+    std::string cookLog;
+    int cookResult = RunAssetCooker(args, { MakeTextureCookRule(), MakeCopyRule(".txt"), MakeCopyRule(".animgraph"), MakeCopyRule(".skel") }, &cookLog);
+    if (cookResult >= 0) {
+        WriteToolLog(cookLog);
+        return cookResult;
+    }
+
+    std::string headlessLog;
+    int headlessResult = RunHeadless(args, &headlessLog);
+    if (headlessResult >= 0) {
+        WriteToolLog(headlessLog);
+        return headlessResult;
+    }
+
     const wchar_t CLASS_NAME[] = L"Window";
 
     //登録するウィンドウクラス
@@ -70,6 +153,28 @@ int WINAPI wWinMain(
         return 0;
     }
 
+    // 入力はウィンドウができる前に用意しておく（WM_KEYDOWN で使う）
+    pState->input = std::make_unique<InputSystem>();
+    pState->keyboard = std::make_unique<KeyboardSource>(pState->input->GetQueue());
+    pState->keyboard->BindKey('A', InputAction::Left);
+    pState->keyboard->BindKey('D', InputAction::Right);
+    pState->keyboard->BindKey(VK_SPACE, InputAction::Jump);
+    pState->keyboard->BindKey('S', InputAction::Down);
+    pState->input->AddSource(pState->keyboard.get());
+
+    pState->telemetry = std::make_unique<FrameTelemetry>();
+    if (!telemetryPath.empty()) pState->telemetry->SetSnapshotFile(telemetryPath, 60.0f);
+
+    ResourceSetBudget(ResourcePool::Gpu, gpuBudgetMb << 20);
+    ResourceSetBudget(ResourcePool::Cpu, cpuBudgetMb << 20);
+    ResourceSetWarningCallback([](const char* message) { OutputDebugStringA(message); });
+    pState->resourceReportPath = resourcesPath;
+    pState->textureBudgetMb = textureBudgetMb;
+    pState->fixedRenderScale = renderScale;
+    pState->resizeCoalescer = std::make_unique<ResizeCoalescer>();
+    pState->pacer = std::make_unique<FramePacer>(pacerDesc);
+    pState->presentInterval = presentInterval;
+
     //
     const DWORD C_WND_STYLE = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_MINIMIZEBOX | WS_MAXIMIZEBOX;
 
@@ -114,6 +219,23 @@ int WINAPI wWinMain(
         return 0;
     }
 
+    // シミュレーションは固定ステップで進め、入力はその tick の終わりの時刻までのものを渡す
+    const float fixedStep = 1.0f / 120.0f;
+    float accumulator = 0.0f;
+
+    if (!recordPath.empty()) {
+        ReplayHeader header;
+        header.seed = pState->world->seed;
+        header.fixedStep = fixedStep;
+        header.assets.push_back({ "assets/level01.txt", pState->world->mapHash });    // d3dApp.cpp で読むマップ
+        pState->recorder = std::make_unique<ReplayRecorder>();
+        pState->recorder->Begin(header);
+        pState->recordPath = recordPath;
+    }
+
+    // Sleep を 1ms 単位で起きられるようにする（FramePacer の眠りが 15ms 刻みにならないように）
+    timeBeginPeriod(1);
+
     //
     Timer timer;       // タイマーオブジェクト
     timer.Reset();     // プログラム起動時に一度だけ呼び出す
@@ -122,29 +244,72 @@ int WINAPI wWinMain(
     MSG msg = {};
     while (true)
     {
+        PROFILE_ZONE("Frame");
+
+        // 待つのはメッセージと入力を取り出す前。起きてすぐの入力で更新・描画するので、待ちが遅れに入らない
+        bool minimized = IsIconic(hwnd) != FALSE;
+        pState->pacer->SetWindowState(minimized || pState->presentOccluded ? PacerWindowState::Minimized
+            : GetForegroundWindow() != hwnd ? PacerWindowState::Unfocused : PacerWindowState::Active);
+        pState->pacer->Wait();
+
         while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
         {
-            if (msg.message == WM_QUIT)
+            if (msg.message == WM_QUIT) {
+                if (!profilePath.empty()) ProfilerWriteChromeTrace(profilePath.c_str());
+                timeEndPeriod(1);
                 return 0;
+            }
 
             TranslateMessage(&msg);
             DispatchMessage(&msg);
         }
 
+        // 溜まった WM_SIZE を最後の大きさでまとめて反映する
+        UINT resizeWidth = 0, resizeHeight = 0;
+        if (pState->resizeCoalescer->Poll(static_cast<double>(InputNow()) * 1e-6, &resizeWidth, &resizeHeight)) {
+            OnResize(hwnd, pState, resizeWidth, resizeHeight);
+        }
+
 		timer.Tick();    // 毎フレーム呼び出す
 		float deltaTime = timer.GetDeltaTime();  
 
-		bool leftPressed = (GetAsyncKeyState('A') & 0x8000) != 0;
-		bool rightPressed = (GetAsyncKeyState('D') & 0x8000) != 0;
-		bool spacePressed = (GetAsyncKeyState(VK_SPACE) & 0x8000) != 0;
+        ResourceBeginFrame();
 
-        //UpdateAll(pState, deltaTime, leftPressed, rightPressed, spacePressed);
+        int64_t frameNow = InputNow();
+        pState->input->Pump(frameNow);
+        pState->telemetry->Record(FrameMetric::Frame, deltaTime * 1000.0f);
 
+        // 止まっていた後に tick が溜まりすぎないようにする
+        accumulator += (deltaTime < 0.25f) ? deltaTime : 0.25f;
+        int64_t firstInput = 0;
+        while (accumulator >= fixedStep) {
+            accumulator -= fixedStep;
+            int64_t tickEnd = frameNow - static_cast<int64_t>(accumulator * 1e9f);
+            InputFrame input = pState->input->Consume(tickEnd);
+            if (firstInput == 0) firstInput = input.firstEventTime;
 
+            UpdateSimulation(pState, fixedStep, input);
+        }
 
+        UpdatePlayerState(pState, deltaTime);
         UpdatePlayer(pState, deltaTime);
-
-        Render(hwnd, pState);
+        UpdateHits(pState);
+        UpdateSkeletons(pState, deltaTime);
+        UpdateParticles(pState, deltaTime);
+        UpdateLights(pState);
+        UpdateVisibility(pState);
+        UpdateTextureStreaming(pState);
+        pState->telemetry->Record(FrameMetric::Update, static_cast<float>(InputNow() - frameNow) * 1e-6f);
+
+        // 最小化中は描いても見えないので、更新だけ続ける（隠れているだけなら Present で戻ったか確かめる）
+        if (!minimized) Render(hwnd, pState);
+        pState->telemetry->Tick(deltaTime);
+
+        // 入力から Present まで
+        if (firstInput != 0) {
+            float latency = static_cast<float>(InputNow() - firstInput) * 1e-6f;
+            pState->inputLatencyMs += (latency - pState->inputLatencyMs) * 0.1f;
+        }
     
     }
 
@@ -183,6 +348,12 @@ LRESULT CALLBACK WindowProc(
 
     case WM_DESTROY:
         if (pState) { // pStateが有効なポインタか確認
+            if (pState->recorder && pState->world) {
+                pState->recorder->Save(pState->recordPath.c_str(), HashGameWorld(*pState->world));
+            }
+            if (!pState->resourceReportPath.empty()) {
+                ResourceWriteReport(pState->resourceReportPath.c_str());
+            }
             CleanupD3D(pState);
             delete pState;
             pState = nullptr;
@@ -190,6 +361,28 @@ LRESULT CALLBACK WindowProc(
         PostQuitMessage(0);
 
         return 0;
+    case WM_KEYDOWN:
+    case WM_SYSKEYDOWN:
+    case WM_KEYUP:
+    case WM_SYSKEYUP:
+        if (pState && pState->keyboard) {
+            bool down = (uMsg == WM_KEYDOWN || uMsg == WM_SYSKEYDOWN);
+            pState->keyboard->OnKey(static_cast<int>(wParam), down, GetMessageInputTime());
+        }
+        // F3 でデバッグ表示（押しっぱなしの繰り返しは無視）
+        if (pState && uMsg == WM_KEYDOWN && wParam == VK_F3 && (lParam & (1 << 30)) == 0) {
+            pState->showDebugOverlay = !pState->showDebugOverlay;
+        }
+        if (uMsg == WM_SYSKEYDOWN || uMsg == WM_SYSKEYUP) break;   // Alt+F4 などは既定の処理へ
+        return 0;
+
+    case WM_KILLFOCUS:
+        // 離したキーのメッセージが来なくなるので、押しっぱなしにならないよう全部離す
+        if (pState && pState->keyboard) {
+            pState->keyboard->ReleaseAll();
+        }
+        return 0;
+
     case WM_SIZE:
     {
         //
@@ -198,16 +391,25 @@ LRESULT CALLBACK WindowProc(
             // ビューポート更新
             UpdateViewport(pState->context, hwnd);
 
+            // バッファの作り直しはメインループで 1 回にまとめる（ドラッグ中は離すまで待つ）
             UINT width = LOWORD(lParam);
             UINT height = HIWORD(lParam);
-            if (width > 0 && height > 0) {
-                OnResize(hwnd, pState, width, height);
+            if (width > 0 && height > 0 && pState->resizeCoalescer) {
+                pState->resizeCoalescer->Request(width, height, static_cast<double>(InputNow()) * 1e-6);
             }
         }
 
         return 0;
     }
 
+    case WM_ENTERSIZEMOVE:
+        if (pState && pState->resizeCoalescer) pState->resizeCoalescer->BeginInteractive();
+        return 0;
+
+    case WM_EXITSIZEMOVE:
+        if (pState && pState->resizeCoalescer) pState->resizeCoalescer->EndInteractive(static_cast<double>(InputNow()) * 1e-6);
+        return 0;
+
     }
     // switch文で明示的に処理しなかったメッセージは、デフォルトウィンドウプロシージャへ
     return DefWindowProc(hwnd, uMsg, wParam, lParam);
@@ -243,6 +445,35 @@ void UpdateViewport(ID3D11DeviceContext* context, HWND hwnd)
 
     context->RSSetViewports(1, &vp);
 }
+// 今処理しているメッセージがキューに入った時刻を InputNow() の時計で返す
+// GetMessageTime は GetTickCount と同じミリ秒の時計なので、今との差だけを引く（49 日で一周しても差は正しい）
+int64_t GetMessageInputTime()
+{
+    int64_t now = InputNow();
+    DWORD age = GetTickCount() - static_cast<DWORD>(GetMessageTime());
+    // 長く止まっていたときの古すぎる値は信用しない
+    if (age > 1000) return now;
+    return now - static_cast<int64_t>(age) * 1000000;
+}
+
+// -cook や -batch の結果。Windows サブシステムの exe なので標準出力は普通はない
+// ビルドの手順などで出力がつながっていればそこへ、なければ起動したコンソールへ書く（デバッガーにも出す）
+void WriteToolLog(const std::string& log)
+{
+    OutputDebugStringA(log.c_str());
+
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    bool attached = false;
+    if (out == NULL || out == INVALID_HANDLE_VALUE) {
+        if (!AttachConsole(ATTACH_PARENT_PROCESS)) return;
+        out = CreateFileW(L"CONOUT$", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (out == INVALID_HANDLE_VALUE) return;
+        attached = true;
+    }
+    DWORD written = 0;
+    WriteFile(out, log.data(), static_cast<DWORD>(log.size()), &written, nullptr);
+    if (attached) CloseHandle(out);
+}
 void GetScaledWindowSizeAndPosition(float logicalWidth, float logicalHeight,
     int& outW, int& outH, int& outLeft, int& outTop, DWORD C_WND_STYLE)
 {
@@ -15,7 +15,8 @@ cbuffer ConstantBuffer : register(b0)
     float2 texOffset;
     float2 texScale;
     uint uFlipX;
-    float3 padding;
+    float alpha;
+    float2 padding;
 };
 // テクスチャオブジェクト (Texture2D) とサンプラー (SamplerState) を宣言
 // register(t0) はテクスチャをレジスタ t0 にバインドすることを意味する
@@ -70,7 +71,10 @@ float4 PSMain(PS_INPUT input) : SV_TARGET
      // サンプラーと補間後のテクスチャ座標を使ってテクスチャから色をサンプリング
     float4 textureColor = shaderTexture.Sample(SamplerClamp, input.tex);
 
-    // テクスチャの色だけを使う：
+    // テクスチャは premultiplied alpha。頂点カラーは straight のまま渡ってくるので、ここでαを掛けてから合わせる
+    // （スプライトは白、パーティクルは色付き）。alpha はアニメーションのクロスフェード用で、色ごと薄くする
+    float a = input.col.a * alpha;
+    textureColor *= float4(input.col.rgb * a, a);
     return textureColor;
     
     //return float4(1, 0, 0, 1);
@@ -78,9 +82,14 @@ float4 PSMain(PS_INPUT input) : SV_TARGET
      // 頂点シェーダーから渡された色をそのまま出力する場合。各ピクセルの色は頂点から補間されたものになる。
     //return input.col;
     
-
-    // テクスチャカラーと頂点カラーを掛け合わせる（テクスチャの色付けを実現）：
-    // return textureColor * input.col;
-    
    
+}
+
+// アルファテスト用（SpritePass の AlphaTested）。抜けは捨てて、残りは不透明として深度を書く
+float4 PSAlphaTest(PS_INPUT input) : SV_TARGET
+{
+    float4 textureColor = shaderTexture.Sample(SamplerClamp, input.tex);
+    clip(textureColor.a * input.col.a - 0.5f);
+    // premultiplied なので、不透明として書くときは αで割って元の色に戻す（残るのは a >= 0.5 だけ）
+    return float4(textureColor.rgb / textureColor.a * input.col.rgb, 1.0f);
 }
\ No newline at end of file